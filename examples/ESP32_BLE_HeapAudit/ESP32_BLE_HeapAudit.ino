@@ -0,0 +1,83 @@
+/****************************************************************************************************************************
+   ESP32_BLE_HeapAudit.ino
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   Purpose: Stop and restart Blynk_BLE every CYCLE_INTERVAL_MS, NUM_CYCLES times, and print the free heap and the
+            largest free block after each cycle with BlynkHeapAudit. Both must stay flat : end() keeps the stack and
+            the GATT objects, begin() reuses them. The sketch asserts it after the last cycle.
+ *****************************************************************************************************************************/
+
+#ifndef ESP32
+#error This code is intended to run on the ESP32 platform! Please check your Tools->Board setting.
+#endif
+
+#define BLYNK_PRINT Serial
+
+#include <assert.h>
+
+#define NUM_CYCLES                100
+#define CYCLE_INTERVAL_MS         2000L
+
+#include <BlynkSimpleEsp32_BLE_WF.h>
+#include <BLEDevice.h>
+#include <BLEServer.h>
+#include <BlynkEsp32_Arena.h>
+
+char auth[] = "****";
+
+BlynkTimer timer;
+
+BlynkHeapAudit heapAudit;
+
+void cycleBLE()
+{
+  static uint32_t numCycles = 0;
+
+  if (numCycles > NUM_CYCLES)
+    return;
+
+  if (numCycles == NUM_CYCLES)
+  {
+    numCycles++;
+
+    Serial.println(heapAudit.isFlat() ? F("HeapAudit:PASS") : F("HeapAudit:FAIL"));
+    assert(heapAudit.isFlat());
+    return;
+  }
+
+  Blynk_BLE.end();
+  Blynk_BLE.begin(auth);
+
+  // The stacks keep some buffers for good after the first cycle
+  if (numCycles++ == 0)
+  {
+    heapAudit.begin();
+    return;
+  }
+
+  heapAudit.sample();
+  heapAudit.print(Serial);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println(F("\nStarting ESP32_BLE_HeapAudit"));
+
+  Blynk_BLE.setDeviceName("Blynk-HeapAudit");
+  Blynk_BLE.begin(auth);
+
+  timer.setInterval(CYCLE_INTERVAL_MS, cycleBLE);
+}
+
+void loop()
+{
+  Blynk_BLE.run();
+  timer.run();
+}
@@ -258,7 +258,7 @@ void setup()
     Serial.println(F("GPIO14 LOW, Use BLE"));
     Blynk_BLE.setDeviceName(BLE_Device_Name);
 #if USE_BLYNK_WM
-    if (Blynk_WF.getBlynkBLEToken() == NO_CONFIG)        //String("blank"))
+    if (!strcmp(Blynk_WF.getBlynkBLEToken(), NO_CONFIG))        //String("blank"))
     {
       Serial.println(F("No valid stored BLE auth. Have to run WiFi then enter config portal"));
       USE_BLE = false;
@@ -269,9 +269,9 @@ void setup()
       
       Blynk_WF.begin(BLE_Device_Name);
     }
-    String BLE_auth = Blynk_WF.getBlynkBLEToken();
+    const char* BLE_auth = Blynk_WF.getBlynkBLEToken();
 #else
-    String BLE_auth = auth;
+    const char* BLE_auth = auth;
 #endif
 
     if (USE_BLE)
@@ -283,7 +283,7 @@ void setup()
       Serial.println(F("USE_BLE: Blynk_BLE begin"));
 #endif   
       
-      Blynk_BLE.begin(BLE_auth.c_str());
+      Blynk_BLE.begin(BLE_auth);
     }
   }
 #endif
@@ -0,0 +1,194 @@
+/****************************************************************************************************************************
+   ESP32_BLE_WF_Tasks.ino
+   For ESP32 using WiFi along with BlueTooth BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   Purpose: Run Blynk_BLE and Blynk_WF each in its own task, pinned to a core, while loop() samples a sensor.
+            Readings are published to both through their lock-free queues, also from a Ticker and from a button ISR.
+            BLYNK_WRITE_ON() handlers run in loop().
+            Set USE_BLYNK_TASKS false to run everything from loop() and compare the timings printed every 10 s.
+ *****************************************************************************************************************************/
+
+#ifndef ESP32
+#error This code is intended to run on the ESP32 platform! Please check your Tools->Board setting.
+#endif
+
+#define BLYNK_PRINT Serial
+
+#define USE_SPIFFS                  false
+
+#if (!USE_SPIFFS)
+// EEPROM_SIZE must be <= 2048 and >= CONFIG_DATA_SIZE
+#define EEPROM_SIZE    (2 * 1024)
+// EEPROM_START + CONFIG_DATA_SIZE must be <= EEPROM_SIZE
+#define EEPROM_START   0
+#endif
+
+// Set false to compare with everything run from loop()
+#define USE_BLYNK_TASKS             true
+
+#include <BlynkSimpleEsp32_BLE_WF.h>
+#include <BLEDevice.h>
+#include <BLEServer.h>
+
+// Those above #define's must be placed before #include <BlynkSimpleEsp32_WFM.h>
+#include <BlynkSimpleEsp32_WFM.h>
+
+MenuItem myMenuItems [] = {};
+
+uint16_t NUM_MENU_ITEMS = sizeof(myMenuItems) / sizeof(MenuItem);  //MenuItemSize;
+
+#include <BlynkEsp32_Tasks.h>
+
+#if USE_BLYNK_TASKS
+// The Bluetooth stack and the WiFi stack run on core 0, the Arduino loop() on core 1
+#define BLE_TASK_CORE               0
+#define WF_TASK_CORE                1
+
+BlynkTask<BlynkEsp32_BLE> bleTask(Blynk_BLE);
+BlynkTask<BlynkWifi>      wfTask(Blynk_WF);
+
+BlynkWriteQueue           loopWrites;
+
+BlynkPublishQueue<BlynkEsp32_BLE>&  bleQueue  = bleTask.getPublishQueue();
+BlynkPublishQueue<BlynkWifi>&       wfQueue   = wfTask.getPublishQueue();
+#else
+// Drained by loop()
+BlynkPublishQueue<BlynkEsp32_BLE>   bleQueue(Blynk_BLE);
+BlynkPublishQueue<BlynkWifi>        wfQueue(Blynk_WF);
+#endif
+
+#include <Ticker.h>
+
+Ticker uptimeTicker;
+
+#define SENSOR_PIN                  A0
+#define BUTTON_PIN                  0
+#define SAMPLE_INTERVAL_MS          100L
+#define PUBLISH_INTERVAL_MS         1000L
+#define STATS_INTERVAL_MS           10000L
+
+// Blynk token of the BLE link
+char auth[] = "****";
+
+char BLE_Device_Name[] = "ESP32-Tasks";
+
+BlynkTimer      timer;
+BlynkTaskStats  loopStats;
+
+uint32_t sum      = 0;
+uint16_t samples  = 0;
+
+volatile int32_t numPresses = 0;
+
+void IRAM_ATTR onButton()
+{
+  numPresses = numPresses + 1;
+  wfQueue.virtualWriteFromISR(V3, numPresses);
+}
+
+// Runs in the esp_timer task
+void publishUptime()
+{
+  wfQueue.virtualWrite(V4, millis() / 1000);
+}
+
+#if USE_BLYNK_TASKS
+// Runs in loop(), not in the Blynk tasks
+BLYNK_WRITE_ON(loopWrites, V2)
+#else
+BLYNK_WRITE(V2)
+#endif
+{
+  digitalWrite(LED_BUILTIN, param.asInt() ? HIGH : LOW);
+}
+
+void sample()
+{
+  sum += analogRead(SENSOR_PIN);
+  samples++;
+}
+
+void publish()
+{
+  if (!samples)
+    return;
+
+  uint32_t value = sum / samples;
+
+  sum     = 0;
+  samples = 0;
+
+  bleQueue.virtualWrite(V1, value);
+  wfQueue.virtualWrite(V1, value);
+}
+
+void printStats()
+{
+  Serial.print(F("loop : "));
+  loopStats.print(Serial);
+
+#if USE_BLYNK_TASKS
+  Serial.print(F("BLE  : "));
+  bleTask.getStats().print(Serial);
+  Serial.print(F("WiFi : "));
+  wfTask.getStats().print(Serial);
+  Serial.print(F("Dropped writes : "));
+  Serial.println(loopWrites.getDropped());
+#endif
+
+  bleQueue.print(Serial);
+  wfQueue.print(Serial);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println(F("\nStarting ESP32_BLE_WF_Tasks"));
+
+  pinMode(LED_BUILTIN, OUTPUT);
+  pinMode(BUTTON_PIN, INPUT_PULLUP);
+
+  Blynk_BLE.setDeviceName(BLE_Device_Name);
+  Blynk_BLE.begin(auth);
+
+  Blynk_WF.begin("ESP32-Tasks");
+
+#if USE_BLYNK_TASKS
+  loopWrites.begin();
+
+  bleTask.begin("BlynkBLE", BLE_TASK_CORE);
+  wfTask.begin("BlynkWF", WF_TASK_CORE);
+#endif
+
+  attachInterrupt(BUTTON_PIN, onButton, FALLING);
+  uptimeTicker.attach(5, publishUptime);
+
+  timer.setInterval(SAMPLE_INTERVAL_MS,  sample);
+  timer.setInterval(PUBLISH_INTERVAL_MS, publish);
+  timer.setInterval(STATS_INTERVAL_MS,   printStats);
+}
+
+void loop()
+{
+  loopStats.begin();
+
+#if USE_BLYNK_TASKS
+  loopWrites.run();
+#else
+  Blynk_BLE.run();
+  bleQueue.run();
+
+  Blynk_WF.run();
+  wfQueue.run();
+#endif
+
+  timer.run();
+
+  loopStats.end();
+}
@@ -259,7 +259,7 @@ void setup()
     Serial.println(F("GPIO14 LOW, Use BT"));
     Blynk_BT.setDeviceName(BT_Device_Name);
 #if USE_BLYNK_WM
-    if (Blynk_WF.getBlynkBTToken() == NO_CONFIG)        //String("blank"))
+    if (!strcmp(Blynk_WF.getBlynkBTToken(), NO_CONFIG))        //String("blank"))
     {
       Serial.println(F("No valid stored BT auth. Have to run WiFi then enter config portal"));
       USE_BT = false;
@@ -270,9 +270,9 @@ void setup()
 
       Blynk_WF.begin(BT_Device_Name);
     }
-    String BT_auth = Blynk_WF.getBlynkBTToken();
+    const char* BT_auth = Blynk_WF.getBlynkBTToken();
 #else
-    String BT_auth = auth;
+    const char* BT_auth = auth;
 #endif
 
     if (USE_BT)
@@ -284,7 +284,7 @@ void setup()
       Serial.println(F("USE_BT: Blynk_BT begin"));
 #endif
 
-      Blynk_BT.begin(BT_auth.c_str());
+      Blynk_BT.begin(BT_auth);
     }
   }
 #endif
@@ -0,0 +1,188 @@
+/****************************************************************************************************************************
+   ESP32_Coex_Benchmark.ino
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   Purpose: Measure Blynk throughput for WiFi only, BT/BLE only and both at the same time, with or without
+            BlynkCoexController. Select the mode with BENCH_MODE, connect the Blynk app over BT/BLE if used,
+            then read the results on Serial Monitor.
+ *****************************************************************************************************************************/
+
+#ifndef ESP32
+#error This code is intended to run on the ESP32 platform! Please check your Tools->Board setting.
+#endif
+
+#define BLYNK_PRINT Serial
+
+#define BENCH_MODE_WIFI           1
+#define BENCH_MODE_BT             2
+#define BENCH_MODE_DUAL           3
+
+#define BENCH_MODE                BENCH_MODE_DUAL
+
+// Set true to let BlynkCoexController set coexistence preference and TX power
+#define USE_COEX_CONTROLLER       true
+
+#define USE_BLE_NOT_BT            true
+
+// Each round sends BENCH_BURST writes per link every BENCH_PERIOD_MS for BENCH_DURATION_MS
+#define BENCH_BURST               10
+#define BENCH_PERIOD_MS           100L
+#define BENCH_DURATION_MS         30000L
+
+#if USE_BLE_NOT_BT
+#include <BlynkSimpleEsp32_BLE_WF.h>
+#include <BLEDevice.h>
+#include <BLEServer.h>
+#define Blynk_BT_BLE              Blynk_BLE
+#define BT_BLE_TRANSPORT          BLYNK_TRANSPORT_BLE
+#else
+#include <BlynkSimpleEsp32_BT_WF.h>
+#define Blynk_BT_BLE              Blynk_BT
+#define BT_BLE_TRANSPORT          BLYNK_TRANSPORT_BT
+#endif
+
+#include <BlynkSimpleEsp32_WF.h>
+#include <BlynkEsp32_Coex.h>
+
+String cloudBlynkServer = "account.duckdns.org";
+#define BLYNK_SERVER_HARDWARE_PORT    8080
+
+char ssid[] = "SSID";
+char pass[] = "PASS";
+
+char WiFi_auth[]  = "WF_token";
+char BT_auth[]    = "BT_token";
+
+#define USE_WIFI    (BENCH_MODE != BENCH_MODE_BT)
+#define USE_BT_BLE  (BENCH_MODE != BENCH_MODE_WIFI)
+
+#if USE_COEX_CONTROLLER
+BlynkCoexController coex(BT_BLE_TRANSPORT);
+#endif
+
+BlynkTimer timer;
+
+BlynkTrafficCounter noTraffic = { 0, 0 };
+
+uint32_t benchStart_ms = 0;
+BlynkTrafficCounter wifiStart;
+BlynkTrafficCounter btStart;
+
+const BlynkTrafficCounter& wifiTraffic()
+{
+#if USE_WIFI
+  return Blynk_WF.getTraffic();
+#else
+  return noTraffic;
+#endif
+}
+
+const BlynkTrafficCounter& btTraffic()
+{
+#if USE_BT_BLE
+  return Blynk_BT_BLE.getTraffic();
+#else
+  return noTraffic;
+#endif
+}
+
+bool linksReady()
+{
+  bool ready = true;
+
+#if USE_WIFI
+  ready = ready && Blynk_WF.connected();
+#endif
+
+#if USE_BT_BLE
+  ready = ready && Blynk_BT_BLE.connected();
+#endif
+
+  return ready;
+}
+
+void sendBurst()
+{
+  if (!linksReady())
+    return;
+
+  if (!benchStart_ms)
+  {
+    Serial.println(F("Links ready, start"));
+    benchStart_ms = millis();
+    wifiStart     = wifiTraffic();
+    btStart       = btTraffic();
+  }
+
+  if (millis() - benchStart_ms > BENCH_DURATION_MS)
+    return;
+
+  for (int i = 0; i < BENCH_BURST; i++)
+  {
+#if USE_WIFI
+    Blynk_WF.virtualWrite(V1, millis());
+#endif
+
+#if USE_BT_BLE
+    Blynk_BT_BLE.virtualWrite(V1, millis());
+#endif
+  }
+}
+
+void printResult()
+{
+  static bool printed = false;
+
+  if (printed || !benchStart_ms || (millis() - benchStart_ms <= BENCH_DURATION_MS))
+    return;
+
+  printed = true;
+
+  uint32_t wifiBytes  = wifiTraffic().bytesOut - wifiStart.bytesOut;
+  uint32_t btBytes    = btTraffic().bytesOut - btStart.bytesOut;
+
+  Serial.printf("\nMode=%d, Coex=%d\n", BENCH_MODE, USE_COEX_CONTROLLER);
+  Serial.printf("WiFi : %u bytes, %u B/s\n", wifiBytes, wifiBytes * 1000 / BENCH_DURATION_MS);
+  Serial.printf("BT/BLE : %u bytes, %u B/s\n", btBytes, btBytes * 1000 / BENCH_DURATION_MS);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println(F("\nStarting ESP32_Coex_Benchmark"));
+
+#if USE_BT_BLE
+  Blynk_BT_BLE.setDeviceName("Blynk-Bench");
+  Blynk_BT_BLE.begin(BT_auth);
+#endif
+
+#if USE_WIFI
+  Blynk_WF.begin(WiFi_auth, ssid, pass, cloudBlynkServer.c_str(), BLYNK_SERVER_HARDWARE_PORT);
+#endif
+
+  timer.setInterval(BENCH_PERIOD_MS, sendBurst);
+  timer.setInterval(1000L, printResult);
+}
+
+void loop()
+{
+#if USE_BT_BLE
+  Blynk_BT_BLE.run();
+#endif
+
+#if USE_WIFI
+  Blynk_WF.run();
+#endif
+
+#if USE_COEX_CONTROLLER
+  coex.run(wifiTraffic(), btTraffic());
+#endif
+
+  timer.run();
+}
@@ -0,0 +1,103 @@
+/****************************************************************************************************************************
+   ESP32_WFM_DeepSleep.ino
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   Purpose: Periodic sensor. Wake up, publish one batch of readings to Blynk over WiFi, then deep sleep.
+            The first cycle runs the full Blynk_WF.begin() (Config Portal if there is no config yet). Next cycles
+            resume the stored session from RTC memory. Timings of each phase are printed on Serial Monitor.
+            If the AP or the server can't be reached, the board stays awake at most NO_LINK_TIMEOUT_MS, then sleeps
+            and tries again on the next wake-up.
+ *****************************************************************************************************************************/
+
+#ifndef ESP32
+#error This code is intended to run on the ESP32 platform! Please check your Tools->Board setting.
+#endif
+
+#define BLYNK_PRINT Serial
+
+#define USE_SPIFFS                  false
+
+#if (!USE_SPIFFS)
+// EEPROM_SIZE must be <= 2048 and >= CONFIG_DATA_SIZE
+#define EEPROM_SIZE    (2 * 1024)
+// EEPROM_START + CONFIG_DATA_SIZE must be <= EEPROM_SIZE
+#define EEPROM_START   0
+#endif
+
+#define USE_DEEP_SLEEP_RESUME       true
+
+// Time between two publishes
+#define SLEEP_TIME_US               (60ULL * 1000000ULL)
+
+// Max time awake without a link, then sleep RETRY_SLEEP_US and try again
+#define NO_LINK_TIMEOUT_MS          30000UL
+#define RETRY_SLEEP_US              SLEEP_TIME_US
+
+// No custom parameters : myMenuItems[] not needed, and their code is not compiled
+#define BLYNK_WM_DYNAMIC_PARAMETERS false
+
+// Those above #define's must be placed before #include <BlynkSimpleEsp32_WFM.h>
+#include <BlynkSimpleEsp32_WFM.h>
+
+RTC_DATA_ATTR uint32_t numCycles = 0;
+
+void publish()
+{
+  Blynk_WF.virtualWrite(V1, analogRead(A0));
+  Blynk_WF.virtualWrite(V2, numCycles);
+  Blynk_WF.virtualWrite(V3, Blynk_WF.getLastCycle().getTotal());
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println(F("\nStarting ESP32_WFM_DeepSleep"));
+
+  numCycles++;
+
+  bool resumed = Blynk_WF.resume("ESP32-DeepSleep");
+
+  if (!Blynk_WF.connected())
+  {
+    // Config Portal or no link : loop() runs Blynk_WF.run(), until NO_LINK_TIMEOUT_MS for the latter
+    return;
+  }
+
+  if (numCycles > 1)
+  {
+    Serial.print(F("Last cycle : "));
+    Blynk_WF.getLastCycle().print(Serial);
+  }
+
+  publish();
+
+  Serial.print(resumed ? F("Resumed in ") : F("Full begin in "));
+  Serial.print(millis());
+  Serial.println(F(" ms"));
+
+  Blynk_WF.sleep(SLEEP_TIME_US);
+}
+
+void loop()
+{
+  Blynk_WF.run();
+
+  // Config done and connected : start the cycle
+  if (Blynk_WF.connected())
+  {
+    publish();
+    Blynk_WF.sleep(SLEEP_TIME_US);
+  }
+  else if ( !Blynk_WF.isConfigPortalHeld() && (millis() > NO_LINK_TIMEOUT_MS) )
+  {
+    // Config is there, but the AP or server is down : don't drain the battery waiting for it
+    Serial.println(F("No link, retry after sleep"));
+    Blynk_WF.sleep(RETRY_SLEEP_US);
+  }
+}
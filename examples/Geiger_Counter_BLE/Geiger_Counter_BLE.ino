@@ -173,6 +173,16 @@ void IRAM_ATTR countPulse();
 volatile unsigned long last_micros;
 volatile long          count = 0;
 
+// Set true to count pulses with the PCNT hardware counter, instead of one interrupt per pulse
+#define USE_PCNT_COUNTER              false
+
+#if USE_PCNT_COUNTER
+#include <BlynkEsp32_PulseCounter.h>
+
+BlynkPulseCounter   geigerCounter(GEIGER_INPUT_PIN);
+BlynkPulseSnapshot  geigerSnapshot;
+#endif
+
 BlynkTimer timer;
 
 #include <Ticker.h>
@@ -180,10 +190,12 @@ Ticker     led_ticker;
 
 void IRAM_ATTR countPulse()
 {
-  if ((long)(micros() - last_micros) >= DEBOUNCE_TIME_MICRO_SEC)
+  unsigned long now = micros();
+
+  if ((long)(now - last_micros) >= DEBOUNCE_TIME_MICRO_SEC)
   {
     count++;
-    last_micros = micros();
+    last_micros = now;
   }
 }
 
@@ -276,8 +288,16 @@ void checkStatus()
 
     timePreviousMeassure = millis();
 
+#if (USE_PCNT_COUNTER && !USE_SIMULATION)
+    count = geigerCounter.getCountSince(geigerSnapshot);
+#endif
+
+    // Read and clear together, else pulses counted in between are lost
     noInterrupts();
     countPerMinute = COUNT_PER_MIN_CONVERSION * count;
+#if !USE_SIMULATION
+    count = 0;
+#endif
     interrupts();
 
     radiationValue = countPerMinute * CONV_FACTOR;
@@ -297,8 +317,6 @@ void checkStatus()
     count += 10;
     if (count >= 1000)
       count = 0;
-#else
-    count = 0;
 #endif
 
     // report Blynk connection
@@ -313,8 +331,13 @@ void setup()
   Serial.begin(115200);
   Serial.println(F("\nStarting Geiger-Counter"));
 
+#if USE_PCNT_COUNTER
+  geigerCounter.begin();
+  geigerSnapshot = geigerCounter.snapshot();
+#else
   pinMode(GEIGER_INPUT_PIN, INPUT);
   attachInterrupt(GEIGER_INPUT_PIN, countPulse, HIGH);
+#endif
 
 #if BLYNK_USE_BLE_ONLY
   Blynk_BLE.setDeviceName(BLE_Device_Name);
@@ -340,22 +363,22 @@ void setup()
     Serial.println(F("GPIO14 LOW, Use BLE"));
     Blynk_BLE.setDeviceName(BLE_Device_Name);
 #if USE_BLYNK_WM
-    if (Blynk_WF.getBlynkBLEToken() == NO_CONFIG)        //String("blank"))
+    if (!strcmp(Blynk_WF.getBlynkBLEToken(), NO_CONFIG))        //String("blank"))
     {
       Serial.println(F("No valid stored BLE auth. Have to run WiFi then enter config portal"));
       USE_BLE = false;
       Blynk_WF.begin(BLE_Device_Name);
     }
-    String BLE_auth = Blynk_WF.getBlynkBLEToken();
+    const char* BLE_auth = Blynk_WF.getBlynkBLEToken();
 #else
-    String BLE_auth = auth;
+    const char* BLE_auth = auth;
 #endif
 
     if (USE_BLE)
     {
       Serial.print(F("Connecting Blynk via BLE, using auth = "));
       Serial.println(BLE_auth);
-      Blynk_BLE.begin(BLE_auth.c_str());
+      Blynk_BLE.begin(BLE_auth);
     }
   }
 #endif
@@ -180,6 +180,16 @@ void IRAM_ATTR countPulse();
 volatile unsigned long last_micros;
 volatile long          count = 0;
 
+// Set true to count pulses with the PCNT hardware counter, instead of one interrupt per pulse
+#define USE_PCNT_COUNTER              false
+
+#if USE_PCNT_COUNTER
+#include <BlynkEsp32_PulseCounter.h>
+
+BlynkPulseCounter   geigerCounter(GEIGER_INPUT_PIN);
+BlynkPulseSnapshot  geigerSnapshot;
+#endif
+
 Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET_PIN);
 BlynkTimer timer;
 
@@ -188,10 +198,12 @@ Ticker     led_ticker;
 
 void IRAM_ATTR countPulse()
 {
-  if ((long)(micros() - last_micros) >= DEBOUNCE_TIME_MICRO_SEC)
+  unsigned long now = micros();
+
+  if ((long)(now - last_micros) >= DEBOUNCE_TIME_MICRO_SEC)
   {
     count++;
-    last_micros = micros();
+    last_micros = now;
   }
 }
 
@@ -310,8 +322,16 @@ void checkStatus()
   {
     timePreviousMeassure = millis();
 
+#if (USE_PCNT_COUNTER && !USE_SIMULATION)
+    count = geigerCounter.getCountSince(geigerSnapshot);
+#endif
+
+    // Read and clear together, else pulses counted in between are lost
     noInterrupts();
     countPerMinute = COUNT_PER_MIN_CONVERSION * count;
+#if !USE_SIMULATION
+    count = 0;
+#endif
     interrupts();
 
     radiationValue = countPerMinute * CONV_FACTOR;
@@ -332,8 +352,6 @@ void checkStatus()
     count += 10;
     if (count >= 1000)
       count = 0;
-#else
-    count = 0;
 #endif
 
     // report Blynk connection
@@ -348,8 +366,13 @@ void setup()
   Serial.begin(115200);
   Serial.println(F("\nStarting Geiger-Counter-OLED"));
 
+#if USE_PCNT_COUNTER
+  geigerCounter.begin();
+  geigerSnapshot = geigerCounter.snapshot();
+#else
   pinMode(GEIGER_INPUT_PIN, INPUT);
   attachInterrupt(GEIGER_INPUT_PIN, countPulse, HIGH);
+#endif
 
   if (!display.begin(SSD1306_SWITCHCAPVCC, 0x3C)) {
     Serial.println(F("SSD1306 allocation failed"));
@@ -383,22 +406,22 @@ void setup()
     Serial.println(F("GPIO14 LOW, Use BT"));
     Blynk_BT.setDeviceName(BT_Device_Name);
 #if USE_BLYNK_WM
-    if (Blynk_WF.getBlynkBTToken() == NO_CONFIG)        //String("blank"))
+    if (!strcmp(Blynk_WF.getBlynkBTToken(), NO_CONFIG))        //String("blank"))
     {
       Serial.println(F("No valid stored BT auth. Have to run WiFi then enter config portal"));
       USE_BT = false;
       Blynk_WF.begin(BT_Device_Name);
     }
-    String BT_auth = Blynk_WF.getBlynkBTToken();
+    const char* BT_auth = Blynk_WF.getBlynkBTToken();
 #else
-    String BT_auth = auth;
+    const char* BT_auth = auth;
 #endif
 
     if (USE_BT)
     {
       Serial.print(F("Connecting Blynk via BT, using auth = "));
       Serial.println(BT_auth);
-      Blynk_BT.begin(BT_auth.c_str());
+      Blynk_BT.begin(BT_auth);
     }
   }
 #endif
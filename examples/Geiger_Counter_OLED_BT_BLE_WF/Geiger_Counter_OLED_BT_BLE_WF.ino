@@ -41,6 +41,10 @@
 
 #define BLYNK_PRINT Serial
 
+// Set true to record loop() trace points. Paste the dumped JSON into https://ui.perfetto.dev or chrome://tracing
+#define BLYNK_USE_TRACE             false
+#define TRACE_DUMP_INTERVAL_MS      60000L
+
 #include <SPI.h>
 #include <Wire.h>
 #include <Adafruit_GFX.h>
@@ -63,6 +67,10 @@
 #define TIMEOUT_RECONNECT_WIFI                    10000L
 #define RESET_IF_CONFIG_TIMEOUT                   true
 #define CONFIG_TIMEOUT_RETRYTIMES_BEFORE_RESET    5
+
+// Set true to report Blynk_WF.run() calls longer than RUN_WATCHDOG_BUDGET_MS, with the call site that caused it
+#define USE_RUN_WATCHDOG                          false
+#define RUN_WATCHDOG_BUDGET_MS                    50
 // Those above #define's must be placed before #include <BlynkSimpleEsp32_WFM.h>
 
 #define USE_BLE_NOT_BT   true
@@ -158,6 +166,58 @@ char BLE_auth[]    = "BLE_token";
 
 #endif
 
+// Set true to keep readings taken while WiFi or BT/BLE is disconnected, and send them after reconnection
+#define USE_OFFLINE_QUEUE         false
+
+#if USE_OFFLINE_QUEUE
+#include <BlynkEsp32_OfflineQueue.h>
+
+#if USE_BLE_NOT_BT
+BlynkOfflineQueue<BlynkEsp32_BLE> BT_BLE_Queue(Blynk_BLE, "/offq_bt.dat");
+#else
+BlynkOfflineQueue<BlynkEsp32_BT>  BT_BLE_Queue(Blynk_BT,  "/offq_bt.dat");
+#endif
+
+BlynkOfflineQueue<BlynkWifi>      WF_Queue(Blynk_WF, "/offq_wf.dat");
+
+#define Blynk_BT_BLE_Out          BT_BLE_Queue
+#define Blynk_WF_Out              WF_Queue
+#elif USE_BLE_NOT_BT
+#define Blynk_BT_BLE_Out          Blynk_BLE
+#define Blynk_WF_Out              Blynk_WF
+#else
+#define Blynk_BT_BLE_Out          Blynk_BT
+#define Blynk_WF_Out              Blynk_WF
+#endif
+
+// Set true to start / stop WiFi and BT/BLE at runtime by writing to V9 : 1 = WiFi, 2 = BT, 4 = BLE, or a sum of them
+#define USE_TRANSPORT_MANAGER     false
+
+// Set true to use BT/BLE only while WiFi is lost, and send data on whichever link is up. Needs USE_TRANSPORT_MANAGER
+#define USE_FAILOVER              false
+
+#if USE_TRANSPORT_MANAGER
+#include <BlynkEsp32_Transport.h>
+
+BlynkTransportManager transports;
+
+#if USE_FAILOVER
+#include <BlynkEsp32_Failover.h>
+
+BlynkFailover failover(transports, USE_BLE_NOT_BT ? BLYNK_TRANSPORT_BLE : BLYNK_TRANSPORT_BT);
+#endif
+#endif
+
+// Set true for battery operation : WiFi modem sleep, publishes batched every PUBLISH_INTERVAL_MS, idle BLE stretched
+#define USE_POWER_MANAGER         false
+#define PUBLISH_INTERVAL_MS       20000L
+
+#if USE_POWER_MANAGER
+#include <BlynkEsp32_Power.h>
+
+BlynkPowerManager power;
+#endif
+
 #define WIFI_BT_SELECTION_PIN     14   //Pin D14 mapped to pin GPIO14/HSPI_SCK/ADC16/TOUCH6/TMS of ESP32
 #define GEIGER_INPUT_PIN          18   // Pin D18 mapped to pin GPIO18/VSPI_SCK of ESP32
 #define VOLTAGER_INPUT_PIN        36   // Pin D36 mapped to pin GPIO36/ADC0/SVP of ESP32  
@@ -183,47 +243,138 @@ long  countPrevious         = 0;
 float radiationValue        = 0.0;
 float radiationDose         = 0;
 
+// Set true to sample the battery voltage continuously by DMA and average it, instead of one analogRead()
+#define USE_ADC_SAMPLER               false
+
+#if USE_ADC_SAMPLER
+#include <BlynkEsp32_AdcSampler.h>
+
+BlynkAdcSampler adcSampler;
+#endif
+
+float readVoltage()
+{
+#if USE_ADC_SAMPLER
+  // Same scale as analogRead(), with less noise
+  return adcSampler.getRaw() * VOLTAGE_FACTOR;
+#else
+  return (float) analogRead(VOLTAGER_INPUT_PIN) * VOLTAGE_FACTOR;
+#endif
+}
+
 void IRAM_ATTR countPulse();
 volatile unsigned long last_micros;
 volatile long          count = 0;
 
+// Set true to count pulses with the PCNT hardware counter, instead of one interrupt per pulse
+#define USE_PCNT_COUNTER              false
+
+#if USE_PCNT_COUNTER
+#include <BlynkEsp32_PulseCounter.h>
+
+BlynkPulseCounter   geigerCounter(GEIGER_INPUT_PIN);
+BlynkPulseSnapshot  geigerSnapshot;
+#endif
+
+// Set true for CPM and dose rate over a sliding 1 min window, updated every second, with dead-time correction
+#define USE_CPM_METER                 false
+
+#if USE_CPM_METER
+#define CPM_CONV_FACTOR               CONV_FACTOR
+// Dead time of the J305 / M4011 tube
+#define CPM_DEAD_TIME_US              190
+
+#include <BlynkEsp32_CPMMeter.h>
+
+BlynkCPMMeter cpmMeter;
+#endif
+
 Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET_PIN);
+
+// Set true to redraw and send only the OLED fields that changed, in small chunks from loop()
+#define USE_OLED_FIELDS               false
+
+#if USE_OLED_FIELDS
+#include <BlynkEsp32_OLEDFields.h>
+
+BlynkOLEDFields oled(display);
+
+int8_t oledCPM;
+int8_t oledDose;
+int8_t oledVoltage;
+int8_t oledRate;
+#endif
+
+// Set true to sample, print, display and publish through BlynkAcquisition channels and sinks
+#define USE_ACQUISITION               false
+
+#if USE_ACQUISITION
+#include <BlynkEsp32_Acquisition.h>
+
+BlynkAcquisition acquisition;
+
+BlynkSerialSink                           serialSink(Serial);
+BlynkPinSink<decltype(Blynk_BT_BLE_Out)>  btSink(Blynk_BT_BLE_Out);
+BlynkPinSink<decltype(Blynk_WF_Out)>      wfSink(Blynk_WF_Out);
+
+#if USE_OLED_FIELDS
+BlynkOLEDSink                             oledSink(oled);
+#endif
+
+int8_t acqCPM;
+int8_t acqRate;
+int8_t acqDose;
+int8_t acqVoltage;
+#endif
 BlynkTimer timer;
 
 #include <Ticker.h>
 Ticker     led_ticker;
 
+#if USE_TRANSPORT_MANAGER
+BLYNK_WRITE(V9)
+{
+  // Switch after the current handler returned, as it may stop the transport running it
+  static uint8_t requested;
+
+  requested = param.asInt();
+  timer.setTimeout(100L, []() { transports.select(requested); });
+}
+#endif
+
 void IRAM_ATTR countPulse()
 {
-  if ((long)(micros() - last_micros) >= DEBOUNCE_TIME_MICRO_SEC)
+  unsigned long now = micros();
+
+  if ((long)(now - last_micros) >= DEBOUNCE_TIME_MICRO_SEC)
   {
     count++;
-    last_micros = micros();
+    last_micros = now;
   }
 }
 
 void sendDatatoBlynk()
 {
-#if USE_BLE_NOT_BT
-  // For BLE
-  Blynk_BLE.virtualWrite(V1, countPerMinute);
-  Blynk_BLE.virtualWrite(V3, radiationValue);
-  Blynk_BLE.virtualWrite(V5, radiationDose);
-  Blynk_BLE.virtualWrite(V7, voltage);
-#else
-  // For BT
-  Blynk_BT.virtualWrite(V1, countPerMinute);
-  Blynk_BT.virtualWrite(V3, radiationValue);
-  Blynk_BT.virtualWrite(V5, radiationDose);
-  Blynk_BT.virtualWrite(V7, voltage);
+#if (USE_TRANSPORT_MANAGER && USE_FAILOVER)
+  // To the link currently up
+  failover.virtualWrite(V1, countPerMinute);
+  failover.virtualWrite(V3, radiationValue);
+  failover.virtualWrite(V5, radiationDose);
+  failover.virtualWrite(V7, voltage);
+  return;
 #endif
 
-  // For WiFi
-  Blynk_WF.virtualWrite(V1, countPerMinute);
-  Blynk_WF.virtualWrite(V3, radiationValue);
-  Blynk_WF.virtualWrite(V5, radiationDose);
-  Blynk_WF.virtualWrite(V7, voltage);
+  // For BT or BLE
+  Blynk_BT_BLE_Out.virtualWrite(V1, countPerMinute);
+  Blynk_BT_BLE_Out.virtualWrite(V3, radiationValue);
+  Blynk_BT_BLE_Out.virtualWrite(V5, radiationDose);
+  Blynk_BT_BLE_Out.virtualWrite(V7, voltage);
 
+  // For WiFi
+  Blynk_WF_Out.virtualWrite(V1, countPerMinute);
+  Blynk_WF_Out.virtualWrite(V3, radiationValue);
+  Blynk_WF_Out.virtualWrite(V5, radiationDose);
+  Blynk_WF_Out.virtualWrite(V7, voltage);
 }
 
 void Serial_Display()
@@ -243,6 +394,20 @@ void Serial_Display()
 
 void OLED_Display()
 {
+  BLYNK_TRACE_SCOPE("OLED_Display");
+
+#if USE_OLED_FIELDS
+  oled.setText(oledCPM, countPerMinute);
+  oled.setText(oledDose, radiationDose, 3);
+  oled.setText(oledVoltage, voltage, 2);
+  oled.setTextSize(oledRate, (radiationValue < 9.99) ? 2 : 1);
+  oled.setText(oledRate, radiationValue, 2);
+
+  // Sent by oled.run() in loop()
+  oled.update(true);
+  return;
+#endif
+
   display.setCursor(0, 0);
   display.clearDisplay();
   display.setTextSize(1);
@@ -309,38 +474,79 @@ void heartBeatPrint(void)
 
 #define USE_SIMULATION    true
 
+#if USE_CPM_METER
+void feedCPMMeter()
+{
+  uint32_t pulses;
+
+#if USE_PCNT_COUNTER
+  pulses = geigerCounter.getCountSince(geigerSnapshot);
+#else
+  noInterrupts();
+  pulses = count;
+  count = 0;
+  interrupts();
+#endif
+
+  cpmMeter.addPulses(pulses);
+}
+#endif
+
 void checkStatus()
 {
   static float voltage;
 
+#if USE_CPM_METER
+  feedCPMMeter();
+#endif
+
   if (millis() - timePreviousMeassure > MEASURE_INTERVAL_MS)
   {
     timePreviousMeassure = millis();
 
+#if USE_CPM_METER
+    countPerMinute  = cpmMeter.getCPM(CPM_WINDOW_1MIN);
+    radiationValue  = cpmMeter.getDoseRate(CPM_WINDOW_1MIN);
+    radiationDose   = cpmMeter.getDose();
+#else
+
+#if (USE_PCNT_COUNTER && !USE_SIMULATION)
+    count = geigerCounter.getCountSince(geigerSnapshot);
+#endif
+
+    // Read and clear together, else pulses counted in between are lost
     noInterrupts();
     countPerMinute = COUNT_PER_MIN_CONVERSION * count;
+#if !USE_SIMULATION
+    count = 0;
+#endif
     interrupts();
 
     radiationValue = countPerMinute * CONV_FACTOR;
     radiationDose = radiationDose + (radiationValue / float(240.0));
 
-    // can optimize this calculation
-    voltage = (float) analogRead(VOLTAGER_INPUT_PIN) * VOLTAGE_FACTOR;
-
     if (radiationDose > 99.999)
     {
       radiationDose = 0;
     }
+#endif
 
+    voltage = readVoltage();
+
+#if USE_ACQUISITION
+    // Sinks get them at the next acquisition.run()
+    acquisition.sample(acqCPM);
+    acquisition.sample(acqRate);
+    acquisition.sample(acqDose);
+#else
     Serial_Display();
     OLED_Display();
+#endif
 
-#if USE_SIMULATION
+#if (USE_SIMULATION && !USE_CPM_METER)
     count += 10;
     if (count >= 1000)
       count = 0;
-#else
-    count = 0;
 #endif
 
     // report Blynk connection
@@ -348,6 +554,13 @@ void checkStatus()
   }
 }
 
+#if (USE_BLYNK_WM && USE_RUN_WATCHDOG)
+void runStalled(const BlynkRunStall& stall)
+{
+  Serial.printf("\nBlynk_WF.run() stalled %u us in %s (%u us)\n", stall.run_us, stall.site, stall.site_us);
+}
+#endif
+
 bool valid_BT_BLE_token = false;
 char BLE_Device_Name[]  = "GeigerCounter-BLE";
 char BT_Device_Name[]   = "GeigerCounter-BT";
@@ -357,8 +570,18 @@ void setup()
   Serial.begin(115200);
   Serial.println(F("\nStarting Geiger-Counter-OLED-BT-BLE-WF"));
 
+#if USE_PCNT_COUNTER
+  geigerCounter.begin();
+  geigerSnapshot = geigerCounter.snapshot();
+#else
   pinMode(GEIGER_INPUT_PIN, INPUT);
   attachInterrupt(GEIGER_INPUT_PIN, countPulse, HIGH);
+#endif
+
+#if USE_ADC_SAMPLER
+  // VOLTAGER_INPUT_PIN, GPIO36
+  adcSampler.begin(ADC1_CHANNEL_0);
+#endif
 
   if (!display.begin(SSD1306_SWITCHCAPVCC, 0x3C)) {
     Serial.println(F("SSD1306 allocation failed"));
@@ -368,12 +591,33 @@ void setup()
   delay(200);
   display.clearDisplay();
 
+#if USE_OLED_FIELDS
+  oledCPM     = oled.addField(0, 0, 6);
+  oled.addLabel(40, 0, "CPM");
+  oledDose    = oled.addField(0, 10, 6);
+  oled.addLabel(40, 10, "uSv");
+  oledVoltage = oled.addField(0, 20, 6);
+  oled.addLabel(40, 20, "V");
+  oledRate    = oled.addField(65, 10, 5, 2);
+  oled.addLabel(90, 25, "uSv/h");
+
+  // Whole screen once, only changes afterwards
+  oled.invalidate();
+  oled.update();
+
+  timer.setInterval(60000L, []() { oled.print(Serial); });
+#endif
+
   Serial.println(F("Use WiFi to connect Blynk"));
 
 #if USE_BLYNK_WM
   // Set config portal channel, defalut = 1. Use 0 => random channel from 1-13 to avoid conflict
   Blynk_WF.setConfigPortalChannel(0);
 
+#if USE_RUN_WATCHDOG
+  Blynk_WF.setRunWatchdog(RUN_WATCHDOG_BUDGET_MS, runStalled);
+#endif
+
   Blynk_WF.begin("GeigerCounter-WiFi");
 #else
   //Blynk_WF.begin(WiFi_auth, ssid, pass);
@@ -385,11 +629,11 @@ void setup()
   Blynk_BLE.setDeviceName(BLE_Device_Name);
 
 #if USE_BLYNK_WM
-  String BLE_auth = Blynk_WF.getBlynkBLEToken();
+  const char* BLE_auth = Blynk_WF.getBlynkBLEToken();
   Serial.print(F("BLE_auth = "));
   Serial.println(BLE_auth);
 
-  if (BLE_auth == NO_CONFIG)        //String("blank"))
+  if (!strcmp(BLE_auth, NO_CONFIG))        //String("blank"))
   {
     Serial.println(F("No valid stored BLE auth. Have to run WiFi then enter config portal"));
     valid_BT_BLE_token = false;
@@ -397,7 +641,7 @@ void setup()
   else
   {
     valid_BT_BLE_token = true;
-    Blynk_BLE.begin(BLE_auth.c_str());
+    Blynk_BLE.begin(BLE_auth);
   }
 
 #else
@@ -409,11 +653,11 @@ void setup()
   Blynk_BT.setDeviceName(BT_Device_Name);
 
 #if USE_BLYNK_WM
-  String BT_auth = Blynk_WF.getBlynkBTToken();
+  const char* BT_auth = Blynk_WF.getBlynkBTToken();
   Serial.print(F("BT_auth = "));
   Serial.println(BT_auth);
 
-  if (BT_auth == NO_CONFIG)        //String("blank"))
+  if (!strcmp(BT_auth, NO_CONFIG))        //String("blank"))
   {
     Serial.println(F("No valid stored BT auth. Have to run WiFi then enter config portal"));
     valid_BT_BLE_token = false;
@@ -421,7 +665,7 @@ void setup()
   else
   {
     valid_BT_BLE_token = true;
-    Blynk_BT.begin(BT_auth.c_str());
+    Blynk_BT.begin(BT_auth);
   }
 
 #else
@@ -430,7 +674,66 @@ void setup()
 
 #endif
 
+#if USE_TRANSPORT_MANAGER
+#if USE_BLE_NOT_BT
+  transports.setBTToken(BLE_auth);
+#else
+  transports.setBTToken(BT_auth);
+#endif
+#endif
+
+#if USE_TRANSPORT_MANAGER
+  transports.setActive(BLYNK_TRANSPORT_WIFI |
+                       (valid_BT_BLE_token ? (USE_BLE_NOT_BT ? BLYNK_TRANSPORT_BLE : BLYNK_TRANSPORT_BT) : 0));
+#endif
+
+#if USE_OFFLINE_QUEUE
+  BT_BLE_Queue.begin();
+  WF_Queue.begin(OFFLINE_QUEUE_DOWNSAMPLE);
+#endif
+
+#if USE_POWER_MANAGER
+  power.setMode(POWER_MODE_MODEM_SLEEP_MAX);
+  power.setPublishInterval(PUBLISH_INTERVAL_MS);
+  power.addPublisher(sendDatatoBlynk);
+  timer.setInterval(60000L, []() { power.print(Serial); });
+#elif !USE_ACQUISITION
   timer.setInterval(5000L, sendDatatoBlynk);
+#endif
+
+#if BLYNK_USE_TRACE
+  timer.setInterval(TRACE_DUMP_INTERVAL_MS, []() { BLYNK_TRACE_DUMP(Serial); BlynkTracer.clear(); });
+#endif
+
+#if USE_CPM_METER
+  // First second starts now, not at boot
+  cpmMeter.reset();
+#endif
+
+#if USE_ACQUISITION
+  // Computed by checkStatus(), which samples them
+  acqCPM      = acquisition.addChannel("cpm",   []() -> float { return countPerMinute; }, 0, V1, SENSOR_INT);
+  acqRate     = acquisition.addChannel("uSv/h", []() -> float { return radiationValue; }, 0, V3, SENSOR_FLOAT, 3);
+  acqDose     = acquisition.addChannel("uSv",   []() -> float { return radiationDose; },  0, V5, SENSOR_FLOAT, 4);
+
+  // Read on its own schedule
+  acqVoltage  = acquisition.addChannel("V", []() -> float { return readVoltage(); },
+                                       5000L, V7, SENSOR_FLOAT, 2);
+
+  acquisition.addSink(serialSink);
+  acquisition.addSink(btSink, 5000L);
+  acquisition.addSink(wfSink, 5000L);
+
+#if USE_OLED_FIELDS
+  oledSink.setField(acqCPM,     oledCPM);
+  oledSink.setField(acqRate,    oledRate);
+  oledSink.setField(acqDose,    oledDose);
+  oledSink.setField(acqVoltage, oledVoltage);
+  acquisition.addSink(oledSink);
+#endif
+
+  timer.setInterval(60000L, []() { acquisition.print(Serial); });
+#endif
 }
 
 #if (USE_BLYNK_WM && USE_DYNAMIC_PARAMETERS)
@@ -447,8 +750,16 @@ void displayCredentials(void)
 
 void loop()
 {
+  BLYNK_TRACE_SCOPE("loop");
+
+#if (USE_TRANSPORT_MANAGER && USE_FAILOVER)
+  failover.run();
+#elif USE_TRANSPORT_MANAGER
+  transports.run();
+#else
   if (valid_BT_BLE_token)
   {
+    BLYNK_TRACE_SCOPE("BT_BLE.run");
 #if USE_BLE_NOT_BT
     Blynk_BLE.run();
 #else
@@ -457,8 +768,36 @@ void loop()
   }
 
   Blynk_WF.run();
+#endif
+
+#if USE_OFFLINE_QUEUE
+  BT_BLE_Queue.run();
+  WF_Queue.run();
+#endif
+
+#if USE_POWER_MANAGER
+  power.run();
+#endif
+
+#if USE_OLED_FIELDS
+  oled.run();
+#endif
+
+  BLYNK_TRACE_BEGIN("timer.run");
   timer.run();
+  BLYNK_TRACE_END("timer.run");
+
+  BLYNK_TRACE_BEGIN("checkStatus");
   checkStatus();
+  BLYNK_TRACE_END("checkStatus");
+
+#if USE_ADC_SAMPLER
+  adcSampler.run();
+#endif
+
+#if USE_ACQUISITION
+  acquisition.run();
+#endif
 
 #if (USE_BLYNK_WM && USE_DYNAMIC_PARAMETERS)
   static bool displayedCredentials = false;
@@ -178,6 +178,16 @@ void IRAM_ATTR countPulse();
 volatile unsigned long last_micros;
 volatile long          count = 0;
 
+// Set true to count pulses with the PCNT hardware counter, instead of one interrupt per pulse
+#define USE_PCNT_COUNTER              false
+
+#if USE_PCNT_COUNTER
+#include <BlynkEsp32_PulseCounter.h>
+
+BlynkPulseCounter   geigerCounter(GEIGER_INPUT_PIN);
+BlynkPulseSnapshot  geigerSnapshot;
+#endif
+
 Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET_PIN);
 BlynkTimer timer;
 
@@ -186,10 +196,12 @@ Ticker     led_ticker;
 
 void IRAM_ATTR countPulse()
 {
-  if ((long)(micros() - last_micros) >= DEBOUNCE_TIME_MICRO_SEC)
+  unsigned long now = micros();
+
+  if ((long)(now - last_micros) >= DEBOUNCE_TIME_MICRO_SEC)
   {
     count++;
-    last_micros = micros();
+    last_micros = now;
   }
 }
 
@@ -299,8 +311,16 @@ void checkStatus()
   {
     timePreviousMeassure = millis();
 
+#if (USE_PCNT_COUNTER && !USE_SIMULATION)
+    count = geigerCounter.getCountSince(geigerSnapshot);
+#endif
+
+    // Read and clear together, else pulses counted in between are lost
     noInterrupts();
     countPerMinute = COUNT_PER_MIN_CONVERSION * count;
+#if !USE_SIMULATION
+    count = 0;
+#endif
     interrupts();
 
     radiationValue = countPerMinute * CONV_FACTOR;
@@ -321,8 +341,6 @@ void checkStatus()
     count += 10;
     if (count >= 1000)
       count = 0;
-#else
-    count = 0;
 #endif
 
       // report Blynk connection
@@ -339,8 +357,13 @@ void setup()
   Serial.begin(115200);
   Serial.println(F("\nStarting Geiger-Counter-OLED-BT-WF"));
 
+#if USE_PCNT_COUNTER
+  geigerCounter.begin();
+  geigerSnapshot = geigerCounter.snapshot();
+#else
   pinMode(GEIGER_INPUT_PIN, INPUT);
   attachInterrupt(GEIGER_INPUT_PIN, countPulse, HIGH);
+#endif
 
   if (!display.begin(SSD1306_SWITCHCAPVCC, 0x3C)) {
     Serial.println(F("SSD1306 allocation failed"));
@@ -366,11 +389,11 @@ void setup()
   Blynk_BT.setDeviceName(BT_Device_Name);
 
 #if USE_BLYNK_WM
-  String BT_auth = Blynk_WF.getBlynkBTToken();
+  const char* BT_auth = Blynk_WF.getBlynkBTToken();
   Serial.print(F("BT_auth = "));
   Serial.println(BT_auth);
 
-  if (BT_auth == NO_CONFIG)        //String("blank"))
+  if (!strcmp(BT_auth, NO_CONFIG))        //String("blank"))
   {
     Serial.println(F("No valid stored BT auth. Have to run WiFi then enter config portal"));
     valid_BT_token = false;
@@ -378,7 +401,7 @@ void setup()
   else
   {
     valid_BT_token = true;
-    Blynk_BT.begin(BT_auth.c_str());
+    Blynk_BT.begin(BT_auth);
   }
 
 #else
@@ -0,0 +1,185 @@
+/****************************************************************************************************************************
+   adc_sampler.cpp
+   Host test of <BlynkEsp32_AdcSampler.h> : noise reduction and cost per sample
+
+   Input : a constant level of 2000.3 LSB with Gaussian noise of ADC_NOISE_LSB, as the ESP32 ADC gives.
+   - Noise : rms error of raw samples, of decimated readings (sqrt(ADC_OVERSAMPLE) less) and of smoothed readings.
+   - Sampler : BlynkAdcSampler over the I2S model of mock/driver/i2s.h, run() every RUN_INTERVAL_MS. No sample may
+     be dropped, the channel bits must be masked and every ADC_OVERSAMPLE samples must give a reading.
+   - Cost : host time per sample of the decimator alone, and of run() draining full DMA buffers.
+ *****************************************************************************************************************************/
+
+#define BLYNK_PRINT             Serial
+
+#include <Arduino.h>
+#include <Blynk/BlynkDebug.h>
+#include <BlynkEsp32_AdcSampler.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#define ADC_LEVEL               2000.3
+#define ADC_NOISE_LSB           8.0
+#define NUM_SAMPLES             (1 << 22)
+#define RUN_INTERVAL_MS         10
+#define SAMPLER_SECONDS         60
+
+// Host bounds, far above the measured cost, for a loaded machine
+#define MAX_NS_DECIMATOR        20
+#define MAX_NS_RUN              50
+
+static int numFailures = 0;
+
+#define CHECK(cond)                                                           \
+  do                                                                          \
+  {                                                                           \
+    if (!(cond))                                                              \
+    {                                                                         \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+      numFailures++;                                                          \
+    }                                                                         \
+  } while (0)
+
+static std::vector<uint16_t> samples(NUM_SAMPLES);
+
+static double nsSince(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void testNoise()
+{
+  BlynkAdcDecimator decimator;
+  BlynkAdcSmoother  smoother;
+
+  double  rawSq     = 0;
+  double  decSq     = 0;
+  double  decSum    = 0;
+  double  smoothSq  = 0;
+  int     numDec    = 0;
+
+  for (size_t i = 0; i < samples.size(); i++)
+  {
+    double e = samples[i] - ADC_LEVEL;
+
+    rawSq += e * e;
+
+    if (!decimator.add(samples[i]))
+      continue;
+
+    e = decimator.get() - ADC_LEVEL;
+
+    decSq  += e * e;
+    decSum += decimator.get();
+    numDec++;
+
+    // Past the start of the average
+    double s = smoother.add(decimator.get()) - ADC_LEVEL;
+
+    if (numDec > 4 * ADC_SMOOTHING)
+      smoothSq += s * s;
+  }
+
+  double rawRms     = sqrt(rawSq / samples.size());
+  double decRms     = sqrt(decSq / numDec);
+  double smoothRms  = sqrt(smoothSq / (numDec - 4 * ADC_SMOOTHING));
+
+  printf("ADC:Noise,Raw=%.2f,Decimated=%.3f,Smoothed=%.3f,Mean=%.3f,Readings=%d\n",
+         rawRms, decRms, smoothRms, decSum / numDec, numDec);
+
+  CHECK(numDec == NUM_SAMPLES / ADC_OVERSAMPLE);
+  CHECK(fabs(rawRms - ADC_NOISE_LSB) < 0.5);
+  // sqrt(256) = 16 less, and the rounding noise of the raw samples
+  CHECK(decRms < 1.1 * sqrt(rawRms * rawRms / ADC_OVERSAMPLE));
+  CHECK(smoothRms < decRms);
+  CHECK(fabs(decSum / numDec - ADC_LEVEL) < 0.05);
+}
+
+static void testSampler()
+{
+  BlynkAdcSampler sampler;
+
+  hostI2sData = samples.data();
+  hostI2sLen  = samples.size();
+
+  CHECK(sampler.begin(ADC1_CHANNEL_6));
+
+  for (uint32_t ms = 0; ms < SAMPLER_SECONDS * 1000; ms += RUN_INTERVAL_MS)
+  {
+    delay(RUN_INTERVAL_MS);
+    sampler.run();
+  }
+
+  esp_adc_cal_characteristics_t cal;
+
+  esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, ADC_DEFAULT_VREF, &cal);
+
+  printf("ADC:Sampler,Samples=%llu,Dropped=%llu,Readings=%u,Raw=%.3f,mV=%u\n", (unsigned long long) hostI2sConsumed,
+         (unsigned long long) hostI2sDropped, sampler.getNumReadings(), sampler.getRaw(), sampler.getMillivolts());
+
+  CHECK(hostI2sDropped == 0);
+  CHECK(hostI2sConsumed == (uint64_t) SAMPLER_SECONDS * ADC_SAMPLE_RATE);
+  CHECK(sampler.getNumReadings() == hostI2sConsumed / ADC_OVERSAMPLE);
+  CHECK(fabs(sampler.getRaw() - ADC_LEVEL) < 1.0);
+  CHECK(sampler.getMillivolts() == esp_adc_cal_raw_to_voltage(2000, &cal));
+
+  sampler.end();
+
+  CHECK(!hostI2sInstalled);
+}
+
+static void testCost()
+{
+  BlynkAdcDecimator decimator;
+
+  auto      start     = std::chrono::steady_clock::now();
+  uint16_t  readings  = decimator.add(samples.data(), samples.size());
+  double    nsKernel  = nsSince(start) / samples.size();
+
+  CHECK(readings == (uint16_t) (NUM_SAMPLES / ADC_OVERSAMPLE));
+
+  // run() on full DMA buffers each time
+  BlynkAdcSampler sampler;
+
+  sampler.begin();
+
+  uint64_t dmaLen   = ADC_DMA_BUF_COUNT * ADC_DMA_BUF_LEN;
+  uint64_t fill_us  = dmaLen * 1000000 / ADC_SAMPLE_RATE;
+  double   ns       = 0;
+
+  while (hostI2sConsumed + dmaLen <= NUM_SAMPLES)
+  {
+    hostAdvance_us(fill_us);
+
+    start = std::chrono::steady_clock::now();
+    sampler.run();
+    ns   += nsSince(start);
+  }
+
+  double nsRun = ns / hostI2sConsumed;
+
+  sampler.end();
+
+  printf("ADC:Cost,nsPerSample=%.2f,runNsPerSample=%.2f\n", nsKernel, nsRun);
+
+  CHECK(nsKernel < MAX_NS_DECIMATOR);
+  CHECK(nsRun < MAX_NS_RUN);
+}
+
+int main()
+{
+  std::mt19937                      rng(1);
+  std::normal_distribution<double>  noise(ADC_LEVEL, ADC_NOISE_LSB);
+
+  for (uint16_t& sample : samples)
+    sample = (uint16_t) std::min(std::max(lround(noise(rng)), 0L), (long) ADC_RAW_MASK);
+
+  testNoise();
+  testSampler();
+  testCost();
+
+  printf("adc_sampler: %s\n", numFailures ? "FAIL" : "PASS");
+
+  return numFailures ? 1 : 0;
+}
@@ -0,0 +1,239 @@
+/****************************************************************************************************************************
+   cpm_meter.cpp
+   Host test of <BlynkEsp32_CPMMeter.h> : window sums, dead-time correction and dose integration
+
+   - Windows : random counts fed at random times, with gaps longer than the ring. Each second, the 10 s, 1 min and
+     10 min rates must equal those recomputed from a plain array of all the seconds.
+   - Dead time : Poisson trains from 0.5 to 2000 cps through a non-paralyzable tube of CPM_DEAD_TIME_US. The corrected
+     10 min rate must be within 3 sigma of the true rate, where the measured one is not at the higher rates.
+   - Dose : a constant rate gives the exact dose. The dose of the Poisson trains must be within 3 sigma of the true
+     dose, and is kept by reset().
+ *****************************************************************************************************************************/
+
+#define CPM_DEAD_TIME_US        200
+
+#include <Arduino.h>
+#include <BlynkEsp32_CPMMeter.h>
+
+#include <random>
+#include <vector>
+
+#define WINDOW_SECONDS          3000
+#define POISSON_SECONDS         700
+#define FEED_INTERVAL_MS        10
+
+static int numFailures = 0;
+
+#define CHECK(cond)                                                           \
+  do                                                                          \
+  {                                                                           \
+    if (!(cond))                                                              \
+    {                                                                         \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+      numFailures++;                                                          \
+    }                                                                         \
+  } while (0)
+
+static std::mt19937_64 rng(0xC0FFEE);
+
+static const uint16_t windowSeconds[CPM_NUM_WINDOWS] = { 10, 60, 600 };
+
+static bool near(double value, double expected, double tolerance)
+{
+  return fabs(value - expected) <= tolerance * fabs(expected) + 1e-9;
+}
+
+// CPM of a window, from all the closed seconds
+static double referenceCPM(const std::vector<uint32_t>& seconds, uint16_t length)
+{
+  uint32_t n   = (seconds.size() < length) ? seconds.size() : length;
+  uint64_t sum = 0;
+
+  for (uint32_t i = seconds.size() - n; i < seconds.size(); i++)
+    sum += (seconds[i] > 0xFFFF) ? 0xFFFF : seconds[i];
+
+  return n ? sum * 60.0 / n : 0;
+}
+
+static void testWindows()
+{
+  BlynkCPMMeter meter;
+
+  meter.setDeadTime(0);
+
+  uint64_t              start_ms = millis();
+  std::vector<uint32_t> seconds;
+  uint32_t              numBad   = 0;
+  uint32_t              numGaps  = 0;
+
+  for (uint32_t s = 0; s < WINDOW_SECONDS; s++)
+  {
+    // Calls at irregular times within the second, some seconds with none
+    while (true)
+    {
+      uint64_t now_ms = hostTime_us / 1000;
+      uint32_t index  = (now_ms - start_ms) / 1000;
+
+      // Pulses of this call go to the running second
+      uint32_t pulses = (s % 997 == 500) ? 70000 : std::uniform_int_distribution<uint32_t>(0, 1000)(rng);
+
+      meter.addPulses(pulses);
+
+      if (seconds.size() <= index)
+        seconds.resize(index + 1, 0);
+
+      seconds[index] += pulses;
+
+      uint32_t step = std::uniform_int_distribution<uint32_t>(1, 1500)(rng);
+
+      // Now and then, a gap longer than the ring
+      if (std::uniform_int_distribution<uint32_t>(0, 999)(rng) == 0)
+      {
+        step = (CPM_RING_SECONDS + 100) * 1000;
+        numGaps++;
+      }
+
+      hostAdvance_us(step * 1000ULL);
+
+      if ( (hostTime_us / 1000 - start_ms) / 1000 != index )
+        break;
+    }
+
+    meter.run();
+
+    // Closed seconds only : the running one isn't in the rates yet
+    uint32_t closed = (hostTime_us / 1000 - start_ms) / 1000;
+
+    seconds.resize(closed + 1, 0);
+
+    std::vector<uint32_t> done(seconds.begin(), seconds.begin() + closed);
+
+    for (uint8_t w = 0; w < CPM_NUM_WINDOWS; w++)
+    {
+      if (!near(meter.getCPM((BlynkCPMWindow) w), referenceCPM(done, windowSeconds[w]), 1e-6))
+        numBad++;
+    }
+
+    CHECK(meter.getSeconds() == ( (closed < CPM_RING_SECONDS - 1) ? closed : CPM_RING_SECONDS - 1 ));
+  }
+
+  printf("CPM:Windows,Seconds=%u,Gaps=%u,Bad=%u\n", (uint32_t) seconds.size(), numGaps, numBad);
+
+  CHECK(numBad == 0);
+  CHECK(numGaps > 0);
+}
+
+static void testPoisson()
+{
+  const double rates[] = { 0.5, 5, 50, 500, 2000 };
+  const double tau     = CPM_DEAD_TIME_US / 1e6;
+
+  for (double cps : rates)
+  {
+    BlynkCPMMeter meter;
+
+    std::exponential_distribution<double> interval(cps);
+
+    double    start_s   = hostTime_us / 1e6;
+    double    next_s    = start_s + interval(rng);
+    double    dead_s    = 0;
+    uint64_t  measured  = 0;
+
+    for (uint32_t ms = FEED_INTERVAL_MS; ms <= POISSON_SECONDS * 1000; ms += FEED_INTERVAL_MS)
+    {
+      double    end_s   = start_s + ms / 1000.0;
+      uint32_t  pulses  = 0;
+
+      for ( ; next_s < end_s; next_s += interval(rng))
+      {
+        // Non-paralyzable : pulses in the dead time are lost, and don't extend it
+        if (next_s >= dead_s)
+        {
+          pulses++;
+          dead_s = next_s + tau;
+        }
+      }
+
+      measured   += pulses;
+      hostTime_us = (uint64_t) (end_s * 1e6);
+
+      meter.addPulses(pulses);
+    }
+
+    meter.run();
+
+    // Over the 10 min window : sigma of the count of 600 s
+    double trueCPM     = cps * 60;
+    double sigma       = sqrt(cps * 600) * 60 / 600;
+    double corrected   = meter.getCPM(CPM_WINDOW_10MIN);
+    double uncorrected = measured * 60.0 / POISSON_SECONDS;
+
+    // All the seconds closed, not only those of the ring
+    double trueDose    = trueCPM * CPM_CONV_FACTOR * POISSON_SECONDS / 3600.0;
+    double doseSigma   = trueDose / sqrt(cps * POISSON_SECONDS);
+
+    printf("CPM:cps=%.1f,True=%.1f,Measured=%.1f,Corrected=%.1f,Sigma=%.2f,Dose=%.5f,TrueDose=%.5f\n",
+           cps, trueCPM, uncorrected, corrected, sigma, meter.getDose(), trueDose);
+
+    CHECK(fabs(corrected - trueCPM) <= 3 * sigma);
+    CHECK(fabs(meter.getDose() - trueDose) <= 3 * doseSigma + 1e-9);
+
+    if (cps * tau >= 0.05)
+      CHECK(fabs(uncorrected - trueCPM) > 3 * sigma);
+  }
+}
+
+static void testDose()
+{
+  BlynkCPMMeter meter;
+
+  meter.setDeadTime(0);
+
+  // 10 cps for an hour : 600 CPM
+  for (uint32_t s = 0; s < 3600; s++)
+  {
+    for (uint8_t i = 0; i < 10; i++)
+    {
+      meter.addPulses(1);
+      hostAdvance_us(100000);
+    }
+  }
+
+  meter.run();
+
+  printf("CPM:Dose=%.9f,CPM=%.3f\n", meter.getDose(), meter.getCPM(CPM_WINDOW_1MIN));
+
+  CHECK(near(meter.getDose(), 600 * CPM_CONV_FACTOR, 1e-9));
+  CHECK(near(meter.getDoseRate(CPM_WINDOW_10MIN), 600 * CPM_CONV_FACTOR, 1e-6));
+
+  // Rates cleared, dose kept
+  meter.reset();
+
+  CHECK(meter.getCPM(CPM_WINDOW_10S) == 0);
+  CHECK(near(meter.getDose(), 600 * CPM_CONV_FACTOR, 1e-9));
+
+  meter.resetDose();
+
+  CHECK(meter.getDose() == 0);
+
+  // Saturated tube : measured rate kept
+  meter.setDeadTime(1000);
+  meter.addPulses(1000);
+  hostAdvance_us(1000000);
+  meter.run();
+
+  CHECK(near(meter.getCPM(CPM_WINDOW_10S), 1000 * 60, 1e-6));
+}
+
+int main()
+{
+  hostTime_us = 12345678;
+
+  testWindows();
+  testPoisson();
+  testDose();
+
+  printf("cpm_meter: %s\n", numFailures ? "FAIL" : "PASS");
+
+  return numFailures ? 1 : 0;
+}
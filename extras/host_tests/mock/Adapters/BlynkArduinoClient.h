@@ -0,0 +1,71 @@
+/****************************************************************************************************************************
+   Adapters/BlynkArduinoClient.h
+   Host mock for the tests of extras/host_tests : the Blynk transport over an Arduino Client
+ *****************************************************************************************************************************/
+
+#ifndef BlynkArduinoClient_h
+#define BlynkArduinoClient_h
+
+#include <WiFiClient.h>
+
+template <typename Client>
+class BlynkArduinoClientGen
+{
+  public:
+    BlynkArduinoClientGen(Client& c)
+      : client(&c)
+    {}
+
+    void begin(const char* d, uint16_t p)
+    {
+      domain  = d;
+      port    = p;
+    }
+
+    void begin(IPAddress a, uint16_t p)
+    {
+      domain  = NULL;
+      addr    = a;
+      port    = p;
+    }
+
+    bool connect()
+    {
+      return domain ? client->connect(domain, port) : client->connect(addr, port);
+    }
+
+    void disconnect()
+    {
+      client->stop();
+    }
+
+    size_t write(const void* buf, size_t len)
+    {
+      return client->write((const uint8_t*) buf, len);
+    }
+
+    size_t read(void* buf, size_t len)
+    {
+      return client->read((uint8_t*) buf, len);
+    }
+
+    bool connected()
+    {
+      return client->connected();
+    }
+
+    int available()
+    {
+      return client->available();
+    }
+
+  protected:
+    Client*     client;
+    IPAddress   addr;
+    const char* domain  = NULL;
+    uint16_t    port    = 0;
+};
+
+typedef BlynkArduinoClientGen<Client> BlynkArduinoClient;
+
+#endif    // BlynkArduinoClient_h
@@ -0,0 +1,437 @@
+/****************************************************************************************************************************
+   Arduino.h
+   Host mock for the tests of extras/host_tests
+
+   The part of the ESP32 Arduino core the headers of src/ use, built for the host : a simulated clock, GPIO stubs,
+   FreeRTOS critical sections as mutexes, String, Print, Serial and ESP.
+   The clock only moves through delay() and hostAdvance_us(), so a test runs hours of board time in milliseconds.
+   hostRealTime switches micros() / millis() to the host clock, for the multi-threaded tests.
+ *****************************************************************************************************************************/
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <math.h>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include "HostHeap.h"
+
+#define ESP32                   1
+
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
+#define PROGMEM
+
+typedef uint8_t   byte;
+typedef bool      boolean;
+
+#define LOW                     0
+#define HIGH                    1
+#define INPUT                   0x01
+#define OUTPUT                  0x02
+#define INPUT_PULLUP            0x05
+
+#define DEC                     10
+#define HEX                     16
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Clock
+
+inline uint64_t hostTime_us   = 0;
+inline bool     hostRealTime  = false;
+
+inline uint64_t hostMicros64()
+{
+  if (hostRealTime)
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+  return hostTime_us;
+}
+
+inline void hostAdvance_us(uint64_t us)
+{
+  hostTime_us += us;
+}
+
+inline uint32_t micros()
+{
+  return (uint32_t) hostMicros64();
+}
+
+inline uint32_t millis()
+{
+  return (uint32_t) (hostMicros64() / 1000);
+}
+
+inline void delayMicroseconds(uint32_t us)
+{
+  if (hostRealTime)
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+  else
+    hostAdvance_us(us);
+}
+
+inline void delay(uint32_t ms)
+{
+  delayMicroseconds(ms * 1000);
+}
+
+inline void yield()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// GPIO and random
+
+inline uint8_t hostPinLevel[40];
+
+inline void pinMode(uint8_t pin, uint8_t mode)
+{
+  (void) pin;
+  (void) mode;
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t level)
+{
+  if (pin < sizeof(hostPinLevel))
+    hostPinLevel[pin] = level;
+}
+
+inline int digitalRead(uint8_t pin)
+{
+  return (pin < sizeof(hostPinLevel)) ? hostPinLevel[pin] : LOW;
+}
+
+inline uint32_t hostRandomSeed = 1;
+
+inline void randomSeed(uint32_t seed)
+{
+  hostRandomSeed = seed ? seed : 1;
+}
+
+inline long random(long howBig)
+{
+  if (howBig <= 0)
+    return 0;
+
+  hostRandomSeed ^= hostRandomSeed << 13;
+  hostRandomSeed ^= hostRandomSeed >> 17;
+  hostRandomSeed ^= hostRandomSeed << 5;
+
+  return hostRandomSeed % howBig;
+}
+
+inline long random(long howSmall, long howBig)
+{
+  return (howSmall >= howBig) ? howSmall : howSmall + random(howBig - howSmall);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// FreeRTOS critical sections : one mutex per portMUX_TYPE, ISRs never run on the host
+
+typedef struct
+{
+  std::mutex lock;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED  {}
+
+#define portENTER_CRITICAL(mux)       (mux)->lock.lock()
+#define portEXIT_CRITICAL(mux)        (mux)->lock.unlock()
+#define portENTER_CRITICAL_ISR(mux)   portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_ISR(mux)    portEXIT_CRITICAL(mux)
+
+inline bool xPortInIsrContext()
+{
+  return false;
+}
+
+// Core of the calling thread : the loop task's by default
+inline thread_local int hostCoreID = 1;
+
+inline int xPortGetCoreID()
+{
+  return hostCoreID;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Flash strings are plain strings on the host
+
+class __FlashStringHelper;
+
+#define F(text)                 ( (const __FlashStringHelper*) (text) )
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// String, on the heap as in the core : short ones in the object, longer ones allocated
+
+class String
+{
+  public:
+    String(const char* text = "")
+    {
+      assign(text ? text : "", text ? strlen(text) : 0);
+    }
+
+    String(const String& other)
+    {
+      assign(other.c_str(), other.len);
+    }
+
+    String(const __FlashStringHelper* text)
+    {
+      assign((const char*) text, strlen((const char*) text));
+    }
+
+    explicit String(int value)
+    {
+      char text[12];
+
+      snprintf(text, sizeof(text), "%d", value);
+      assign(text, strlen(text));
+    }
+
+    ~String()
+    {
+      release();
+    }
+
+    String& operator = (const String& other)
+    {
+      if (this != &other)
+      {
+        release();
+        assign(other.c_str(), other.len);
+      }
+
+      return *this;
+    }
+
+    String& operator = (const char* text)
+    {
+      String copy(text);
+
+      return (*this = copy);
+    }
+
+    String& operator += (const char* text)
+    {
+      size_t    textLen = strlen(text);
+      String    joined;
+
+      joined.release();
+      joined.reserve(len + textLen);
+      memcpy(joined.data(), c_str(), len);
+      memcpy(joined.data() + len, text, textLen + 1);
+      joined.len = len + textLen;
+
+      return (*this = joined);
+    }
+
+    String& operator += (const String& other)
+    {
+      return (*this += other.c_str());
+    }
+
+    bool operator == (const char* text) const
+    {
+      return !strcmp(c_str(), text);
+    }
+
+    bool operator == (const String& other) const
+    {
+      return !strcmp(c_str(), other.c_str());
+    }
+
+    bool operator != (const char* text) const
+    {
+      return !(*this == text);
+    }
+
+    const char* c_str() const
+    {
+      return heap ? heap : sso;
+    }
+
+    unsigned int length() const
+    {
+      return len;
+    }
+
+    long toInt() const
+    {
+      return atol(c_str());
+    }
+
+  private:
+    static const size_t SSO_LEN = 11;
+
+    char    sso[SSO_LEN + 1];
+    char*   heap = NULL;
+    size_t  len  = 0;
+
+    char* data()
+    {
+      return heap ? heap : sso;
+    }
+
+    void reserve(size_t size)
+    {
+      heap = (size > SSO_LEN) ? new char[size + 1] : NULL;
+    }
+
+    void assign(const char* text, size_t textLen)
+    {
+      reserve(textLen);
+      memcpy(data(), text, textLen);
+      data()[textLen] = 0;
+      len = textLen;
+    }
+
+    void release()
+    {
+      delete[] heap;
+      heap  = NULL;
+      len   = 0;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Print
+
+class Print;
+
+class Printable
+{
+  public:
+    virtual ~Printable() {}
+    virtual size_t printTo(Print& out) const = 0;
+};
+
+class Print
+{
+  public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t c) = 0;
+
+    virtual size_t write(const uint8_t* buf, size_t size)
+    {
+      size_t n = 0;
+
+      while (size--)
+        n += write(*buf++);
+
+      return n;
+    }
+
+    size_t write(const char* text)
+    {
+      return write((const uint8_t*) text, strlen(text));
+    }
+
+    size_t print(const char* text)                  { return write(text); }
+    size_t print(const __FlashStringHelper* text)   { return write((const char*) text); }
+    size_t print(const String& text)                { return write(text.c_str()); }
+    size_t print(char c)                            { return write((uint8_t) c); }
+    size_t print(const Printable& value)            { return value.printTo(*this); }
+
+    size_t print(int value, int base = DEC)           { return print((long) value, base); }
+    size_t print(unsigned int value, int base = DEC)  { return print((unsigned long) value, base); }
+    size_t print(long value, int base = DEC)          { return (base == DEC) ? printf("%ld", value) : print((unsigned long) value, base); }
+    size_t print(unsigned long value, int base = DEC) { return printf( (base == HEX) ? "%lX" : "%lu", value); }
+    size_t print(long long value)                     { return printf("%lld", value); }
+    size_t print(unsigned long long value)            { return printf("%llu", value); }
+    size_t print(double value, int digits = 2)        { return printf("%.*f", digits, value); }
+
+    template <typename T>
+    size_t println(const T& value)
+    {
+      return print(value) + println();
+    }
+
+    template <typename T>
+    size_t println(const T& value, int format)
+    {
+      return print(value, format) + println();
+    }
+
+    size_t println()
+    {
+      return write("\r\n");
+    }
+
+    template <typename... Args>
+    size_t printf(const char* format, Args... args)
+    {
+      char text[64];
+      int  n = snprintf(text, sizeof(text), format, args...);
+
+      return (n > 0) ? write((const uint8_t*) text, strnlen(text, sizeof(text) - 1)) : 0;
+    }
+};
+
+// Serial : to stdout, or nowhere with hostQuiet
+inline bool hostQuiet = false;
+
+class HardwareSerial : public Print
+{
+  public:
+    void begin(uint32_t baud)
+    {
+      (void) baud;
+    }
+
+    using Print::write;
+
+    size_t write(uint8_t c)
+    {
+      if (!hostQuiet)
+        putchar(c);
+
+      return 1;
+    }
+
+    operator bool ()
+    {
+      return true;
+    }
+};
+
+inline HardwareSerial Serial;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ESP
+
+class EspClass
+{
+  public:
+    uint32_t  numRestarts = 0;
+    uint64_t  efuseMac    = 0x2462ABCDEF01ULL;
+
+    uint64_t getEfuseMac()
+    {
+      return efuseMac;
+    }
+
+    uint32_t getFreeHeap()
+    {
+      return HOST_HEAP_FREE();
+    }
+
+    // Returns on the host : the test sees it in numRestarts
+    void restart()
+    {
+      numRestarts++;
+    }
+};
+
+inline EspClass ESP;
+
+#endif    // Arduino_h
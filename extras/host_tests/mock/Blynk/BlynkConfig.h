@@ -0,0 +1,35 @@
+/****************************************************************************************************************************
+   Blynk/BlynkConfig.h
+   Host mock for the tests of extras/host_tests : the defaults of Blynk 0.6.1 used by src/
+ *****************************************************************************************************************************/
+
+#ifndef BlynkConfig_h
+#define BlynkConfig_h
+
+#define BLYNK_VERSION           "0.6.1"
+
+#ifndef BLYNK_DEFAULT_DOMAIN
+#define BLYNK_DEFAULT_DOMAIN    "blynk-cloud.com"
+#endif
+
+#ifndef BLYNK_DEFAULT_PORT
+#define BLYNK_DEFAULT_PORT      80
+#endif
+
+#ifndef BLYNK_TIMEOUT_MS
+#define BLYNK_TIMEOUT_MS        10000UL
+#endif
+
+#ifndef BLYNK_HEARTBEAT
+#define BLYNK_HEARTBEAT         10
+#endif
+
+#ifndef BLYNK_MAX_READBYTES
+#define BLYNK_MAX_READBYTES     256
+#endif
+
+#ifndef BLYNK_MAX_SENDBYTES
+#define BLYNK_MAX_SENDBYTES     128
+#endif
+
+#endif    // BlynkConfig_h
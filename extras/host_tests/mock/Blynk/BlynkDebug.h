@@ -0,0 +1,46 @@
+/****************************************************************************************************************************
+   Blynk/BlynkDebug.h
+   Host mock for the tests of extras/host_tests : BLYNK_LOGx() print to BLYNK_PRINT when defined, as in Blynk 0.6.1
+ *****************************************************************************************************************************/
+
+#ifndef BlynkDebug_h
+#define BlynkDebug_h
+
+#include <Arduino.h>
+
+#define BLYNK_F(text)           F(text)
+
+#define BlynkDelay(ms)          delay(ms)
+
+#ifdef BLYNK_PRINT
+
+template <typename... Args>
+inline void blynkLogHost(const Args&... args)
+{
+  BLYNK_PRINT.print('[');
+  BLYNK_PRINT.print(millis());
+  BLYNK_PRINT.print(F("] "));
+
+  int dummy[] = { 0, ( (void) BLYNK_PRINT.print(args), 0 )... };
+  (void) dummy;
+
+  BLYNK_PRINT.println();
+}
+
+#define BLYNK_LOG1(p1)                      blynkLogHost(p1)
+#define BLYNK_LOG2(p1, p2)                  blynkLogHost(p1, p2)
+#define BLYNK_LOG3(p1, p2, p3)              blynkLogHost(p1, p2, p3)
+#define BLYNK_LOG4(p1, p2, p3, p4)          blynkLogHost(p1, p2, p3, p4)
+#define BLYNK_LOG6(p1, p2, p3, p4, p5, p6)  blynkLogHost(p1, p2, p3, p4, p5, p6)
+
+#else
+
+#define BLYNK_LOG1(p1)                      do {} while (0)
+#define BLYNK_LOG2(p1, p2)                  do {} while (0)
+#define BLYNK_LOG3(p1, p2, p3)              do {} while (0)
+#define BLYNK_LOG4(p1, p2, p3, p4)          do {} while (0)
+#define BLYNK_LOG6(p1, p2, p3, p4, p5, p6)  do {} while (0)
+
+#endif    // BLYNK_PRINT
+
+#endif    // BlynkDebug_h
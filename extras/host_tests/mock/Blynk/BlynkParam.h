@@ -0,0 +1,87 @@
+/****************************************************************************************************************************
+   Blynk/BlynkParam.h
+   Host mock for the tests of extras/host_tests : the encoding side of BlynkParam in Blynk 0.6.1. Values are added
+   with their terminating 0, and a value that doesn't fit the buffer is silently left out, as there.
+ *****************************************************************************************************************************/
+
+#ifndef BlynkParam_h
+#define BlynkParam_h
+
+#include <Arduino.h>
+
+class BlynkParam
+{
+  public:
+    BlynkParam(void* addr, size_t length, size_t buffsize)
+      : buff((char*) addr)
+      , len(length)
+      , buff_size(buffsize)
+    {}
+
+    const char* getBuffer() const
+    {
+      return buff;
+    }
+
+    size_t getLength() const
+    {
+      return len;
+    }
+
+    void add(const void* b, size_t l)
+    {
+      if (len + l > buff_size)
+        return;
+
+      memcpy(buff + len, b, l);
+      len += l;
+    }
+
+    void add(const char* str)
+    {
+      add(str, strlen(str) + 1);
+    }
+
+    void add(const String& str)
+    {
+      add(str.c_str());
+    }
+
+    void add(int value)                 { addFormat("%i", value);   }
+    void add(unsigned int value)        { addFormat("%u", value);   }
+    void add(long value)                { addFormat("%li", value);  }
+    void add(unsigned long value)       { addFormat("%lu", value);  }
+    void add(long long value)           { addFormat("%lli", value); }
+    void add(unsigned long long value)  { addFormat("%llu", value); }
+    void add(float value)               { addFormat("%.3f", value); }
+    void add(double value)              { addFormat("%.7f", value); }
+
+    template <typename T>
+    void add_multi(T last)
+    {
+      add(last);
+    }
+
+    template <typename T, typename... Args>
+    void add_multi(T head, Args... tail)
+    {
+      add(head);
+      add_multi(tail...);
+    }
+
+  private:
+    char*   buff;
+    size_t  len;
+    size_t  buff_size;
+
+    template <typename T>
+    void addFormat(const char* format, T value)
+    {
+      char text[24];
+
+      snprintf(text, sizeof(text), format, value);
+      add(text);
+    }
+};
+
+#endif    // BlynkParam_h
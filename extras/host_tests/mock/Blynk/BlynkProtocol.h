@@ -0,0 +1,86 @@
+/****************************************************************************************************************************
+   Blynk/BlynkProtocol.h
+   Host mock for the tests of extras/host_tests. Login succeeds when the transport connects, commands are counted.
+ *****************************************************************************************************************************/
+
+#ifndef BlynkProtocol_h
+#define BlynkProtocol_h
+
+#include <Arduino.h>
+#include <Blynk/BlynkConfig.h>
+#include <Blynk/BlynkProtocolDefs.h>
+#include <Blynk/BlynkDebug.h>
+
+template <class Transp>
+class BlynkProtocol
+{
+  public:
+    uint32_t numLogins    = 0;
+    uint32_t numCommands  = 0;
+
+    BlynkProtocol(Transp& transp)
+      : conn(transp)
+    {}
+
+    void begin(const char* auth)
+    {
+      authkey = auth;
+    }
+
+    bool connect(uint32_t timeout = BLYNK_TIMEOUT_MS * 3)
+    {
+      (void) timeout;
+
+      conn.disconnect();
+
+      if (!conn.connect())
+        return false;
+
+      numLogins++;
+      isConnected = true;
+
+      return true;
+    }
+
+    bool connected()
+    {
+      return isConnected && conn.connected();
+    }
+
+    void disconnect()
+    {
+      conn.disconnect();
+      isConnected = false;
+    }
+
+    bool run(bool avail = false)
+    {
+      (void) avail;
+
+      if (isConnected && !conn.connected())
+        isConnected = false;
+
+      return isConnected;
+    }
+
+    void sendCmd(uint8_t cmd, uint16_t id = 0, const void* data = NULL, size_t length = 0,
+                 const void* data2 = NULL, size_t length2 = 0)
+    {
+      (void) cmd;
+      (void) id;
+      (void) data;
+      (void) data2;
+
+      if (connected())
+        numCommands++;
+
+      conn.write(NULL, length + length2);
+    }
+
+  protected:
+    Transp&     conn;
+    const char* authkey     = NULL;
+    bool        isConnected = false;
+};
+
+#endif    // BlynkProtocol_h
@@ -0,0 +1,38 @@
+/****************************************************************************************************************************
+   Blynk/BlynkProtocolDefs.h
+   Host mock for the tests of extras/host_tests : the command codes of Blynk 0.6.1
+ *****************************************************************************************************************************/
+
+#ifndef BlynkProtocolDefs_h
+#define BlynkProtocolDefs_h
+
+#include <stdint.h>
+
+enum BlynkCmd
+{
+  BLYNK_CMD_RESPONSE       = 0,
+  BLYNK_CMD_LOGIN          = 2,
+  BLYNK_CMD_PING           = 6,
+  BLYNK_CMD_TWEET          = 12,
+  BLYNK_CMD_EMAIL          = 13,
+  BLYNK_CMD_NOTIFY         = 14,
+  BLYNK_CMD_BRIDGE         = 15,
+  BLYNK_CMD_HARDWARE_SYNC  = 16,
+  BLYNK_CMD_INTERNAL       = 17,
+  BLYNK_CMD_SMS            = 18,
+  BLYNK_CMD_PROPERTY       = 19,
+  BLYNK_CMD_HARDWARE       = 20,
+  BLYNK_CMD_REDIRECT       = 41,
+  BLYNK_CMD_DEBUG_PRINT    = 55,
+  BLYNK_CMD_EVENT_LOG      = 64
+};
+
+enum BlynkStatus
+{
+  BLYNK_SUCCESS            = 200,
+  BLYNK_TIMEOUT            = 1,
+  BLYNK_INVALID_TOKEN      = 9,
+  BLYNK_NOT_ALLOWED        = 6
+};
+
+#endif    // BlynkProtocolDefs_h
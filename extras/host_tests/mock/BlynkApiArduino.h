@@ -0,0 +1,12 @@
+/****************************************************************************************************************************
+   BlynkApiArduino.h
+   Host mock for the tests of extras/host_tests : the Blynk API itself is not exercised
+ *****************************************************************************************************************************/
+
+#ifndef BlynkApiArduino_h
+#define BlynkApiArduino_h
+
+#include <Arduino.h>
+#include <Blynk/BlynkConfig.h>
+
+#endif    // BlynkApiArduino_h
@@ -0,0 +1,9 @@
+/****************************************************************************************************************************
+   BlynkWidgets.h
+   Host mock for the tests of extras/host_tests : no widgets
+ *****************************************************************************************************************************/
+
+#ifndef BlynkWidgets_h
+#define BlynkWidgets_h
+
+#endif    // BlynkWidgets_h
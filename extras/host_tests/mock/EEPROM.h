@@ -0,0 +1,73 @@
+/****************************************************************************************************************************
+   EEPROM.h
+   Host mock for the tests of extras/host_tests. Same bounds as the core : accesses past the size given to begin()
+   are ignored.
+ *****************************************************************************************************************************/
+
+#ifndef EEPROM_h
+#define EEPROM_h
+
+#include <Arduino.h>
+
+#define HOST_EEPROM_MAX_SIZE    4096
+
+class EEPROMClass
+{
+  public:
+    uint32_t numCommits = 0;
+
+    bool begin(size_t size)
+    {
+      length = (size > HOST_EEPROM_MAX_SIZE) ? HOST_EEPROM_MAX_SIZE : size;
+      return true;
+    }
+
+    uint8_t read(int address)
+    {
+      return ( (address >= 0) && ((size_t) address < length) ) ? data[address] : 0;
+    }
+
+    void write(int address, uint8_t value)
+    {
+      if ( (address >= 0) && ((size_t) address < length) )
+        data[address] = value;
+    }
+
+    template <typename T>
+    T& get(int address, T& value)
+    {
+      if ( (address >= 0) && (address + sizeof(T) <= length) )
+        memcpy((void*) &value, data + address, sizeof(T));
+
+      return value;
+    }
+
+    template <typename T>
+    const T& put(int address, const T& value)
+    {
+      if ( (address >= 0) && (address + sizeof(T) <= length) )
+        memcpy(data + address, (const void*) &value, sizeof(T));
+
+      return value;
+    }
+
+    bool commit()
+    {
+      numCommits++;
+      return true;
+    }
+
+    // Erased flash
+    void hostErase()
+    {
+      memset(data, 0xFF, sizeof(data));
+    }
+
+  private:
+    uint8_t data[HOST_EEPROM_MAX_SIZE];
+    size_t  length = 0;
+};
+
+inline EEPROMClass EEPROM;
+
+#endif    // EEPROM_h
@@ -0,0 +1,182 @@
+/****************************************************************************************************************************
+   FS.h
+   Host mock for the tests of extras/host_tests
+
+   Files of the ESP32 core FS API, kept in memory in hostFiles. seek() past the end fails, as on SPIFFS.
+   hostFsFailReads / hostFsFailWrites make the next reads / writes fail, like a bad sector. hostFsNumWrites counts the
+   bytes written, for the flash wear.
+ *****************************************************************************************************************************/
+
+#ifndef FS_h
+#define FS_h
+
+#include <Arduino.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+inline std::map<std::string, std::vector<uint8_t>>  hostFiles;
+inline uint32_t                                     hostFsFailReads   = 0;
+inline uint32_t                                     hostFsFailWrites  = 0;
+inline uint64_t                                     hostFsNumWrites   = 0;
+
+namespace fs
+{
+  enum SeekMode
+  {
+    SeekSet = 0,
+    SeekCur = 1,
+    SeekEnd = 2
+  };
+
+  class File
+  {
+    public:
+      File()
+      {}
+
+      File(const char* path, bool writable)
+        : name(path)
+        , open(true)
+        , canWrite(writable)
+      {}
+
+      operator bool () const
+      {
+        return open;
+      }
+
+      size_t write(const uint8_t* buf, size_t size)
+      {
+        if (!open || !canWrite)
+          return 0;
+
+        if (hostFsFailWrites)
+        {
+          hostFsFailWrites--;
+          return 0;
+        }
+
+        std::vector<uint8_t>& data = hostFiles[name];
+
+        if (pos + size > data.size())
+          data.resize(pos + size);
+
+        memcpy(data.data() + pos, buf, size);
+        pos             += size;
+        hostFsNumWrites += size;
+
+        return size;
+      }
+
+      size_t write(uint8_t c)
+      {
+        return write(&c, 1);
+      }
+
+      size_t read(uint8_t* buf, size_t size)
+      {
+        if (!open)
+          return 0;
+
+        if (hostFsFailReads)
+        {
+          hostFsFailReads--;
+          return 0;
+        }
+
+        std::vector<uint8_t>& data = hostFiles[name];
+
+        if (pos + size > data.size())
+          size = data.size() - pos;
+
+        memcpy(buf, data.data() + pos, size);
+        pos += size;
+
+        return size;
+      }
+
+      bool seek(uint32_t offset, SeekMode mode = SeekSet)
+      {
+        size_t length = size();
+        size_t target = (mode == SeekSet) ? offset : ( (mode == SeekCur) ? pos + offset : length + offset );
+
+        if (!open || (target > length))
+          return false;
+
+        pos = target;
+        return true;
+      }
+
+      size_t position() const
+      {
+        return pos;
+      }
+
+      size_t size() const
+      {
+        return open ? hostFiles[name].size() : 0;
+      }
+
+      void close()
+      {
+        open = false;
+      }
+
+    private:
+      std::string name;
+      bool        open      = false;
+      bool        canWrite  = false;
+      size_t      pos       = 0;
+  };
+
+  class FS
+  {
+    public:
+      bool begin(bool formatOnFail = false)
+      {
+        return true;
+      }
+
+      // "r", "r+", "w" and "a" as fopen()
+      File open(const char* path, const char* mode = "r")
+      {
+        bool exists = (hostFiles.count(path) != 0);
+
+        if ( (mode[0] == 'r') && !exists )
+          return File();
+
+        if (mode[0] == 'w')
+          hostFiles[path].clear();
+        else if (!exists)
+          hostFiles[path];
+
+        File file(path, (mode[0] != 'r') || (mode[1] == '+'));
+
+        if (mode[0] == 'a')
+          file.seek(0, SeekEnd);
+
+        return file;
+      }
+
+      bool exists(const char* path)
+      {
+        return hostFiles.count(path) != 0;
+      }
+
+      bool remove(const char* path)
+      {
+        return hostFiles.erase(path) != 0;
+      }
+  };
+}
+
+using fs::FS;
+using fs::File;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
+
+#endif    // FS_h
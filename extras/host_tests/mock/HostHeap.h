@@ -0,0 +1,184 @@
+/****************************************************************************************************************************
+   HostHeap.h
+   Host mock for the tests of extras/host_tests
+
+   Model of the ESP32 heap : a first-fit allocator over a fixed arena, with block headers and coalescing, so free size
+   and largest free block move as those of heap_caps_* on the board, fragmentation included. Define HOST_HEAP_SIZE
+   before the first include of <Arduino.h> to use it : it then replaces the global operator new / delete of the test.
+   Not thread-safe, for single-threaded tests only.
+ *****************************************************************************************************************************/
+
+#ifndef HostHeap_h
+#define HostHeap_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+
+#ifdef HOST_HEAP_SIZE
+
+namespace HostHeap
+{
+  // Header of each block, payload follows. size includes the header.
+  typedef struct
+  {
+    uint32_t  size;
+    uint32_t  used;
+  } Block;
+
+  const uint32_t HEADER = sizeof(Block);
+
+  alignas(16) inline uint8_t  arena[HOST_HEAP_SIZE];
+  inline bool                 ready     = false;
+  inline uint32_t             numAllocs = 0;
+  inline uint32_t             liveBytes = 0;
+  inline uint32_t             peakBytes = 0;
+
+  inline Block* first()
+  {
+    if (!ready)
+    {
+      Block* block = (Block*) arena;
+
+      block->size = HOST_HEAP_SIZE;
+      block->used = 0;
+      ready       = true;
+    }
+
+    return (Block*) arena;
+  }
+
+  inline Block* next(Block* block)
+  {
+    uint8_t* p = (uint8_t*) block + block->size;
+
+    return (p < arena + HOST_HEAP_SIZE) ? (Block*) p : NULL;
+  }
+
+  inline void* alloc(size_t n)
+  {
+    uint32_t need = ( ( (uint32_t) n + 7 ) & ~7U ) + HEADER;
+
+    for (Block* block = first(); block; block = next(block))
+    {
+      if (block->used || (block->size < need))
+        continue;
+
+      // Split, unless the rest is too small to hold anything
+      if (block->size - need >= 2 * HEADER)
+      {
+        Block* rest = (Block*) ( (uint8_t*) block + need );
+
+        rest->size  = block->size - need;
+        rest->used  = 0;
+        block->size = need;
+      }
+
+      block->used = 1;
+
+      numAllocs++;
+      liveBytes += block->size - HEADER;
+
+      if (liveBytes > peakBytes)
+        peakBytes = liveBytes;
+
+      return (uint8_t*) block + HEADER;
+    }
+
+    return NULL;
+  }
+
+  inline void release(void* p)
+  {
+    if (!p)
+      return;
+
+    Block* block = (Block*) ( (uint8_t*) p - HEADER );
+
+    block->used = 0;
+    liveBytes  -= block->size - HEADER;
+
+    // Merge runs of free blocks
+    for (Block* b = first(); b; b = next(b))
+    {
+      Block* n;
+
+      while ( !b->used && (n = next(b)) && !n->used )
+        b->size += n->size;
+    }
+  }
+
+  inline uint32_t getFree()
+  {
+    uint32_t total = 0;
+
+    for (Block* block = first(); block; block = next(block))
+    {
+      if (!block->used)
+        total += block->size - HEADER;
+    }
+
+    return total;
+  }
+
+  inline uint32_t getLargestFree()
+  {
+    uint32_t largest = 0;
+
+    for (Block* block = first(); block; block = next(block))
+    {
+      if (!block->used && (block->size - HEADER > largest))
+        largest = block->size - HEADER;
+    }
+
+    return largest;
+  }
+}
+
+void* operator new(size_t n)
+{
+  void* p = HostHeap::alloc(n);
+
+  if (!p)
+    throw std::bad_alloc();
+
+  return p;
+}
+
+void* operator new[](size_t n)
+{
+  return operator new(n);
+}
+
+void operator delete(void* p) noexcept
+{
+  HostHeap::release(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+  HostHeap::release(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+  HostHeap::release(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+  HostHeap::release(p);
+}
+
+#define HOST_HEAP_FREE()          HostHeap::getFree()
+#define HOST_HEAP_LARGEST_FREE()  HostHeap::getLargestFree()
+
+#else
+
+// No model : a constant heap, enough for BlynkHeapAudit to compile
+#define HOST_HEAP_FREE()          200000U
+#define HOST_HEAP_LARGEST_FREE()  110000U
+
+#endif    // HOST_HEAP_SIZE
+
+#endif    // HostHeap_h
@@ -0,0 +1,53 @@
+/****************************************************************************************************************************
+   IPAddress.h
+   Host mock for the tests of extras/host_tests
+ *****************************************************************************************************************************/
+
+#ifndef IPAddress_h
+#define IPAddress_h
+
+#include <Arduino.h>
+
+class IPAddress : public Printable
+{
+  public:
+    IPAddress(uint32_t address = 0)
+      : addr(address)
+    {}
+
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+      : addr( a | (b << 8) | (c << 16) | ((uint32_t) d << 24) )
+    {}
+
+    operator uint32_t () const
+    {
+      return addr;
+    }
+
+    bool operator == (const IPAddress& other) const
+    {
+      return addr == other.addr;
+    }
+
+    bool operator != (const IPAddress& other) const
+    {
+      return addr != other.addr;
+    }
+
+    uint8_t operator [] (int index) const
+    {
+      return (addr >> (index * 8)) & 0xFF;
+    }
+
+    size_t printTo(Print& out) const
+    {
+      return out.printf("%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+    }
+
+  private:
+    uint32_t addr;
+};
+
+inline const IPAddress INADDR_NONE(0, 0, 0, 0);
+
+#endif    // IPAddress_h
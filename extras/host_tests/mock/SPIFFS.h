@@ -0,0 +1,26 @@
+/****************************************************************************************************************************
+   SPIFFS.h
+   Host mock for the tests of extras/host_tests
+ *****************************************************************************************************************************/
+
+#ifndef SPIFFS_h
+#define SPIFFS_h
+
+#include "FS.h"
+
+namespace fs
+{
+  class SPIFFSFS : public FS
+  {
+    public:
+      bool format()
+      {
+        hostFiles.clear();
+        return true;
+      }
+  };
+}
+
+inline fs::SPIFFSFS SPIFFS;
+
+#endif    // SPIFFS_h
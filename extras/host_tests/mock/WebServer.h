@@ -0,0 +1,154 @@
+/****************************************************************************************************************************
+   WebServer.h
+   Host mock for the tests of extras/host_tests
+
+   Requests are queued by the test with hostRequest() and served by handleClient(). As in the core, the server keeps
+   some state on the heap while it exists, and the args of a request are Strings that live until it is served.
+   The response is only measured : status, bytes, chunks and whether the last, empty chunk was sent.
+ *****************************************************************************************************************************/
+
+#ifndef WebServer_h
+#define WebServer_h
+
+#include <Arduino.h>
+#include <functional>
+
+#define CONTENT_LENGTH_UNKNOWN  ((size_t) -1)
+
+#define HOST_WEB_MAX_HANDLERS   4
+#define HOST_WEB_STATE_LEN      512
+
+typedef struct
+{
+  int       code;
+  size_t    bytes;
+  uint32_t  chunks;
+  bool      ended;
+} HostResponse;
+
+class WebServer;
+
+// The WebServer that exists, if any
+inline WebServer* hostWebServer = NULL;
+
+class WebServer
+{
+  public:
+    typedef std::function<void(void)> THandlerFunction;
+
+    HostResponse response;
+
+    WebServer(int port = 80)
+    {
+      (void) port;
+      state         = new uint8_t[HOST_WEB_STATE_LEN];
+      hostWebServer = this;
+    }
+
+    ~WebServer()
+    {
+      delete[] state;
+      hostWebServer = NULL;
+    }
+
+    void on(const char* uri, THandlerFunction handler)
+    {
+      if (numHandlers < HOST_WEB_MAX_HANDLERS)
+      {
+        uris[numHandlers]     = uri;
+        handlers[numHandlers] = handler;
+        numHandlers++;
+      }
+    }
+
+    void begin()
+    {
+    }
+
+    void stop()
+    {
+    }
+
+    // Queues one request, served by the next handleClient()
+    void hostRequest(const char* uri, const char* key = NULL, const char* value = NULL)
+    {
+      pendingUri    = uri;
+      pendingKey    = key;
+      pendingValue  = value;
+    }
+
+    void handleClient()
+    {
+      if (!pendingUri)
+        return;
+
+      const char* uri = pendingUri;
+
+      pendingUri = NULL;
+      memset(&response, 0, sizeof(response));
+
+      String key(pendingKey ? pendingKey : "");
+      String value(pendingValue ? pendingValue : "");
+
+      currentKey    = &key;
+      currentValue  = &value;
+
+      for (uint8_t i = 0; i < numHandlers; i++)
+      {
+        if (!strcmp(uris[i], uri))
+          handlers[i]();
+      }
+
+      currentKey    = NULL;
+      currentValue  = NULL;
+    }
+
+    String arg(const String& name)
+    {
+      if (currentKey && (name == "key"))
+        return *currentKey;
+
+      if (currentValue && (name == "value"))
+        return *currentValue;
+
+      return String();
+    }
+
+    void setContentLength(size_t length)
+    {
+      (void) length;
+    }
+
+    void send(int code, const char* contentType, const String& content)
+    {
+      (void) contentType;
+
+      response.code   = code;
+      response.bytes  = content.length();
+    }
+
+    void sendContent_P(const char* content, size_t size)
+    {
+      (void) content;
+
+      if (!size)
+        response.ended = true;
+
+      response.bytes += size;
+      response.chunks++;
+    }
+
+  private:
+    uint8_t*          state;
+    const char*       uris[HOST_WEB_MAX_HANDLERS];
+    THandlerFunction  handlers[HOST_WEB_MAX_HANDLERS];
+    uint8_t           numHandlers = 0;
+
+    const char*       pendingUri    = NULL;
+    const char*       pendingKey    = NULL;
+    const char*       pendingValue  = NULL;
+    String*           currentKey    = NULL;
+    String*           currentValue  = NULL;
+};
+
+#endif    // WebServer_h
@@ -0,0 +1,294 @@
+/****************************************************************************************************************************
+   WiFi.h
+   Host mock for the tests of extras/host_tests
+
+   A simulated radio environment : the test fills hostAPs with the access points in range. begin() associates with one
+   of them, immediately. Scans are asynchronous as on the board : scanComplete() reports WIFI_SCAN_RUNNING for a few
+   polls, then the results, allocated on the heap until scanDelete() as the core does.
+ *****************************************************************************************************************************/
+
+#ifndef WiFi_h
+#define WiFi_h
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#include <esp_wifi.h>
+
+#include "WiFiClient.h"
+
+typedef enum
+{
+  WL_IDLE_STATUS      = 0,
+  WL_NO_SSID_AVAIL    = 1,
+  WL_SCAN_COMPLETED   = 2,
+  WL_CONNECTED        = 3,
+  WL_CONNECT_FAILED   = 4,
+  WL_CONNECTION_LOST  = 5,
+  WL_DISCONNECTED     = 6
+} wl_status_t;
+
+typedef enum
+{
+  WIFI_OFF,
+  WIFI_STA,
+  WIFI_AP,
+  WIFI_AP_STA
+} wifi_mode_t;
+
+#define WIFI_SCAN_RUNNING       (-1)
+#define WIFI_SCAN_FAILED        (-2)
+
+// Polls of scanComplete() an asynchronous scan takes
+#define HOST_SCAN_POLLS         3
+
+#define HOST_MAX_APS            16
+
+inline wifi_ap_record_t hostAPs[HOST_MAX_APS];
+inline uint8_t          hostNumAPs = 0;
+
+// Adds an access point in range
+inline void hostAddAP(const char* ssid, int8_t rssi, uint8_t channel, uint8_t bssidLast, wifi_auth_mode_t auth = WIFI_AUTH_WPA2_PSK)
+{
+  wifi_ap_record_t& ap = hostAPs[hostNumAPs++];
+  const uint8_t     bssid[6] = { 0x24, 0x0A, 0xC4, 0x00, 0x00, bssidLast };
+
+  memset(&ap, 0, sizeof(ap));
+  strncpy((char*) ap.ssid, ssid, sizeof(ap.ssid) - 1);
+  memcpy(ap.bssid, bssid, sizeof(ap.bssid));
+  ap.rssi     = rssi;
+  ap.primary  = channel;
+  ap.authmode = auth;
+}
+
+class WiFiClass
+{
+  public:
+    // Counters for the tests
+    uint32_t numBegins      = 0;
+    uint32_t numDhcp        = 0;
+    uint32_t numScans       = 0;
+
+    wifi_mode_t getMode()
+    {
+      return wifiMode;
+    }
+
+    bool mode(wifi_mode_t m)
+    {
+      wifiMode = m;
+
+      if (m == WIFI_OFF)
+        disconnect();
+
+      return true;
+    }
+
+    bool config(IPAddress ip, IPAddress gateway, IPAddress subnet, IPAddress dns1 = IPAddress(), IPAddress dns2 = IPAddress())
+    {
+      (void) dns2;
+
+      staticIP  = ip;
+      staticGW  = gateway;
+      staticSN  = subnet;
+      staticDNS = dns1;
+
+      return true;
+    }
+
+    bool setHostname(const char* name)
+    {
+      (void) name;
+      return true;
+    }
+
+    wl_status_t begin(const char* ssid, const char* pass = NULL, int32_t channel = 0, const uint8_t* bssid = NULL, bool connect = true)
+    {
+      (void) pass;
+      (void) connect;
+
+      numBegins++;
+      disconnect();
+
+      for (uint8_t i = 0; i < hostNumAPs; i++)
+      {
+        wifi_ap_record_t& ap = hostAPs[i];
+
+        if ( strcmp((const char*) ap.ssid, ssid) || (channel && (channel != ap.primary)) ||
+             (bssid && memcmp(bssid, ap.bssid, sizeof(ap.bssid))) )
+          continue;
+
+        if ( !current || (ap.rssi > current->rssi) )
+          current = &ap;
+      }
+
+      if (!current)
+      {
+        wifiStatus = WL_NO_SSID_AVAIL;
+        return wifiStatus;
+      }
+
+      if (staticIP == IPAddress())
+      {
+        numDhcp++;
+        leasedIP = IPAddress(192, 168, 2, 100 + (numDhcp % 100));
+      }
+
+      hostApInfo      = *current;
+      hostApInfoValid = true;
+      wifiStatus      = WL_CONNECTED;
+
+      return wifiStatus;
+    }
+
+    bool disconnect(bool wifioff = false, bool eraseap = false)
+    {
+      (void) wifioff;
+      (void) eraseap;
+
+      current         = NULL;
+      hostApInfoValid = false;
+      wifiStatus      = WL_DISCONNECTED;
+
+      return true;
+    }
+
+    // Link drop, or AP out of range
+    void hostDrop()
+    {
+      disconnect();
+      wifiStatus = WL_CONNECTION_LOST;
+    }
+
+    wl_status_t status()
+    {
+      return wifiStatus;
+    }
+
+    IPAddress localIP()
+    {
+      return (staticIP != IPAddress()) ? staticIP : leasedIP;
+    }
+
+    IPAddress gatewayIP()
+    {
+      return (staticIP != IPAddress()) ? staticGW : IPAddress(192, 168, 2, 1);
+    }
+
+    IPAddress subnetMask()
+    {
+      return (staticIP != IPAddress()) ? staticSN : IPAddress(255, 255, 255, 0);
+    }
+
+    IPAddress dnsIP(uint8_t index = 0)
+    {
+      return index ? IPAddress(8, 8, 8, 8) : ( (staticIP != IPAddress()) ? staticDNS : IPAddress(192, 168, 2, 1) );
+    }
+
+    int8_t RSSI()
+    {
+      return current ? current->rssi : 0;
+    }
+
+    uint8_t* BSSID()
+    {
+      return current ? current->bssid : NULL;
+    }
+
+    int32_t channel()
+    {
+      return current ? current->primary : 0;
+    }
+
+    int16_t scanNetworks(bool async = false, bool show_hidden = false)
+    {
+      (void) show_hidden;
+
+      if (scanPolls)
+        return WIFI_SCAN_RUNNING;
+
+      scanDelete();
+      numScans++;
+      scanStarted = true;
+      scanPolls   = HOST_SCAN_POLLS;
+
+      return async ? WIFI_SCAN_RUNNING : scanComplete();
+    }
+
+    int16_t scanComplete()
+    {
+      if (scanPolls && --scanPolls)
+        return WIFI_SCAN_RUNNING;
+
+      if (scanStarted && !scanDone)
+      {
+        scanCount = hostNumAPs;
+        scanDone  = true;
+
+        if (scanCount)
+        {
+          scanResults = new wifi_ap_record_t[scanCount];
+          memcpy(scanResults, hostAPs, scanCount * sizeof(wifi_ap_record_t));
+        }
+      }
+
+      return scanDone ? scanCount : WIFI_SCAN_FAILED;
+    }
+
+    void scanDelete()
+    {
+      delete[] scanResults;
+
+      scanResults = NULL;
+      scanCount   = 0;
+      scanStarted = false;
+      scanDone    = false;
+    }
+
+    void* getScanInfoByIndex(int i)
+    {
+      return (scanResults && (i >= 0) && (i < scanCount)) ? &scanResults[i] : NULL;
+    }
+
+    bool softAP(const char* ssid, const char* pass = NULL, int channel = 1)
+    {
+      (void) ssid;
+      (void) pass;
+      (void) channel;
+      return true;
+    }
+
+    bool softAPConfig(IPAddress local_ip, IPAddress gateway, IPAddress subnet)
+    {
+      (void) local_ip;
+      (void) gateway;
+      (void) subnet;
+      return true;
+    }
+
+    bool softAPdisconnect(bool wifioff = false)
+    {
+      (void) wifioff;
+      return true;
+    }
+
+  private:
+    wifi_mode_t             wifiMode    = WIFI_OFF;
+    wl_status_t             wifiStatus  = WL_IDLE_STATUS;
+    wifi_ap_record_t*       current     = NULL;
+
+    IPAddress staticIP;
+    IPAddress staticGW;
+    IPAddress staticSN;
+    IPAddress staticDNS;
+    IPAddress leasedIP;
+
+    wifi_ap_record_t* scanResults = NULL;
+    int16_t           scanCount   = 0;
+    bool              scanStarted = false;
+    bool              scanDone    = false;
+    uint8_t           scanPolls   = 0;
+};
+
+inline WiFiClass WiFi;
+
+#endif    // WiFi_h
@@ -0,0 +1,95 @@
+/****************************************************************************************************************************
+   WiFiClient.h
+   Host mock for the tests of extras/host_tests. A TCP connection succeeds while hostServerUp is set, and only
+   counts what is written : the Blynk protocol is mocked one level higher.
+ *****************************************************************************************************************************/
+
+#ifndef WiFiClient_h
+#define WiFiClient_h
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+inline bool hostServerUp = true;
+
+class Client : public Print
+{
+  public:
+    virtual int connect(const char* host, uint16_t port) = 0;
+    virtual int connect(IPAddress ip, uint16_t port) = 0;
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int read(uint8_t* buf, size_t size) = 0;
+    virtual void stop() = 0;
+    virtual uint8_t connected() = 0;
+};
+
+class WiFiClient : public Client
+{
+  public:
+    int connect(const char* host, uint16_t port)
+    {
+      (void) host;
+      (void) port;
+
+      isConnected = hostServerUp;
+      return isConnected;
+    }
+
+    int connect(const char* host, uint16_t port, int32_t timeout)
+    {
+      (void) timeout;
+      return connect(host, port);
+    }
+
+    int connect(IPAddress ip, uint16_t port)
+    {
+      (void) ip;
+      return connect("", port);
+    }
+
+    using Print::write;
+
+    size_t write(uint8_t data)
+    {
+      return write(&data, 1);
+    }
+
+    size_t write(const uint8_t* buf, size_t size)
+    {
+      (void) buf;
+      return isConnected ? size : 0;
+    }
+
+    int available()
+    {
+      return 0;
+    }
+
+    int read()
+    {
+      return -1;
+    }
+
+    int read(uint8_t* buf, size_t size)
+    {
+      (void) buf;
+      (void) size;
+      return -1;
+    }
+
+    void stop()
+    {
+      isConnected = false;
+    }
+
+    uint8_t connected()
+    {
+      return isConnected && hostServerUp;
+    }
+
+  private:
+    bool isConnected = false;
+};
+
+#endif    // WiFiClient_h
@@ -0,0 +1,82 @@
+/****************************************************************************************************************************
+   WiFiMulti.h
+   Host mock for the tests of extras/host_tests. As in the core, addAP() keeps a heap copy of every entry it is given,
+   duplicates included, until the WiFiMulti is destroyed.
+ *****************************************************************************************************************************/
+
+#ifndef WiFiMulti_h
+#define WiFiMulti_h
+
+#include <WiFi.h>
+
+#define HOST_MULTI_MAX_APS      32
+
+class WiFiMulti
+{
+  public:
+    ~WiFiMulti()
+    {
+      for (uint8_t i = 0; i < numAPs; i++)
+      {
+        delete[] ssids[i];
+        delete[] passes[i];
+      }
+    }
+
+    bool addAP(const char* ssid, const char* pass = NULL)
+    {
+      if (!ssid || !*ssid || (numAPs == HOST_MULTI_MAX_APS))
+        return false;
+
+      ssids[numAPs]   = copy(ssid);
+      passes[numAPs]  = copy(pass ? pass : "");
+      numAPs++;
+
+      return true;
+    }
+
+    // Joins the strongest AP of the list in range
+    uint8_t run(uint32_t connectTimeout = 5000)
+    {
+      (void) connectTimeout;
+
+      if (WiFi.status() == WL_CONNECTED)
+        return WL_CONNECTED;
+
+      int best = -1;
+
+      for (uint8_t i = 0; i < numAPs; i++)
+      {
+        for (uint8_t j = 0; j < hostNumAPs; j++)
+        {
+          if ( !strcmp(ssids[i], (const char*) hostAPs[j].ssid) && ( (best < 0) || (hostAPs[j].rssi > hostAPs[best].rssi) ) )
+            best = j;
+        }
+      }
+
+      if (best < 0)
+        return WL_NO_SSID_AVAIL;
+
+      return WiFi.begin((const char*) hostAPs[best].ssid);
+    }
+
+    uint8_t getNumAPs()
+    {
+      return numAPs;
+    }
+
+  private:
+    char*   ssids[HOST_MULTI_MAX_APS];
+    char*   passes[HOST_MULTI_MAX_APS];
+    uint8_t numAPs = 0;
+
+    static char* copy(const char* text)
+    {
+      char* dup = new char[strlen(text) + 1];
+
+      strcpy(dup, text);
+      return dup;
+    }
+};
+
+#endif    // WiFiMulti_h
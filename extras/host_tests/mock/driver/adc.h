@@ -0,0 +1,56 @@
+/****************************************************************************************************************************
+   driver/adc.h
+   Host mock for the tests of extras/host_tests
+ *****************************************************************************************************************************/
+
+#ifndef driver_adc_h
+#define driver_adc_h
+
+#include <esp_err.h>
+
+typedef enum
+{
+  ADC_UNIT_1 = 1,
+  ADC_UNIT_2 = 2
+} adc_unit_t;
+
+typedef enum
+{
+  ADC1_CHANNEL_0,
+  ADC1_CHANNEL_1,
+  ADC1_CHANNEL_2,
+  ADC1_CHANNEL_3,
+  ADC1_CHANNEL_4,
+  ADC1_CHANNEL_5,
+  ADC1_CHANNEL_6,
+  ADC1_CHANNEL_7,
+  ADC1_CHANNEL_MAX
+} adc1_channel_t;
+
+typedef enum
+{
+  ADC_ATTEN_DB_0,
+  ADC_ATTEN_DB_2_5,
+  ADC_ATTEN_DB_6,
+  ADC_ATTEN_DB_11
+} adc_atten_t;
+
+typedef enum
+{
+  ADC_WIDTH_BIT_9,
+  ADC_WIDTH_BIT_10,
+  ADC_WIDTH_BIT_11,
+  ADC_WIDTH_BIT_12
+} adc_bits_width_t;
+
+inline esp_err_t adc1_config_width(adc_bits_width_t width)
+{
+  return (width == ADC_WIDTH_BIT_12) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+inline esp_err_t adc1_config_channel_atten(adc1_channel_t channel, adc_atten_t atten)
+{
+  return (channel < ADC1_CHANNEL_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+#endif    // driver_adc_h
@@ -0,0 +1,160 @@
+/****************************************************************************************************************************
+   driver/i2s.h
+   Host mock for the tests of extras/host_tests
+
+   Model of I2S in built-in ADC mode : samples arrive at sample_rate on the clock of <Arduino.h>, taken in turn from
+   the hostI2sData array the test provides, with the channel number in the top 4 bits as on the board. The DMA holds
+   dma_buf_count x dma_buf_len samples : older ones are dropped, and counted in hostI2sDropped, when i2s_read() is
+   late. i2s_read() never waits.
+ *****************************************************************************************************************************/
+
+#ifndef driver_i2s_h
+#define driver_i2s_h
+
+#include <Arduino.h>
+#include <esp_err.h>
+#include "driver/adc.h"
+
+typedef uint32_t TickType_t;
+
+#define ESP_INTR_FLAG_LEVEL1    (1 << 1)
+
+typedef enum
+{
+  I2S_NUM_0,
+  I2S_NUM_1,
+  I2S_NUM_MAX
+} i2s_port_t;
+
+typedef enum
+{
+  I2S_MODE_MASTER         = 1,
+  I2S_MODE_SLAVE          = 2,
+  I2S_MODE_TX             = 4,
+  I2S_MODE_RX             = 8,
+  I2S_MODE_DAC_BUILT_IN   = 16,
+  I2S_MODE_ADC_BUILT_IN   = 32
+} i2s_mode_t;
+
+typedef enum
+{
+  I2S_BITS_PER_SAMPLE_16BIT = 16,
+  I2S_BITS_PER_SAMPLE_32BIT = 32
+} i2s_bits_per_sample_t;
+
+typedef enum
+{
+  I2S_CHANNEL_FMT_RIGHT_LEFT,
+  I2S_CHANNEL_FMT_ALL_RIGHT,
+  I2S_CHANNEL_FMT_ALL_LEFT,
+  I2S_CHANNEL_FMT_ONLY_RIGHT,
+  I2S_CHANNEL_FMT_ONLY_LEFT
+} i2s_channel_fmt_t;
+
+typedef enum
+{
+  I2S_COMM_FORMAT_I2S       = 1,
+  I2S_COMM_FORMAT_I2S_MSB   = 2,
+  I2S_COMM_FORMAT_I2S_LSB   = 4
+} i2s_comm_format_t;
+
+typedef struct
+{
+  i2s_mode_t            mode;
+  int                   sample_rate;
+  i2s_bits_per_sample_t bits_per_sample;
+  i2s_channel_fmt_t     channel_format;
+  i2s_comm_format_t     communication_format;
+  int                   intr_alloc_flags;
+  int                   dma_buf_count;
+  int                   dma_buf_len;
+  bool                  use_apll;
+} i2s_config_t;
+
+inline const uint16_t*  hostI2sData       = NULL;
+inline size_t           hostI2sLen        = 0;
+inline bool             hostI2sInstalled  = false;
+inline bool             hostI2sAdcOn      = false;
+inline i2s_config_t     hostI2sConfig;
+inline uint16_t         hostI2sChannel    = 0;
+inline uint64_t         hostI2sProduced   = 0;
+inline uint64_t         hostI2sConsumed   = 0;
+inline uint64_t         hostI2sDropped    = 0;
+inline uint64_t         hostI2sStart_us   = 0;
+
+inline esp_err_t i2s_driver_install(i2s_port_t port, const i2s_config_t* config, int queueSize, void* queue)
+{
+  if ( hostI2sInstalled || (port != I2S_NUM_0) || !(config->mode & I2S_MODE_ADC_BUILT_IN) )
+    return ESP_ERR_INVALID_STATE;
+
+  hostI2sConfig     = *config;
+  hostI2sInstalled  = true;
+
+  return ESP_OK;
+}
+
+inline esp_err_t i2s_driver_uninstall(i2s_port_t port)
+{
+  hostI2sInstalled  = false;
+  hostI2sAdcOn      = false;
+
+  return ESP_OK;
+}
+
+inline esp_err_t i2s_set_adc_mode(adc_unit_t unit, adc1_channel_t channel)
+{
+  hostI2sChannel = channel;
+  return (unit == ADC_UNIT_1) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+inline esp_err_t i2s_adc_enable(i2s_port_t port)
+{
+  hostI2sAdcOn      = true;
+  hostI2sStart_us   = hostMicros64();
+  hostI2sProduced   = 0;
+  hostI2sConsumed   = 0;
+  hostI2sDropped    = 0;
+
+  return ESP_OK;
+}
+
+inline esp_err_t i2s_adc_disable(i2s_port_t port)
+{
+  hostI2sAdcOn = false;
+  return ESP_OK;
+}
+
+inline esp_err_t i2s_read(i2s_port_t port, void* dest, size_t size, size_t* bytesRead, TickType_t ticksToWait)
+{
+  *bytesRead = 0;
+
+  if (!hostI2sAdcOn || !hostI2sLen)
+    return ESP_ERR_INVALID_STATE;
+
+  uint64_t dmaLen = (uint64_t) hostI2sConfig.dma_buf_count * hostI2sConfig.dma_buf_len;
+
+  hostI2sProduced = (hostMicros64() - hostI2sStart_us) * hostI2sConfig.sample_rate / 1000000;
+
+  // DMA full : the oldest samples are overwritten
+  if (hostI2sProduced - hostI2sConsumed > dmaLen)
+  {
+    hostI2sDropped  += hostI2sProduced - hostI2sConsumed - dmaLen;
+    hostI2sConsumed  = hostI2sProduced - dmaLen;
+  }
+
+  size_t    n       = size / sizeof(uint16_t);
+  uint16_t* samples = (uint16_t*) dest;
+
+  if (n > hostI2sProduced - hostI2sConsumed)
+    n = hostI2sProduced - hostI2sConsumed;
+
+  for (size_t i = 0; i < n; i++)
+    samples[i] = (hostI2sChannel << 12) | hostI2sData[(hostI2sConsumed + i) % hostI2sLen];
+
+  hostI2sConsumed += n;
+  *bytesRead       = n * sizeof(uint16_t);
+
+  return ESP_OK;
+}
+
+#endif    // driver_i2s_h
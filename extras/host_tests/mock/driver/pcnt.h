@@ -0,0 +1,224 @@
+/****************************************************************************************************************************
+   driver/pcnt.h
+   Host mock for the tests of extras/host_tests
+
+   Model of the PCNT peripheral : a 16-bit counter with its glitch filter, counting rising edges up to counter_h_lim,
+   where it restarts from 0 and raises PCNT_EVT_H_LIM. The test feeds it with hostPcntPulse(). The overflow interrupt
+   runs at once, or with hostPcntDeferIsr is left pending until hostPcntRunIsr(), as when the ISR core is busy.
+   hostPcntOnRead, if set, runs inside pcnt_get_counter_value() before the counter is read : it can inject pulses or
+   run the ISR at that exact point.
+ *****************************************************************************************************************************/
+
+#ifndef driver_pcnt_h
+#define driver_pcnt_h
+
+#include <Arduino.h>
+#include <esp_err.h>
+
+typedef enum
+{
+  PCNT_UNIT_0,
+  PCNT_UNIT_1,
+  PCNT_UNIT_2,
+  PCNT_UNIT_3,
+  PCNT_UNIT_MAX
+} pcnt_unit_t;
+
+typedef enum
+{
+  PCNT_CHANNEL_0,
+  PCNT_CHANNEL_1
+} pcnt_channel_t;
+
+typedef enum
+{
+  PCNT_COUNT_DIS,
+  PCNT_COUNT_INC,
+  PCNT_COUNT_DEC
+} pcnt_count_mode_t;
+
+typedef enum
+{
+  PCNT_MODE_KEEP,
+  PCNT_MODE_REVERSE,
+  PCNT_MODE_DISABLE
+} pcnt_ctrl_mode_t;
+
+typedef enum
+{
+  PCNT_EVT_L_LIM    = 0,
+  PCNT_EVT_H_LIM    = 1
+} pcnt_evt_type_t;
+
+#define PCNT_PIN_NOT_USED       (-1)
+
+typedef struct
+{
+  int                 pulse_gpio_num;
+  int                 ctrl_gpio_num;
+  pcnt_ctrl_mode_t    lctrl_mode;
+  pcnt_ctrl_mode_t    hctrl_mode;
+  pcnt_count_mode_t   pos_mode;
+  pcnt_count_mode_t   neg_mode;
+  int16_t             counter_h_lim;
+  int16_t             counter_l_lim;
+  pcnt_unit_t         unit;
+  pcnt_channel_t      channel;
+} pcnt_config_t;
+
+typedef struct
+{
+  pcnt_config_t config;
+  int16_t       value;
+  uint16_t      filterTicks;
+  bool          filterOn;
+  bool          paused;
+  bool          eventOn;
+  void          (*isr)(void*);
+  void*         isrArg;
+  uint32_t      pendingIsr;
+} HostPcntUnit;
+
+inline HostPcntUnit hostPcnt[PCNT_UNIT_MAX];
+inline bool         hostPcntDeferIsr  = false;
+inline void         (*hostPcntOnRead)(pcnt_unit_t unit) = NULL;
+
+// Runs the pending overflow interrupts of unit
+inline void hostPcntRunIsr(pcnt_unit_t unit)
+{
+  HostPcntUnit& u = hostPcnt[unit];
+
+  for ( ; u.pendingIsr; u.pendingIsr--)
+  {
+    if (u.isr)
+      u.isr(u.isrArg);
+  }
+}
+
+// One pulse of width_ns on the input of unit. True if counted.
+inline bool hostPcntPulse(pcnt_unit_t unit, uint32_t width_ns)
+{
+  HostPcntUnit& u = hostPcnt[unit];
+
+  // The filter ignores pulses shorter than filterTicks APB cycles, at 80 MHz
+  if ( u.paused || (u.config.pos_mode != PCNT_COUNT_INC) || (u.filterOn && (width_ns * 80 / 1000 < u.filterTicks)) )
+    return false;
+
+  if (++u.value >= u.config.counter_h_lim)
+  {
+    u.value = 0;
+
+    if (u.eventOn)
+    {
+      u.pendingIsr++;
+
+      if (!hostPcntDeferIsr)
+        hostPcntRunIsr(unit);
+    }
+  }
+
+  return true;
+}
+
+inline esp_err_t pcnt_unit_config(const pcnt_config_t* config)
+{
+  if ( (config->unit >= PCNT_UNIT_MAX) || (config->counter_h_lim <= 0) )
+    return ESP_ERR_INVALID_ARG;
+
+  HostPcntUnit& u = hostPcnt[config->unit];
+
+  u.config  = *config;
+  u.value   = 0;
+
+  return ESP_OK;
+}
+
+inline esp_err_t pcnt_set_filter_value(pcnt_unit_t unit, uint16_t value)
+{
+  if (value > 1023)
+    return ESP_ERR_INVALID_ARG;
+
+  hostPcnt[unit].filterTicks = value;
+  return ESP_OK;
+}
+
+inline esp_err_t pcnt_filter_enable(pcnt_unit_t unit)
+{
+  hostPcnt[unit].filterOn = true;
+  return ESP_OK;
+}
+
+inline esp_err_t pcnt_filter_disable(pcnt_unit_t unit)
+{
+  hostPcnt[unit].filterOn = false;
+  return ESP_OK;
+}
+
+inline esp_err_t pcnt_counter_pause(pcnt_unit_t unit)
+{
+  hostPcnt[unit].paused = true;
+  return ESP_OK;
+}
+
+inline esp_err_t pcnt_counter_resume(pcnt_unit_t unit)
+{
+  hostPcnt[unit].paused = false;
+  return ESP_OK;
+}
+
+inline esp_err_t pcnt_counter_clear(pcnt_unit_t unit)
+{
+  hostPcnt[unit].value = 0;
+  return ESP_OK;
+}
+
+inline esp_err_t pcnt_get_counter_value(pcnt_unit_t unit, int16_t* count)
+{
+  if (hostPcntOnRead)
+    hostPcntOnRead(unit);
+
+  *count = hostPcnt[unit].value;
+  return ESP_OK;
+}
+
+inline bool hostPcntIsrService = false;
+
+inline esp_err_t pcnt_isr_service_install(int flags)
+{
+  if (hostPcntIsrService)
+    return ESP_ERR_INVALID_STATE;
+
+  hostPcntIsrService = true;
+  return ESP_OK;
+}
+
+inline esp_err_t pcnt_isr_handler_add(pcnt_unit_t unit, void (*isr)(void*), void* arg)
+{
+  hostPcnt[unit].isr    = isr;
+  hostPcnt[unit].isrArg = arg;
+  return ESP_OK;
+}
+
+inline esp_err_t pcnt_isr_handler_remove(pcnt_unit_t unit)
+{
+  hostPcnt[unit].isr = NULL;
+  return ESP_OK;
+}
+
+inline esp_err_t pcnt_event_enable(pcnt_unit_t unit, pcnt_evt_type_t evt)
+{
+  if (evt == PCNT_EVT_H_LIM)
+    hostPcnt[unit].eventOn = true;
+
+  return ESP_OK;
+}
+
+inline esp_err_t pcnt_event_disable(pcnt_unit_t unit, pcnt_evt_type_t evt)
+{
+  if (evt == PCNT_EVT_H_LIM)
+    hostPcnt[unit].eventOn = false;
+
+  return ESP_OK;
+}
+
+#endif    // driver_pcnt_h
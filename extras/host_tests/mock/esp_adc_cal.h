@@ -0,0 +1,50 @@
+/****************************************************************************************************************************
+   esp_adc_cal.h
+   Host mock for the tests of extras/host_tests. An ideal linear ADC : full scale of the attenuation, scaled by vref.
+ *****************************************************************************************************************************/
+
+#ifndef esp_adc_cal_h
+#define esp_adc_cal_h
+
+#include <stdint.h>
+#include "driver/adc.h"
+
+typedef enum
+{
+  ESP_ADC_CAL_VAL_EFUSE_VREF,
+  ESP_ADC_CAL_VAL_EFUSE_TP,
+  ESP_ADC_CAL_VAL_DEFAULT_VREF
+} esp_adc_cal_value_t;
+
+typedef struct
+{
+  adc_unit_t        adc_num;
+  adc_atten_t       atten;
+  adc_bits_width_t  bit_width;
+  uint32_t          coeff_a;
+  uint32_t          coeff_b;
+  uint32_t          vref;
+} esp_adc_cal_characteristics_t;
+
+inline esp_adc_cal_value_t esp_adc_cal_characterize(adc_unit_t unit, adc_atten_t atten, adc_bits_width_t width,
+                                                    uint32_t vref, esp_adc_cal_characteristics_t* chars)
+{
+  // Full scale in mV at vref 1100
+  static const uint32_t fullScale[] = { 1100, 1470, 2200, 3900 };
+
+  chars->adc_num    = unit;
+  chars->atten      = atten;
+  chars->bit_width  = width;
+  chars->vref       = vref;
+  chars->coeff_a    = (uint32_t) ( (uint64_t) fullScale[atten] * vref * 65536 / 1100 / 4095 );
+  chars->coeff_b    = 0;
+
+  return ESP_ADC_CAL_VAL_DEFAULT_VREF;
+}
+
+inline uint32_t esp_adc_cal_raw_to_voltage(uint32_t raw, const esp_adc_cal_characteristics_t* chars)
+{
+  return (uint32_t) ( ( (uint64_t) raw * chars->coeff_a + 32768 ) / 65536 ) + chars->coeff_b;
+}
+
+#endif    // esp_adc_cal_h
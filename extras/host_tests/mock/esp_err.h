@@ -0,0 +1,18 @@
+/****************************************************************************************************************************
+   esp_err.h
+   Host mock for the tests of extras/host_tests
+ *****************************************************************************************************************************/
+
+#ifndef esp_err_h
+#define esp_err_h
+
+typedef int esp_err_t;
+
+#define ESP_OK                  0
+#define ESP_FAIL                -1
+#define ESP_ERR_NO_MEM          0x101
+#define ESP_ERR_INVALID_ARG     0x102
+#define ESP_ERR_INVALID_STATE   0x103
+#define ESP_ERR_TIMEOUT         0x107
+
+#endif    // esp_err_h
@@ -0,0 +1,25 @@
+/****************************************************************************************************************************
+   esp_heap_caps.h
+   Host mock for the tests of extras/host_tests : the heap model of HostHeap.h
+ *****************************************************************************************************************************/
+
+#ifndef esp_heap_caps_h
+#define esp_heap_caps_h
+
+#include <Arduino.h>
+
+#define MALLOC_CAP_8BIT         (1 << 2)
+
+inline size_t heap_caps_get_free_size(uint32_t caps)
+{
+  (void) caps;
+  return HOST_HEAP_FREE();
+}
+
+inline size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+  (void) caps;
+  return HOST_HEAP_LARGEST_FREE();
+}
+
+#endif    // esp_heap_caps_h
@@ -0,0 +1,40 @@
+/****************************************************************************************************************************
+   esp_sleep.h
+   Host mock for the tests of extras/host_tests. esp_deep_sleep_start() returns : the test then simulates the wake-up.
+ *****************************************************************************************************************************/
+
+#ifndef esp_sleep_h
+#define esp_sleep_h
+
+#include <Arduino.h>
+
+typedef enum
+{
+  ESP_SLEEP_WAKEUP_UNDEFINED,
+  ESP_SLEEP_WAKEUP_ALL,
+  ESP_SLEEP_WAKEUP_EXT0,
+  ESP_SLEEP_WAKEUP_EXT1,
+  ESP_SLEEP_WAKEUP_TIMER,
+} esp_sleep_wakeup_cause_t;
+
+inline esp_sleep_wakeup_cause_t hostWakeupCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+inline uint64_t                 hostSleep_us    = 0;
+inline uint32_t                 hostNumSleeps   = 0;
+
+inline esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause()
+{
+  return hostWakeupCause;
+}
+
+inline int esp_sleep_enable_timer_wakeup(uint64_t time_us)
+{
+  hostSleep_us = time_us;
+  return 0;
+}
+
+inline void esp_deep_sleep_start()
+{
+  hostNumSleeps++;
+}
+
+#endif    // esp_sleep_h
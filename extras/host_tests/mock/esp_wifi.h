@@ -0,0 +1,70 @@
+/****************************************************************************************************************************
+   esp_wifi.h
+   Host mock for the tests of extras/host_tests : the types and calls of the ESP-IDF WiFi driver used by src/
+ *****************************************************************************************************************************/
+
+#ifndef esp_wifi_h
+#define esp_wifi_h
+
+#include <stdint.h>
+#include <esp_err.h>
+
+typedef enum
+{
+  WIFI_AUTH_OPEN = 0,
+  WIFI_AUTH_WEP,
+  WIFI_AUTH_WPA_PSK,
+  WIFI_AUTH_WPA2_PSK,
+  WIFI_AUTH_WPA_WPA2_PSK,
+} wifi_auth_mode_t;
+
+typedef struct
+{
+  uint8_t           bssid[6];
+  uint8_t           ssid[33];
+  uint8_t           primary;
+  int8_t            rssi;
+  wifi_auth_mode_t  authmode;
+} wifi_ap_record_t;
+
+typedef enum
+{
+  WIFI_PS_NONE,
+  WIFI_PS_MIN_MODEM,
+  WIFI_PS_MAX_MODEM,
+} wifi_ps_type_t;
+
+// Filled in by the WiFi mock while associated
+inline bool             hostApInfoValid = false;
+inline wifi_ap_record_t hostApInfo;
+inline int8_t           hostMaxTxPower  = 80;
+inline wifi_ps_type_t   hostPowerSave   = WIFI_PS_MIN_MODEM;
+
+inline esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t* info)
+{
+  if (!hostApInfoValid)
+    return ESP_FAIL;
+
+  *info = hostApInfo;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_wifi_set_max_tx_power(int8_t power)
+{
+  hostMaxTxPower = power;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_wifi_get_max_tx_power(int8_t* power)
+{
+  *power = hostMaxTxPower;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_wifi_set_ps(wifi_ps_type_t type)
+{
+  hostPowerSave = type;
+  return ESP_OK;
+}
+
+#endif    // esp_wifi_h
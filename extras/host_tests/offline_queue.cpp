@@ -0,0 +1,314 @@
+/****************************************************************************************************************************
+   offline_queue.cpp
+   Host test of <BlynkEsp32_OfflineQueue.h> : replay of the RAM / SPIFFS ring over disconnect / reconnect cycles
+
+   A counter is written every WRITE_INTERVAL_MS, through the queue, for NUM_CYCLES cycles of an outage then a
+   connected period. Outages are random, from none to 1.5 times the capacity of writes. Most connected periods are
+   long enough to drain the queue, one in four is cut short in the middle of the drain. A plain FIFO of the same
+   capacity is the reference : what the server receives must equal it exactly, in order, with drops only of the
+   oldest entries once RAM and file are full, and each one counted.
+   Then, with OFFLINE_QUEUE_DOWNSAMPLE : nothing is reordered, and what is kept plus what is dropped is all that was
+   written. Last, a bad slot of the ring file : that entry only is lost and counted.
+ *****************************************************************************************************************************/
+
+#define USE_SPIFFS              true
+
+#include <Arduino.h>
+#include <Blynk/BlynkConfig.h>
+#include <Blynk/BlynkProtocolDefs.h>
+#include <Blynk/BlynkParam.h>
+#include <BlynkEsp32_OfflineQueue.h>
+
+#include <deque>
+#include <random>
+#include <vector>
+
+#define NUM_CYCLES              200
+#define WRITE_INTERVAL_MS       50
+#define RUN_INTERVAL_MS         10
+#define VALUE_PIN               5
+
+static int numFailures = 0;
+
+#define CHECK(cond)                                                           \
+  do                                                                          \
+  {                                                                           \
+    if (!(cond))                                                              \
+    {                                                                         \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+      numFailures++;                                                          \
+    }                                                                         \
+  } while (0)
+
+// The Blynk instance : records the values the server receives, sent directly or drained from the queue
+class TestBlynk
+{
+  public:
+    bool                  online = true;
+    std::vector<uint32_t> received;
+    uint32_t              numDirect = 0;
+    uint32_t              numBad    = 0;
+
+    bool connected()
+    {
+      return online;
+    }
+
+    void virtualWrite(int pin, unsigned int value)
+    {
+      CHECK(online);
+
+      numDirect++;
+      received.push_back(value);
+    }
+
+    void sendCmd(uint8_t cmd, uint16_t id, const char* data, size_t length)
+    {
+      char text[OFFLINE_QUEUE_ENTRY_LEN + 1];
+
+      memcpy(text, data, length);
+      text[length] = 0;
+
+      const char* pin = text + 3;
+
+      if ( !online || (cmd != BLYNK_CMD_HARDWARE) || strcmp(text, "vw") || (atoi(pin) != VALUE_PIN) )
+        numBad++;
+
+      received.push_back(atol(pin + strlen(pin) + 1));
+    }
+};
+
+static std::mt19937 rng(2024);
+
+static uint32_t randomBelow(uint32_t n)
+{
+  return std::uniform_int_distribution<uint32_t>(0, n - 1)(rng);
+}
+
+static void testReplay()
+{
+  TestBlynk                       blynk;
+  BlynkOfflineQueue<TestBlynk>    queue(blynk, "/offq_test.dat");
+
+  queue.begin();
+
+  std::deque<uint32_t>  reference;
+  std::vector<uint32_t> expected;
+  uint32_t              value       = 0;
+  uint32_t              numDropped  = 0;
+  uint32_t              maxSize     = 0;
+  uint32_t              numFull     = 0;
+  uint32_t              numEmptied  = 0;
+  uint32_t              capacity    = queue.getCapacity();
+
+  for (uint32_t cycle = 0; cycle < NUM_CYCLES; cycle++)
+  {
+    // The drain gains one entry per write : capacity writes empty a full queue
+    uint32_t outage = (cycle % 10 == 0) ? 0 : randomBelow(3 * capacity / 2);
+    uint32_t online = (randomBelow(4) == 0) ? randomBelow(capacity / 2) : capacity + randomBelow(capacity);
+
+    for (uint32_t phase = 0; phase < 2; phase++)
+    {
+      uint32_t ticks = (phase == 0) ? outage : online;
+
+      blynk.online = (phase == 1);
+
+      for (uint32_t tick = 0; tick < ticks; tick++)
+      {
+        bool direct = blynk.online && (queue.getSize() == 0);
+
+        queue.virtualWrite(VALUE_PIN, (unsigned int) value);
+
+        if (direct)
+        {
+          expected.push_back(value);
+        }
+        else
+        {
+          if (reference.size() == capacity)
+          {
+            reference.pop_front();
+            numDropped++;
+          }
+
+          reference.push_back(value);
+        }
+
+        value++;
+
+        if (queue.getSize() > maxSize)
+          maxSize = queue.getSize();
+
+        if (queue.getSize() == capacity)
+          numFull++;
+
+        for (uint32_t ms = 0; ms < WRITE_INTERVAL_MS; ms += RUN_INTERVAL_MS)
+        {
+          size_t before = blynk.received.size();
+
+          queue.run();
+          delay(RUN_INTERVAL_MS);
+
+          // Drained, oldest first
+          for (size_t i = before; i < blynk.received.size(); i++)
+          {
+            expected.push_back(reference.front());
+            reference.pop_front();
+          }
+        }
+      }
+    }
+
+    CHECK(queue.getSize() == reference.size());
+
+    if (queue.getSize() == 0)
+      numEmptied++;
+  }
+
+  // Last drain
+  blynk.online = true;
+
+  while (queue.getSize())
+  {
+    size_t before = blynk.received.size();
+
+    queue.run();
+    delay(RUN_INTERVAL_MS);
+
+    for (size_t i = before; i < blynk.received.size(); i++)
+    {
+      expected.push_back(reference.front());
+      reference.pop_front();
+    }
+  }
+
+  printf("OQ:Replay,Written=%u,Received=%u,Direct=%u,Dropped=%u,MaxSize=%u/%u,Full=%u,Emptied=%u/%u,FlashKB=%llu\n",
+         value, (uint32_t) blynk.received.size(), blynk.numDirect, queue.getDropped(), maxSize, capacity, numFull,
+         numEmptied, NUM_CYCLES, (unsigned long long) (hostFsNumWrites / 1024));
+
+  CHECK(blynk.received == expected);
+  CHECK(blynk.numBad == 0);
+  CHECK(queue.getDropped() == numDropped);
+  CHECK(blynk.received.size() + numDropped == value);
+  CHECK(maxSize == capacity);
+  CHECK( (numEmptied > 0) && (numEmptied < NUM_CYCLES) );
+  CHECK( (numDropped > 0) && (numDropped < value / 10) );
+  CHECK(capacity == OFFLINE_QUEUE_SIZE + OFFLINE_QUEUE_FLASH_SIZE);
+  // File removed once empty
+  CHECK(!SPIFFS.exists("/offq_test.dat"));
+}
+
+static uint32_t lastDrained   = 0;
+static uint32_t numDrained    = 0;
+static bool     drainOrderOk  = true;
+
+// Timestamps kept : each value was written at value * WRITE_INTERVAL_MS from the start
+static uint32_t writeStart_ms = 0;
+static bool     drainTimeOk   = true;
+
+static void onDrain(const BlynkQueuedWrite& entry)
+{
+  // Not terminated : len excludes the last 0
+  char text[OFFLINE_QUEUE_ENTRY_LEN + 1];
+
+  memcpy(text, entry.data, entry.len);
+  text[entry.len] = 0;
+
+  const char* pin   = text + 3;
+  uint32_t    value = atol(pin + strlen(pin) + 1);
+
+  if (numDrained && (value <= lastDrained))
+    drainOrderOk = false;
+
+  if (entry.at_ms != writeStart_ms + value * WRITE_INTERVAL_MS)
+    drainTimeOk = false;
+
+  lastDrained = value;
+  numDrained++;
+}
+
+static void testDownsample()
+{
+  TestBlynk                       blynk;
+  BlynkOfflineQueue<TestBlynk>    queue(blynk, "/offq_ds.dat");
+
+  queue.begin(OFFLINE_QUEUE_DOWNSAMPLE);
+  queue.setDrainHandler(onDrain);
+
+  blynk.online  = false;
+  writeStart_ms = millis();
+
+  uint32_t written = 3 * queue.getCapacity();
+
+  for (uint32_t value = 0; value < written; value++)
+  {
+    queue.virtualWrite(VALUE_PIN, (unsigned int) value);
+    delay(WRITE_INTERVAL_MS);
+  }
+
+  uint32_t kept = queue.getSize();
+
+  blynk.online = true;
+
+  while (queue.getSize())
+  {
+    queue.run();
+    delay(RUN_INTERVAL_MS);
+  }
+
+  printf("OQ:Downsample,Written=%u,Kept=%u,Dropped=%u,Drained=%u,Last=%u\n", written, kept, queue.getDropped(),
+         numDrained, lastDrained);
+
+  CHECK(drainOrderOk);
+  CHECK(drainTimeOk);
+  CHECK(numDrained == kept);
+  CHECK(kept + queue.getDropped() == written);
+  // The newest write is always kept
+  CHECK(lastDrained == written - 1);
+}
+
+static void testBadSlot()
+{
+  TestBlynk                       blynk;
+  BlynkOfflineQueue<TestBlynk>    queue(blynk, "/offq_bad.dat");
+
+  queue.begin();
+
+  blynk.online = false;
+
+  uint32_t written = OFFLINE_QUEUE_SIZE + 10;
+
+  for (uint32_t value = 0; value < written; value++)
+    queue.virtualWrite(VALUE_PIN, (unsigned int) value);
+
+  // The first read of the file fails
+  hostFsFailReads = 1;
+  blynk.online    = true;
+
+  while (queue.getSize())
+  {
+    queue.run();
+    delay(RUN_INTERVAL_MS);
+  }
+
+  printf("OQ:BadSlot,Written=%u,Received=%u,Dropped=%u,First=%u\n", written, (uint32_t) blynk.received.size(),
+         queue.getDropped(), blynk.received.empty() ? 0 : blynk.received[0]);
+
+  CHECK(queue.getDropped() == 1);
+  CHECK(blynk.received.size() == written - 1);
+  CHECK(!blynk.received.empty() && (blynk.received[0] == 1));
+  CHECK(blynk.received.back() == written - 1);
+}
+
+int main()
+{
+  SPIFFS.begin();
+
+  testReplay();
+  testDownsample();
+  testBadSlot();
+
+  printf("offline_queue: %s\n", numFailures ? "FAIL" : "PASS");
+
+  return numFailures ? 1 : 0;
+}
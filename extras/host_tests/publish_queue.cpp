@@ -0,0 +1,143 @@
+/****************************************************************************************************************************
+   publish_queue.cpp
+   Host test of <BlynkEsp32_PublishQueue.h> : concurrent producers on BlynkMpscQueue
+
+   NUM_PRODUCERS threads each publish WRITES_PER_PRODUCER values 0, 1, 2... on their own pin, half of them with
+   virtualWrite() and half with virtualWriteFromISR(), retrying when the ring is full. One consumer thread drains it
+   with run(), as the Blynk task does. Each pin must receive all its values, once and in order, every entry must decode
+   intact, and getDropped() must count the full-ring retries exactly.
+   Run with "make tsan" under ThreadSanitizer : no data race may be reported.
+ *****************************************************************************************************************************/
+
+#include <Arduino.h>
+#include <Blynk/BlynkConfig.h>
+#include <Blynk/BlynkProtocolDefs.h>
+#include <Blynk/BlynkParam.h>
+#include <BlynkEsp32_PublishQueue.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#define NUM_PRODUCERS           4
+#define WRITES_PER_PRODUCER     200000
+
+static int numFailures = 0;
+
+#define CHECK(cond)                                                           \
+  do                                                                          \
+  {                                                                           \
+    if (!(cond))                                                              \
+    {                                                                         \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+      numFailures++;                                                          \
+    }                                                                         \
+  } while (0)
+
+// The Blynk instance : checks each write it is sent. Consumer thread only.
+class TestBlynk
+{
+  public:
+    uint32_t  next[NUM_PRODUCERS] = { 0 };
+    uint32_t  numReceived         = 0;
+    uint32_t  numBad              = 0;
+
+    bool connected()
+    {
+      return true;
+    }
+
+    void sendCmd(uint8_t cmd, uint16_t id, const char* data, size_t length)
+    {
+      // "vw\0<pin>\0<value>", the last 0 not sent
+      char text[PUBLISH_QUEUE_ENTRY_LEN + 1];
+
+      memcpy(text, data, length);
+      text[length] = 0;
+
+      const char* pin   = text + 3;
+      const char* value = pin + strlen(pin) + 1;
+      long        p     = atol(pin);
+
+      numReceived++;
+
+      if ( (cmd != BLYNK_CMD_HARDWARE) || strcmp(text, "vw") || (value >= text + length) ||
+           (p < 0) || (p >= NUM_PRODUCERS) || ((uint32_t) atol(value) != next[p]) )
+      {
+        numBad++;
+        return;
+      }
+
+      next[p]++;
+    }
+};
+
+int main()
+{
+  hostRealTime = true;
+
+  TestBlynk                         blynk;
+  BlynkPublishQueue<TestBlynk>      queue(blynk);
+
+  // Too long for an entry : refused, counted
+  CHECK(!queue.virtualWrite(0, "a value much longer than an entry of the queue"));
+  CHECK(queue.getDropped() == 1);
+
+  queue.resetStats();
+
+  std::atomic<uint32_t>     numDone(0);
+  std::atomic<uint32_t>     numFull(0);
+  std::vector<std::thread>  producers;
+
+  for (int p = 0; p < NUM_PRODUCERS; p++)
+  {
+    producers.emplace_back([&, p]
+    {
+      uint32_t full = 0;
+
+      for (uint32_t i = 0; i < WRITES_PER_PRODUCER; i++)
+      {
+        while ( !( (p & 1) ? queue.virtualWriteFromISR(p, i) : queue.virtualWrite(p, (unsigned int) i) ) )
+        {
+          full++;
+          std::this_thread::yield();
+        }
+      }
+
+      numFull += full;
+      numDone++;
+    });
+  }
+
+  std::thread consumer([&]
+  {
+    while ( (numDone < NUM_PRODUCERS) || queue.getDepth() )
+    {
+      if (!queue.run())
+        std::this_thread::yield();
+    }
+  });
+
+  for (std::thread& producer : producers)
+    producer.join();
+
+  consumer.join();
+
+  printf("PQ:Writes=%u,Received=%u,Bad=%u,Full=%u,Dropped=%u,MaxDepth=%u\n", NUM_PRODUCERS * WRITES_PER_PRODUCER,
+         blynk.numReceived, blynk.numBad, (uint32_t) numFull, queue.getDropped(), queue.getMaxDepth());
+
+  CHECK(blynk.numReceived == NUM_PRODUCERS * WRITES_PER_PRODUCER);
+  CHECK(blynk.numBad == 0);
+
+  for (int p = 0; p < NUM_PRODUCERS; p++)
+    CHECK(blynk.next[p] == WRITES_PER_PRODUCER);
+
+  // Too long cleared by resetStats() : every refused write is a full ring, seen by its producer
+  CHECK(queue.getDropped() == numFull);
+  CHECK(queue.getMaxDepth() <= PUBLISH_QUEUE_SIZE);
+  CHECK(queue.getDepth() == 0);
+
+  printf("publish_queue: %s\n", numFailures ? "FAIL" : "PASS");
+
+  return numFailures ? 1 : 0;
+}
@@ -0,0 +1,217 @@
+/****************************************************************************************************************************
+   pulse_counter.cpp
+   Host test of <BlynkEsp32_PulseCounter.h> : Poisson pulse trains through the PCNT model of mock/driver/pcnt.h
+
+   For each rate, SIM_SECONDS of Poisson pulses of 2 to 10 us, plus glitches below the filter width. Overlapping pulses
+   merge into one edge, as on the tube output. getTotal() is read every READ_INTERVAL_MS and must equal the number of
+   edges so far, with no loss nor double count across the 16-bit wraps :
+   - each rate starts with a burst up to just below the limit, so even the slowest train crosses a wrap;
+   - the overflow ISR is deferred, and run before or after the read at random, so reads see wraps not counted yet;
+   - some reads get pulses injected between the overflow count and the counter read, crossing the limit, with or
+     without the ISR running there.
+   getTotal() sees a wrap whose ISR is still pending only within PULSE_COUNTER_LIMIT / 2 pulses of the previous read,
+   which the injections respect : the ISR runs microseconds after the wrap on the board.
+   getCountSince() every second must add up to the total.
+ *****************************************************************************************************************************/
+
+#include <Arduino.h>
+#include <Blynk/BlynkDebug.h>
+#include <BlynkEsp32_PulseCounter.h>
+
+#include <random>
+
+#define SIM_SECONDS             600
+#define READ_INTERVAL_MS        100
+#define PULSE_MIN_NS            2000
+#define PULSE_MAX_NS            10000
+#define GLITCH_MAX_NS           900
+#define GLITCH_RATIO            0.2
+
+#define GEIGER_PIN              25
+
+static int numFailures = 0;
+
+#define CHECK(cond)                                                           \
+  do                                                                          \
+  {                                                                           \
+    if (!(cond))                                                              \
+    {                                                                         \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+      numFailures++;                                                          \
+    }                                                                         \
+  } while (0)
+
+static std::mt19937_64  rng(0x5EED);
+static uint64_t         numEdges    = 0;
+static uint64_t         numInjected = 0;
+static int16_t          lastSeen    = 0;
+
+static double uniform()
+{
+  return std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+}
+
+// Crosses the wrap inside getTotal(), between its two reads
+static void injectOnRead(pcnt_unit_t unit)
+{
+  HostPcntUnit& u = hostPcnt[unit];
+
+  uint32_t since  = (u.value - lastSeen + PULSE_COUNTER_LIMIT) % PULSE_COUNTER_LIMIT;
+  uint32_t toWrap = PULSE_COUNTER_LIMIT - u.value;
+  uint32_t count  = toWrap + (uint32_t) (uniform() * 100);
+
+  if ( !u.pendingIsr && (since + count < PULSE_COUNTER_LIMIT / 2) && (uniform() < 0.05) )
+  {
+    for (uint32_t i = 0; i < count; i++)
+      hostPcntPulse(unit, PULSE_MIN_NS);
+
+    numEdges    += count;
+    numInjected += count;
+
+    if (uniform() < 0.5)
+      hostPcntRunIsr(unit);
+  }
+
+  lastSeen = u.value;
+}
+
+// A burst of short pulses, read at once
+static void burst(BlynkPulseCounter& counter, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; i++)
+    numEdges += hostPcntPulse(PCNT_UNIT_0, PULSE_MIN_NS);
+
+  hostPcntRunIsr(PCNT_UNIT_0);
+  counter.getTotal();
+}
+
+static void simulate(BlynkPulseCounter& counter, double cps)
+{
+  std::exponential_distribution<double> interval(cps * (1 + GLITCH_RATIO));
+
+  burst(counter, PULSE_COUNTER_LIMIT - 20 - hostPcnt[PCNT_UNIT_0].value);
+
+  // Baseline, after the read : it can inject
+  uint32_t  startTotal  = counter.getTotal();
+  uint64_t  startEdges  = numEdges;
+  uint32_t  startOverflows = counter.getNumOverflows();
+  uint64_t  numPulses   = 0;
+  uint64_t  numMerged   = 0;
+  uint64_t  numGlitches = 0;
+  uint64_t  numReads    = 0;
+  uint64_t  numBadReads = 0;
+  uint64_t  sumSince    = 0;
+
+  double    start_us    = (double) hostTime_us;
+  double    t_us        = start_us;
+  double    busyUntil   = 0;
+  double    nextRead    = start_us + READ_INTERVAL_MS * 1000.0;
+  double    end_us      = start_us + SIM_SECONDS * 1e6;
+
+  BlynkPulseSnapshot  last = counter.snapshot();
+  uint32_t            readsPerSecond = 1000 / READ_INTERVAL_MS;
+
+  while (t_us < end_us)
+  {
+    t_us += interval(rng) * 1e6;
+
+    // Reads due before this pulse
+    while ( (nextRead <= t_us) && (nextRead < end_us) )
+    {
+      hostTime_us = (uint64_t) nextRead;
+
+      bool runIsrFirst = (uniform() < 0.5);
+
+      if (runIsrFirst)
+        hostPcntRunIsr(PCNT_UNIT_0);
+
+      uint32_t total = counter.getTotal();
+
+      numReads++;
+
+      if (total - startTotal != numEdges - startEdges)
+        numBadReads++;
+
+      if (!runIsrFirst)
+        hostPcntRunIsr(PCNT_UNIT_0);
+
+      if (numReads % readsPerSecond == 0)
+        sumSince += counter.getCountSince(last);
+
+      nextRead += READ_INTERVAL_MS * 1000.0;
+    }
+
+    if (t_us >= end_us)
+      break;
+
+    // A glitch, or a pulse of the tube
+    if (uniform() < GLITCH_RATIO / (1 + GLITCH_RATIO))
+    {
+      numGlitches += !hostPcntPulse(PCNT_UNIT_0, 50 + (uint32_t) (uniform() * (GLITCH_MAX_NS - 50)));
+      continue;
+    }
+
+    double width_ns = PULSE_MIN_NS + uniform() * (PULSE_MAX_NS - PULSE_MIN_NS);
+
+    numPulses++;
+
+    // Starts while the previous one is still high : no new edge
+    if (t_us < busyUntil)
+    {
+      numMerged++;
+
+      if (t_us + width_ns / 1000 > busyUntil)
+        busyUntil = t_us + width_ns / 1000;
+
+      continue;
+    }
+
+    busyUntil = t_us + width_ns / 1000;
+
+    if (hostPcntPulse(PCNT_UNIT_0, (uint32_t) width_ns))
+      numEdges++;
+  }
+
+  hostTime_us = (uint64_t) end_us;
+  hostPcntRunIsr(PCNT_UNIT_0);
+
+  uint32_t counted = counter.getTotal() - startTotal;
+
+  sumSince += counter.getCountSince(last);
+
+  printf("PC:cps=%.1f,Pulses=%llu,Merged=%llu,Glitches=%llu,Edges=%llu,Counted=%u,Wraps=%u,Reads=%llu,BadReads=%llu\n",
+         cps, (unsigned long long) numPulses, (unsigned long long) numMerged, (unsigned long long) numGlitches,
+         (unsigned long long) (numEdges - startEdges), counted, counter.getNumOverflows() - startOverflows,
+         (unsigned long long) numReads, (unsigned long long) numBadReads);
+
+  CHECK(counted == numEdges - startEdges);
+  CHECK(numBadReads == 0);
+  CHECK(sumSince == counted);
+  CHECK(numGlitches > 0);
+  CHECK(counter.getNumOverflows() > startOverflows);
+}
+
+int main()
+{
+  BlynkPulseCounter counter(GEIGER_PIN);
+
+  CHECK(counter.begin());
+
+  hostPcntDeferIsr  = true;
+  hostPcntOnRead    = injectOnRead;
+
+  const double rates[] = { 0.5, 5, 50, 500, 5000, 50000 };
+
+  for (double cps : rates)
+    simulate(counter, cps);
+
+  printf("PC:Injected=%llu,Overflows=%u\n", (unsigned long long) numInjected, counter.getNumOverflows());
+
+  CHECK(numInjected > 0);
+
+  counter.end();
+
+  printf("pulse_counter: %s\n", numFailures ? "FAIL" : "PASS");
+
+  return numFailures ? 1 : 0;
+}
@@ -0,0 +1,143 @@
+/****************************************************************************************************************************
+   reconnect_fleet.cpp
+   Host test of <BlynkEsp32_Backoff.h> : a fleet of boards reconnecting to one server
+
+   FLEET_SIZE boards, each with its own BlynkReconnectPolicy, lose the server at the same time. It is down for
+   OUTAGE_S seconds, then accepts at most SERVER_LOGINS_PER_S logins per second : attempts above that fail, as on an
+   overloaded server. Two runs :
+   - Jitter : each policy seeded from its board's efuse MAC, consecutive as in one production batch.
+   - Same seed : all boards seeded alike, the herd a shared seed would make.
+   Prints the attempts per second over time. With the MAC seeds, the attempts of any PEAK_MS must be a small part
+   of the fleet, few attempts may be turned away by the loaded server after the outage, and all boards must be back
+   within the backoff window. With the same seed, the whole fleet hits the server in the same step.
+ *****************************************************************************************************************************/
+
+#include <Arduino.h>
+#include <BlynkEsp32_Backoff.h>
+
+#include <vector>
+
+#define FLEET_SIZE              1000
+#define OUTAGE_S                60
+#define SERVER_LOGINS_PER_S     50
+#define SIM_S                   (OUTAGE_S + 600)
+#define STEP_MS                 10
+#define HISTOGRAM_S             10
+#define PEAK_MS                 100
+
+static int numFailures = 0;
+
+#define CHECK(cond)                                                           \
+  do                                                                          \
+  {                                                                           \
+    if (!(cond))                                                              \
+    {                                                                         \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+      numFailures++;                                                          \
+    }                                                                         \
+  } while (0)
+
+typedef struct
+{
+  uint32_t  peak;           // Attempts in PEAK_MS
+  uint32_t  lastBack_s;
+  uint32_t  numBack;
+  uint32_t  numAttempts;
+  uint32_t  numOverloaded;  // Turned away by the server once up
+} FleetResult;
+
+static FleetResult simulate(const char* name, bool sameSeed)
+{
+  std::vector<BlynkReconnectPolicy> boards(FLEET_SIZE);
+  std::vector<bool>                 back(FLEET_SIZE, false);
+  std::vector<uint32_t>             perSecond(SIM_S, 0);
+  std::vector<uint32_t>             perPeak(SIM_S * 1000 / PEAK_MS, 0);
+
+  FleetResult result = { 0, 0, 0, 0, 0 };
+
+  for (uint32_t i = 0; i < FLEET_SIZE; i++)
+  {
+    boards[i].begin(sameSeed ? 0x2462ABCDEF01ULL : 0x2462ABCD0000ULL + i);
+    boards[i].lost();
+  }
+
+  for (uint32_t t_ms = 0; t_ms < SIM_S * 1000; t_ms += STEP_MS)
+  {
+    uint32_t second = t_ms / 1000;
+
+    for (uint32_t i = 0; i < FLEET_SIZE; i++)
+    {
+      if (back[i] || !boards[i].due())
+        continue;
+
+      perSecond[second]++;
+      perPeak[t_ms / PEAK_MS]++;
+      result.numAttempts++;
+
+      // Down, then at most SERVER_LOGINS_PER_S accepted each second
+      bool accepted = (second >= OUTAGE_S) && (perSecond[second] <= SERVER_LOGINS_PER_S);
+
+      if (accepted)
+      {
+        boards[i].succeeded();
+        back[i] = true;
+        result.numBack++;
+        result.lastBack_s = second;
+      }
+      else
+      {
+        boards[i].failed();
+
+        if (second >= OUTAGE_S)
+          result.numOverloaded++;
+      }
+    }
+
+    hostAdvance_us(STEP_MS * 1000);
+  }
+
+  printf("Fleet:%s,Attempts/s per %us :", name, HISTOGRAM_S);
+
+  for (uint32_t s = 0; s < SIM_S; s += HISTOGRAM_S)
+  {
+    uint32_t sum = 0;
+
+    for (uint32_t i = s; i < s + HISTOGRAM_S; i++)
+      sum += perSecond[i];
+
+    if (s < OUTAGE_S + 300)
+      printf(" %u", sum / HISTOGRAM_S);
+  }
+
+  for (uint32_t count : perPeak)
+  {
+    if (count > result.peak)
+      result.peak = count;
+  }
+
+  printf("\nFleet:%s,Peak=%u/%ums,Attempts=%u,Overloaded=%u,Back=%u,LastBack=%us\n", name, result.peak, PEAK_MS,
+         result.numAttempts, result.numOverloaded, result.numBack, result.lastBack_s);
+
+  return result;
+}
+
+int main()
+{
+  FleetResult jitter    = simulate("Jitter", false);
+  FleetResult sameSeed  = simulate("SameSeed", true);
+
+  CHECK(jitter.numBack == FLEET_SIZE);
+  // Within one full backoff window after the outage, plus the time the server needs for the fleet
+  CHECK(jitter.lastBack_s <= OUTAGE_S + RECONNECT_BACKOFF_MAX_MS / 1000 + FLEET_SIZE / SERVER_LOGINS_PER_S);
+  CHECK(jitter.peak <= FLEET_SIZE / 8);
+  CHECK(jitter.numOverloaded <= FLEET_SIZE / 20);
+
+  // The herd : the whole fleet in the same step, most of it turned away each time
+  CHECK(sameSeed.peak == FLEET_SIZE);
+  CHECK(sameSeed.numOverloaded > FLEET_SIZE);
+  CHECK(sameSeed.numBack < FLEET_SIZE);
+
+  printf("reconnect_fleet: %s\n", numFailures ? "FAIL" : "PASS");
+
+  return numFailures ? 1 : 0;
+}
@@ -0,0 +1,467 @@
+/****************************************************************************************************************************
+   trace.cpp
+   Host test of <BlynkEsp32_Trace.h> : the Chrome Trace Event dump
+
+   - Dump : nested scopes and instants on both cores, dumped through Print and parsed back as JSON. It must be a valid
+     Chrome trace : a traceEvents array of events with name, ph, ts, pid and tid, Begin / End matched per core, and
+     ts in order. The dump is also written to build/trace.json, to open in chrome://tracing or ui.perfetto.dev.
+   - Wrap : more events than BLYNK_TRACE_BUFFER_SIZE. The newest are dumped, oldest first, and the others counted.
+   - Both cores : two threads recording at once, on the host clock. No event lost nor torn. Run under
+     ThreadSanitizer by "make tsan".
+ *****************************************************************************************************************************/
+
+#define BLYNK_USE_TRACE         true
+
+#include <Arduino.h>
+#include <BlynkEsp32_Trace.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#define NUM_RUNS                20
+#define EVENTS_PER_THREAD       100000
+
+static int numFailures = 0;
+
+#define CHECK(cond)                                                           \
+  do                                                                          \
+  {                                                                           \
+    if (!(cond))                                                              \
+    {                                                                         \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+      numFailures++;                                                          \
+    }                                                                         \
+  } while (0)
+
+// Print into a string
+class CapturePrint : public Print
+{
+  public:
+    std::string text;
+
+    using Print::write;
+
+    size_t write(uint8_t c)
+    {
+      text += (char) c;
+      return 1;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Minimal JSON parser, enough to check the dump
+
+typedef struct JsonValue
+{
+  enum { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT } type = NUL;
+
+  double                                          number = 0;
+  std::string                                     str;
+  std::vector<JsonValue>                          items;
+  std::vector<std::pair<std::string, JsonValue>>  members;
+
+  const JsonValue* get(const char* key) const
+  {
+    for (const auto& member : members)
+    {
+      if (member.first == key)
+        return &member.second;
+    }
+
+    return NULL;
+  }
+} JsonValue;
+
+class JsonParser
+{
+  public:
+    JsonParser(const std::string& input)
+      : text(input)
+    {}
+
+    // Whole text, one value with only white space after it
+    bool parse(JsonValue& value)
+    {
+      if (!parseValue(value))
+        return false;
+
+      skipSpace();
+
+      return pos == text.size();
+    }
+
+  private:
+    const std::string&  text;
+    size_t              pos = 0;
+
+    void skipSpace()
+    {
+      while ( (pos < text.size()) && isspace((unsigned char) text[pos]) )
+        pos++;
+    }
+
+    bool expect(char c)
+    {
+      skipSpace();
+
+      if ( (pos < text.size()) && (text[pos] == c) )
+      {
+        pos++;
+        return true;
+      }
+
+      return false;
+    }
+
+    bool parseString(std::string& out)
+    {
+      if (!expect('"'))
+        return false;
+
+      while (pos < text.size())
+      {
+        char c = text[pos++];
+
+        if (c == '"')
+          return true;
+
+        // Control characters must be escaped
+        if ( (unsigned char) c < 0x20 )
+          return false;
+
+        if (c == '\\')
+        {
+          if (pos >= text.size())
+            return false;
+
+          c = text[pos++];
+
+          if (!strchr("\"\\/bfnrtu", c))
+            return false;
+
+          if (c == 'u')
+            pos += 4;
+        }
+
+        out += c;
+      }
+
+      return false;
+    }
+
+    bool parseValue(JsonValue& value)
+    {
+      skipSpace();
+
+      if (pos >= text.size())
+        return false;
+
+      char c = text[pos];
+
+      if (c == '{')
+      {
+        pos++;
+        value.type = JsonValue::OBJECT;
+
+        if (expect('}'))
+          return true;
+
+        do
+        {
+          std::pair<std::string, JsonValue> member;
+
+          if ( !parseString(member.first) || !expect(':') || !parseValue(member.second) )
+            return false;
+
+          value.members.push_back(member);
+        } while (expect(','));
+
+        return expect('}');
+      }
+
+      if (c == '[')
+      {
+        pos++;
+        value.type = JsonValue::ARRAY;
+
+        if (expect(']'))
+          return true;
+
+        do
+        {
+          JsonValue item;
+
+          if (!parseValue(item))
+            return false;
+
+          value.items.push_back(item);
+        } while (expect(','));
+
+        return expect(']');
+      }
+
+      if (c == '"')
+      {
+        value.type = JsonValue::STRING;
+        return parseString(value.str);
+      }
+
+      for (const char* word : { "true", "false", "null" })
+      {
+        if (!text.compare(pos, strlen(word), word))
+        {
+          pos       += strlen(word);
+          value.type = (word[0] == 'n') ? JsonValue::NUL : JsonValue::BOOL;
+          return true;
+        }
+      }
+
+      // Number : digits only where JSON allows them
+      const char* start = text.c_str() + pos;
+      char*       end;
+
+      if ( !( (c == '-') || isdigit((unsigned char) c) ) )
+        return false;
+
+      value.type    = JsonValue::NUMBER;
+      value.number  = strtod(start, &end);
+      pos          += end - start;
+
+      return end != start;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef struct
+{
+  uint32_t  numEvents;
+  uint32_t  numUnmatched;
+  uint32_t  numOutOfOrder;
+  uint32_t  dropped;
+} TraceCheck;
+
+// Parses a dump and checks it against the Chrome Trace Event format
+static bool checkTrace(const std::string& json, TraceCheck& result, bool nested)
+{
+  JsonValue root;
+
+  memset(&result, 0, sizeof(result));
+
+  if (!JsonParser(json).parse(root) || (root.type != JsonValue::OBJECT))
+    return false;
+
+  const JsonValue* events   = root.get("traceEvents");
+  const JsonValue* other    = root.get("otherData");
+  const JsonValue* dropped  = other ? other->get("dropped") : NULL;
+
+  if ( !events || (events->type != JsonValue::ARRAY) || !dropped || (dropped->type != JsonValue::NUMBER) )
+    return false;
+
+  result.dropped = (uint32_t) dropped->number;
+
+  std::vector<std::string>  open[2];
+  double                    lastTs = 0;
+
+  for (const JsonValue& ev : events->items)
+  {
+    const JsonValue* name = ev.get("name");
+    const JsonValue* ph   = ev.get("ph");
+    const JsonValue* ts   = ev.get("ts");
+    const JsonValue* pid  = ev.get("pid");
+    const JsonValue* tid  = ev.get("tid");
+
+    if ( !name || !ph || !ts || !pid || !tid || (name->type != JsonValue::STRING) || (ph->type != JsonValue::STRING) ||
+         (ts->type != JsonValue::NUMBER) || (pid->type != JsonValue::NUMBER) || (tid->type != JsonValue::NUMBER) ||
+         (tid->number < 0) || (tid->number > 1) )
+      return false;
+
+    result.numEvents++;
+
+    if (ts->number < lastTs)
+      result.numOutOfOrder++;
+
+    lastTs = ts->number;
+
+    std::vector<std::string>& stack = open[(int) tid->number];
+
+    if (ph->str == "B")
+    {
+      stack.push_back(name->str);
+    }
+    else if (ph->str == "E")
+    {
+      // Must close the innermost open scope of its core
+      if ( stack.empty() || (stack.back() != name->str) )
+        result.numUnmatched++;
+      else
+        stack.pop_back();
+    }
+    else if (ph->str == "i")
+    {
+      const JsonValue* scope = ev.get("s");
+
+      if ( !scope || (scope->str != "t") )
+        return false;
+    }
+    else
+    {
+      return false;
+    }
+  }
+
+  if (nested)
+    result.numUnmatched += open[0].size() + open[1].size();
+
+  return true;
+}
+
+static void simulateRun(uint32_t run)
+{
+  BLYNK_TRACE_SCOPE("run");
+
+  delayMicroseconds(50);
+
+  if (run % 5 == 0)
+  {
+    BLYNK_TRACE_SCOPE("connect");
+
+    delay(2);
+    BLYNK_TRACE_INSTANT("login");
+  }
+
+  BLYNK_TRACE_BEGIN("processInput");
+  delayMicroseconds(120);
+  BLYNK_TRACE_END("processInput");
+}
+
+static void testDump()
+{
+  BlynkTracer.clear();
+
+  for (uint32_t run = 0; run < NUM_RUNS; run++)
+  {
+    simulateRun(run);
+
+    // BT task on the other core
+    hostCoreID = 0;
+    {
+      BLYNK_TRACE_SCOPE("bt.run");
+      delayMicroseconds(30);
+    }
+    hostCoreID = 1;
+
+    delay(10);
+  }
+
+  CapturePrint  out;
+  TraceCheck    check;
+
+  BLYNK_TRACE_DUMP(out);
+
+  bool valid = checkTrace(out.text, check, true);
+
+  FILE* file = fopen("build/trace.json", "w");
+
+  if (file)
+  {
+    fputs(out.text.c_str(), file);
+    fclose(file);
+  }
+
+  printf("Trace:Dump,Bytes=%u,Events=%u,Unmatched=%u,OutOfOrder=%u,%s\n", (uint32_t) out.text.size(),
+         check.numEvents, check.numUnmatched, check.numOutOfOrder, valid ? "valid" : "INVALID");
+
+  CHECK(valid);
+  // run, processInput and bt.run : B and E. connect : B, E and one instant.
+  CHECK(check.numEvents == NUM_RUNS * 6 + (NUM_RUNS / 5) * 3);
+  CHECK(check.numEvents == BlynkTracer.size());
+  CHECK(check.numUnmatched == 0);
+  CHECK(check.numOutOfOrder == 0);
+  CHECK(check.dropped == 0);
+}
+
+static void testWrap()
+{
+  BlynkTracer.clear();
+
+  uint32_t total = 3 * BLYNK_TRACE_BUFFER_SIZE + 7;
+
+  for (uint32_t i = 0; i < total; i++)
+  {
+    BLYNK_TRACE_INSTANT("tick");
+    delayMicroseconds(10);
+  }
+
+  CapturePrint  out;
+  TraceCheck    check;
+
+  BLYNK_TRACE_DUMP(out);
+
+  bool valid = checkTrace(out.text, check, false);
+
+  printf("Trace:Wrap,Recorded=%u,Events=%u,Dropped=%u,%s\n", total, check.numEvents, check.dropped,
+         valid ? "valid" : "INVALID");
+
+  CHECK(valid);
+  CHECK(check.numEvents == BLYNK_TRACE_BUFFER_SIZE);
+  CHECK(check.dropped == total - BLYNK_TRACE_BUFFER_SIZE);
+  CHECK(check.numOutOfOrder == 0);
+
+  // The newest, oldest first : the last one was recorded 10 us before now
+  CHECK(out.text.find("\"ts\":" + std::to_string(micros() - 10) + ",") != std::string::npos);
+}
+
+static void testBothCores()
+{
+  hostRealTime = true;
+
+  BlynkTracer.clear();
+
+  std::vector<std::thread> threads;
+
+  for (int core = 0; core < 2; core++)
+  {
+    threads.emplace_back([core]
+    {
+      hostCoreID = core;
+
+      for (uint32_t i = 0; i < EVENTS_PER_THREAD / 2; i++)
+      {
+        BLYNK_TRACE_SCOPE("task");
+      }
+    });
+  }
+
+  for (std::thread& thread : threads)
+    thread.join();
+
+  CapturePrint  out;
+  TraceCheck    check;
+
+  BLYNK_TRACE_DUMP(out);
+
+  // Timestamps are taken before the lock, so not in order across cores
+  bool valid = checkTrace(out.text, check, false);
+
+  printf("Trace:BothCores,Recorded=%u,Events=%u,Dropped=%u,%s\n", 2 * EVENTS_PER_THREAD, check.numEvents,
+         check.dropped, valid ? "valid" : "INVALID");
+
+  CHECK(valid);
+  CHECK(check.numEvents == BLYNK_TRACE_BUFFER_SIZE);
+  CHECK(check.numEvents + check.dropped == 2 * EVENTS_PER_THREAD);
+
+  hostRealTime = false;
+}
+
+int main()
+{
+  testDump();
+  testWrap();
+  testBothCores();
+
+  printf("trace: %s\n", numFailures ? "FAIL" : "PASS");
+
+  return numFailures ? 1 : 0;
+}
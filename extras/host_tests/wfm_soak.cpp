@@ -0,0 +1,256 @@
+/****************************************************************************************************************************
+   wfm_soak.cpp
+   Host test of <BlynkSimpleEsp32_WFM.h> : heap soak of the Config Portal and the config getters
+
+   Runs the unmodified header over the mocks, on the heap model of HostHeap.h : first-fit with coalescing, so free
+   size and largest free block move as on the board. Phases :
+   - Portal : no config data, the portal runs. SOAK_CYCLES of page, scan and run(), then a full submission.
+   - Connected : after the reboot, the portal is closed. SOAK_CYCLES of every getter and run(), with background
+     roaming scans, and a server outage every SOAK_OUTAGE_EVERY cycles.
+   BlynkHeapAudit samples the heap at the end of each cycle. Both phases must be flat with no tolerance, with a peak
+   reached in the first cycle, and the getters must not allocate at all.
+ *****************************************************************************************************************************/
+
+#define HOST_HEAP_SIZE          (64 * 1024)
+
+#define BLYNK_PRINT             Serial
+#define BLYNK_WM_LOG_LEVEL      BLYNK_LOG_LEVEL_DEBUG
+
+#define USE_WIFI_ROAMING        true
+#define USE_RUN_WATCHDOG        true
+#define BLYNK_USE_TRACE         true
+
+#include <Arduino.h>
+
+#include <BlynkSimpleEsp32_WFM.h>
+
+#define SOAK_CYCLES             5000
+#define SOAK_OUTAGE_EVERY       500
+#define SOAK_OUTAGE_CYCLES      5
+#define SOAK_RUNS_PER_CYCLE     8
+#define SOAK_CYCLE_MS           1000
+
+char mqttServer[21] = "blank";
+char mqttUser[21]   = "blank";
+
+MenuItem myMenuItems [] =
+{
+  { "mqtt", "MQTT Server", mqttServer,  20 },
+  { "user", "MQTT User",   mqttUser,    20 },
+};
+
+uint16_t NUM_MENU_ITEMS = sizeof(myMenuItems) / sizeof(MenuItem);
+
+static int numFailures = 0;
+
+#define CHECK(cond)                                                           \
+  do                                                                          \
+  {                                                                           \
+    if (!(cond))                                                              \
+    {                                                                         \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+      numFailures++;                                                          \
+    }                                                                         \
+  } while (0)
+
+// Values submitted through the portal, as the page script sends them
+typedef struct
+{
+  const char* key;
+  const char* value;
+} PortalValue;
+
+static const PortalValue portalValues[] =
+{
+  { "id",   "HomeNetwork-2.4GHz"  },  { "pw",   "HomePassword"    },
+  { "id1",  "OfficeNetwork"       },  { "pw1",  "OfficePassword"  },
+  { "sv",   "blynk.example"       },  { "tk",   "token0"          },
+  { "sv1",  "backup.example"      },  { "tk1",  "token1"          },
+  { "pt",   "8080"                },  { "rmin", "3"               },
+  { "rmax", "90"                  },  { "bttk", "bttoken"         },
+  { "bltk", "bletoken"            },  { "nm",   "SoakBoard"       },
+  { "mqtt", "mqtt.example"        },  { "user", "soak<&\"'>"      },
+};
+
+#define NUM_PORTAL_VALUES       ( sizeof(portalValues) / sizeof(portalValues[0]) )
+
+static_assert(NUM_PORTAL_VALUES == NUM_CONFIGURABLE_ITEMS + 2, "one value per config field and menu item");
+
+static void runFor(uint8_t numRuns)
+{
+  for (uint8_t i = 0; i < numRuns; i++)
+  {
+    Blynk_WF.run();
+    delay(SOAK_CYCLE_MS / numRuns);
+  }
+}
+
+static void report(const char* phase, BlynkHeapAudit& audit, uint32_t allocs, uint32_t numScans)
+{
+  printf("Soak:%s,Cycles=%u,Free=%d,Largest=%d,Peak=%u,Allocs=%u,Scans=%u,%s\n", phase, audit.getCycles(),
+         audit.getFreeDelta(), audit.getLargestDelta(), HostHeap::peakBytes, allocs, numScans,
+         audit.isFlat(0) ? "flat" : "LEAK");
+}
+
+int main()
+{
+  BlynkHeapAudit audit;
+
+  hostQuiet = true;
+
+  // Long enough SSIDs for a String to allocate. Both HomeAP under the roaming threshold, too close to hand over.
+  hostAddAP("HomeNetwork-2.4GHz",   -74,  6, 1);
+  hostAddAP("HomeNetwork-2.4GHz",   -71, 11, 2);
+  hostAddAP("OfficeNetwork",        -85,  1, 3);
+  hostAddAP("Neighbour-Guest-WiFi", -60,  6, 4, WIFI_AUTH_OPEN);
+  hostAddAP("",                     -65,  3, 5);
+
+  EEPROM.hostErase();
+
+  // No config data : the portal comes up
+  Blynk_WF.begin("SoakBoard");
+
+  WebServer* server = hostWebServer;
+
+  CHECK(server != NULL);
+
+  if (!server)
+    return 1;
+
+  HostResponse  page;
+  uint32_t      allocsBefore    = 0;
+  uint32_t      peakAfterFirst  = 0;
+  uint32_t      numScans        = 0;
+
+  for (uint32_t cycle = 0; cycle <= SOAK_CYCLES; cycle++)
+  {
+    server->hostRequest("/");
+    Blynk_WF.run();
+
+    CHECK(server->response.code == 200);
+    CHECK(server->response.ended);
+
+    if (cycle && memcmp(&page, &server->response, sizeof(page)))
+      CHECK(!"same page at each cycle");
+
+    page = server->response;
+
+    server->hostRequest("/scan");
+    runFor(SOAK_RUNS_PER_CYCLE);
+
+    // Results of the scan of the previous request
+    CHECK( (server->response.code == 200) || (server->response.code == 202) );
+
+    if (cycle == 0)
+    {
+      audit.begin();
+      allocsBefore    = HostHeap::numAllocs;
+      peakAfterFirst  = HostHeap::peakBytes;
+      numScans        = WiFi.numScans;
+    }
+    else
+    {
+      audit.sample();
+    }
+  }
+
+  numScans = WiFi.numScans - numScans;
+
+  report("Portal", audit, HostHeap::numAllocs - allocsBefore, numScans);
+
+  CHECK(audit.isFlat(0));
+  CHECK(HostHeap::peakBytes == peakAfterFirst);
+  // The results of each scan, nothing else
+  CHECK(HostHeap::numAllocs - allocsBefore == numScans);
+
+  // Full submission : saved, then restart
+  for (uint8_t i = 0; i < NUM_PORTAL_VALUES; i++)
+  {
+    server->hostRequest("/", portalValues[i].key, portalValues[i].value);
+    Blynk_WF.run();
+  }
+
+  CHECK(ESP.numRestarts == 1);
+
+  // Reboot : config read back, WiFi and Blynk up, the portal is closed by the next run()
+  Blynk_WF.begin("SoakBoard");
+  runFor(SOAK_RUNS_PER_CYCLE);
+
+  CHECK(Blynk_WF.connected());
+  CHECK(hostWebServer == NULL);
+
+  CHECK(!strcmp(Blynk_WF.getWiFiSSID(1),  "OfficeNetwork"));
+  CHECK(!strcmp(Blynk_WF.getToken(1),     "token1"));
+  CHECK(!strcmp(Blynk_WF.getBoardName(),  "SoakBoard"));
+  CHECK(!strcmp(mqttUser,                 "soak<&\"'>"));
+  CHECK(Blynk_WF.getHWPort() == 8080);
+
+  Blynk_WM_Configuration  config;
+  uint32_t                getterAllocs  = 0;
+  uint32_t                numLogins     = Blynk_WF.numLogins;
+  size_t                  firstTotal    = 0;
+
+  for (uint32_t cycle = 0; cycle <= SOAK_CYCLES; cycle++)
+  {
+    uint32_t before = HostHeap::numAllocs;
+    size_t   total  = 0;
+
+    for (uint8_t i = 0; i < NUM_WIFI_CREDENTIALS; i++)
+      total += strlen(Blynk_WF.getWiFiSSID(i)) + strlen(Blynk_WF.getWiFiPW(i));
+
+    for (uint8_t i = 0; i < NUM_BLYNK_CREDENTIALS; i++)
+      total += strlen(Blynk_WF.getServerName(i)) + strlen(Blynk_WF.getToken(i));
+
+    total += strlen(Blynk_WF.getBlynkBTToken()) + strlen(Blynk_WF.getBlynkBLEToken()) + strlen(Blynk_WF.getBoardName());
+    total += Blynk_WF.getHWPort();
+
+    Blynk_WF.getFullConfigData(&config);
+
+    getterAllocs += HostHeap::numAllocs - before;
+
+    if (cycle == 0)
+      firstTotal = total;
+
+    CHECK(total == firstTotal);
+
+    // Server down for a few cycles : reconnects with backoff
+    uint32_t phase = cycle % SOAK_OUTAGE_EVERY;
+
+    hostServerUp = (phase < SOAK_OUTAGE_EVERY / 2) || (phase >= SOAK_OUTAGE_EVERY / 2 + SOAK_OUTAGE_CYCLES);
+
+    runFor(SOAK_RUNS_PER_CYCLE);
+
+    if (cycle == 0)
+    {
+      audit.begin();
+      allocsBefore    = HostHeap::numAllocs;
+      peakAfterFirst  = HostHeap::peakBytes;
+      numScans        = WiFi.numScans;
+    }
+    else
+    {
+      audit.sample();
+    }
+  }
+
+  numScans  = WiFi.numScans - numScans;
+  numLogins = Blynk_WF.numLogins - numLogins;
+
+  report("Connected", audit, HostHeap::numAllocs - allocsBefore, numScans);
+
+  printf("Soak:Logins=%u,GetterAllocs=%u\n", numLogins, getterAllocs);
+
+  CHECK(audit.isFlat(0));
+  CHECK(HostHeap::peakBytes == peakAfterFirst);
+  CHECK(getterAllocs == 0);
+  // Roaming scans ran, and allocated their results only
+  CHECK(numScans >= SOAK_CYCLES * SOAK_CYCLE_MS / ROAM_SCAN_INTERVAL_MS / 2);
+  CHECK(HostHeap::numAllocs - allocsBefore == numScans);
+  // Back after each outage
+  CHECK(numLogins == SOAK_CYCLES / SOAK_OUTAGE_EVERY);
+  CHECK(Blynk_WF.connected());
+
+  printf("wfm_soak: %s\n", numFailures ? "FAIL" : "PASS");
+
+  return numFailures ? 1 : 0;
+}
@@ -0,0 +1,444 @@
+/****************************************************************************************************************************
+   BlynkEsp32_Acquisition.h
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   Small sensor acquisition framework.
+   Each sensor channel is read on its own schedule. Samples are timestamped and stored in one shared ring.
+   Sinks (Blynk virtual pins of any instance, Serial, OLED fields) subscribe either to every new sample or to a
+   publish interval. They get references into the ring, so sample data is never copied.
+   The cost of sampling and of publishing is measured.
+   Include after the Blynk transport headers, and after <BlynkEsp32_OLEDFields.h> to get the OLED sink.
+ *****************************************************************************************************************************/
+
+#ifndef BlynkEsp32_Acquisition_h
+#define BlynkEsp32_Acquisition_h
+
+#include <Arduino.h>
+
+#ifndef ACQ_MAX_CHANNELS
+#define ACQ_MAX_CHANNELS          8
+#endif
+
+#ifndef ACQ_MAX_SINKS
+#define ACQ_MAX_SINKS             6
+#endif
+
+// Must hold all samples taken during the longest publish interval
+#ifndef ACQ_RING_SIZE
+#define ACQ_RING_SIZE             32
+#endif
+
+typedef enum
+{
+  SENSOR_FLOAT,             // Published with the channel digits
+  SENSOR_INT,               // Published as integer, e.g. counts
+  SENSOR_BOOL               // 0 / 1, e.g. a switch
+} BlynkSensorType;
+
+typedef float (*BlynkSensorReader)(void);
+
+typedef struct
+{
+  uint32_t  at_ms;
+  uint32_t  seq;            // Increases with each sample, never 0
+  uint8_t   channel;
+  float     value;
+} BlynkSample;
+
+typedef struct
+{
+  const char*       name;
+  BlynkSensorReader reader;
+  BlynkSensorType   type;
+  uint8_t           digits;
+  uint8_t           vpin;
+  uint32_t          interval_ms;
+  uint32_t          last_ms;
+  uint8_t           latest;       // Ring index of the latest sample
+  uint32_t          latestSeq;    // 0 if no sample yet
+} BlynkSensorChannel;
+
+class BlynkSampleSink
+{
+  public:
+    // sample is in the ring : valid until overwritten, don't keep the reference
+    virtual void onSample(const BlynkSensorChannel& channel, const BlynkSample& sample) = 0;
+
+    // After the last sample of one run() or publish
+    virtual void onBatchEnd() {}
+};
+
+class BlynkAcquisition
+{
+  public:
+    BlynkAcquisition()
+      : numChannels(0)
+      , numSinks(0)
+      , head(0)
+      , nextSeq(1)
+      , numLost(0)
+      , sampleCost_us(0)
+      , maxSampleCost_us(0)
+      , publishCost_us(0)
+    {
+      memset(ring, 0, sizeof(ring));
+    }
+
+    // Returns channel id, or -1 if ACQ_MAX_CHANNELS reached. interval_ms = 0 : only sampled by sample().
+    int8_t addChannel(const char* name, BlynkSensorReader reader, uint32_t interval_ms, uint8_t vpin,
+                      BlynkSensorType type = SENSOR_FLOAT, uint8_t digits = 2)
+    {
+      if (numChannels >= ACQ_MAX_CHANNELS)
+        return -1;
+
+      BlynkSensorChannel& ch = channels[numChannels];
+
+      ch.name         = name;
+      ch.reader       = reader;
+      ch.type         = type;
+      ch.digits       = digits;
+      ch.vpin         = vpin;
+      ch.interval_ms  = interval_ms;
+      ch.last_ms      = 0;
+      ch.latest       = 0;
+      ch.latestSeq    = 0;
+
+      return numChannels++;
+    }
+
+    // publish_ms = 0 : every new sample. Else the latest sample of each channel, every publish_ms.
+    bool addSink(BlynkSampleSink& sink, uint32_t publish_ms = 0)
+    {
+      if (numSinks >= ACQ_MAX_SINKS)
+        return false;
+
+      sinks[numSinks].sink        = &sink;
+      sinks[numSinks].interval_ms = publish_ms;
+      sinks[numSinks].last_ms     = 0;
+      sinks[numSinks].lastSeq     = 0;
+
+      numSinks++;
+
+      return true;
+    }
+
+    // Call in loop()
+    void run()
+    {
+      for (uint8_t i = 0; i < numChannels; i++)
+      {
+        BlynkSensorChannel& ch = channels[i];
+
+        if ( (ch.interval_ms == 0) || ( ch.latestSeq && (millis() - ch.last_ms < ch.interval_ms) ) )
+          continue;
+
+        ch.last_ms = millis();
+        sample(i);
+      }
+
+      // Immediate sinks, also for samples taken by sample() since the last run()
+      for (uint8_t s = 0; s < numSinks; s++)
+      {
+        if ( (sinks[s].interval_ms == 0) && (sinks[s].lastSeq != nextSeq - 1) )
+          publishSince(sinks[s], sinks[s].lastSeq + 1);
+      }
+
+      // Scheduled sinks
+      for (uint8_t s = 0; s < numSinks; s++)
+      {
+        SinkEntry& entry = sinks[s];
+
+        if ( (entry.interval_ms == 0) || (millis() - entry.last_ms < entry.interval_ms) )
+          continue;
+
+        entry.last_ms = millis();
+        publishLatest(entry);
+      }
+    }
+
+    // Take one sample now, e.g. when a computed value is ready. Sinks get it at the next run().
+    void sample(uint8_t channel)
+    {
+      if (channel >= numChannels)
+        return;
+
+      uint32_t start = micros();
+
+      BlynkSensorChannel& ch = channels[channel];
+      BlynkSample& s = ring[head];
+
+      s.value   = ch.reader();
+      s.at_ms   = millis();
+      s.seq     = nextSeq++;
+      s.channel = channel;
+
+      ch.latest     = head;
+      ch.latestSeq  = s.seq;
+
+      head = (head + 1) % ACQ_RING_SIZE;
+
+      uint32_t cost = micros() - start;
+
+      // EWMA with alpha = 1/8
+      sampleCost_us = sampleCost_us ? (7 * sampleCost_us + cost) / 8 : cost;
+
+      if (cost > maxSampleCost_us)
+        maxSampleCost_us = cost;
+    }
+
+    // NULL if none yet, or already overwritten
+    const BlynkSample* getLatest(uint8_t channel)
+    {
+      if ( (channel >= numChannels) || (channels[channel].latestSeq == 0) )
+        return NULL;
+
+      const BlynkSample& s = ring[channels[channel].latest];
+
+      return (s.seq == channels[channel].latestSeq) ? &s : NULL;
+    }
+
+    // 0 is the most recent sample of any channel. NULL if out of range.
+    const BlynkSample* getHistory(uint8_t index)
+    {
+      if ( (index >= ACQ_RING_SIZE) || (index >= nextSeq - 1) )
+        return NULL;
+
+      return &ring[(head + ACQ_RING_SIZE - 1 - index) % ACQ_RING_SIZE];
+    }
+
+    const BlynkSensorChannel& getChannel(uint8_t channel)
+    {
+      return channels[channel];
+    }
+
+    uint8_t getNumChannels()
+    {
+      return numChannels;
+    }
+
+    // Samples overwritten before an immediate sink got them. ACQ_RING_SIZE too small if not 0.
+    uint32_t getNumLost()
+    {
+      return numLost;
+    }
+
+    // Smoothed read + store time of one sample, in us. The reader itself is included.
+    uint32_t getSampleCost()
+    {
+      return sampleCost_us;
+    }
+
+    uint32_t getMaxSampleCost()
+    {
+      return maxSampleCost_us;
+    }
+
+    // Smoothed time of one sink call with its samples, in us
+    uint32_t getPublishCost()
+    {
+      return publishCost_us;
+    }
+
+    void print(Print& out)
+    {
+      out.print(F("Acq:Samples="));
+      out.print(nextSeq - 1);
+      out.print(F(",Lost="));
+      out.print(numLost);
+      out.print(F(",SampleUs="));
+      out.print(sampleCost_us);
+      out.print(F(",MaxSampleUs="));
+      out.print(maxSampleCost_us);
+      out.print(F(",PublishUs="));
+      out.println(publishCost_us);
+    }
+
+  private:
+    typedef struct
+    {
+      BlynkSampleSink*  sink;
+      uint32_t          interval_ms;
+      uint32_t          last_ms;
+      uint32_t          lastSeq;      // Latest sample seen by this sink
+    } SinkEntry;
+
+    BlynkSensorChannel  channels[ACQ_MAX_CHANNELS];
+    uint8_t             numChannels;
+
+    SinkEntry           sinks[ACQ_MAX_SINKS];
+    uint8_t             numSinks;
+
+    BlynkSample         ring[ACQ_RING_SIZE];
+    uint8_t             head;         // Next slot to write
+    uint32_t            nextSeq;
+    uint32_t            numLost;
+
+    uint32_t            sampleCost_us;
+    uint32_t            maxSampleCost_us;
+    uint32_t            publishCost_us;
+
+    // Every sample from firstSeq on, oldest first
+    void publishSince(SinkEntry& entry, uint32_t firstSeq)
+    {
+      uint32_t count = nextSeq - firstSeq;
+
+      if (count > ACQ_RING_SIZE)
+      {
+        numLost += count - ACQ_RING_SIZE;
+        count    = ACQ_RING_SIZE;
+      }
+
+      uint32_t start = micros();
+
+      for (uint32_t i = count; i > 0; i--)
+      {
+        const BlynkSample& s = ring[(head + ACQ_RING_SIZE - i) % ACQ_RING_SIZE];
+
+        entry.sink->onSample(channels[s.channel], s);
+      }
+
+      entry.sink->onBatchEnd();
+      entry.lastSeq = nextSeq - 1;
+
+      addPublishCost(micros() - start);
+    }
+
+    // Latest sample of each channel, if new for this sink
+    void publishLatest(SinkEntry& entry)
+    {
+      uint32_t start  = micros();
+      bool     any    = false;
+
+      for (uint8_t i = 0; i < numChannels; i++)
+      {
+        const BlynkSample* s = getLatest(i);
+
+        if ( s && (s->seq > entry.lastSeq) )
+        {
+          entry.sink->onSample(channels[i], *s);
+          any = true;
+        }
+      }
+
+      if (!any)
+        return;
+
+      entry.sink->onBatchEnd();
+      entry.lastSeq = nextSeq - 1;
+
+      addPublishCost(micros() - start);
+    }
+
+    void addPublishCost(uint32_t cost)
+    {
+      publishCost_us = publishCost_us ? (7 * publishCost_us + cost) / 8 : cost;
+    }
+};
+
+// Virtual pin of the channel on one Blynk instance, or anything with virtualWrite(), e.g. BlynkOfflineQueue
+template<class TBlynk>
+class BlynkPinSink : public BlynkSampleSink
+{
+  public:
+    BlynkPinSink(TBlynk& blynkInstance)
+      : blynk(blynkInstance)
+    {}
+
+    void onSample(const BlynkSensorChannel& channel, const BlynkSample& sample)
+    {
+      if (channel.type == SENSOR_FLOAT)
+        blynk.virtualWrite(channel.vpin, sample.value);
+      else
+        blynk.virtualWrite(channel.vpin, (long) sample.value);
+    }
+
+  private:
+    TBlynk& blynk;
+};
+
+// One "name=value" line per batch
+class BlynkSerialSink : public BlynkSampleSink
+{
+  public:
+    BlynkSerialSink(Print& output)
+      : out(output)
+      , first(true)
+    {}
+
+    void onSample(const BlynkSensorChannel& channel, const BlynkSample& sample)
+    {
+      if (!first)
+        out.print(F(", "));
+
+      first = false;
+
+      out.print(channel.name);
+      out.print(F("="));
+
+      if (channel.type == SENSOR_FLOAT)
+        out.print(sample.value, channel.digits);
+      else
+        out.print((long) sample.value);
+    }
+
+    void onBatchEnd()
+    {
+      if (!first)
+        out.println();
+
+      first = true;
+    }
+
+  private:
+    Print&  out;
+    bool    first;
+};
+
+#if defined(BlynkEsp32_OLEDFields_h)
+// One OLED field per channel, sent asynchronously after each batch
+class BlynkOLEDSink : public BlynkSampleSink
+{
+  public:
+    BlynkOLEDSink(BlynkOLEDFields& oledFields)
+      : oled(oledFields)
+    {
+      memset(fieldOf, -1, sizeof(fieldOf));
+    }
+
+    void setField(uint8_t channel, int8_t field)
+    {
+      if (channel < ACQ_MAX_CHANNELS)
+        fieldOf[channel] = field;
+    }
+
+    void onSample(const BlynkSensorChannel& channel, const BlynkSample& sample)
+    {
+      int8_t field = fieldOf[sample.channel];
+
+      if (field < 0)
+        return;
+
+      if (channel.type == SENSOR_FLOAT)
+        oled.setText(field, (double) sample.value, channel.digits);
+      else
+        oled.setText(field, (long) sample.value);
+    }
+
+    void onBatchEnd()
+    {
+      oled.update(true);
+    }
+
+  private:
+    BlynkOLEDFields&  oled;
+    int8_t            fieldOf[ACQ_MAX_CHANNELS];
+};
+#endif
+
+#endif    // BlynkEsp32_Acquisition_h
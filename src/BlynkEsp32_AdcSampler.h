@@ -0,0 +1,290 @@
+/****************************************************************************************************************************
+   BlynkEsp32_AdcSampler.h
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   Continuous ADC sampling with oversampling, e.g. for the battery voltage.
+   The ADC1 channel is sampled by the I2S peripheral in ADC mode and written to memory by DMA. run() only drains what
+   is already in the DMA buffers, never waits. Every ADC_OVERSAMPLE samples are decimated into one reading with extra
+   resolution, then smoothed. Readings are converted to mV with the eFuse calibration.
+   The filtering kernels don't use any ESP32 API, so they can also be built on a host.
+   While running, analogRead() of other ADC1 pins is not possible.
+ *****************************************************************************************************************************/
+
+#ifndef BlynkEsp32_AdcSampler_h
+#define BlynkEsp32_AdcSampler_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Samples per decimated reading. Noise goes down by sqrt(ADC_OVERSAMPLE).
+#ifndef ADC_OVERSAMPLE
+#define ADC_OVERSAMPLE            256
+#endif
+
+// Smoothing of decimated readings : alpha = 1 / ADC_SMOOTHING. 1 => none.
+#ifndef ADC_SMOOTHING
+#define ADC_SMOOTHING             4
+#endif
+
+#define ADC_RAW_MASK              0x0FFF
+
+// Block average of n raw samples
+class BlynkAdcDecimator
+{
+  public:
+    BlynkAdcDecimator(uint16_t numSamples = ADC_OVERSAMPLE)
+      : n(numSamples)
+      , count(0)
+      , sum(0)
+      , value(0)
+    {}
+
+    // true when a new reading is ready
+    bool add(uint16_t raw)
+    {
+      sum += raw & ADC_RAW_MASK;
+
+      if (++count < n)
+        return false;
+
+      value = (float) sum / n;
+      sum   = 0;
+      count = 0;
+
+      return true;
+    }
+
+    // Adds a whole DMA buffer. Returns the number of readings completed.
+    uint16_t add(const uint16_t* samples, size_t len)
+    {
+      uint16_t done = 0;
+
+      for (size_t i = 0; i < len; i++)
+      {
+        if (add(samples[i]))
+          done++;
+      }
+
+      return done;
+    }
+
+    // Last reading, in raw ADC units, with the fractional part gained by oversampling
+    float get() const
+    {
+      return value;
+    }
+
+  private:
+    uint16_t  n;
+    uint16_t  count;
+    uint32_t  sum;
+    float     value;
+};
+
+// Exponential moving average, first input taken as is
+class BlynkAdcSmoother
+{
+  public:
+    BlynkAdcSmoother(uint8_t divisor = ADC_SMOOTHING)
+      : div(divisor ? divisor : 1)
+      , started(false)
+      , value(0)
+    {}
+
+    float add(float x)
+    {
+      value   = started ? value + (x - value) / div : x;
+      started = true;
+
+      return value;
+    }
+
+    float get() const
+    {
+      return value;
+    }
+
+  private:
+    uint8_t div;
+    bool    started;
+    float   value;
+};
+
+#if defined(ESP32)
+
+#include <Arduino.h>
+#include "driver/i2s.h"
+#include "driver/adc.h"
+#include "esp_adc_cal.h"
+
+// Samples per second
+#ifndef ADC_SAMPLE_RATE
+#define ADC_SAMPLE_RATE           20000
+#endif
+
+// DMA buffers : ADC_DMA_BUF_COUNT x ADC_DMA_BUF_LEN samples
+#ifndef ADC_DMA_BUF_COUNT
+#define ADC_DMA_BUF_COUNT         4
+#endif
+
+#ifndef ADC_DMA_BUF_LEN
+#define ADC_DMA_BUF_LEN           256
+#endif
+
+// Reference of uncalibrated chips
+#define ADC_DEFAULT_VREF          1100
+
+class BlynkAdcSampler
+{
+  public:
+    BlynkAdcSampler()
+      : channel(ADC1_CHANNEL_0)
+      , running(false)
+      , numSamples(0)
+      , numReadings(0)
+      , busy_us(0)
+    {}
+
+    // GPIO36 is ADC1_CHANNEL_0. Only ADC1 works with I2S.
+    bool begin(adc1_channel_t adcChannel = ADC1_CHANNEL_0, adc_atten_t atten = ADC_ATTEN_DB_11,
+               uint32_t sampleRate = ADC_SAMPLE_RATE)
+    {
+      channel = adcChannel;
+
+      i2s_config_t config;
+
+      memset(&config, 0, sizeof(config));
+
+      config.mode                 = (i2s_mode_t) (I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_ADC_BUILT_IN);
+      config.sample_rate          = sampleRate;
+      config.bits_per_sample      = I2S_BITS_PER_SAMPLE_16BIT;
+      config.channel_format       = I2S_CHANNEL_FMT_ONLY_LEFT;
+      config.communication_format = I2S_COMM_FORMAT_I2S_MSB;
+      config.intr_alloc_flags     = ESP_INTR_FLAG_LEVEL1;
+      config.dma_buf_count        = ADC_DMA_BUF_COUNT;
+      config.dma_buf_len          = ADC_DMA_BUF_LEN;
+      config.use_apll             = false;
+
+      if (i2s_driver_install(I2S_NUM_0, &config, 0, NULL) != ESP_OK)
+      {
+        BLYNK_LOG1(BLYNK_F("ADC:I2SFail"));
+        return false;
+      }
+
+      adc1_config_width(ADC_WIDTH_BIT_12);
+      adc1_config_channel_atten(channel, atten);
+      i2s_set_adc_mode(ADC_UNIT_1, channel);
+
+      esp_adc_cal_value_t calType = esp_adc_cal_characterize(ADC_UNIT_1, atten, ADC_WIDTH_BIT_12, ADC_DEFAULT_VREF, &calibration);
+
+      i2s_adc_enable(I2S_NUM_0);
+
+      running = true;
+
+      BLYNK_LOG4(BLYNK_F("ADC:Ch="), channel, BLYNK_F(",Cal="), calType);
+
+      return true;
+    }
+
+    void end()
+    {
+      if (!running)
+        return;
+
+      i2s_adc_disable(I2S_NUM_0);
+      i2s_driver_uninstall(I2S_NUM_0);
+
+      running = false;
+    }
+
+    // Call in loop(). Takes what the DMA has written, without waiting.
+    void run()
+    {
+      if (!running)
+        return;
+
+      uint32_t start = micros();
+      size_t   bytes;
+
+      do
+      {
+        bytes = 0;
+        i2s_read(I2S_NUM_0, buffer, sizeof(buffer), &bytes, 0);
+
+        size_t len = bytes / sizeof(buffer[0]);
+
+        for (size_t i = 0; i < len; i++)
+        {
+          if (decimator.add(buffer[i]))
+          {
+            smoother.add(decimator.get());
+            numReadings++;
+          }
+        }
+
+        numSamples += len;
+      } while (bytes == sizeof(buffer));
+
+      busy_us += micros() - start;
+    }
+
+    // Smoothed reading in raw ADC units (0 - 4095), with fractional part
+    float getRaw()
+    {
+      return smoother.get();
+    }
+
+    // Calibrated smoothed reading, at the ADC pin
+    uint32_t getMillivolts()
+    {
+      return esp_adc_cal_raw_to_voltage((uint32_t) (smoother.get() + 0.5f), &calibration);
+    }
+
+    uint32_t getNumReadings()
+    {
+      return numReadings;
+    }
+
+    // Average CPU time spent in run() per ADC sample, in ns
+    uint32_t getCostPerSample()
+    {
+      return numSamples ? (uint32_t) (busy_us * 1000ULL / numSamples) : 0;
+    }
+
+    void print(Print& out)
+    {
+      out.print(F("ADC:Raw="));
+      out.print(getRaw(), 2);
+      out.print(F(",mV="));
+      out.print(getMillivolts());
+      out.print(F(",Samples="));
+      out.print((uint32_t) numSamples);
+      out.print(F(",nsPerSample="));
+      out.println(getCostPerSample());
+    }
+
+  private:
+    adc1_channel_t  channel;
+    bool            running;
+
+    uint16_t        buffer[ADC_DMA_BUF_LEN];
+
+    BlynkAdcDecimator decimator;
+    BlynkAdcSmoother  smoother;
+
+    esp_adc_cal_characteristics_t calibration;
+
+    uint64_t        numSamples;
+    uint32_t        numReadings;
+    uint64_t        busy_us;
+};
+
+#endif    // ESP32
+
+#endif    // BlynkEsp32_AdcSampler_h
@@ -0,0 +1,165 @@
+/****************************************************************************************************************************
+   BlynkEsp32_Arena.h
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   Static storage for the objects the transports and the Config Portal create : the WebServer of the portal, created
+   and destroyed at each start / stop, and the BLE characteristics and their descriptor. BlynkStaticSlot<T> is sized for one T
+   at compile time, constructs it in place and runs its destructor on teardown, so sessions can be cycled without
+   the heap growing or fragmenting. BlynkHeapAudit checks it : free heap and largest free block after each cycle.
+ *****************************************************************************************************************************/
+
+#ifndef BlynkEsp32_Arena_h
+#define BlynkEsp32_Arena_h
+
+#include <Arduino.h>
+#include <new>
+#include <utility>
+#include "esp_heap_caps.h"
+
+// Bytes a cycle may lose before BlynkHeapAudit reports it as not flat. The WiFi and Bluetooth stacks keep a few
+// buffers of varying size between cycles.
+#ifndef BLYNK_HEAP_AUDIT_TOLERANCE
+#define BLYNK_HEAP_AUDIT_TOLERANCE    512
+#endif
+
+template <class T>
+class BlynkStaticSlot
+{
+  public:
+    BlynkStaticSlot()
+      : object(NULL)
+      , numCreated(0)
+    {}
+
+    ~BlynkStaticSlot()
+    {
+      destroy();
+    }
+
+    // Constructs T in the slot. Returns the existing one if already created.
+    template <typename... Args>
+    T* create(Args&&... args)
+    {
+      if (!object)
+      {
+        object = new (storage) T(std::forward<Args>(args)...);
+        numCreated++;
+      }
+
+      return object;
+    }
+
+    void destroy()
+    {
+      if (object)
+      {
+        object->~T();
+        object = NULL;
+      }
+    }
+
+    // NULL when not created
+    T* get()
+    {
+      return object;
+    }
+
+    uint32_t getNumCreated()
+    {
+      return numCreated;
+    }
+
+  private:
+    alignas(T) uint8_t storage[sizeof(T)];
+
+    T*        object;
+    uint32_t  numCreated;
+};
+
+class BlynkHeapAudit
+{
+  public:
+    BlynkHeapAudit()
+      : numCycles(0)
+      , baseFree(0)
+      , baseLargest(0)
+      , lastFree(0)
+      , lastLargest(0)
+      , minFree(0)
+    {}
+
+    // Call after the first start / stop cycle : the stacks allocate their lasting buffers in it
+    void begin()
+    {
+      numCycles   = 0;
+      baseFree    = lastFree    = minFree = ESP.getFreeHeap();
+      baseLargest = lastLargest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    }
+
+    // Call after each later cycle, at the same point of it
+    void sample()
+    {
+      numCycles++;
+
+      lastFree    = ESP.getFreeHeap();
+      lastLargest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+
+      if (lastFree < minFree)
+        minFree = lastFree;
+    }
+
+    // Since begin(). Negative when memory was lost.
+    int32_t getFreeDelta()
+    {
+      return (int32_t) (lastFree - baseFree);
+    }
+
+    // Negative when the heap got more fragmented
+    int32_t getLargestDelta()
+    {
+      return (int32_t) (lastLargest - baseLargest);
+    }
+
+    uint32_t getCycles()
+    {
+      return numCycles;
+    }
+
+    bool isFlat(uint32_t tolerance = BLYNK_HEAP_AUDIT_TOLERANCE)
+    {
+      return (getFreeDelta() >= - (int32_t) tolerance) && (getLargestDelta() >= - (int32_t) tolerance);
+    }
+
+    void print(Print& out)
+    {
+      out.print(F("HA:Cycles="));
+      out.print(numCycles);
+      out.print(F(",Free="));
+      out.print(lastFree);
+      out.print(F("/"));
+      out.print(getFreeDelta());
+      out.print(F(",Min="));
+      out.print(minFree);
+      out.print(F(",Largest="));
+      out.print(lastLargest);
+      out.print(F("/"));
+      out.print(getLargestDelta());
+      out.println(isFlat() ? F(",flat") : F(",LEAK"));
+    }
+
+  private:
+    uint32_t  numCycles;
+    uint32_t  baseFree;
+    uint32_t  baseLargest;
+    uint32_t  lastFree;
+    uint32_t  lastLargest;
+    uint32_t  minFree;
+};
+
+#endif    // BlynkEsp32_Arena_h
@@ -0,0 +1,170 @@
+/****************************************************************************************************************************
+   BlynkEsp32_Backoff.h
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   Reconnect policy with exponential backoff and per-device jitter.
+   The jitter generator is seeded from the efuse MAC, so boards of a fleet losing the same AP at the same time
+   spread their WiFi / Blynk reconnects instead of hitting the server together.
+ *****************************************************************************************************************************/
+
+#ifndef BlynkEsp32_Backoff_h
+#define BlynkEsp32_Backoff_h
+
+#include <Arduino.h>
+
+// Delay before the first reconnect is random in [0, RECONNECT_BACKOFF_MIN_MS]
+#ifndef RECONNECT_BACKOFF_MIN_MS
+#define RECONNECT_BACKOFF_MIN_MS      2000L
+#endif
+
+// Upper bound of the backoff window
+#ifndef RECONNECT_BACKOFF_MAX_MS
+#define RECONNECT_BACKOFF_MAX_MS      120000L
+#endif
+
+#define RECONNECT_BACKOFF_LIMIT_MS    3600000L
+
+class BlynkReconnectPolicy
+{
+  public:
+    BlynkReconnectPolicy()
+      : min_ms(RECONNECT_BACKOFF_MIN_MS)
+      , max_ms(RECONNECT_BACKOFF_MAX_MS)
+      , attempt(0)
+      , pending(false)
+      , nextAttempt(0)
+      , seed(1)
+    {}
+
+    // Seed is normally ESP.getEfuseMac(), unique per board
+    void begin(uint64_t deviceSeed)
+    {
+      seed = (uint32_t) (deviceSeed ^ (deviceSeed >> 32));
+
+      // xorshift32 must not start from 0
+      if (seed == 0)
+        seed = 0x9E3779B9UL;
+    }
+
+    // Values <= 0, e.g. not set in Config Portal, fall back to the compile-time defaults. Window is capped at 1 hour.
+    void setLimits(int32_t minMs, int32_t maxMs)
+    {
+      if (minMs <= 0)
+        minMs = RECONNECT_BACKOFF_MIN_MS;
+
+      if (maxMs <= 0)
+        maxMs = RECONNECT_BACKOFF_MAX_MS;
+
+      if (maxMs > RECONNECT_BACKOFF_LIMIT_MS)
+        maxMs = RECONNECT_BACKOFF_LIMIT_MS;
+
+      if (minMs > maxMs)
+        minMs = maxMs;
+
+      min_ms = minMs;
+      max_ms = maxMs;
+    }
+
+    // Same, from the seconds of the Config Portal. Clamped before the multiply, which would overflow int32_t.
+    void setLimitsSeconds(int32_t minSec, int32_t maxSec)
+    {
+      if (minSec < 0)
+        minSec = 0;
+
+      if (maxSec < 0)
+        maxSec = 0;
+
+      if (minSec > RECONNECT_BACKOFF_LIMIT_MS / 1000)
+        minSec = RECONNECT_BACKOFF_LIMIT_MS / 1000;
+
+      if (maxSec > RECONNECT_BACKOFF_LIMIT_MS / 1000)
+        maxSec = RECONNECT_BACKOFF_LIMIT_MS / 1000;
+
+      setLimits(minSec * 1000, maxSec * 1000);
+    }
+
+    // Connection just lost : first attempt after a random fraction of min_ms
+    void lost()
+    {
+      if (pending)
+        return;
+
+      pending     = true;
+      attempt     = 0;
+      nextAttempt = millis() + random32() % (min_ms + 1);
+    }
+
+    // true when a reconnect attempt is allowed now
+    bool due()
+    {
+      if (!pending)
+        return true;
+
+      return ( (int32_t) (millis() - nextAttempt) >= 0 );
+    }
+
+    // Attempt failed : wait half of the exponential window plus a random part of the other half ("equal jitter")
+    void failed()
+    {
+      pending = true;
+
+      uint32_t window = getWindow();
+
+      nextAttempt = millis() + (window / 2) + random32() % (window / 2 + 1);
+
+      if (attempt < 31)
+        attempt++;
+    }
+
+    void succeeded()
+    {
+      pending = false;
+      attempt = 0;
+    }
+
+    uint8_t getAttempt()
+    {
+      return attempt;
+    }
+
+    // ms until next attempt, 0 if due
+    uint32_t getWaitTime()
+    {
+      return due() ? 0 : (nextAttempt - millis());
+    }
+
+  private:
+    uint32_t  min_ms;
+    uint32_t  max_ms;
+    uint8_t   attempt;
+    bool      pending;
+    uint32_t  nextAttempt;
+    uint32_t  seed;
+
+    uint32_t getWindow()
+    {
+      uint32_t window = min_ms;
+
+      for (uint8_t i = 0; (i < attempt) && (window < max_ms); i++)
+        window <<= 1;
+
+      return (window > max_ms) ? max_ms : window;
+    }
+
+    uint32_t random32()
+    {
+      seed ^= seed << 13;
+      seed ^= seed >> 17;
+      seed ^= seed << 5;
+
+      return seed;
+    }
+};
+
+#endif    // BlynkEsp32_Backoff_h
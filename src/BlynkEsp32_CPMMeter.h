@@ -0,0 +1,190 @@
+/****************************************************************************************************************************
+   BlynkEsp32_CPMMeter.h
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   Streaming count-rate and dose-rate meter for a Geiger tube.
+   Pulses go into per-second bins of a fixed ring. Sums over 10 s, 1 min and 10 min slide by one bin each second, so
+   each update costs the same whatever the window length. Rates are corrected for the tube dead time
+   (non-paralyzable model), and the dose is integrated every second in double precision.
+ *****************************************************************************************************************************/
+
+#ifndef BlynkEsp32_CPMMeter_h
+#define BlynkEsp32_CPMMeter_h
+
+#include <Arduino.h>
+
+// uSv/h per CPM. 0.00658 for the J305 / M4011 tubes.
+#ifndef CPM_CONV_FACTOR
+#define CPM_CONV_FACTOR           0.00658
+#endif
+
+// Tube dead time. 0 => no correction.
+#ifndef CPM_DEAD_TIME_US
+#define CPM_DEAD_TIME_US          0
+#endif
+
+typedef enum
+{
+  CPM_WINDOW_10S,
+  CPM_WINDOW_1MIN,
+  CPM_WINDOW_10MIN,
+  CPM_NUM_WINDOWS
+} BlynkCPMWindow;
+
+// One bin more than the longest window, so the bin leaving it is still there
+#define CPM_RING_SECONDS          (600 + 1)
+
+class BlynkCPMMeter
+{
+  public:
+    BlynkCPMMeter()
+      : conversion(CPM_CONV_FACTOR)
+      , deadTime_s(CPM_DEAD_TIME_US / 1000000.0)
+    {
+      reset();
+    }
+
+    // Clear the rate windows. Dose is kept.
+    void reset()
+    {
+      memset(bins, 0, sizeof(bins));
+      memset(sums, 0, sizeof(sums));
+
+      head          = 0;
+      filled        = 0;
+      current       = 0;
+      second_ms     = millis();
+    }
+
+    void setConversion(double uSvh_per_cpm)
+    {
+      conversion = uSvh_per_cpm;
+    }
+
+    void setDeadTime(uint32_t dead_us)
+    {
+      deadTime_s = dead_us / 1000000.0;
+    }
+
+    // Pulses counted since the last call. Call often, at least once per second.
+    void addPulses(uint32_t pulses)
+    {
+      run();
+
+      current += pulses;
+    }
+
+    // Close the seconds elapsed since the last call
+    void run()
+    {
+      uint32_t elapsed = (millis() - second_ms) / 1000;
+
+      if (elapsed == 0)
+        return;
+
+      second_ms += elapsed * 1000;
+
+      // Longer gap : older bins would all be zero anyway
+      if (elapsed > CPM_RING_SECONDS)
+        elapsed = CPM_RING_SECONDS;
+
+      closeSecond(current);
+      current = 0;
+
+      while (--elapsed)
+        closeSecond(0);
+    }
+
+    // Dead-time corrected counts per minute over a window. Uses the seconds available if the window isn't full yet.
+    float getCPM(BlynkCPMWindow window)
+    {
+      uint16_t seconds = (filled < windowLength(window)) ? filled : windowLength(window);
+
+      if (seconds == 0)
+        return 0;
+
+      return correct((double) sums[window] / seconds) * 60.0;
+    }
+
+    // uSv/h over a window
+    float getDoseRate(BlynkCPMWindow window)
+    {
+      return getCPM(window) * conversion;
+    }
+
+    // uSv since start or resetDose()
+    double getDose()
+    {
+      return dose;
+    }
+
+    void resetDose()
+    {
+      dose = 0;
+    }
+
+    // Seconds of data in the ring, up to the longest window
+    uint16_t getSeconds()
+    {
+      return filled;
+    }
+
+  private:
+    uint16_t  bins[CPM_RING_SECONDS];
+    uint32_t  sums[CPM_NUM_WINDOWS];
+    uint16_t  head;         // Most recent closed second
+    uint16_t  filled;       // Closed seconds in the ring
+    uint32_t  current;      // Pulses of the running second
+    uint32_t  second_ms;    // Start of the running second
+
+    double    conversion;
+    double    deadTime_s;
+    double    dose = 0;
+
+    uint16_t windowLength(uint8_t window)
+    {
+      return (window == CPM_WINDOW_10S) ? 10 : ( (window == CPM_WINDOW_1MIN) ? 60 : 600 );
+    }
+
+    // Non-paralyzable dead time : true rate = measured / (1 - measured * deadTime)
+    double correct(double cps)
+    {
+      double busy = cps * deadTime_s;
+
+      // Saturated tube : can't be corrected, keep measured rate
+      if (busy >= 0.99)
+        return cps;
+
+      return cps / (1.0 - busy);
+    }
+
+    void closeSecond(uint32_t pulses)
+    {
+      uint16_t value = (pulses > 0xFFFF) ? 0xFFFF : pulses;
+
+      head        = (head + 1) % CPM_RING_SECONDS;
+      bins[head]  = value;
+
+      for (uint8_t w = 0; w < CPM_NUM_WINDOWS; w++)
+      {
+        sums[w] += value;
+
+        if (filled >= windowLength(w))
+          sums[w] -= bins[(head + CPM_RING_SECONDS - windowLength(w)) % CPM_RING_SECONDS];
+      }
+
+      if (filled < CPM_RING_SECONDS - 1)
+        filled++;
+
+      // uSv/h * 1/3600 h
+      dose += correct(value) * 60.0 * conversion / 3600.0;
+    }
+};
+
+#endif    // BlynkEsp32_CPMMeter_h
@@ -0,0 +1,214 @@
+/****************************************************************************************************************************
+   BlynkEsp32_Coex.h
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   WiFi / Bluetooth coexistence controller.
+   WiFi and BT/BLE share one 2.4 GHz radio. Every COEX_UPDATE_INTERVAL_MS, the traffic of each link is compared to
+   COEX_BUSY_BYTES_PER_S. The ESP-IDF coexistence preference and the TX power of both radios then follow the link
+   that carries the traffic. WiFi TX power is only lowered when the AP signal has margin for it, so an idle link at
+   the edge of coverage is not lost. Settings are only written when they change.
+   Include after the Blynk transport headers used by the sketch, as for BlynkEsp32_Transport.h.
+ *****************************************************************************************************************************/
+
+#ifndef BlynkEsp32_Coex_h
+#define BlynkEsp32_Coex_h
+
+#include <Arduino.h>
+#include "sdkconfig.h"
+#include "esp_wifi.h"
+#include "esp_bt.h"
+
+#if defined(CONFIG_SW_COEXIST_ENABLE)
+#include "esp_coexist.h"
+#endif
+
+#include "BlynkEsp32_Traffic.h"
+#include "BlynkEsp32_Transport.h"
+
+#ifndef COEX_UPDATE_INTERVAL_MS
+#define COEX_UPDATE_INTERVAL_MS     1000L
+#endif
+
+// A link moving more than this is considered busy
+#ifndef COEX_BUSY_BYTES_PER_S
+#define COEX_BUSY_BYTES_PER_S       32
+#endif
+
+// WiFi max TX power, in 0.25 dBm. 78 => 19.5 dBm, 52 => 13 dBm
+#ifndef COEX_WIFI_TX_POWER_HIGH
+#define COEX_WIFI_TX_POWER_HIGH     78
+#endif
+
+#ifndef COEX_WIFI_TX_POWER_LOW
+#define COEX_WIFI_TX_POWER_LOW      52
+#endif
+
+// Min AP RSSI, in dBm, to use COEX_WIFI_TX_POWER_LOW when WiFi isn't busy. Back to high power below it by more than
+// COEX_WIFI_RSSI_HYSTERESIS dB.
+#ifndef COEX_WIFI_LOW_POWER_RSSI
+#define COEX_WIFI_LOW_POWER_RSSI    -60
+#endif
+
+#ifndef COEX_WIFI_RSSI_HYSTERESIS
+#define COEX_WIFI_RSSI_HYSTERESIS   3
+#endif
+
+// BT / BLE TX power
+#ifndef COEX_BT_TX_POWER_HIGH
+#define COEX_BT_TX_POWER_HIGH       ESP_PWR_LVL_P7
+#endif
+
+#ifndef COEX_BT_TX_POWER_LOW
+#define COEX_BT_TX_POWER_LOW        ESP_PWR_LVL_N2
+#endif
+
+typedef enum
+{
+  COEX_PROFILE_IDLE,      // No traffic : balanced, BT at low power, WiFi too if RSSI has margin
+  COEX_PROFILE_WIFI,      // WiFi busy
+  COEX_PROFILE_BT,        // BT / BLE busy, WiFi at low power if RSSI has margin
+  COEX_PROFILE_DUAL       // Both busy : balanced, both radios at high power
+} BlynkCoexProfile;
+
+class BlynkCoexController
+{
+  public:
+    // btTransport is BLYNK_TRANSPORT_BT or BLYNK_TRANSPORT_BLE
+    BlynkCoexController(uint8_t btTransport = BLYNK_TRANSPORT_BLE)
+      : btMode(btTransport)
+      , profile(COEX_PROFILE_DUAL)
+      , applied(false)
+      , wifiLowPower(false)
+      , last_ms(0)
+      , lastWiFi(0)
+      , lastBT(0)
+      , wifiRate(0)
+      , btRate(0)
+      , numChanges(0)
+    {}
+
+    // Call in loop() with the counters of Blynk_WF and Blynk_BT / Blynk_BLE
+    void run(const BlynkTrafficCounter& wifi, const BlynkTrafficCounter& bt)
+    {
+      uint32_t elapsed = millis() - last_ms;
+
+      if (applied && (elapsed < COEX_UPDATE_INTERVAL_MS))
+        return;
+
+      uint32_t wifiBytes  = wifi.bytesIn + wifi.bytesOut;
+      uint32_t btBytes    = bt.bytesIn + bt.bytesOut;
+
+      if (last_ms && elapsed)
+      {
+        wifiRate  = (wifiBytes - lastWiFi) * 1000UL / elapsed;
+        btRate    = (btBytes - lastBT) * 1000UL / elapsed;
+      }
+
+      last_ms   = millis();
+      lastWiFi  = wifiBytes;
+      lastBT    = btBytes;
+
+      bool wifiBusy = (wifiRate >= COEX_BUSY_BYTES_PER_S);
+      bool btBusy   = (btRate >= COEX_BUSY_BYTES_PER_S);
+
+      BlynkCoexProfile newProfile = wifiBusy ? (btBusy ? COEX_PROFILE_DUAL : COEX_PROFILE_WIFI) :
+                                    (btBusy ? COEX_PROFILE_BT : COEX_PROFILE_IDLE);
+
+      bool wifiLow = !wifiBusy && hasRssiMargin();
+
+      if (!applied || (newProfile != profile) || (wifiLow != wifiLowPower))
+        apply(newProfile, wifiLow);
+    }
+
+    BlynkCoexProfile getProfile()
+    {
+      return profile;
+    }
+
+    // Bytes per second measured in the last interval
+    uint32_t getWiFiRate()
+    {
+      return wifiRate;
+    }
+
+    uint32_t getBTRate()
+    {
+      return btRate;
+    }
+
+    uint32_t getNumChanges()
+    {
+      return numChanges;
+    }
+
+    bool isWiFiLowPower()
+    {
+      return wifiLowPower;
+    }
+
+  private:
+    uint8_t           btMode;
+    BlynkCoexProfile  profile;
+    bool              applied;
+    bool              wifiLowPower;
+
+    uint32_t  last_ms;
+    uint32_t  lastWiFi;
+    uint32_t  lastBT;
+    uint32_t  wifiRate;
+    uint32_t  btRate;
+    uint32_t  numChanges;
+
+    // No AP info, e.g. not associated : no margin
+    bool hasRssiMargin()
+    {
+      wifi_ap_record_t apInfo;
+
+      if (esp_wifi_sta_get_ap_info(&apInfo) != ESP_OK)
+        return false;
+
+      int minRssi = wifiLowPower ? (COEX_WIFI_LOW_POWER_RSSI - COEX_WIFI_RSSI_HYSTERESIS) : COEX_WIFI_LOW_POWER_RSSI;
+
+      return apInfo.rssi >= minRssi;
+    }
+
+    void apply(BlynkCoexProfile newProfile, bool wifiLow)
+    {
+      profile       = newProfile;
+      wifiLowPower  = wifiLow;
+      applied       = true;
+      numChanges++;
+
+#if defined(CONFIG_SW_COEXIST_ENABLE)
+      esp_coex_prefer_t prefer = (profile == COEX_PROFILE_WIFI) ? ESP_COEX_PREFER_WIFI :
+                                 ( (profile == COEX_PROFILE_BT) ? ESP_COEX_PREFER_BT : ESP_COEX_PREFER_BALANCE );
+
+      esp_coex_preference_set(prefer);
+#endif
+
+      bool btHigh   = (profile == COEX_PROFILE_BT)   || (profile == COEX_PROFILE_DUAL);
+
+      esp_wifi_set_max_tx_power(wifiLowPower ? COEX_WIFI_TX_POWER_LOW : COEX_WIFI_TX_POWER_HIGH);
+
+      // Controller must be enabled, else the call fails harmlessly
+      if (esp_bt_controller_get_status() == ESP_BT_CONTROLLER_STATUS_ENABLED)
+      {
+        esp_power_level_t level = btHigh ? COEX_BT_TX_POWER_HIGH : COEX_BT_TX_POWER_LOW;
+
+        if (btMode == BLYNK_TRANSPORT_BT)
+          esp_bredr_tx_power_set(COEX_BT_TX_POWER_LOW, level);
+        else
+          esp_ble_tx_power_set(ESP_BLE_PWR_TYPE_DEFAULT, level);
+      }
+
+      BLYNK_LOG6(BLYNK_F("Coex:Profile="), profile, BLYNK_F(",WFLow="), wifiLowPower, BLYNK_F(",Bps="), wifiRate + btRate);
+    }
+};
+
+#endif    // BlynkEsp32_Coex_h
@@ -0,0 +1,149 @@
+/****************************************************************************************************************************
+   BlynkEsp32_DeepSleep.h
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   Wake - publish - deep sleep cycle for periodic sensors.
+   Before sleeping, BlynkWifi keeps the session that just worked (validated config, AP channel / BSSID, DHCP lease and
+   Blynk server) in RTC memory. On the next timer wake-up, BlynkWifi::resume() uses it to skip the config read, the
+   WiFi scan, DHCP and the server selection. The lease is reused as a static IP only for half of
+   DEEP_SLEEP_DHCP_LEASE_S, counting the time asleep. Then the resume runs DHCP again. Each phase of the cycle is timed.
+   Define USE_DEEP_SLEEP_RESUME true before including <BlynkSimpleEsp32_WFM.h> to enable.
+ *****************************************************************************************************************************/
+
+#ifndef BlynkEsp32_DeepSleep_h
+#define BlynkEsp32_DeepSleep_h
+
+#ifndef USE_DEEP_SLEEP_RESUME
+#define USE_DEEP_SLEEP_RESUME         false
+#endif
+
+#if USE_DEEP_SLEEP_RESUME
+
+#include <Arduino.h>
+#include "esp_sleep.h"
+
+// Max time to join the stored AP on its stored channel
+#ifndef DEEP_SLEEP_WIFI_TIMEOUT_MS
+#define DEEP_SLEEP_WIFI_TIMEOUT_MS    3000L
+#endif
+
+// Max time to log in to the stored Blynk server
+#ifndef DEEP_SLEEP_BLYNK_TIMEOUT_MS
+#define DEEP_SLEEP_BLYNK_TIMEOUT_MS   3000L
+#endif
+
+// Time given to the TCP stack to send the last writes before the link is closed
+#ifndef DEEP_SLEEP_FLUSH_MS
+#define DEEP_SLEEP_FLUSH_MS           20
+#endif
+
+// Stored session is used for this many wake-ups, then a full begin() refreshes it, e.g. the server selection
+#ifndef DEEP_SLEEP_MAX_RESUMES
+#define DEEP_SLEEP_MAX_RESUMES        100
+#endif
+
+// Shortest DHCP lease expected from the APs. Renewed through DHCP at half of it, as a DHCP client does at T1.
+#ifndef DEEP_SLEEP_DHCP_LEASE_S
+#define DEEP_SLEEP_DHCP_LEASE_S       3600UL
+#endif
+
+#define DEEP_SLEEP_MAGIC              0x424C5253UL     // "BLRS"
+
+typedef enum
+{
+  SLEEP_PHASE_CONFIG,       // Config read (EEPROM / SPIFFS) or copied from RTC memory
+  SLEEP_PHASE_WIFI,         // WiFi associated, IP ready
+  SLEEP_PHASE_BLYNK,        // Blynk server logged in
+  SLEEP_PHASE_PUBLISH,      // From login to sleep() : user writes
+  SLEEP_NUM_PHASES
+} BlynkSleepPhase;
+
+// Session that worked on the last cycle. Kept in RTC memory by BlynkWifi.
+typedef struct
+{
+  uint32_t  magic;
+  uint8_t   channel;
+  uint8_t   bssid[6];
+  uint8_t   wifiIndex;      // Index of the WiFi_Creds entry in use
+  int8_t    server;         // Index of the Blynk_Creds entry in use
+  uint16_t  numResumes;     // Consecutive fast resumes since the last full begin()
+  uint32_t  leaseAge_s;     // Since the DHCP lease was obtained, awake and asleep
+  uint32_t  ip;
+  uint32_t  gateway;
+  uint32_t  subnet;
+  uint32_t  dns;
+} BlynkRtcSession;
+
+// Timings of one wake cycle, in ms since boot
+class BlynkSleepTimings
+{
+  public:
+    void reset(bool isResumed)
+    {
+      resumed = isResumed;
+      last_ms = millis();
+      memset(phase_ms, 0, sizeof(phase_ms));
+    }
+
+    // Close one phase. Time is counted from the end of the previous phase.
+    void mark(BlynkSleepPhase phase)
+    {
+      uint32_t now = millis();
+
+      phase_ms[phase] = now - last_ms;
+      last_ms         = now;
+    }
+
+    uint32_t getPhase(BlynkSleepPhase phase) const
+    {
+      return phase_ms[phase];
+    }
+
+    // Boot (ROM + bootloader + setup() before begin) to last mark
+    uint32_t getTotal() const
+    {
+      return last_ms;
+    }
+
+    bool isResumed() const
+    {
+      return resumed;
+    }
+
+    void print(Print& out) const
+    {
+      out.print(resumed ? F("Resume") : F("FullBegin"));
+      out.print(F(":CfgMs="));
+      out.print(phase_ms[SLEEP_PHASE_CONFIG]);
+      out.print(F(",WiFiMs="));
+      out.print(phase_ms[SLEEP_PHASE_WIFI]);
+      out.print(F(",BlynkMs="));
+      out.print(phase_ms[SLEEP_PHASE_BLYNK]);
+      out.print(F(",PubMs="));
+      out.print(phase_ms[SLEEP_PHASE_PUBLISH]);
+      out.print(F(",TotalMs="));
+      out.println(last_ms);
+    }
+
+  private:
+    bool      resumed;
+    uint32_t  last_ms;
+    uint32_t  phase_ms[SLEEP_NUM_PHASES];
+};
+
+// Used inside BlynkWifi, which owns sleepTimings
+#define DEEP_SLEEP_MARK(phase)        sleepTimings.mark(phase)
+
+#else
+
+#define DEEP_SLEEP_MARK(phase)        do {} while (0)
+
+#endif    // USE_DEEP_SLEEP_RESUME
+
+#endif    // BlynkEsp32_DeepSleep_h
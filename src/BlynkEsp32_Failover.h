@@ -0,0 +1,274 @@
+/****************************************************************************************************************************
+   BlynkEsp32_Failover.h
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   Automatic WiFi <-> BT/BLE failover over BlynkTransportManager.
+   WiFi is the primary link. When its Blynk session stays lost for FAILOVER_GRACE_MS, the standby BT or BLE transport is
+   started. Once WiFi has been back for FAILOVER_RESTORE_MS, the standby is stopped again.
+   Writes go to whichever link is up. The last value of each virtual pin is cached and replayed on the new link.
+   Each change of route is recorded with the outage window it caused.
+ *****************************************************************************************************************************/
+
+#ifndef BlynkEsp32_Failover_h
+#define BlynkEsp32_Failover_h
+
+#include "BlynkEsp32_Transport.h"
+#include <Blynk/BlynkConfig.h>
+#include <Blynk/BlynkParam.h>
+
+// WiFi must be lost this long before the standby is started. Blynk_WF.run() often reconnects within this time.
+#ifndef FAILOVER_GRACE_MS
+#define FAILOVER_GRACE_MS           15000L
+#endif
+
+// WiFi must be back this long before the standby is stopped. 0 => keep standby running.
+#ifndef FAILOVER_RESTORE_MS
+#define FAILOVER_RESTORE_MS         30000L
+#endif
+
+// Number of virtual pins whose last value is kept for replay
+#ifndef FAILOVER_PIN_CACHE_SIZE
+#define FAILOVER_PIN_CACHE_SIZE     16
+#endif
+
+#ifndef FAILOVER_PIN_VALUE_LEN
+#define FAILOVER_PIN_VALUE_LEN      32
+#endif
+
+// Number of failover events kept
+#ifndef FAILOVER_EVENTS
+#define FAILOVER_EVENTS             8
+#endif
+
+typedef struct
+{
+  uint8_t   from;         // BLYNK_TRANSPORT_xxx, BLYNK_TRANSPORT_NONE if no link was up
+  uint8_t   to;
+  uint32_t  at_ms;        // millis() when the new route went up
+  uint32_t  outage_ms;    // Time without any link, 0 for a seamless switch
+} BlynkFailoverEvent;
+
+typedef void (*BlynkFailoverCallback)(const BlynkFailoverEvent& event);
+
+class BlynkFailover
+{
+  public:
+    BlynkFailover(BlynkTransportManager& manager, uint8_t standbyTransport)
+      : transports(manager)
+      , standby(standbyTransport)
+      , route(BLYNK_TRANSPORT_NONE)
+      , callback(NULL)
+      , wifiLost_ms(0)
+      , wifiBack_ms(0)
+      , down_ms(0)
+      , numPins(0)
+      , numEvents(0)
+      , nextEvent(0)
+    {}
+
+    void setCallback(BlynkFailoverCallback cb)
+    {
+      callback = cb;
+    }
+
+    // Call in loop() instead of transports.run()
+    void run()
+    {
+      transports.run();
+
+      bool wifiUp = transports.isConnected(BLYNK_TRANSPORT_WIFI);
+
+      if (wifiUp)
+      {
+        wifiLost_ms = 0;
+
+        if (!wifiBack_ms)
+          wifiBack_ms = millis();
+
+        // WiFi stable again : standby no longer needed
+        if ( FAILOVER_RESTORE_MS && transports.isActive(standby) && (millis() - wifiBack_ms >= FAILOVER_RESTORE_MS) )
+        {
+          BLYNK_LOG1(BLYNK_F("FO:StopStandby"));
+          transports.stop(standby);
+        }
+      }
+      else
+      {
+        wifiBack_ms = 0;
+
+        if (!wifiLost_ms)
+          wifiLost_ms = millis();
+
+        if ( !transports.isActive(standby) && (millis() - wifiLost_ms >= FAILOVER_GRACE_MS) )
+        {
+          BLYNK_LOG1(BLYNK_F("FO:StartStandby"));
+          transports.start(standby);
+        }
+      }
+
+      uint8_t newRoute = wifiUp ? BLYNK_TRANSPORT_WIFI :
+                         (transports.isConnected(standby) ? standby : BLYNK_TRANSPORT_NONE);
+
+      if (newRoute != route)
+        changeRoute(newRoute);
+    }
+
+    // Same as Blynk virtualWrite(), sent on the current route and cached for replay
+    template <typename... Args>
+    void virtualWrite(int pin, Args... values)
+    {
+      // Full size, as Blynk does : a value longer than the cache is still sent, only not cached
+      char mem[BLYNK_MAX_SENDBYTES];
+
+      BlynkParam cmd(mem, 0, sizeof(mem));
+      cmd.add("vw");
+      cmd.add(pin);
+      cmd.add_multi(values...);
+
+      size_t len = cmd.getLength() - 1;
+
+      cache(pin, mem, len);
+
+      if (route != BLYNK_TRANSPORT_NONE)
+        transports.sendHardware(route, mem, len);
+    }
+
+    uint8_t getRoute()
+    {
+      return route;
+    }
+
+    uint8_t getNumEvents()
+    {
+      return numEvents;
+    }
+
+    // 0 is the most recent. Returns NULL if index out of range
+    const BlynkFailoverEvent* getEvent(uint8_t index)
+    {
+      if (index >= numEvents)
+        return NULL;
+
+      return &events[(nextEvent + FAILOVER_EVENTS - 1 - index) % FAILOVER_EVENTS];
+    }
+
+    void print(Print& out)
+    {
+      for (uint8_t i = 0; i < numEvents; i++)
+      {
+        const BlynkFailoverEvent* ev = getEvent(i);
+
+        out.print(F("FO#"));
+        out.print(i);
+        out.print(F(" from="));
+        out.print(ev->from);
+        out.print(F(",to="));
+        out.print(ev->to);
+        out.print(F(",atMs="));
+        out.print(ev->at_ms);
+        out.print(F(",outageMs="));
+        out.println(ev->outage_ms);
+      }
+    }
+
+  private:
+    BlynkTransportManager& transports;
+    uint8_t   standby;
+    uint8_t   route;
+
+    BlynkFailoverCallback callback;
+
+    uint32_t  wifiLost_ms;
+    uint32_t  wifiBack_ms;
+    uint32_t  down_ms;      // When the last route went down, 0 while a route is up
+
+    struct
+    {
+      uint8_t pin;
+      uint8_t len;
+      char    data[FAILOVER_PIN_VALUE_LEN];
+    } pins[FAILOVER_PIN_CACHE_SIZE];
+
+    uint8_t   numPins;
+
+    BlynkFailoverEvent events[FAILOVER_EVENTS];
+    uint8_t   numEvents;
+    uint8_t   nextEvent;
+
+    void changeRoute(uint8_t newRoute)
+    {
+      uint8_t oldRoute = route;
+
+      route = newRoute;
+
+      if (newRoute == BLYNK_TRANSPORT_NONE)
+      {
+        down_ms = millis();
+        BLYNK_LOG1(BLYNK_F("FO:NoLink"));
+        return;
+      }
+
+      BlynkFailoverEvent& ev = events[nextEvent];
+
+      ev.from       = oldRoute;
+      ev.to         = newRoute;
+      ev.at_ms      = millis();
+      ev.outage_ms  = down_ms ? (millis() - down_ms) : 0;
+
+      nextEvent = (nextEvent + 1) % FAILOVER_EVENTS;
+
+      if (numEvents < FAILOVER_EVENTS)
+        numEvents++;
+
+      down_ms = 0;
+
+      BLYNK_LOG6(BLYNK_F("FO:Route="), newRoute, BLYNK_F(",from="), oldRoute, BLYNK_F(",outageMs="), ev.outage_ms);
+
+      // New link : bring app widgets up to date
+      for (uint8_t i = 0; i < numPins; i++)
+      {
+        transports.sendHardware(route, pins[i].data, pins[i].len);
+      }
+
+      if (callback)
+        callback(ev);
+    }
+
+    void cache(int pin, const char* data, size_t len)
+    {
+      uint8_t i;
+
+      for (i = 0; (i < numPins) && (pins[i].pin != pin); i++)
+        ;
+
+      if (len >= FAILOVER_PIN_VALUE_LEN)
+      {
+        // Too long to cache : forget the older value rather than replay it
+        if (i < numPins)
+          pins[i] = pins[--numPins];
+
+        return;
+      }
+
+      if (i == numPins)
+      {
+        // Cache full : pin not replayed
+        if (numPins == FAILOVER_PIN_CACHE_SIZE)
+          return;
+
+        numPins++;
+        pins[i].pin = pin;
+      }
+
+      memcpy(pins[i].data, data, len);
+      pins[i].len = len;
+    }
+};
+
+#endif    // BlynkEsp32_Failover_h
@@ -0,0 +1,91 @@
+/****************************************************************************************************************************
+   BlynkEsp32_Features.h
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   Compile-time selection of the optional parts of <BlynkSimpleEsp32_WFM.h>, to fit the sketch in a smaller partition,
+   e.g. with OTA. Define the flags before including <BlynkSimpleEsp32_WFM.h>. Parts not selected are not compiled.
+   Other size levers, already compile-time :
+   - USE_SPIFFS selects SPIFFS or EEPROM storage. Only one of them is built.
+   - Without #define BLYNK_PRINT, all BLYNK_LOGx() and their strings are removed.
+   - BLYNK_USE_TRACE, USE_RUN_WATCHDOG, USE_WIFI_ROAMING and USE_DEEP_SLEEP_RESUME default to false.
+   - Including only one of the BT / BLE / WiFi headers links only that stack.
+   Set BLYNK_FEATURE_REPORT true to list the selection in the build output.
+ *****************************************************************************************************************************/
+
+#ifndef BlynkEsp32_Features_h
+#define BlynkEsp32_Features_h
+
+// Config Portal : soft AP, WebServer and its HTML. Without it, the stored config data must already be valid.
+#ifndef BLYNK_WM_CONFIG_PORTAL
+#define BLYNK_WM_CONFIG_PORTAL          true
+#endif
+
+// Dynamic parameters : myMenuItems[] of the sketch are stored and shown in the Config Portal.
+// When false, the sketch doesn't need to define myMenuItems[] and NUM_MENU_ITEMS.
+#ifndef BLYNK_WM_DYNAMIC_PARAMETERS
+#define BLYNK_WM_DYNAMIC_PARAMETERS     true
+#endif
+
+// WiFi scan in the Config Portal : the SSID inputs offer the networks around, strongest first. Needs the Config Portal.
+#ifndef BLYNK_WM_WIFI_SCAN
+#define BLYNK_WM_WIFI_SCAN              true
+#endif
+
+#if !BLYNK_WM_CONFIG_PORTAL
+#undef  BLYNK_WM_WIFI_SCAN
+#define BLYNK_WM_WIFI_SCAN              false
+#endif
+
+#ifndef BLYNK_FEATURE_REPORT
+#define BLYNK_FEATURE_REPORT            false
+#endif
+
+#if BLYNK_FEATURE_REPORT
+
+#if BLYNK_WM_CONFIG_PORTAL
+#pragma message("BlynkESP32_BT_WF Config Portal = on")
+#else
+#pragma message("BlynkESP32_BT_WF Config Portal = off")
+#endif
+
+#if BLYNK_WM_WIFI_SCAN
+#pragma message("BlynkESP32_BT_WF WiFi scan = on")
+#else
+#pragma message("BlynkESP32_BT_WF WiFi scan = off")
+#endif
+
+#if BLYNK_WM_DYNAMIC_PARAMETERS
+#pragma message("BlynkESP32_BT_WF dynamic parameters = on")
+#else
+#pragma message("BlynkESP32_BT_WF dynamic parameters = off")
+#endif
+
+#if (defined(USE_SPIFFS) && USE_SPIFFS)
+#pragma message("BlynkESP32_BT_WF storage = SPIFFS")
+#else
+#pragma message("BlynkESP32_BT_WF storage = EEPROM")
+#endif
+
+#if defined(BLYNK_PRINT)
+#pragma message("BlynkESP32_BT_WF logs = on")
+#else
+#pragma message("BlynkESP32_BT_WF logs = off")
+#endif
+
+#if defined(BlynkSimpleEsp32_BT_WF_h)
+#pragma message("BlynkESP32_BT_WF transport = BT")
+#endif
+
+#if defined(BlynkSimpleEsp32_BLE_WF_h)
+#pragma message("BlynkESP32_BT_WF transport = BLE")
+#endif
+
+#endif    // BLYNK_FEATURE_REPORT
+
+#endif    // BlynkEsp32_Features_h
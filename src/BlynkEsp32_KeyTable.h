@@ -0,0 +1,112 @@
+/****************************************************************************************************************************
+   BlynkEsp32_KeyTable.h
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   Hash table from Config Portal keys to the config field or menu item they set, so a portal request costs the same
+   whatever the number of parameters. blynkKeyHash() is constexpr : hashes of the keys of the config schema are
+   compile-time constants. The table holds only a 16-bit tag of the hash and an entry number, the caller compares
+   the key of the entries found. It is kept at most half full, with linear probing.
+ *****************************************************************************************************************************/
+
+#ifndef BlynkEsp32_KeyTable_h
+#define BlynkEsp32_KeyTable_h
+
+#include <stdint.h>
+
+// Slots in the table. Must be a power of 2. Holds up to BLYNK_KEY_TABLE_SIZE / 2 keys.
+#ifndef BLYNK_KEY_TABLE_SIZE
+#define BLYNK_KEY_TABLE_SIZE      64
+#endif
+
+#if (BLYNK_KEY_TABLE_SIZE & (BLYNK_KEY_TABLE_SIZE - 1))
+#error BLYNK_KEY_TABLE_SIZE must be a power of 2
+#endif
+
+#define BLYNK_KEY_NONE            0xFF
+
+#define BLYNK_KEY_HASH_OFFSET     2166136261UL
+#define BLYNK_KEY_HASH_PRIME      16777619UL
+
+// FNV-1a of the first len chars of key
+constexpr uint32_t blynkKeyHash(const char* key, uint8_t len, uint32_t hash = BLYNK_KEY_HASH_OFFSET)
+{
+  return len ? blynkKeyHash(key + 1, (uint8_t) (len - 1), (uint32_t) ((hash ^ (uint8_t) *key) * BLYNK_KEY_HASH_PRIME)) : hash;
+}
+
+class BlynkKeyTable
+{
+  public:
+    BlynkKeyTable()
+    {
+      clear();
+    }
+
+    void clear()
+    {
+      for (uint16_t i = 0; i < BLYNK_KEY_TABLE_SIZE; i++)
+        slots[i].entry = BLYNK_KEY_NONE;
+
+      numKeys = 0;
+    }
+
+    // False if the table is full
+    bool add(uint32_t hash, uint8_t entry)
+    {
+      if ( (entry == BLYNK_KEY_NONE) || (numKeys >= BLYNK_KEY_TABLE_SIZE / 2) )
+        return false;
+
+      uint16_t i = hash & (BLYNK_KEY_TABLE_SIZE - 1);
+
+      while (slots[i].entry != BLYNK_KEY_NONE)
+        i = (i + 1) & (BLYNK_KEY_TABLE_SIZE - 1);
+
+      slots[i].tag    = hash >> 16;
+      slots[i].entry  = entry;
+      numKeys++;
+
+      return true;
+    }
+
+    // Next entry whose hash may match. Start with probe = 0, then call again while the key of the entry differs.
+    // BLYNK_KEY_NONE when there is no more.
+    uint8_t find(uint32_t hash, uint16_t& probe)
+    {
+      uint16_t tag = hash >> 16;
+
+      while (probe < BLYNK_KEY_TABLE_SIZE)
+      {
+        Slot& slot = slots[(hash + probe++) & (BLYNK_KEY_TABLE_SIZE - 1)];
+
+        if (slot.entry == BLYNK_KEY_NONE)
+          break;
+
+        if (slot.tag == tag)
+          return slot.entry;
+      }
+
+      return BLYNK_KEY_NONE;
+    }
+
+    uint16_t getNumKeys()
+    {
+      return numKeys;
+    }
+
+  private:
+    typedef struct
+    {
+      uint16_t  tag;
+      uint8_t   entry;
+    } Slot;
+
+    Slot      slots[BLYNK_KEY_TABLE_SIZE];
+    uint16_t  numKeys;
+};
+
+#endif    // BlynkEsp32_KeyTable_h
@@ -0,0 +1,234 @@
+/****************************************************************************************************************************
+   BlynkEsp32_LinkMonitor.h
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   WiFi link-quality monitor and roaming decision.
+   RSSI and Blynk round-trip time are smoothed in the background. When RSSI stays below ROAM_RSSI_THRESHOLD,
+   configured APs are scanned asynchronously. If one is better by at least ROAM_RSSI_HYSTERESIS dB, a handover is
+   planned, then done by BlynkWifi::run() at a quiet moment of the protocol.
+   Define USE_WIFI_ROAMING true before including <BlynkSimpleEsp32_WFM.h> to enable.
+ *****************************************************************************************************************************/
+
+#ifndef BlynkEsp32_LinkMonitor_h
+#define BlynkEsp32_LinkMonitor_h
+
+#ifndef USE_WIFI_ROAMING
+#define USE_WIFI_ROAMING                false
+#endif
+
+#if USE_WIFI_ROAMING
+
+#include <Arduino.h>
+
+// RSSI sampling period
+#ifndef LINK_MONITOR_INTERVAL_MS
+#define LINK_MONITOR_INTERVAL_MS        5000L
+#endif
+
+// Blynk round-trip time probe period
+#ifndef LINK_MONITOR_RTT_INTERVAL_MS
+#define LINK_MONITOR_RTT_INTERVAL_MS    30000L
+#endif
+
+// Look for a better AP only when smoothed RSSI is below this
+#ifndef ROAM_RSSI_THRESHOLD
+#define ROAM_RSSI_THRESHOLD             -70
+#endif
+
+// A candidate AP must be better than the current one by this many dB
+#ifndef ROAM_RSSI_HYSTERESIS
+#define ROAM_RSSI_HYSTERESIS            10
+#endif
+
+// Min time between two scans
+#ifndef ROAM_SCAN_INTERVAL_MS
+#define ROAM_SCAN_INTERVAL_MS           60000L
+#endif
+
+// Min time between two handovers, to avoid flapping between APs
+#ifndef ROAM_MIN_INTERVAL_MS
+#define ROAM_MIN_INTERVAL_MS            300000L
+#endif
+
+// Max time to associate with the new AP during a handover
+#ifndef ROAM_CONNECT_TIMEOUT_MS
+#define ROAM_CONNECT_TIMEOUT_MS         5000L
+#endif
+
+#define LINK_RSSI_UNKNOWN               -127
+
+typedef struct
+{
+  int8_t    credIndex;
+  int32_t   rssi;
+  int32_t   channel;
+  uint8_t   bssid[6];
+} BlynkRoamTarget;
+
+class BlynkLinkMonitor
+{
+  public:
+    BlynkLinkMonitor()
+    {
+      reset();
+      lastHandover_ms = 0;
+      numHandovers    = 0;
+    }
+
+    // New association : restart smoothing
+    void reset()
+    {
+      rssi_x16        = LINK_RSSI_UNKNOWN * 16;
+      lastSample_ms   = 0;
+      lastScan_ms     = millis();
+      lastPing_ms     = millis();
+      rtt_ms          = 0;
+      scanning        = false;
+      handoverPending = false;
+    }
+
+    // Call often while connected. RSSI is sampled every LINK_MONITOR_INTERVAL_MS.
+    void sampleRSSI(int32_t rssi)
+    {
+      if ( lastSample_ms && (millis() - lastSample_ms < LINK_MONITOR_INTERVAL_MS) )
+        return;
+
+      lastSample_ms = millis();
+
+      // EWMA with alpha = 1/4, in 1/16 dB
+      if (rssi_x16 == LINK_RSSI_UNKNOWN * 16)
+        rssi_x16 = rssi * 16;
+      else
+        rssi_x16 += (rssi * 16 - rssi_x16) / 4;
+    }
+
+    bool isSampleDue()
+    {
+      return ( !lastSample_ms || (millis() - lastSample_ms >= LINK_MONITOR_INTERVAL_MS) );
+    }
+
+    int16_t getRSSI()
+    {
+      return rssi_x16 / 16;
+    }
+
+    bool isRttProbeDue()
+    {
+      return (millis() - lastPing_ms >= LINK_MONITOR_RTT_INTERVAL_MS);
+    }
+
+    void rttProbeSent()
+    {
+      lastPing_ms = millis();
+    }
+
+    void addRTT(uint32_t ms)
+    {
+      rtt_ms = (rtt_ms == 0) ? ms : (3 * rtt_ms + ms) / 4;
+    }
+
+    uint32_t getRTT()
+    {
+      return rtt_ms;
+    }
+
+    // true when link is weak and no scan / handover is under way
+    bool isScanDue()
+    {
+      if ( scanning || handoverPending || (getRSSI() == LINK_RSSI_UNKNOWN) || (getRSSI() >= ROAM_RSSI_THRESHOLD) )
+        return false;
+
+      if (millis() - lastScan_ms < ROAM_SCAN_INTERVAL_MS)
+        return false;
+
+      return (millis() - lastHandover_ms >= ROAM_MIN_INTERVAL_MS) || (numHandovers == 0);
+    }
+
+    void scanStarted()
+    {
+      scanning          = true;
+      lastScan_ms       = millis();
+      best.credIndex    = -1;
+      best.rssi         = LINK_RSSI_UNKNOWN;
+    }
+
+    bool isScanning()
+    {
+      return scanning;
+    }
+
+    // Feed every scanned AP matching one of the configured SSIDs
+    void considerAP(uint8_t credIndex, int32_t rssi, const uint8_t* bssid, int32_t channel, const uint8_t* currentBSSID)
+    {
+      // Same AP we're on
+      if (currentBSSID && !memcmp(bssid, currentBSSID, 6))
+        return;
+
+      if (rssi > best.rssi)
+      {
+        best.credIndex  = credIndex;
+        best.rssi       = rssi;
+        best.channel    = channel;
+        memcpy(best.bssid, bssid, 6);
+      }
+    }
+
+    // Scan done. Plan a handover if the best candidate is significantly better.
+    bool scanDone()
+    {
+      scanning = false;
+
+      if ( (best.credIndex >= 0) && (best.rssi >= getRSSI() + ROAM_RSSI_HYSTERESIS) )
+      {
+        handoverPending = true;
+      }
+
+      return handoverPending;
+    }
+
+    bool isHandoverPending()
+    {
+      return handoverPending;
+    }
+
+    const BlynkRoamTarget& getTarget()
+    {
+      return best;
+    }
+
+    void handoverDone()
+    {
+      handoverPending = false;
+      lastHandover_ms = millis();
+      numHandovers++;
+    }
+
+    uint16_t getNumHandovers()
+    {
+      return numHandovers;
+    }
+
+  private:
+    int16_t   rssi_x16;
+    uint32_t  lastSample_ms;
+    uint32_t  lastScan_ms;
+    uint32_t  lastPing_ms;
+    uint32_t  lastHandover_ms;
+    uint32_t  rtt_ms;
+    uint16_t  numHandovers;
+
+    bool      scanning;
+    bool      handoverPending;
+
+    BlynkRoamTarget best;
+};
+
+#endif    // USE_WIFI_ROAMING
+
+#endif    // BlynkEsp32_LinkMonitor_h
@@ -0,0 +1,341 @@
+/****************************************************************************************************************************
+   BlynkEsp32_Log.h
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   Logging backend of <BlynkSimpleEsp32_WFM.h>, without heap allocation.
+   BLYNK_WM_LOGE/W/I/D() store a binary record in a fixed RAM ring : flash strings and numbers as is, IPAddress as
+   uint32_t, RAM strings and String copied into the record. Records are formatted, in the same layout as BLYNK_LOGx(),
+   only when drained to BLYNK_PRINT : by Blynk_WF.run(), at the end of begin() and before its blocking waits, or when
+   the ring is full.
+   Levels above BLYNK_WM_LOG_LEVEL compile to nothing, their arguments are not evaluated.
+ *****************************************************************************************************************************/
+
+#ifndef BlynkEsp32_Log_h
+#define BlynkEsp32_Log_h
+
+#define BLYNK_LOG_LEVEL_NONE        0
+#define BLYNK_LOG_LEVEL_ERROR       1
+#define BLYNK_LOG_LEVEL_WARN        2
+#define BLYNK_LOG_LEVEL_INFO        3
+#define BLYNK_LOG_LEVEL_DEBUG       4
+
+#ifndef BLYNK_WM_LOG_LEVEL
+#if defined(BLYNK_PRINT)
+#define BLYNK_WM_LOG_LEVEL          BLYNK_LOG_LEVEL_INFO
+#else
+#define BLYNK_WM_LOG_LEVEL          BLYNK_LOG_LEVEL_NONE
+#endif
+#endif
+
+#if (BLYNK_WM_LOG_LEVEL > BLYNK_LOG_LEVEL_NONE)
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+// Records in the ring
+#ifndef BLYNK_WM_LOG_BUFFER_SIZE
+#define BLYNK_WM_LOG_BUFFER_SIZE    16
+#endif
+
+// Arguments of one record, as BLYNK_LOG6()
+#define BLYNK_WM_LOG_MAX_ARGS       6
+
+// Room for the RAM strings of one record. Longer ones are truncated.
+#ifndef BLYNK_WM_LOG_TEXT_LEN
+#define BLYNK_WM_LOG_TEXT_LEN       48
+#endif
+
+#define BLYNK_LOG_ARG_FLASH         0
+#define BLYNK_LOG_ARG_TEXT          1
+#define BLYNK_LOG_ARG_INT           2
+#define BLYNK_LOG_ARG_UINT          3
+#define BLYNK_LOG_ARG_HEX           4
+#define BLYNK_LOG_ARG_IP            5
+
+// Number printed in hex, instead of String(value, HEX)
+typedef struct
+{
+  uint32_t value;
+} BlynkLogHex;
+
+inline BlynkLogHex blynkLogHex(uint32_t value)
+{
+  BlynkLogHex hex = { value };
+  return hex;
+}
+
+typedef union
+{
+  uint32_t    number;
+  const void* flash;
+} BlynkLogValue;
+
+typedef struct
+{
+  uint32_t  ts;
+  uint8_t   level;
+  uint8_t   numArgs;
+  uint8_t   textLen;
+  uint8_t   types[BLYNK_WM_LOG_MAX_ARGS];
+  // Flash string, number, or offset in text
+  BlynkLogValue values[BLYNK_WM_LOG_MAX_ARGS];
+  char      text[BLYNK_WM_LOG_TEXT_LEN];
+} BlynkLogRecord;
+
+class BlynkLog
+{
+  public:
+    BlynkLog()
+      : head(0)
+      , count(0)
+      , dropped(0)
+    {}
+
+    template <typename... Args>
+    void record(uint8_t level, const Args&... args)
+    {
+      BlynkLogRecord rec;
+
+      rec.ts      = millis();
+      rec.level   = level;
+      rec.numArgs = 0;
+      rec.textLen = 0;
+
+      add(rec, args...);
+
+#if defined(BLYNK_PRINT)
+      // Make room, unless called from an ISR
+      if ( (count == BLYNK_WM_LOG_BUFFER_SIZE) && !xPortInIsrContext() )
+        drain(BLYNK_PRINT);
+#endif
+
+      portENTER_CRITICAL(&logMux);
+
+      records[head] = rec;
+      head = (head + 1) % BLYNK_WM_LOG_BUFFER_SIZE;
+
+      if (count < BLYNK_WM_LOG_BUFFER_SIZE)
+        count++;
+      else
+        dropped++;
+
+      portEXIT_CRITICAL(&logMux);
+    }
+
+    // Formats and prints the waiting records, oldest first
+    void drain(Print& out)
+    {
+      BlynkLogRecord rec;
+
+      while (pop(rec))
+        print(out, rec);
+    }
+
+    uint16_t size()
+    {
+      return count;
+    }
+
+    // Overwritten before being drained
+    uint32_t getDropped()
+    {
+      return dropped;
+    }
+
+  private:
+    BlynkLogRecord records[BLYNK_WM_LOG_BUFFER_SIZE];
+
+    volatile uint16_t head;
+    volatile uint16_t count;
+    volatile uint32_t dropped;
+
+    portMUX_TYPE logMux = portMUX_INITIALIZER_UNLOCKED;
+
+    bool pop(BlynkLogRecord& rec)
+    {
+      bool found = false;
+
+      portENTER_CRITICAL(&logMux);
+
+      if (count)
+      {
+        rec   = records[(head + BLYNK_WM_LOG_BUFFER_SIZE - count) % BLYNK_WM_LOG_BUFFER_SIZE];
+        found = true;
+        count--;
+      }
+
+      portEXIT_CRITICAL(&logMux);
+
+      return found;
+    }
+
+    void add(BlynkLogRecord& rec)
+    {
+      (void) rec;
+    }
+
+    template <typename T, typename... Rest>
+    void add(BlynkLogRecord& rec, const T& first, const Rest&... rest)
+    {
+      if (rec.numArgs < BLYNK_WM_LOG_MAX_ARGS)
+        addArg(rec, first);
+
+      add(rec, rest...);
+    }
+
+    void addValue(BlynkLogRecord& rec, uint8_t type, uint32_t value)
+    {
+      rec.types[rec.numArgs]          = type;
+      rec.values[rec.numArgs].number  = value;
+      rec.numArgs++;
+    }
+
+    void addText(BlynkLogRecord& rec, const char* text)
+    {
+      uint8_t start = rec.textLen;
+
+      while ( *text && (rec.textLen < BLYNK_WM_LOG_TEXT_LEN - 1) )
+        rec.text[rec.textLen++] = *text++;
+
+      rec.text[rec.textLen++] = 0;
+
+      // Full : the text is truncated, or empty
+      if (rec.textLen > BLYNK_WM_LOG_TEXT_LEN - 1)
+        rec.textLen = BLYNK_WM_LOG_TEXT_LEN - 1;
+
+      addValue(rec, BLYNK_LOG_ARG_TEXT, start);
+    }
+
+    void addArg(BlynkLogRecord& rec, const __FlashStringHelper* value)
+    {
+      rec.types[rec.numArgs]        = BLYNK_LOG_ARG_FLASH;
+      rec.values[rec.numArgs].flash = value;
+      rec.numArgs++;
+    }
+
+    void addArg(BlynkLogRecord& rec, const char* value)
+    {
+      addText(rec, value ? value : "");
+    }
+
+    void addArg(BlynkLogRecord& rec, const String& value)
+    {
+      addText(rec, value.c_str());
+    }
+
+    void addArg(BlynkLogRecord& rec, const IPAddress& value)
+    {
+      addValue(rec, BLYNK_LOG_ARG_IP, (uint32_t) value);
+    }
+
+    void addArg(BlynkLogRecord& rec, const BlynkLogHex& value)
+    {
+      addValue(rec, BLYNK_LOG_ARG_HEX, value.value);
+    }
+
+    void addArg(BlynkLogRecord& rec, int value)
+    {
+      addValue(rec, BLYNK_LOG_ARG_INT, value);
+    }
+
+    void addArg(BlynkLogRecord& rec, long value)
+    {
+      addValue(rec, BLYNK_LOG_ARG_INT, value);
+    }
+
+    void addArg(BlynkLogRecord& rec, unsigned int value)
+    {
+      addValue(rec, BLYNK_LOG_ARG_UINT, value);
+    }
+
+    void addArg(BlynkLogRecord& rec, unsigned long value)
+    {
+      addValue(rec, BLYNK_LOG_ARG_UINT, value);
+    }
+
+    // Same layout as BLYNK_LOGx()
+    void print(Print& out, const BlynkLogRecord& rec)
+    {
+      out.print('[');
+      out.print(rec.ts);
+      out.print(F("] "));
+
+      for (uint8_t i = 0; i < rec.numArgs; i++)
+      {
+        uint32_t value = rec.values[i].number;
+
+        switch (rec.types[i])
+        {
+          case BLYNK_LOG_ARG_FLASH:
+            out.print((const __FlashStringHelper*) rec.values[i].flash);
+            break;
+
+          case BLYNK_LOG_ARG_TEXT:
+            out.print(&rec.text[value]);
+            break;
+
+          case BLYNK_LOG_ARG_INT:
+            out.print((int32_t) value);
+            break;
+
+          case BLYNK_LOG_ARG_UINT:
+            out.print(value);
+            break;
+
+          case BLYNK_LOG_ARG_HEX:
+            out.print(value, HEX);
+            break;
+
+          case BLYNK_LOG_ARG_IP:
+            out.print(IPAddress(value));
+            break;
+        }
+      }
+
+      out.println();
+    }
+};
+
+BlynkLog BlynkLogger;
+
+#if defined(BLYNK_PRINT)
+#define BLYNK_WM_LOG_DRAIN()        BlynkLogger.drain(BLYNK_PRINT)
+#endif
+
+#endif    // (BLYNK_WM_LOG_LEVEL > BLYNK_LOG_LEVEL_NONE)
+
+#ifndef BLYNK_WM_LOG_DRAIN
+#define BLYNK_WM_LOG_DRAIN()        do {} while (0)
+#endif
+
+#if (BLYNK_WM_LOG_LEVEL >= BLYNK_LOG_LEVEL_ERROR)
+#define BLYNK_WM_LOGE(...)          BlynkLogger.record(BLYNK_LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define BLYNK_WM_LOGE(...)          do {} while (0)
+#endif
+
+#if (BLYNK_WM_LOG_LEVEL >= BLYNK_LOG_LEVEL_WARN)
+#define BLYNK_WM_LOGW(...)          BlynkLogger.record(BLYNK_LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define BLYNK_WM_LOGW(...)          do {} while (0)
+#endif
+
+#if (BLYNK_WM_LOG_LEVEL >= BLYNK_LOG_LEVEL_INFO)
+#define BLYNK_WM_LOGI(...)          BlynkLogger.record(BLYNK_LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define BLYNK_WM_LOGI(...)          do {} while (0)
+#endif
+
+#if (BLYNK_WM_LOG_LEVEL >= BLYNK_LOG_LEVEL_DEBUG)
+#define BLYNK_WM_LOGD(...)          BlynkLogger.record(BLYNK_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define BLYNK_WM_LOGD(...)          do {} while (0)
+#endif
+
+#endif    // BlynkEsp32_Log_h
@@ -0,0 +1,463 @@
+/****************************************************************************************************************************
+   BlynkEsp32_OLEDFields.h
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   Dirty-region text layer over an Adafruit_SSD1306 I2C display.
+   The screen is a set of text fields. Only fields whose text changed are redrawn into the frame buffer, and only the
+   SSD1306 pages / columns they cover are sent over I2C. The transfer can also run in small chunks from loop(), so
+   Blynk run() isn't blocked for a whole frame. Bytes and I2C time of each frame are measured.
+   Display rotation must be 0.
+ *****************************************************************************************************************************/
+
+#ifndef BlynkEsp32_OLEDFields_h
+#define BlynkEsp32_OLEDFields_h
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1306.h>
+
+#ifndef OLED_MAX_FIELDS
+#define OLED_MAX_FIELDS           12
+#endif
+
+// Max chars of one field
+#ifndef OLED_FIELD_LEN
+#define OLED_FIELD_LEN            12
+#endif
+
+// Chunks sent per run() call in async mode. One chunk is about 0.8 ms at 400 kHz.
+#ifndef OLED_CHUNKS_PER_RUN
+#define OLED_CHUNKS_PER_RUN       1
+#endif
+
+// Data bytes per I2C transaction, as in Adafruit_SSD1306
+#define OLED_I2C_CHUNK            31
+#define OLED_MAX_PAGES            8
+#define OLED_PAGE_CLEAN           0xFF
+
+// Built-in 5x7 font, 1 column spacing
+#define OLED_CHAR_WIDTH           6
+#define OLED_CHAR_HEIGHT          8
+
+class BlynkOLEDFields
+{
+  public:
+    BlynkOLEDFields(Adafruit_SSD1306& oled, uint8_t i2cAddress = 0x3C, TwoWire& i2c = Wire)
+      : display(oled)
+      , wire(i2c)
+      , address(i2cAddress)
+      , numFields(0)
+      , busy(false)
+      , sendPage(0)
+      , sendCol(0)
+      , frameBytes(0)
+      , frameTime_us(0)
+      , numFrames(0)
+    {
+      memset(dirtyMin, OLED_PAGE_CLEAN, sizeof(dirtyMin));
+      memset(dirtyMax, 0, sizeof(dirtyMax));
+      memset(sendMin, OLED_PAGE_CLEAN, sizeof(sendMin));
+      memset(sendMax, 0, sizeof(sendMax));
+    }
+
+    // Returns field id, or -1 if OLED_MAX_FIELDS reached
+    int8_t addField(int16_t x, int16_t y, uint8_t maxChars, uint8_t textSize = 1)
+    {
+      if (numFields >= OLED_MAX_FIELDS)
+        return -1;
+
+      Field& f = fields[numFields];
+
+      f.x         = x;
+      f.y         = y;
+      f.maxChars  = (maxChars < OLED_FIELD_LEN) ? maxChars : OLED_FIELD_LEN;
+      f.size      = textSize;
+      f.text[0]   = 0;
+      f.dirty     = true;
+
+      return numFields++;
+    }
+
+    // Fixed text, drawn once
+    int8_t addLabel(int16_t x, int16_t y, const char* text, uint8_t textSize = 1)
+    {
+      int8_t id = addField(x, y, strlen(text), textSize);
+
+      if (id >= 0)
+        setText(id, text);
+
+      return id;
+    }
+
+    void setText(uint8_t id, const char* text)
+    {
+      if (id >= numFields)
+        return;
+
+      Field& f = fields[id];
+
+      if (strncmp(f.text, text, f.maxChars) == 0)
+        return;
+
+      strncpy(f.text, text, f.maxChars);
+      f.text[f.maxChars] = 0;
+      f.dirty = true;
+    }
+
+    void setText(uint8_t id, long value)
+    {
+      char buf[OLED_FIELD_LEN + 1];
+
+      snprintf(buf, sizeof(buf), "%ld", value);
+      setText(id, buf);
+    }
+
+    void setText(uint8_t id, double value, uint8_t digits)
+    {
+      char buf[OLED_FIELD_LEN + 1];
+
+      snprintf(buf, sizeof(buf), "%.*f", digits, value);
+      setText(id, buf);
+    }
+
+    // Old area is cleared, new one drawn
+    void setTextSize(uint8_t id, uint8_t textSize)
+    {
+      if ( (id >= numFields) || (fields[id].size == textSize) )
+        return;
+
+      clearField(fields[id]);
+
+      fields[id].size   = textSize;
+      fields[id].dirty  = true;
+    }
+
+    // Draw changed fields into the frame buffer
+    void render()
+    {
+      // Clearing a field erases the fields it overlaps : redraw them too
+      bool changed = true;
+
+      while (changed)
+      {
+        changed = false;
+
+        for (uint8_t i = 0; i < numFields; i++)
+        {
+          if (!fields[i].dirty)
+            continue;
+
+          for (uint8_t j = 0; j < numFields; j++)
+          {
+            if (!fields[j].dirty && overlap(fields[i], fields[j]))
+            {
+              fields[j].dirty = true;
+              changed         = true;
+            }
+          }
+        }
+      }
+
+      for (uint8_t i = 0; i < numFields; i++)
+      {
+        if (fields[i].dirty)
+          clearField(fields[i]);
+      }
+
+      display.setTextColor(WHITE);
+
+      for (uint8_t i = 0; i < numFields; i++)
+      {
+        Field& f = fields[i];
+
+        if (!f.dirty)
+          continue;
+
+        display.setTextSize(f.size);
+        display.setCursor(f.x, f.y);
+        display.print(f.text);
+
+        f.dirty = false;
+      }
+    }
+
+    // Send the dirty parts of the frame buffer. In async mode, run() sends it chunk by chunk.
+    void flush(bool async = false)
+    {
+      // Previous frame still in progress : finish it first
+      if (busy)
+      {
+        if (async)
+        {
+          pending = true;
+          return;
+        }
+
+        finish();
+      }
+
+      pending = false;
+      startFrame();
+
+      if (!async)
+        finish();
+    }
+
+    // render() + flush()
+    void update(bool async = false)
+    {
+      render();
+      flush(async);
+    }
+
+    // Call in loop() when using async flush
+    void run()
+    {
+      for (uint8_t i = 0; busy && (i < OLED_CHUNKS_PER_RUN); i++)
+      {
+        sendChunk();
+      }
+
+      // Fields changed while the previous frame was sent
+      if (!busy && pending)
+      {
+        pending = false;
+        startFrame();
+      }
+    }
+
+    // Whole screen will be sent by the next flush, e.g. after display.display() or clearDisplay()
+    void invalidate()
+    {
+      for (uint8_t i = 0; i < numFields; i++)
+      {
+        fields[i].dirty = true;
+      }
+
+      markDirty(0, 0, display.width(), display.height());
+    }
+
+    bool isBusy()
+    {
+      return busy;
+    }
+
+    // I2C bytes of the last complete frame, commands included. A full 128x32 frame is more than 512.
+    uint16_t getFrameBytes()
+    {
+      return lastFrameBytes;
+    }
+
+    // I2C time of the last complete frame, in us, summed over its chunks
+    uint32_t getFrameTime()
+    {
+      return lastFrameTime_us;
+    }
+
+    uint32_t getNumFrames()
+    {
+      return numFrames;
+    }
+
+    void print(Print& out)
+    {
+      out.print(F("OLED:Frames="));
+      out.print(numFrames);
+      out.print(F(",Bytes="));
+      out.print(lastFrameBytes);
+      out.print(F(",Us="));
+      out.println(lastFrameTime_us);
+    }
+
+  private:
+    typedef struct
+    {
+      int16_t x;
+      int16_t y;
+      uint8_t maxChars;
+      uint8_t size;
+      bool    dirty;
+      char    text[OLED_FIELD_LEN + 1];
+    } Field;
+
+    Adafruit_SSD1306& display;
+    TwoWire&  wire;
+    uint8_t   address;
+
+    Field     fields[OLED_MAX_FIELDS];
+    uint8_t   numFields;
+
+    // Column range to send, per 8-pixel page. OLED_PAGE_CLEAN if nothing.
+    uint8_t   dirtyMin[OLED_MAX_PAGES];
+    uint8_t   dirtyMax[OLED_MAX_PAGES];
+    uint8_t   sendMin[OLED_MAX_PAGES];
+    uint8_t   sendMax[OLED_MAX_PAGES];
+
+    bool      busy;
+    bool      pending = false;
+    uint8_t   sendPage;
+    uint8_t   sendCol;
+
+    uint16_t  frameBytes;
+    uint32_t  frameTime_us;
+    uint16_t  lastFrameBytes    = 0;
+    uint32_t  lastFrameTime_us  = 0;
+    uint32_t  numFrames;
+
+    int16_t fieldWidth(const Field& f)
+    {
+      return f.maxChars * OLED_CHAR_WIDTH * f.size;
+    }
+
+    int16_t fieldHeight(const Field& f)
+    {
+      return OLED_CHAR_HEIGHT * f.size;
+    }
+
+    bool overlap(const Field& a, const Field& b)
+    {
+      return (a.x < b.x + fieldWidth(b)) && (b.x < a.x + fieldWidth(a)) &&
+             (a.y < b.y + fieldHeight(b)) && (b.y < a.y + fieldHeight(a));
+    }
+
+    void clearField(const Field& f)
+    {
+      display.fillRect(f.x, f.y, fieldWidth(f), fieldHeight(f), BLACK);
+      markDirty(f.x, f.y, fieldWidth(f), fieldHeight(f));
+    }
+
+    void markDirty(int16_t x, int16_t y, int16_t w, int16_t h)
+    {
+      int16_t x1 = x + w - 1;
+      int16_t y1 = y + h - 1;
+
+      if (x < 0)
+        x = 0;
+
+      if (y < 0)
+        y = 0;
+
+      if (x1 >= display.width())
+        x1 = display.width() - 1;
+
+      if (y1 >= display.height())
+        y1 = display.height() - 1;
+
+      if ( (x > x1) || (y > y1) )
+        return;
+
+      for (int16_t page = y / 8; (page <= y1 / 8) && (page < OLED_MAX_PAGES); page++)
+      {
+        if (dirtyMin[page] == OLED_PAGE_CLEAN)
+        {
+          dirtyMin[page] = x;
+          dirtyMax[page] = x1;
+        }
+        else
+        {
+          if (x < dirtyMin[page])
+            dirtyMin[page] = x;
+
+          if (x1 > dirtyMax[page])
+            dirtyMax[page] = x1;
+        }
+      }
+    }
+
+    void startFrame()
+    {
+      memcpy(sendMin, dirtyMin, sizeof(sendMin));
+      memcpy(sendMax, dirtyMax, sizeof(sendMax));
+      memset(dirtyMin, OLED_PAGE_CLEAN, sizeof(dirtyMin));
+      memset(dirtyMax, 0, sizeof(dirtyMax));
+
+      frameBytes    = 0;
+      frameTime_us  = 0;
+      sendPage      = 0;
+      busy          = nextPage();
+    }
+
+    void finish()
+    {
+      while (busy)
+      {
+        sendChunk();
+      }
+    }
+
+    // Move sendPage to the next page with something to send
+    bool nextPage()
+    {
+      while ( (sendPage < OLED_MAX_PAGES) && (sendMin[sendPage] == OLED_PAGE_CLEAN) )
+      {
+        sendPage++;
+      }
+
+      if (sendPage >= OLED_MAX_PAGES)
+      {
+        lastFrameBytes    = frameBytes;
+        lastFrameTime_us  = frameTime_us;
+
+        if (frameBytes)
+          numFrames++;
+
+        return false;
+      }
+
+      sendCol = sendMin[sendPage];
+
+      return true;
+    }
+
+    void sendChunk()
+    {
+      uint32_t start = micros();
+
+      // New page : set the write window to its dirty columns
+      if (sendCol == sendMin[sendPage])
+      {
+        const uint8_t cmds[] = { SSD1306_COLUMNADDR, sendMin[sendPage], sendMax[sendPage],
+                                 SSD1306_PAGEADDR, sendPage, sendPage };
+
+        wire.beginTransmission(address);
+        wire.write((uint8_t) 0x00);
+        wire.write(cmds, sizeof(cmds));
+        wire.endTransmission();
+
+        frameBytes += sizeof(cmds) + 1;
+      }
+
+      uint8_t   count = sendMax[sendPage] - sendCol + 1;
+      uint8_t*  data  = display.getBuffer() + sendPage * display.width() + sendCol;
+
+      if (count > OLED_I2C_CHUNK)
+        count = OLED_I2C_CHUNK;
+
+      wire.beginTransmission(address);
+      wire.write((uint8_t) 0x40);
+      wire.write(data, count);
+      wire.endTransmission();
+
+      frameBytes   += count + 1;
+      frameTime_us += micros() - start;
+
+      if (sendCol + count > sendMax[sendPage])
+      {
+        sendMin[sendPage] = OLED_PAGE_CLEAN;
+        busy = nextPage();
+      }
+      else
+      {
+        sendCol += count;
+      }
+    }
+};
+
+#endif    // BlynkEsp32_OLEDFields_h
@@ -0,0 +1,344 @@
+/****************************************************************************************************************************
+   BlynkEsp32_OfflineQueue.h
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   Store-and-forward queue for virtualWrite() of one Blynk instance (Blynk_WF, Blynk_BT or Blynk_BLE).
+   While not connected, writes are kept with their timestamp in a RAM ring, and when the ring is full the oldest
+   ones spill to a SPIFFS ring file. After reconnection, the queue drains oldest first at a controlled rate.
+   Include after the Blynk headers.
+ *****************************************************************************************************************************/
+
+#ifndef BlynkEsp32_OfflineQueue_h
+#define BlynkEsp32_OfflineQueue_h
+
+#include <Arduino.h>
+#include <Blynk/BlynkConfig.h>
+#include <Blynk/BlynkProtocolDefs.h>
+#include <Blynk/BlynkParam.h>
+
+// Entries kept in RAM
+#ifndef OFFLINE_QUEUE_SIZE
+#define OFFLINE_QUEUE_SIZE              64
+#endif
+
+// Max size of one encoded write ("vw", pin and values)
+#ifndef OFFLINE_QUEUE_ENTRY_LEN
+#define OFFLINE_QUEUE_ENTRY_LEN         32
+#endif
+
+// Entries kept in SPIFFS after the RAM ring is full. Needs USE_SPIFFS true.
+#ifndef OFFLINE_QUEUE_FLASH_SIZE
+#define OFFLINE_QUEUE_FLASH_SIZE        512
+#endif
+
+// Drain rate after reconnection : OFFLINE_QUEUE_DRAIN_BATCH entries every OFFLINE_QUEUE_DRAIN_INTERVAL_MS
+#ifndef OFFLINE_QUEUE_DRAIN_BATCH
+#define OFFLINE_QUEUE_DRAIN_BATCH       4
+#endif
+
+#ifndef OFFLINE_QUEUE_DRAIN_INTERVAL_MS
+#define OFFLINE_QUEUE_DRAIN_INTERVAL_MS 100L
+#endif
+
+// Writes are encoded in a BLYNK_MAX_SENDBYTES buffer first, to find the ones too long for an entry
+#if (OFFLINE_QUEUE_ENTRY_LEN >= BLYNK_MAX_SENDBYTES)
+#error OFFLINE_QUEUE_ENTRY_LEN must be smaller than BLYNK_MAX_SENDBYTES
+#endif
+
+#if (defined(USE_SPIFFS) && USE_SPIFFS && (OFFLINE_QUEUE_FLASH_SIZE > 0))
+#define OFFLINE_QUEUE_USE_SPIFFS        true
+#include <FS.h>
+#include "SPIFFS.h"
+#else
+#define OFFLINE_QUEUE_USE_SPIFFS        false
+#endif
+
+typedef enum
+{
+  OFFLINE_QUEUE_DROP_OLDEST,    // Queue full : oldest entry is dropped
+  OFFLINE_QUEUE_DOWNSAMPLE      // Queue full : every other entry of the RAM ring is dropped, halving its time resolution
+} BlynkOfflineQueuePolicy;
+
+typedef struct
+{
+  uint32_t  at_ms;              // millis() of the original virtualWrite()
+  uint8_t   len;
+  char      data[OFFLINE_QUEUE_ENTRY_LEN];
+} BlynkQueuedWrite;
+
+// Called for each drained entry instead of sending it as is, e.g. to forward the timestamp
+typedef void (*BlynkOfflineQueueHandler)(const BlynkQueuedWrite& entry);
+
+template <class TBlynk>
+class BlynkOfflineQueue
+{
+  public:
+    // fileName is only used with USE_SPIFFS, one per queue, e.g. "/offq_wf.dat"
+    BlynkOfflineQueue(TBlynk& blynk, const char* fileName = "/offq.dat")
+      : mBlynk(blynk)
+      , mFileName(fileName)
+      , policy(OFFLINE_QUEUE_DROP_OLDEST)
+      , handler(NULL)
+      , ramHead(0)
+      , ramCount(0)
+      , flashHead(0)
+      , flashCount(0)
+      , numDropped(0)
+      , lastDrain_ms(0)
+    {}
+
+    // Call once in setup(), after SPIFFS is mounted (Blynk_WF.begin() does it). Entries of a previous boot are discarded.
+    void begin(BlynkOfflineQueuePolicy overflowPolicy = OFFLINE_QUEUE_DROP_OLDEST)
+    {
+      policy = overflowPolicy;
+      clear();
+    }
+
+    void setDrainHandler(BlynkOfflineQueueHandler drainHandler)
+    {
+      handler = drainHandler;
+    }
+
+    // Same as Blynk virtualWrite(), but queued while not connected or while older entries are still waiting
+    template <typename... Args>
+    void virtualWrite(int pin, Args... values)
+    {
+      if ( mBlynk.connected() && (getSize() == 0) )
+      {
+        mBlynk.virtualWrite(pin, values...);
+        return;
+      }
+
+      BlynkQueuedWrite entry;
+
+      // BlynkParam silently drops values that don't fit its buffer : encode in a larger one, then check
+      char buf[BLYNK_MAX_SENDBYTES];
+
+      BlynkParam cmd(buf, 0, sizeof(buf));
+      cmd.add("vw");
+      cmd.add(pin);
+      cmd.add_multi(values...);
+
+      // Doesn't fit in one entry. Can't be queued.
+      if (cmd.getLength() > sizeof(entry.data))
+      {
+        numDropped++;
+        return;
+      }
+
+      entry.at_ms = millis();
+      entry.len   = cmd.getLength() - 1;
+      memcpy(entry.data, buf, entry.len);
+
+      push(entry);
+    }
+
+    // Call in loop(), after run() of the Blynk instance
+    void run()
+    {
+      if ( (getSize() == 0) || !mBlynk.connected() )
+        return;
+
+      if (millis() - lastDrain_ms < OFFLINE_QUEUE_DRAIN_INTERVAL_MS)
+        return;
+
+      lastDrain_ms = millis();
+
+      BlynkQueuedWrite entry;
+
+      for (uint8_t i = 0; (i < OFFLINE_QUEUE_DRAIN_BATCH) && pop(entry); i++)
+      {
+        if (handler)
+          handler(entry);
+        else
+          mBlynk.sendCmd(BLYNK_CMD_HARDWARE, 0, entry.data, entry.len);
+      }
+    }
+
+    uint16_t getSize()
+    {
+      return ramCount + flashCount;
+    }
+
+    uint16_t getCapacity()
+    {
+      return OFFLINE_QUEUE_SIZE + getFlashCapacity();
+    }
+
+    uint32_t getDropped()
+    {
+      return numDropped;
+    }
+
+    void clear()
+    {
+      ramHead     = ramCount    = 0;
+      flashHead   = flashCount  = 0;
+
+#if OFFLINE_QUEUE_USE_SPIFFS
+      if (SPIFFS.exists(mFileName))
+        SPIFFS.remove(mFileName);
+#endif
+    }
+
+  private:
+    TBlynk&     mBlynk;
+    const char* mFileName;
+
+    BlynkOfflineQueuePolicy   policy;
+    BlynkOfflineQueueHandler  handler;
+
+    // Newest entries. Older ones are in flash, so the FIFO is flash ring then RAM ring.
+    BlynkQueuedWrite ram[OFFLINE_QUEUE_SIZE];
+    uint16_t    ramHead;
+    uint16_t    ramCount;
+
+    uint16_t    flashHead;
+    uint16_t    flashCount;
+
+    uint32_t    numDropped;
+    uint32_t    lastDrain_ms;
+
+    uint16_t getFlashCapacity()
+    {
+#if OFFLINE_QUEUE_USE_SPIFFS
+      return OFFLINE_QUEUE_FLASH_SIZE;
+#else
+      return 0;
+#endif
+    }
+
+    void push(const BlynkQueuedWrite& entry)
+    {
+      if (getSize() == getCapacity())
+      {
+        if (policy == OFFLINE_QUEUE_DOWNSAMPLE)
+        {
+          thinRam();
+        }
+        else
+        {
+          BlynkQueuedWrite oldest;
+
+          pop(oldest);
+          numDropped++;
+        }
+      }
+
+      if (ramCount == OFFLINE_QUEUE_SIZE)
+      {
+        // Move oldest RAM entry to flash. No flash : drop it.
+        if (!flashPush(ram[ramHead]))
+          numDropped++;
+
+        ramHead = (ramHead + 1) % OFFLINE_QUEUE_SIZE;
+        ramCount--;
+      }
+
+      ram[(ramHead + ramCount) % OFFLINE_QUEUE_SIZE] = entry;
+      ramCount++;
+    }
+
+    // Keep the oldest of each pair, in place
+    void thinRam()
+    {
+      uint16_t kept = 0;
+
+      for (uint16_t i = 0; i < ramCount; i += 2)
+      {
+        ram[(ramHead + kept) % OFFLINE_QUEUE_SIZE] = ram[(ramHead + i) % OFFLINE_QUEUE_SIZE];
+        kept++;
+      }
+
+      numDropped += ramCount - kept;
+      ramCount    = kept;
+    }
+
+    bool pop(BlynkQueuedWrite& entry)
+    {
+      if (flashCount)
+        return flashPop(entry);
+
+      if (ramCount == 0)
+        return false;
+
+      entry   = ram[ramHead];
+      ramHead = (ramHead + 1) % OFFLINE_QUEUE_SIZE;
+      ramCount--;
+
+      return true;
+    }
+
+#if OFFLINE_QUEUE_USE_SPIFFS
+    // Fixed-size slots in a ring file. Slots are written in order from an empty file, so never past its end.
+    bool flashPush(const BlynkQueuedWrite& entry)
+    {
+      if (flashCount == OFFLINE_QUEUE_FLASH_SIZE)
+        return false;
+
+      File file = SPIFFS.open(mFileName, SPIFFS.exists(mFileName) ? "r+" : "w");
+
+      if (!file)
+        return false;
+
+      uint16_t slot = (flashHead + flashCount) % OFFLINE_QUEUE_FLASH_SIZE;
+
+      file.seek(slot * sizeof(BlynkQueuedWrite), SeekSet);
+      bool ok = (file.write((const uint8_t*) &entry, sizeof(entry)) == sizeof(entry));
+      file.close();
+
+      if (ok)
+        flashCount++;
+
+      return ok;
+    }
+
+    bool flashPop(BlynkQueuedWrite& entry)
+    {
+      File file = SPIFFS.open(mFileName, "r");
+
+      bool ok = file && file.seek(flashHead * sizeof(BlynkQueuedWrite), SeekSet) &&
+                (file.read((uint8_t*) &entry, sizeof(entry)) == sizeof(entry));
+
+      if (file)
+        file.close();
+
+      // Skip the slot even if unreadable, so a bad sector can't block the queue
+      flashHead = (flashHead + 1) % OFFLINE_QUEUE_FLASH_SIZE;
+
+      if (--flashCount == 0)
+      {
+        flashHead = 0;
+        SPIFFS.remove(mFileName);
+      }
+
+      if (!ok)
+      {
+        numDropped++;
+
+        // Fall through to the next one
+        return pop(entry);
+      }
+
+      return true;
+    }
+#else
+    bool flashPush(const BlynkQueuedWrite& entry)
+    {
+      return false;
+    }
+
+    bool flashPop(BlynkQueuedWrite& entry)
+    {
+      return false;
+    }
+#endif
+};
+
+#endif    // BlynkEsp32_OfflineQueue_h
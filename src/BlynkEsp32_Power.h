@@ -0,0 +1,342 @@
+/****************************************************************************************************************************
+   BlynkEsp32_Power.h
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   Low-power operation for battery powered boards.
+   WiFi modem-sleep (or automatic light-sleep when the core is built with power management) between publishes.
+   Publishers registered here run back to back once per interval, so the radio wakes once instead of once per timer.
+   BLE advertising and connection intervals are stretched while the BLE link is idle.
+   The radio duty cycle and the extra latency are estimated from the sleep mode and the measured publish time.
+   Include after the Blynk transport headers.
+ *****************************************************************************************************************************/
+
+#ifndef BlynkEsp32_Power_h
+#define BlynkEsp32_Power_h
+
+#include <Arduino.h>
+#include "sdkconfig.h"
+#include "esp_wifi.h"
+
+#if defined(CONFIG_PM_ENABLE)
+#include "esp_pm.h"
+#endif
+
+// Max number of publishers in one batch
+#ifndef POWER_MAX_PUBLISHERS
+#define POWER_MAX_PUBLISHERS        8
+#endif
+
+// 802.11 beacon interval of most APs : 100 TU
+#ifndef POWER_BEACON_INTERVAL_US
+#define POWER_BEACON_INTERVAL_US    102400UL
+#endif
+
+// Radio on-time to receive one beacon
+#ifndef POWER_BEACON_AWAKE_US
+#define POWER_BEACON_AWAKE_US       3000UL
+#endif
+
+// Beacons skipped by WIFI_PS_MAX_MODEM (listen interval)
+#ifndef POWER_LISTEN_INTERVAL
+#define POWER_LISTEN_INTERVAL       3
+#endif
+
+// BLE link without traffic for this long is idle
+#ifndef POWER_BLE_IDLE_MS
+#define POWER_BLE_IDLE_MS           10000L
+#endif
+
+// BLE intervals while idle / active, in ms
+#ifndef POWER_BLE_IDLE_ADV_MIN_MS
+#define POWER_BLE_IDLE_ADV_MIN_MS   1000
+#define POWER_BLE_IDLE_ADV_MAX_MS   1500
+#endif
+
+#ifndef POWER_BLE_ACTIVE_ADV_MIN_MS
+#define POWER_BLE_ACTIVE_ADV_MIN_MS 20
+#define POWER_BLE_ACTIVE_ADV_MAX_MS 40
+#endif
+
+#ifndef POWER_BLE_IDLE_CONN_MIN_MS
+#define POWER_BLE_IDLE_CONN_MIN_MS  100
+#define POWER_BLE_IDLE_CONN_MAX_MS  200
+#define POWER_BLE_IDLE_LATENCY      4
+#endif
+
+#ifndef POWER_BLE_ACTIVE_CONN_MIN_MS
+#define POWER_BLE_ACTIVE_CONN_MIN_MS  15
+#define POWER_BLE_ACTIVE_CONN_MAX_MS  30
+#endif
+
+#define POWER_BLE_CONN_TIMEOUT_MS   6000
+
+typedef enum
+{
+  POWER_MODE_NORMAL,          // WiFi always awake
+  POWER_MODE_MODEM_SLEEP,     // Radio wakes every beacon
+  POWER_MODE_MODEM_SLEEP_MAX, // Radio wakes every POWER_LISTEN_INTERVAL beacons
+  POWER_MODE_LIGHT_SLEEP      // CPU also sleeps when idle. Needs CONFIG_PM_ENABLE, else same as POWER_MODE_MODEM_SLEEP_MAX
+} BlynkPowerMode;
+
+typedef void (*BlynkPublisher)(void);
+
+class BlynkPowerManager
+{
+  public:
+    BlynkPowerManager()
+      : mode(POWER_MODE_NORMAL)
+      , interval_ms(10000L)
+      , numPublishers(0)
+      , lastPublish_ms(0)
+      , start_ms(0)
+      , busy_us(0)
+      , lastBatch_us(0)
+      , maxLate_ms(0)
+      , bleIdle(false)
+      , bleConn(false)
+      , bleBytes(0)
+      , bleActive_ms(0)
+    {}
+
+    void setMode(BlynkPowerMode newMode)
+    {
+      mode = newMode;
+
+      wifi_ps_type_t ps = WIFI_PS_NONE;
+
+      if (mode == POWER_MODE_MODEM_SLEEP)
+      {
+        ps = WIFI_PS_MIN_MODEM;
+      }
+      else if (mode != POWER_MODE_NORMAL)
+      {
+        wifi_config_t conf;
+
+        // Listen interval is only read at association time
+        if (esp_wifi_get_config(WIFI_IF_STA, &conf) == ESP_OK)
+        {
+          conf.sta.listen_interval = POWER_LISTEN_INTERVAL;
+          esp_wifi_set_config(WIFI_IF_STA, &conf);
+        }
+
+        ps = WIFI_PS_MAX_MODEM;
+      }
+
+      esp_wifi_set_ps(ps);
+
+      if (mode == POWER_MODE_LIGHT_SLEEP)
+      {
+#if defined(CONFIG_PM_ENABLE)
+        esp_pm_config_esp32_t pm;
+
+        pm.max_freq_mhz       = getCpuFrequencyMhz();
+        pm.min_freq_mhz       = 40;
+        pm.light_sleep_enable = true;
+
+        if (esp_pm_configure(&pm) != ESP_OK)
+        {
+          BLYNK_LOG1(BLYNK_F("Pwr:LightSleepFailed"));
+          mode = POWER_MODE_MODEM_SLEEP_MAX;
+        }
+#else
+        BLYNK_LOG1(BLYNK_F("Pwr:NoPM.UseModemSleepMax"));
+        mode = POWER_MODE_MODEM_SLEEP_MAX;
+#endif
+      }
+
+      start_ms  = millis();
+      busy_us   = 0;
+
+      BLYNK_LOG2(BLYNK_F("Pwr:Mode="), mode);
+    }
+
+    BlynkPowerMode getMode()
+    {
+      return mode;
+    }
+
+    // All publishers run together every interval_ms, instead of one BlynkTimer each
+    void setPublishInterval(uint32_t ms)
+    {
+      interval_ms = ms;
+    }
+
+    bool addPublisher(BlynkPublisher publisher)
+    {
+      if (numPublishers >= POWER_MAX_PUBLISHERS)
+        return false;
+
+      publishers[numPublishers++] = publisher;
+
+      return true;
+    }
+
+    // Call in loop(), after run() of the Blynk instances
+    void run()
+    {
+      if (!start_ms)
+        start_ms = millis();
+
+#if defined(BlynkSimpleEsp32_BLE_WF_h)
+      if (mode != POWER_MODE_NORMAL)
+        checkBLEIdle();
+#endif
+
+      if (lastPublish_ms && (millis() - lastPublish_ms < interval_ms))
+        return;
+
+      // How late the batch runs compared to schedule, e.g. because of a blocking reconnect
+      if (lastPublish_ms)
+      {
+        uint32_t late = millis() - lastPublish_ms - interval_ms;
+
+        if (late > maxLate_ms)
+          maxLate_ms = late;
+
+        lastPublish_ms += interval_ms;
+
+        // Too far behind : don't run a burst of batches to catch up
+        if (millis() - lastPublish_ms >= interval_ms)
+          lastPublish_ms = millis();
+      }
+      else
+      {
+        lastPublish_ms = millis();
+      }
+
+      uint32_t t0 = micros();
+
+      for (uint8_t i = 0; i < numPublishers; i++)
+      {
+        publishers[i]();
+      }
+
+      lastBatch_us  = micros() - t0;
+      busy_us      += lastBatch_us;
+    }
+
+    // Estimated radio on-time, in 1/1000. Publish time is measured, beacon listening is computed from the mode.
+    uint16_t getDutyCycle()
+    {
+      uint64_t elapsed_us = (uint64_t) (millis() - start_ms) * 1000ULL;
+
+      if ( (mode == POWER_MODE_NORMAL) || (elapsed_us == 0) )
+        return 1000;
+
+      uint32_t period_us = POWER_BEACON_INTERVAL_US * getListenInterval();
+      uint64_t listen_us = elapsed_us / period_us * POWER_BEACON_AWAKE_US;
+      uint64_t on_us     = listen_us + busy_us;
+
+      return (on_us >= elapsed_us) ? 1000 : (uint16_t) (on_us * 1000 / elapsed_us);
+    }
+
+    // Worst-case delay added to data coming from the app : the radio listens only once per period
+    uint32_t getExtraLatency()
+    {
+      if (mode == POWER_MODE_NORMAL)
+        return 0;
+
+      return POWER_BEACON_INTERVAL_US * getListenInterval() / 1000;
+    }
+
+    // Worst-case delay of a reading waiting for the next batch
+    uint32_t getBatchLatency()
+    {
+      return interval_ms + maxLate_ms;
+    }
+
+    uint32_t getLastBatchTime()
+    {
+      return lastBatch_us;
+    }
+
+    void print(Print& out)
+    {
+      out.print(F("PwrMode="));
+      out.print(mode);
+      out.print(F(",Duty="));
+      out.print(getDutyCycle());
+      out.print(F("/1000,ExtraLatMs="));
+      out.print(getExtraLatency());
+      out.print(F(",BatchLatMs="));
+      out.print(getBatchLatency());
+      out.print(F(",BatchUs="));
+      out.println(lastBatch_us);
+    }
+
+  private:
+    BlynkPowerMode  mode;
+    uint32_t        interval_ms;
+
+    BlynkPublisher  publishers[POWER_MAX_PUBLISHERS];
+    uint8_t         numPublishers;
+
+    uint32_t        lastPublish_ms;
+    uint32_t        start_ms;
+    uint64_t        busy_us;
+    uint32_t        lastBatch_us;
+    uint32_t        maxLate_ms;
+
+    bool            bleIdle;
+    bool            bleConn;
+    uint32_t        bleBytes;
+    uint32_t        bleActive_ms;
+
+#if defined(BlynkSimpleEsp32_BLE_WF_h)
+    // Stretch advertising, or ask the phone for a longer connection interval, when nothing moved for a while
+    void checkBLEIdle()
+    {
+      const BlynkTrafficCounter& traffic = Blynk_BLE.getTraffic();
+
+      uint32_t bytes  = traffic.bytesIn + traffic.bytesOut;
+      bool     conn   = Blynk_BLE.connected();
+
+      if ( (bytes != bleBytes) || (conn != bleConn) )
+      {
+        bleBytes      = bytes;
+        bleActive_ms  = millis();
+
+        // New connection starts with the phone's own parameters
+        if (conn != bleConn)
+        {
+          bleConn = conn;
+          bleIdle = false;
+
+          if (!conn)
+            Blynk_BLE.setAdvertisingInterval(POWER_BLE_ACTIVE_ADV_MIN_MS, POWER_BLE_ACTIVE_ADV_MAX_MS);
+        }
+        else if (bleIdle)
+        {
+          bleIdle = false;
+          Blynk_BLE.setConnectionInterval(POWER_BLE_ACTIVE_CONN_MIN_MS, POWER_BLE_ACTIVE_CONN_MAX_MS, 0, POWER_BLE_CONN_TIMEOUT_MS);
+        }
+
+        return;
+      }
+
+      if ( bleIdle || (millis() - bleActive_ms < POWER_BLE_IDLE_MS) )
+        return;
+
+      bleIdle = true;
+
+      if (conn)
+        Blynk_BLE.setConnectionInterval(POWER_BLE_IDLE_CONN_MIN_MS, POWER_BLE_IDLE_CONN_MAX_MS, POWER_BLE_IDLE_LATENCY,
+                                        POWER_BLE_CONN_TIMEOUT_MS);
+      else
+        Blynk_BLE.setAdvertisingInterval(POWER_BLE_IDLE_ADV_MIN_MS, POWER_BLE_IDLE_ADV_MAX_MS);
+    }
+#endif
+
+    uint8_t getListenInterval()
+    {
+      return (mode == POWER_MODE_MODEM_SLEEP) ? 1 : POWER_LISTEN_INTERVAL;
+    }
+};
+
+#endif    // BlynkEsp32_Power_h
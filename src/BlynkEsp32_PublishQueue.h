@@ -0,0 +1,345 @@
+/****************************************************************************************************************************
+   BlynkEsp32_PublishQueue.h
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   Lock-free multi-producer, single-consumer queue of virtualWrite() in front of one Blynk instance.
+   Any task, Ticker callback or ISR may publish : writes are encoded by the producer into a ring slot claimed with
+   compare-and-swap, so producers never block nor take a lock. The task owning the Blynk instance drains the ring
+   in batches with run(). Enqueue-to-send latency and queue depth are measured.
+   Include after the Blynk headers.
+ *****************************************************************************************************************************/
+
+#ifndef BlynkEsp32_PublishQueue_h
+#define BlynkEsp32_PublishQueue_h
+
+#include <Arduino.h>
+#include <Blynk/BlynkConfig.h>
+#include <Blynk/BlynkProtocolDefs.h>
+#include <Blynk/BlynkParam.h>
+
+// Slots in the ring. Must be a power of 2.
+#ifndef PUBLISH_QUEUE_SIZE
+#define PUBLISH_QUEUE_SIZE            32
+#endif
+
+// Max size of one encoded write ("vw", pin and values)
+#ifndef PUBLISH_QUEUE_ENTRY_LEN
+#define PUBLISH_QUEUE_ENTRY_LEN       32
+#endif
+
+// Writes sent by each run()
+#ifndef PUBLISH_QUEUE_DRAIN_BATCH
+#define PUBLISH_QUEUE_DRAIN_BATCH     8
+#endif
+
+#if (PUBLISH_QUEUE_SIZE & (PUBLISH_QUEUE_SIZE - 1))
+#error PUBLISH_QUEUE_SIZE must be a power of 2
+#endif
+
+// "vw", pin and a 32-bit value written by virtualWriteFromISR()
+#if (PUBLISH_QUEUE_ENTRY_LEN < 20)
+#error PUBLISH_QUEUE_ENTRY_LEN must be at least 20
+#endif
+
+// Writes are encoded in a BLYNK_MAX_SENDBYTES buffer first, to find the ones too long for an entry
+#if (PUBLISH_QUEUE_ENTRY_LEN >= BLYNK_MAX_SENDBYTES)
+#error PUBLISH_QUEUE_ENTRY_LEN must be smaller than BLYNK_MAX_SENDBYTES
+#endif
+
+typedef struct
+{
+  uint32_t  at_us;              // micros() when queued
+  uint8_t   len;
+  char      data[PUBLISH_QUEUE_ENTRY_LEN];
+} BlynkPublishEntry;
+
+// Bounded ring with one sequence number per slot. A slot is free for position p when seq == p, and filled when
+// seq == p + 1. Producers claim positions with CAS on the write index. The consumer doesn't need any atomic RMW.
+class BlynkMpscQueue
+{
+  public:
+    BlynkMpscQueue()
+    {
+      clear();
+    }
+
+    // Only while no producer is running
+    void clear()
+    {
+      for (uint32_t i = 0; i < PUBLISH_QUEUE_SIZE; i++)
+        slots[i].seq = i;
+
+      writePos    = 0;
+      readPos     = 0;
+      numDropped  = 0;
+    }
+
+    // Reserves a slot. Returns NULL if full. Fill it, then commit() it.
+    BlynkPublishEntry* IRAM_ATTR claim(uint32_t& pos)
+    {
+      pos = __atomic_load_n(&writePos, __ATOMIC_RELAXED);
+
+      for (;;)
+      {
+        Slot&   slot  = slots[pos & (PUBLISH_QUEUE_SIZE - 1)];
+        int32_t diff  = (int32_t) (__atomic_load_n(&slot.seq, __ATOMIC_ACQUIRE) - pos);
+
+        if (diff == 0)
+        {
+          // On failure pos is reloaded with the current writePos
+          if (__atomic_compare_exchange_n(&writePos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            return &slot.entry;
+        }
+        else if (diff < 0)
+        {
+          // Not yet freed by the consumer
+          __atomic_fetch_add(&numDropped, 1, __ATOMIC_RELAXED);
+          return NULL;
+        }
+        else
+        {
+          // Taken by another producer meanwhile
+          pos = __atomic_load_n(&writePos, __ATOMIC_RELAXED);
+        }
+      }
+    }
+
+    void IRAM_ATTR commit(uint32_t pos)
+    {
+      __atomic_store_n(&slots[pos & (PUBLISH_QUEUE_SIZE - 1)].seq, pos + 1, __ATOMIC_RELEASE);
+    }
+
+    // Consumer only. False if empty, or if the oldest slot is still being filled.
+    bool pop(BlynkPublishEntry& entry)
+    {
+      Slot& slot = slots[readPos & (PUBLISH_QUEUE_SIZE - 1)];
+
+      if (__atomic_load_n(&slot.seq, __ATOMIC_ACQUIRE) != readPos + 1)
+        return false;
+
+      entry = slot.entry;
+
+      __atomic_store_n(&slot.seq, readPos + PUBLISH_QUEUE_SIZE, __ATOMIC_RELEASE);
+      readPos++;
+
+      return true;
+    }
+
+    // Claimed slots not popped yet. Consumer only.
+    uint32_t getDepth()
+    {
+      return __atomic_load_n(&writePos, __ATOMIC_RELAXED) - readPos;
+    }
+
+    uint32_t getDropped()
+    {
+      return __atomic_load_n(&numDropped, __ATOMIC_RELAXED);
+    }
+
+  private:
+    typedef struct
+    {
+      uint32_t          seq;
+      BlynkPublishEntry entry;
+    } Slot;
+
+    Slot      slots[PUBLISH_QUEUE_SIZE];
+    uint32_t  writePos;
+    uint32_t  readPos;
+    uint32_t  numDropped;
+};
+
+template <class TBlynk>
+class BlynkPublishQueue
+{
+  public:
+    BlynkPublishQueue(TBlynk& blynk)
+      : mBlynk(blynk)
+    {
+      resetStats();
+    }
+
+    // Same as Blynk virtualWrite(), from any task. Not from an ISR : BlynkParam may format floats.
+    template <typename... Args>
+    bool virtualWrite(int pin, Args... values)
+    {
+      // BlynkParam silently drops values that don't fit its buffer : encode in a larger one, then check
+      char buf[BLYNK_MAX_SENDBYTES];
+
+      BlynkParam cmd(buf, 0, sizeof(buf));
+      cmd.add("vw");
+      cmd.add(pin);
+      cmd.add_multi(values...);
+
+      // Doesn't fit in one entry
+      if (cmd.getLength() > PUBLISH_QUEUE_ENTRY_LEN)
+      {
+        __atomic_fetch_add(&numTooLong, 1, __ATOMIC_RELAXED);
+        return false;
+      }
+
+      uint32_t            pos;
+      BlynkPublishEntry*  entry = queue.claim(pos);
+
+      if (!entry)
+        return false;
+
+      entry->at_us  = micros();
+      entry->len    = cmd.getLength() - 1;
+      memcpy(entry->data, buf, entry->len);
+
+      queue.commit(pos);
+
+      return true;
+    }
+
+    // Integer value from an ISR. Encoded without BlynkParam, snprintf or floats.
+    bool IRAM_ATTR virtualWriteFromISR(uint8_t pin, int32_t value)
+    {
+      uint32_t            pos;
+      BlynkPublishEntry*  entry = queue.claim(pos);
+
+      if (!entry)
+        return false;
+
+      char* p = entry->data;
+
+      *p++ = 'v';
+      *p++ = 'w';
+      *p++ = '\0';
+      p   += encodeInt(p, pin);
+      *p++ = '\0';
+      p   += encodeInt(p, value);
+
+      entry->at_us  = micros();
+      entry->len    = p - entry->data;
+
+      queue.commit(pos);
+
+      return true;
+    }
+
+    // Call from the task running the Blynk instance, after its run()
+    uint8_t run()
+    {
+      if (!mBlynk.connected())
+        return 0;
+
+      uint32_t depth = queue.getDepth();
+
+      if (depth > maxDepth)
+        maxDepth = depth;
+
+      BlynkPublishEntry entry;
+      uint8_t           sent = 0;
+
+      while ( (sent < PUBLISH_QUEUE_DRAIN_BATCH) && queue.pop(entry) )
+      {
+        mBlynk.sendCmd(BLYNK_CMD_HARDWARE, 0, entry.data, entry.len);
+
+        uint32_t latency = micros() - entry.at_us;
+
+        avgLatency_us = numSent ? (7 * avgLatency_us + latency) / 8 : latency;
+
+        if (latency > maxLatency_us)
+          maxLatency_us = latency;
+
+        numSent++;
+        sent++;
+      }
+
+      return sent;
+    }
+
+    uint32_t getDepth()
+    {
+      return queue.getDepth();
+    }
+
+    uint32_t getMaxDepth()
+    {
+      return maxDepth;
+    }
+
+    // Queue full, or write longer than PUBLISH_QUEUE_ENTRY_LEN
+    uint32_t getDropped()
+    {
+      return queue.getDropped() + numTooLong;
+    }
+
+    uint32_t getAvgLatency()
+    {
+      return avgLatency_us;
+    }
+
+    uint32_t getMaxLatency()
+    {
+      return maxLatency_us;
+    }
+
+    void resetStats()
+    {
+      numSent       = 0;
+      numTooLong    = 0;
+      maxDepth      = 0;
+      avgLatency_us = 0;
+      maxLatency_us = 0;
+    }
+
+    void print(Print& out)
+    {
+      out.print(F("PQ:Sent="));
+      out.print(numSent);
+      out.print(F(",Depth="));
+      out.print(getDepth());
+      out.print(F("/"));
+      out.print(maxDepth);
+      out.print(F(",Dropped="));
+      out.print(getDropped());
+      out.print(F(",latency_us="));
+      out.print(avgLatency_us);
+      out.print(F("/"));
+      out.println(maxLatency_us);
+    }
+
+  private:
+    TBlynk&         mBlynk;
+    BlynkMpscQueue  queue;
+
+    uint32_t  numSent;
+    uint32_t  numTooLong;
+    uint32_t  maxDepth;
+    uint32_t  avgLatency_us;
+    uint32_t  maxLatency_us;
+
+    // Decimal, without terminating 0. Returns the length, at most 11.
+    static uint8_t IRAM_ATTR encodeInt(char* out, int32_t value)
+    {
+      char      digits[10];
+      uint8_t   n   = 0;
+      uint8_t   len = 0;
+      uint32_t  v   = (value < 0) ? - (uint32_t) value : value;
+
+      do
+      {
+        digits[n++] = '0' + (v % 10);
+        v /= 10;
+      } while (v);
+
+      if (value < 0)
+        out[len++] = '-';
+
+      while (n)
+        out[len++] = digits[--n];
+
+      return len;
+    }
+};
+
+#endif    // BlynkEsp32_PublishQueue_h
@@ -0,0 +1,186 @@
+/****************************************************************************************************************************
+   BlynkEsp32_PulseCounter.h
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   Pulse counter on the ESP32 PCNT peripheral, e.g. for a Geiger tube.
+   Rising edges are counted by hardware, with its glitch filter, so there is no interrupt per pulse and no edge is lost
+   while interrupts are masked. Only the 16-bit counter overflow raises an interrupt, every PULSE_COUNTER_LIMIT pulses.
+   Readers take snapshots of the 32-bit total without disabling interrupts, and the hardware counter is never cleared,
+   so no pulse falls between a read and a reset.
+ *****************************************************************************************************************************/
+
+#ifndef BlynkEsp32_PulseCounter_h
+#define BlynkEsp32_PulseCounter_h
+
+#include <Arduino.h>
+#include "driver/pcnt.h"
+
+// Pulses shorter than this are ignored by the PCNT filter. Max 1023 APB cycles, about 12.7 us.
+#ifndef PULSE_COUNTER_FILTER_NS
+#define PULSE_COUNTER_FILTER_NS     1000
+#endif
+
+// Hardware counter wraps to 0 here
+#define PULSE_COUNTER_LIMIT         32767
+
+#define PULSE_COUNTER_APB_MHZ       80
+#define PULSE_COUNTER_FILTER_MAX    1023
+
+typedef struct
+{
+  uint32_t  total;        // Pulses since begin()
+  uint32_t  at_us;        // micros() of the snapshot
+} BlynkPulseSnapshot;
+
+class BlynkPulseCounter
+{
+  public:
+    BlynkPulseCounter(uint8_t pin, pcnt_unit_t unit = PCNT_UNIT_0)
+      : pulsePin(pin)
+      , pcntUnit(unit)
+      , overflows(0)
+      , lastTotal(0)
+    {}
+
+    bool begin(uint32_t filter_ns = PULSE_COUNTER_FILTER_NS)
+    {
+      pcnt_config_t config;
+
+      memset(&config, 0, sizeof(config));
+
+      config.pulse_gpio_num = pulsePin;
+      config.ctrl_gpio_num  = PCNT_PIN_NOT_USED;
+      config.channel        = PCNT_CHANNEL_0;
+      config.unit           = pcntUnit;
+      config.pos_mode       = PCNT_COUNT_INC;
+      config.neg_mode       = PCNT_COUNT_DIS;
+      config.lctrl_mode     = PCNT_MODE_KEEP;
+      config.hctrl_mode     = PCNT_MODE_KEEP;
+      config.counter_h_lim  = PULSE_COUNTER_LIMIT;
+      config.counter_l_lim  = 0;
+
+      if (pcnt_unit_config(&config) != ESP_OK)
+      {
+        BLYNK_LOG2(BLYNK_F("PC:ConfigFail,unit="), pcntUnit);
+        return false;
+      }
+
+      uint32_t ticks = filter_ns * PULSE_COUNTER_APB_MHZ / 1000;
+
+      if (ticks > PULSE_COUNTER_FILTER_MAX)
+        ticks = PULSE_COUNTER_FILTER_MAX;
+
+      if (ticks)
+      {
+        pcnt_set_filter_value(pcntUnit, ticks);
+        pcnt_filter_enable(pcntUnit);
+      }
+      else
+      {
+        pcnt_filter_disable(pcntUnit);
+      }
+
+      pcnt_counter_pause(pcntUnit);
+      pcnt_counter_clear(pcntUnit);
+
+      overflows = 0;
+      lastTotal = 0;
+
+      // Shared by all units. Already installed by another instance is fine.
+      esp_err_t err = pcnt_isr_service_install(0);
+
+      if ( (err != ESP_OK) && (err != ESP_ERR_INVALID_STATE) )
+      {
+        BLYNK_LOG1(BLYNK_F("PC:ISRFail"));
+        return false;
+      }
+
+      pcnt_isr_handler_add(pcntUnit, onOverflow, this);
+      pcnt_event_enable(pcntUnit, PCNT_EVT_H_LIM);
+
+      pcnt_counter_resume(pcntUnit);
+
+      BLYNK_LOG4(BLYNK_F("PC:Pin="), pulsePin, BLYNK_F(",filterTicks="), ticks);
+
+      return true;
+    }
+
+    void end()
+    {
+      pcnt_counter_pause(pcntUnit);
+      pcnt_event_disable(pcntUnit, PCNT_EVT_H_LIM);
+      pcnt_isr_handler_remove(pcntUnit);
+    }
+
+    // Pulses since begin(). Call from one task only.
+    uint32_t getTotal()
+    {
+      uint32_t  ovf;
+      int16_t   value;
+
+      // Retry if the overflow ISR ran between the two reads
+      do
+      {
+        ovf = overflows;
+        pcnt_get_counter_value(pcntUnit, &value);
+      } while (ovf != overflows);
+
+      uint32_t total = ovf * PULSE_COUNTER_LIMIT + (uint16_t) value;
+
+      // Counter already wrapped but its ISR not run yet, e.g. pending on this core
+      if (total + (PULSE_COUNTER_LIMIT / 2) < lastTotal)
+        total += PULSE_COUNTER_LIMIT;
+
+      lastTotal = total;
+
+      return total;
+    }
+
+    BlynkPulseSnapshot snapshot()
+    {
+      BlynkPulseSnapshot snap;
+
+      snap.total = getTotal();
+      snap.at_us = micros();
+
+      return snap;
+    }
+
+    // Pulses since the previous snapshot, which is then advanced to now
+    uint32_t getCountSince(BlynkPulseSnapshot& previous)
+    {
+      BlynkPulseSnapshot now = snapshot();
+      uint32_t count = now.total - previous.total;
+
+      previous = now;
+
+      return count;
+    }
+
+    uint32_t getNumOverflows()
+    {
+      return overflows;
+    }
+
+  private:
+    uint8_t           pulsePin;
+    pcnt_unit_t       pcntUnit;
+    volatile uint32_t overflows;
+    uint32_t          lastTotal;
+
+    // Counter reached PULSE_COUNTER_LIMIT and restarted from 0
+    static void IRAM_ATTR onOverflow(void* arg)
+    {
+      BlynkPulseCounter* self = (BlynkPulseCounter*) arg;
+
+      self->overflows = self->overflows + 1;
+    }
+};
+
+#endif    // BlynkEsp32_PulseCounter_h
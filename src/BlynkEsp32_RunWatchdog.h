@@ -0,0 +1,259 @@
+/****************************************************************************************************************************
+   BlynkEsp32_RunWatchdog.h
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   Loop-latency watchdog for Blynk_WF.run(). Each call is timed and split into segments by mark(site).
+   The longest calls are kept together with the site that took most of their time.
+   A user callback fires whenever a call exceeds the configured budget.
+   Define USE_RUN_WATCHDOG true before including <BlynkSimpleEsp32_WFM.h> to enable.
+ *****************************************************************************************************************************/
+
+#ifndef BlynkEsp32_RunWatchdog_h
+#define BlynkEsp32_RunWatchdog_h
+
+#ifndef USE_RUN_WATCHDOG
+#define USE_RUN_WATCHDOG      false
+#endif
+
+#if USE_RUN_WATCHDOG
+
+#include <Arduino.h>
+
+// Number of longest run() calls to keep
+#ifndef RUN_WATCHDOG_RECORDS
+#define RUN_WATCHDOG_RECORDS        8
+#endif
+
+// Default budget for one run() call
+#ifndef RUN_WATCHDOG_BUDGET_MS
+#define RUN_WATCHDOG_BUDGET_MS      50
+#endif
+
+typedef struct
+{
+  uint32_t    run_us;       // Duration of the whole run() call
+  uint32_t    site_us;      // Time spent in the worst site
+  const char* site;         // Site which took most of the call
+  uint32_t    at_ms;        // millis() when the call started
+} BlynkRunStall;
+
+typedef void (*BlynkRunWatchdogCallback)(const BlynkRunStall& stall);
+
+class BlynkRunWatchdog
+{
+  public:
+    BlynkRunWatchdog()
+      : budget_us(RUN_WATCHDOG_BUDGET_MS * 1000UL)
+      , callback(NULL)
+      , numStalls(0)
+      , numOverBudget(0)
+      , numRuns(0)
+      , active(false)
+    {}
+
+    void setBudget(uint32_t budget_ms)
+    {
+      budget_us = budget_ms * 1000UL;
+    }
+
+    void setCallback(BlynkRunWatchdogCallback cb)
+    {
+      callback = cb;
+    }
+
+    void start()
+    {
+      active    = true;
+      start_us  = segment_us = micros();
+      start_ms  = millis();
+      site      = "run";
+      worstSite = site;
+      worst_us  = 0;
+    }
+
+    // Close the current segment and attribute following time to the new site
+    void mark(const char* newSite)
+    {
+      if (!active)
+        return;
+
+      closeSegment();
+      site = newSite;
+    }
+
+    void stop()
+    {
+      if (!active)
+        return;
+
+      closeSegment();
+      active = false;
+
+      BlynkRunStall stall;
+
+      stall.run_us  = micros() - start_us;
+      stall.site_us = worst_us;
+      stall.site    = worstSite;
+      stall.at_ms   = start_ms;
+
+      numRuns++;
+
+      if (stall.run_us > max_us)
+        max_us = stall.run_us;
+
+      insert(stall);
+
+      if (stall.run_us > budget_us)
+      {
+        numOverBudget++;
+
+        if (callback)
+          callback(stall);
+      }
+    }
+
+    uint8_t getNumStalls()
+    {
+      return numStalls;
+    }
+
+    // Sorted, longest first. Returns NULL if index out of range
+    const BlynkRunStall* getStall(uint8_t index)
+    {
+      if (index >= numStalls)
+        return NULL;
+
+      return &stalls[index];
+    }
+
+    uint32_t getMaxRunTime()
+    {
+      return max_us;
+    }
+
+    uint32_t getOverBudgetCount()
+    {
+      return numOverBudget;
+    }
+
+    uint32_t getRunCount()
+    {
+      return numRuns;
+    }
+
+    void clear()
+    {
+      numStalls     = 0;
+      numOverBudget = 0;
+      numRuns       = 0;
+      max_us        = 0;
+    }
+
+    void print(Print& out)
+    {
+      out.print(F("Runs="));
+      out.print(numRuns);
+      out.print(F(",OverBudget="));
+      out.print(numOverBudget);
+      out.print(F(",MaxUs="));
+      out.println(max_us);
+
+      for (uint8_t i = 0; i < numStalls; i++)
+      {
+        out.print(F("#"));
+        out.print(i);
+        out.print(F(" runUs="));
+        out.print(stalls[i].run_us);
+        out.print(F(",site="));
+        out.print(stalls[i].site);
+        out.print(F(",siteUs="));
+        out.print(stalls[i].site_us);
+        out.print(F(",atMs="));
+        out.println(stalls[i].at_ms);
+      }
+    }
+
+    // Times one run() call, whichever way it returns
+    class Scope
+    {
+      public:
+        Scope(BlynkRunWatchdog& wd)
+          : mWd(wd)
+        {
+          mWd.start();
+        }
+
+        ~Scope()
+        {
+          mWd.stop();
+        }
+
+      private:
+        BlynkRunWatchdog& mWd;
+    };
+
+  private:
+    uint32_t    budget_us;
+    BlynkRunWatchdogCallback callback;
+
+    BlynkRunStall stalls[RUN_WATCHDOG_RECORDS];
+    uint8_t     numStalls;
+    uint32_t    numOverBudget;
+    uint32_t    numRuns;
+    uint32_t    max_us = 0;
+
+    bool        active;
+    uint32_t    start_us;
+    uint32_t    start_ms;
+    uint32_t    segment_us;
+    const char* site;
+    const char* worstSite;
+    uint32_t    worst_us;
+
+    void closeSegment()
+    {
+      uint32_t now  = micros();
+      uint32_t took = now - segment_us;
+
+      if (took > worst_us)
+      {
+        worst_us  = took;
+        worstSite = site;
+      }
+
+      segment_us = now;
+    }
+
+    // Insertion into the small sorted table, dropping the shortest one
+    void insert(const BlynkRunStall& stall)
+    {
+      if ( (numStalls == RUN_WATCHDOG_RECORDS) && (stall.run_us <= stalls[numStalls - 1].run_us) )
+        return;
+
+      uint8_t i = (numStalls < RUN_WATCHDOG_RECORDS) ? numStalls++ : RUN_WATCHDOG_RECORDS - 1;
+
+      while ( (i > 0) && (stalls[i - 1].run_us < stall.run_us) )
+      {
+        stalls[i] = stalls[i - 1];
+        i--;
+      }
+
+      stalls[i] = stall;
+    }
+};
+
+#define RUN_WATCHDOG_MARK(site)       runWatchdog.mark(site)
+
+#else
+
+#define RUN_WATCHDOG_MARK(site)       do {} while (0)
+
+#endif    // USE_RUN_WATCHDOG
+
+#endif    // BlynkEsp32_RunWatchdog_h
@@ -0,0 +1,252 @@
+/****************************************************************************************************************************
+   BlynkEsp32_ScanCache.h
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   Networks around the board, for the SSID inputs of the Config Portal. The scan is asynchronous : start() returns at
+   once, run() collects the results when the WiFi driver is done. They are kept in a fixed-size cache, one entry per
+   SSID with its strongest signal, strongest first. Hidden networks are skipped. The results of the WiFi library are
+   read in place, without String, and freed once copied. A scan can't be aborted : end() during a scan only marks its
+   results to be freed by run() or start() once the driver is done.
+ *****************************************************************************************************************************/
+
+#ifndef BlynkEsp32_ScanCache_h
+#define BlynkEsp32_ScanCache_h
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+// Networks kept. The weakest ones are dropped.
+#ifndef BLYNK_WM_SCAN_CACHE_SIZE
+#define BLYNK_WM_SCAN_CACHE_SIZE      12
+#endif
+
+// A request later than this after the last scan starts a new one. Older results are served meanwhile.
+#ifndef BLYNK_WM_SCAN_REFRESH_MS
+#define BLYNK_WM_SCAN_REFRESH_MS      30000L
+#endif
+
+#define BLYNK_SCAN_SSID_MAX_LEN       32
+
+// ["ssid",rssi,secure] with every SSID char escaped as \u00XX
+#define BLYNK_SCAN_JSON_ENTRY_LEN     ( BLYNK_SCAN_SSID_MAX_LEN * 6 + 16 )
+
+typedef struct
+{
+  char    ssid[BLYNK_SCAN_SSID_MAX_LEN + 1];
+  int8_t  rssi;
+  bool    secure;
+} BlynkScanEntry;
+
+class BlynkScanCache
+{
+  public:
+    BlynkScanCache()
+      : numEntries(0)
+      , scanning(false)
+      , deletePending(false)
+      , numScans(0)
+      , lastScan_ms(0)
+    {}
+
+    // Starts an asynchronous scan, unless one is running. False if the driver refused it.
+    bool start()
+    {
+      if (deletePending)
+      {
+        deletePending = false;
+
+        // The scan given up by end() is still running : use it
+        if (WiFi.scanComplete() == WIFI_SCAN_RUNNING)
+          scanning = true;
+        else
+          WiFi.scanDelete();
+      }
+
+      if (!scanning)
+        scanning = (WiFi.scanNetworks(true, false) == WIFI_SCAN_RUNNING);
+
+      return scanning;
+    }
+
+    // Call often while the portal runs, and after end() until isIdle(). Replaces the cache when the scan is done.
+    void run()
+    {
+      if (deletePending)
+      {
+        if (WiFi.scanComplete() != WIFI_SCAN_RUNNING)
+        {
+          deletePending = false;
+          WiFi.scanDelete();
+        }
+
+        return;
+      }
+
+      if (!scanning)
+        return;
+
+      int16_t found = WiFi.scanComplete();
+
+      if (found == WIFI_SCAN_RUNNING)
+        return;
+
+      scanning    = false;
+      lastScan_ms = millis();
+      numScans++;
+
+      // WIFI_SCAN_FAILED : keep the previous results
+      if (found < 0)
+        return;
+
+      numEntries = 0;
+
+      for (int16_t i = 0; i < found; i++)
+      {
+        const wifi_ap_record_t* ap = (const wifi_ap_record_t*) WiFi.getScanInfoByIndex(i);
+
+        if (ap)
+          add((const char*) ap->ssid, ap->rssi, ap->authmode != WIFI_AUTH_OPEN);
+      }
+
+      WiFi.scanDelete();
+    }
+
+    // Drops the results of the WiFi library, at once or when the running scan is done. The cache is kept.
+    void end()
+    {
+      if (!scanning)
+        return;
+
+      scanning = false;
+
+      // Freeing the results while the driver still fills them would race with its scan-done event
+      if (WiFi.scanComplete() == WIFI_SCAN_RUNNING)
+        deletePending = true;
+      else
+        WiFi.scanDelete();
+    }
+
+    bool isScanning()
+    {
+      return scanning;
+    }
+
+    // No scan running, no results left to free
+    bool isIdle()
+    {
+      return !scanning && !deletePending;
+    }
+
+    // Never scanned, or last scan older than BLYNK_WM_SCAN_REFRESH_MS
+    bool isStale()
+    {
+      return !numScans || (millis() - lastScan_ms > BLYNK_WM_SCAN_REFRESH_MS);
+    }
+
+    uint8_t size()
+    {
+      return numEntries;
+    }
+
+    const BlynkScanEntry& get(uint8_t index)
+    {
+      return entries[index];
+    }
+
+    // JSON array ["ssid",rssi,secure] of entry index, in buf of BLYNK_SCAN_JSON_ENTRY_LEN
+    void formatEntry(uint8_t index, char* buf)
+    {
+      const BlynkScanEntry& entry = entries[index];
+
+      char* out = buf;
+
+      *out++ = '[';
+      *out++ = '"';
+
+      for (const char* c = entry.ssid; *c; c++)
+      {
+        uint8_t ch = *c;
+
+        if ( (ch == '"') || (ch == '\\') )
+        {
+          *out++ = '\\';
+          *out++ = ch;
+        }
+        else if (ch < 0x20)
+        {
+          out += sprintf(out, "\\u%04x", ch);
+        }
+        else
+        {
+          *out++ = ch;
+        }
+      }
+
+      sprintf(out, "\",%d,%d]", entry.rssi, entry.secure ? 1 : 0);
+    }
+
+  private:
+    BlynkScanEntry  entries[BLYNK_WM_SCAN_CACHE_SIZE];
+    uint8_t         numEntries;
+
+    bool      scanning;
+    bool      deletePending;
+    uint32_t  numScans;
+    uint32_t  lastScan_ms;
+
+    // Keeps entries sorted by RSSI, strongest first, one per SSID
+    void add(const char* ssid, int8_t rssi, bool secure)
+    {
+      if (!ssid[0])
+        return;
+
+      uint8_t i;
+
+      for (i = 0; i < numEntries; i++)
+      {
+        if (!strncmp(entries[i].ssid, ssid, BLYNK_SCAN_SSID_MAX_LEN))
+          break;
+      }
+
+      if (i < numEntries)
+      {
+        // Same SSID from another AP : keep the strongest
+        if (rssi <= entries[i].rssi)
+          return;
+      }
+      else if (numEntries < BLYNK_WM_SCAN_CACHE_SIZE)
+      {
+        i = numEntries++;
+      }
+      else
+      {
+        // Full : replace the weakest, if weaker
+        i = numEntries - 1;
+
+        if (rssi <= entries[i].rssi)
+          return;
+      }
+
+      strncpy(entries[i].ssid, ssid, BLYNK_SCAN_SSID_MAX_LEN);
+      entries[i].ssid[BLYNK_SCAN_SSID_MAX_LEN] = 0;
+      entries[i].rssi   = rssi;
+      entries[i].secure = secure;
+
+      // Only got stronger : move it up
+      while ( (i > 0) && (entries[i - 1].rssi < entries[i].rssi) )
+      {
+        BlynkScanEntry tmp  = entries[i - 1];
+        entries[i - 1]      = entries[i];
+        entries[i]          = tmp;
+        i--;
+      }
+    }
+};
+
+#endif    // BlynkEsp32_ScanCache_h
@@ -0,0 +1,269 @@
+/****************************************************************************************************************************
+   BlynkEsp32_ServerHealth.h
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   Health-scored selection between Blynk_Creds servers.
+   Each server keeps a smoothed connect latency and a recent failure count. connectMultiBlynk() tries the last good
+   server first, then the others by score, and uses a timeout adapted to each server's measured latency.
+ *****************************************************************************************************************************/
+
+#ifndef BlynkEsp32_ServerHealth_h
+#define BlynkEsp32_ServerHealth_h
+
+#include <Arduino.h>
+
+// Upper bound of one connect attempt. Also the timeout used for a server never measured.
+#ifndef BLYNK_CONNECT_TIMEOUT_MS
+#define BLYNK_CONNECT_TIMEOUT_MS          5000L
+#endif
+
+// Lower bound of the adaptive timeout
+#ifndef BLYNK_CONNECT_MIN_TIMEOUT_MS
+#define BLYNK_CONNECT_MIN_TIMEOUT_MS      1500L
+#endif
+
+// Failures older than this are forgotten
+#ifndef BLYNK_SERVER_FAIL_FORGET_MS
+#define BLYNK_SERVER_FAIL_FORGET_MS       600000L
+#endif
+
+// While on a backup server, probe the preferred one (index 0) this often. 0 => never
+#ifndef BLYNK_SERVER_REPROBE_MS
+#define BLYNK_SERVER_REPROBE_MS           600000L
+#endif
+
+#define BLYNK_SERVER_NONE                 -1
+
+typedef struct
+{
+  uint32_t  avgConnect_ms;      // Smoothed connect latency, 0 if never connected
+  uint8_t   failures;           // Consecutive recent failures
+  uint32_t  lastFail_ms;
+  uint32_t  lastOK_ms;
+  uint16_t  numConnects;
+  uint16_t  numFailures;
+} BlynkServerHealth;
+
+template <uint8_t N>
+class BlynkServerSelector
+{
+  public:
+    BlynkServerSelector()
+      : current(BLYNK_SERVER_NONE)
+      , lastGood(BLYNK_SERVER_NONE)
+      , lastProbe_ms(0)
+    {
+      memset(health, 0, sizeof(health));
+      memset(usable, 0, sizeof(usable));
+    }
+
+    // Only usable (configured) servers take part in the selection
+    void setUsable(uint8_t index, bool isUsable)
+    {
+      if (index < N)
+        usable[index] = isUsable;
+    }
+
+    uint8_t getNumUsable()
+    {
+      uint8_t n = 0;
+
+      for (uint8_t i = 0; i < N; i++)
+      {
+        if (usable[i])
+          n++;
+      }
+
+      return n;
+    }
+
+    // Fill order[] with server indexes to try, best first. Returns number of entries.
+    uint8_t getOrder(uint8_t order[N])
+    {
+      uint8_t n     = 0;
+      uint8_t first = 0;
+
+      // Sticky : last good server first, unless it has just failed
+      bool sticky = (lastGood != BLYNK_SERVER_NONE) && usable[lastGood] && (getFailures(lastGood) == 0);
+
+      if (sticky)
+      {
+        order[n++] = lastGood;
+        first = 1;
+      }
+
+      for (uint8_t i = 0; i < N; i++)
+      {
+        if ( !usable[i] || (sticky && (i == (uint8_t) lastGood)) )
+          continue;
+
+        // Stable insertion by score, so a lower index wins a tie and keeps the configured preference
+        uint8_t j = n;
+
+        while ( (j > first) && (getScore(order[j - 1]) > getScore(i)) )
+        {
+          order[j] = order[j - 1];
+          j--;
+        }
+
+        order[j] = i;
+        n++;
+      }
+
+      return n;
+    }
+
+    // Adapted to measured latency, so a dead server costs less than the full timeout once a good one is known
+    uint32_t getTimeout(uint8_t index)
+    {
+      uint32_t avg = health[index].avgConnect_ms;
+
+      if (avg == 0)
+        return BLYNK_CONNECT_TIMEOUT_MS;
+
+      uint32_t timeout = avg * 4;
+
+      if (timeout < BLYNK_CONNECT_MIN_TIMEOUT_MS)
+        timeout = BLYNK_CONNECT_MIN_TIMEOUT_MS;
+      else if (timeout > BLYNK_CONNECT_TIMEOUT_MS)
+        timeout = BLYNK_CONNECT_TIMEOUT_MS;
+
+      return timeout;
+    }
+
+    void success(uint8_t index, uint32_t connect_ms)
+    {
+      BlynkServerHealth& h = health[index];
+
+      // EWMA with alpha = 1/4
+      if (h.avgConnect_ms == 0)
+        h.avgConnect_ms = connect_ms;
+      else
+        h.avgConnect_ms = (3 * h.avgConnect_ms + connect_ms) / 4;
+
+      if (h.avgConnect_ms == 0)
+        h.avgConnect_ms = 1;
+
+      h.failures  = 0;
+      h.lastOK_ms = millis();
+      h.numConnects++;
+
+      current   = index;
+      lastGood  = index;
+
+      lastProbe_ms = millis();
+    }
+
+    void failure(uint8_t index)
+    {
+      BlynkServerHealth& h = health[index];
+
+      if (h.failures < 255)
+        h.failures++;
+
+      h.lastFail_ms = millis();
+      h.numFailures++;
+
+      if (current == index)
+        current = BLYNK_SERVER_NONE;
+    }
+
+    void disconnected()
+    {
+      current = BLYNK_SERVER_NONE;
+    }
+
+    // Preferred server is the first usable one in configured order
+    int8_t getPreferred()
+    {
+      for (uint8_t i = 0; i < N; i++)
+      {
+        if (usable[i])
+          return i;
+      }
+
+      return BLYNK_SERVER_NONE;
+    }
+
+    // true when connected to a backup and it's time to check if the preferred one is back
+    bool shouldReprobe()
+    {
+      if ( (BLYNK_SERVER_REPROBE_MS == 0) || (current == BLYNK_SERVER_NONE) || (current == getPreferred()) )
+        return false;
+
+      if (millis() - lastProbe_ms < BLYNK_SERVER_REPROBE_MS)
+        return false;
+
+      lastProbe_ms = millis();
+
+      return true;
+    }
+
+    int8_t getCurrent()
+    {
+      return current;
+    }
+
+    const BlynkServerHealth& getHealth(uint8_t index)
+    {
+      return health[index];
+    }
+
+    // Expected cost in ms of trying this server. Lower is better.
+    uint32_t getScore(uint8_t index)
+    {
+      const BlynkServerHealth& h = health[index];
+
+      uint32_t latency = h.avgConnect_ms ? h.avgConnect_ms : (BLYNK_CONNECT_TIMEOUT_MS / 2);
+
+      return latency + getFailures(index) * BLYNK_CONNECT_TIMEOUT_MS;
+    }
+
+    void print(Print& out)
+    {
+      for (uint8_t i = 0; i < N; i++)
+      {
+        if (!usable[i])
+          continue;
+
+        out.print(F("Srv#"));
+        out.print(i);
+        out.print(F(" avgMs="));
+        out.print(health[i].avgConnect_ms);
+        out.print(F(",fail="));
+        out.print(getFailures(i));
+        out.print(F(",score="));
+        out.print(getScore(i));
+        out.print(F(",OK/NG="));
+        out.print(health[i].numConnects);
+        out.print('/');
+        out.println(health[i].numFailures);
+      }
+    }
+
+  private:
+    BlynkServerHealth health[N];
+    bool    usable[N];
+
+    int8_t  current;
+    int8_t  lastGood;
+    uint32_t lastProbe_ms;
+
+    uint8_t getFailures(uint8_t index)
+    {
+      const BlynkServerHealth& h = health[index];
+
+      if ( h.failures && (millis() - h.lastFail_ms > BLYNK_SERVER_FAIL_FORGET_MS) )
+        return 0;
+
+      return h.failures;
+    }
+};
+
+#endif    // BlynkEsp32_ServerHealth_h
@@ -0,0 +1,321 @@
+/****************************************************************************************************************************
+   BlynkEsp32_Tasks.h
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   Optional task model : each Blynk instance runs in its own FreeRTOS task, pinned to a core.
+   A Blynk instance is not thread-safe, so only its task may call it. Other tasks and ISRs publish through the
+   task's lock-free BlynkPublishQueue with BlynkTask::virtualWrite(). BLYNK_WRITE_ON() handlers are queued by the
+   Blynk task and run by the task calling BlynkWriteQueue::run(). BlynkTaskStats measures run time and period
+   jitter of a task, or of loop() to compare with the single-loop model.
+   Include after the Blynk headers, and call begin() of the Blynk instance before BlynkTask::begin().
+ *****************************************************************************************************************************/
+
+#ifndef BlynkEsp32_Tasks_h
+#define BlynkEsp32_Tasks_h
+
+#include <Arduino.h>
+#include <Blynk/BlynkProtocolDefs.h>
+#include <Blynk/BlynkParam.h>
+#include <Blynk/BlynkHandlers.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+#include "BlynkEsp32_PublishQueue.h"
+
+#ifndef BLYNK_TASK_STACK_SIZE
+#define BLYNK_TASK_STACK_SIZE         8192
+#endif
+
+#ifndef BLYNK_TASK_PRIORITY
+#define BLYNK_TASK_PRIORITY           1
+#endif
+
+// Delay between two run(). Lets lower priority tasks, and the idle task feeding the watchdog, run.
+#ifndef BLYNK_TASK_PERIOD_MS
+#define BLYNK_TASK_PERIOD_MS          2
+#endif
+
+// BLYNK_WRITE_ON() calls waiting in a BlynkWriteQueue
+#ifndef BLYNK_TASK_QUEUE_SIZE
+#define BLYNK_TASK_QUEUE_SIZE         16
+#endif
+
+// Max size of the param of a BLYNK_WRITE_ON(), terminator included
+#ifndef BLYNK_TASK_ENTRY_LEN
+#define BLYNK_TASK_ENTRY_LEN          32
+#endif
+
+class BlynkTaskStats
+{
+  public:
+    BlynkTaskStats()
+    {
+      reset();
+    }
+
+    void reset()
+    {
+      numRuns       = 0;
+      avgRun_us     = 0;
+      maxRun_us     = 0;
+      avgPeriod_us  = 0;
+      maxPeriod_us  = 0;
+      start_us      = 0;
+    }
+
+    void begin()
+    {
+      uint32_t now = micros();
+
+      if (numRuns)
+      {
+        uint32_t period = now - start_us;
+
+        avgPeriod_us = numRuns > 1 ? (7 * avgPeriod_us + period) / 8 : period;
+
+        if (period > maxPeriod_us)
+          maxPeriod_us = period;
+      }
+
+      start_us = now;
+    }
+
+    void end()
+    {
+      uint32_t run_us = micros() - start_us;
+
+      avgRun_us = numRuns ? (7 * avgRun_us + run_us) / 8 : run_us;
+
+      if (run_us > maxRun_us)
+        maxRun_us = run_us;
+
+      numRuns++;
+    }
+
+    uint32_t getNumRuns()
+    {
+      return numRuns;
+    }
+
+    // Worst period minus average period
+    uint32_t getJitter()
+    {
+      return maxPeriod_us > avgPeriod_us ? maxPeriod_us - avgPeriod_us : 0;
+    }
+
+    void print(Print& out)
+    {
+      out.print(F("Runs="));
+      out.print(numRuns);
+      out.print(F(",run_us="));
+      out.print(avgRun_us);
+      out.print(F("/"));
+      out.print(maxRun_us);
+      out.print(F(",period_us="));
+      out.print(avgPeriod_us);
+      out.print(F("/"));
+      out.print(maxPeriod_us);
+      out.print(F(",jitter_us="));
+      out.println(getJitter());
+    }
+
+  private:
+    uint32_t  numRuns;
+    uint32_t  avgRun_us;
+    uint32_t  maxRun_us;
+    uint32_t  avgPeriod_us;
+    uint32_t  maxPeriod_us;
+    uint32_t  start_us;
+};
+
+template <class TBlynk>
+class BlynkTask
+{
+  public:
+    BlynkTask(TBlynk& blynk)
+      : mBlynk(blynk)
+      , handle(NULL)
+      , publishQueue(blynk)
+    {}
+
+    bool begin(const char* name, BaseType_t core, UBaseType_t priority = BLYNK_TASK_PRIORITY,
+               uint32_t stackSize = BLYNK_TASK_STACK_SIZE)
+    {
+      if (handle)
+        return true;
+
+      if (xTaskCreatePinnedToCore(taskLoop, name, stackSize, this, priority, &handle, core) != pdPASS)
+      {
+        BLYNK_LOG1(BLYNK_F("Task:CreateFail"));
+        handle = NULL;
+        return false;
+      }
+
+      BLYNK_LOG4(BLYNK_F("Task:"), name, BLYNK_F(",core="), core);
+
+      return true;
+    }
+
+    // Same as Blynk virtualWrite(), from any task. Sent by the Blynk task once connected.
+    template <typename... Args>
+    bool virtualWrite(int pin, Args... values)
+    {
+      return publishQueue.virtualWrite(pin, values...);
+    }
+
+    bool IRAM_ATTR virtualWriteFromISR(uint8_t pin, int32_t value)
+    {
+      return publishQueue.virtualWriteFromISR(pin, value);
+    }
+
+    uint32_t getDropped()
+    {
+      return publishQueue.getDropped();
+    }
+
+    BlynkPublishQueue<TBlynk>& getPublishQueue()
+    {
+      return publishQueue;
+    }
+
+    BlynkTaskStats& getStats()
+    {
+      return stats;
+    }
+
+    TaskHandle_t getHandle()
+    {
+      return handle;
+    }
+
+  private:
+    TBlynk&       mBlynk;
+    TaskHandle_t  handle;
+
+    BlynkPublishQueue<TBlynk> publishQueue;
+    BlynkTaskStats            stats;
+
+    static void taskLoop(void* arg)
+    {
+      BlynkTask* self = (BlynkTask*) arg;
+
+      for (;;)
+      {
+        self->runOnce();
+        vTaskDelay(BLYNK_TASK_PERIOD_MS / portTICK_PERIOD_MS);
+      }
+    }
+
+    void runOnce()
+    {
+      stats.begin();
+
+      mBlynk.run();
+      publishQueue.run();
+
+      stats.end();
+    }
+};
+
+typedef void (*BlynkWriteQueueHandler)(BlynkReq& request, const BlynkParam& param);
+
+typedef struct
+{
+  BlynkWriteQueueHandler  handler;
+  uint8_t                 pin;
+  uint8_t                 len;
+  char                    data[BLYNK_TASK_ENTRY_LEN];
+} BlynkQueuedHandlerCall;
+
+// BLYNK_WRITE() handlers run by another task than the Blynk one
+class BlynkWriteQueue
+{
+  public:
+    BlynkWriteQueue()
+      : queue(NULL)
+      , numDropped(0)
+    {}
+
+    bool begin(uint16_t size = BLYNK_TASK_QUEUE_SIZE)
+    {
+      if (!queue)
+        queue = xQueueCreate(size, sizeof(BlynkQueuedHandlerCall));
+
+      return queue != NULL;
+    }
+
+    // Called by the Blynk task, through BLYNK_WRITE_ON()
+    void post(uint8_t pin, const BlynkParam& param, BlynkWriteQueueHandler handler)
+    {
+      BlynkQueuedHandlerCall call;
+
+      // Room for the terminator that BlynkProtocol puts after the input buffer, not counted in getLength()
+      if ( !queue || (param.getLength() >= sizeof(call.data)) )
+      {
+        numDropped++;
+        return;
+      }
+
+      call.handler  = handler;
+      call.pin      = pin;
+      call.len      = param.getLength();
+      memcpy(call.data, param.getBuffer(), call.len);
+      call.data[call.len] = '\0';
+
+      if (xQueueSend(queue, &call, 0) != pdTRUE)
+        numDropped++;
+    }
+
+    // Call from the task which must run the handlers. Waits up to wait_ms for the first one.
+    uint16_t run(uint32_t wait_ms = 0)
+    {
+      BlynkQueuedHandlerCall call;
+      uint16_t done = 0;
+
+      if (!queue)
+        return 0;
+
+      TickType_t wait = wait_ms / portTICK_PERIOD_MS;
+
+      while (xQueueReceive(queue, &call, wait) == pdTRUE)
+      {
+        BlynkReq    request = { call.pin };
+        BlynkParam  param(call.data, call.len, sizeof(call.data));
+
+        call.handler(request, param);
+
+        done++;
+        wait = 0;
+      }
+
+      return done;
+    }
+
+    uint32_t getDropped()
+    {
+      return numDropped;
+    }
+
+  private:
+    QueueHandle_t queue;
+    uint32_t      numDropped;
+};
+
+// Like BLYNK_WRITE(pin), but the body runs in the task calling writeQueue.run()
+#define BLYNK_WRITE_ON(writeQueue, pin) \
+  void BlynkTaskWriteHandler ## pin (BlynkReq BLYNK_UNUSED &request, const BlynkParam BLYNK_UNUSED &param); \
+  BLYNK_WRITE(pin) \
+  { \
+    writeQueue.post(request.pin, param, BlynkTaskWriteHandler ## pin); \
+  } \
+  void BlynkTaskWriteHandler ## pin (BlynkReq BLYNK_UNUSED &request, const BlynkParam BLYNK_UNUSED &param)
+
+#endif    // BlynkEsp32_Tasks_h
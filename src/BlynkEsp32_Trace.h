@@ -0,0 +1,198 @@
+/****************************************************************************************************************************
+   BlynkEsp32_Trace.h
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   Hot-path trace points. Begin / End events are timestamped with micros() and stored in a fixed RAM ring.
+   The ring can be dumped in Chrome Trace Event format (chrome://tracing or https://ui.perfetto.dev).
+   Define BLYNK_USE_TRACE true before including any Blynk header to enable. Otherwise all macros compile to nothing.
+ *****************************************************************************************************************************/
+
+#ifndef BlynkEsp32_Trace_h
+#define BlynkEsp32_Trace_h
+
+#ifndef BLYNK_USE_TRACE
+#define BLYNK_USE_TRACE     false
+#endif
+
+#if BLYNK_USE_TRACE
+
+#include <Arduino.h>
+
+#ifndef BLYNK_TRACE_BUFFER_SIZE
+#define BLYNK_TRACE_BUFFER_SIZE     256
+#endif
+
+// Chrome Trace Event phases
+#define BLYNK_TRACE_PH_BEGIN        'B'
+#define BLYNK_TRACE_PH_END          'E'
+#define BLYNK_TRACE_PH_INSTANT      'i'
+
+typedef struct
+{
+  // Must point to a string literal, only the pointer is stored
+  const char* name;
+  uint32_t    ts;
+  char        phase;
+  uint8_t     core;
+} BlynkTraceEvent;
+
+class BlynkTrace
+{
+  public:
+    BlynkTrace()
+      : head(0)
+      , count(0)
+      , dropped(0)
+      , enabled(true)
+    {}
+
+    // Safe to call from both cores. Oldest events are overwritten when the ring is full.
+    void record(const char* name, char phase)
+    {
+      if (!enabled)
+        return;
+
+      uint32_t now = micros();
+
+      portENTER_CRITICAL(&traceMux);
+
+      BlynkTraceEvent& ev = events[head];
+
+      ev.name   = name;
+      ev.ts     = now;
+      ev.phase  = phase;
+      ev.core   = (uint8_t) xPortGetCoreID();
+
+      head = (head + 1) % BLYNK_TRACE_BUFFER_SIZE;
+
+      if (count < BLYNK_TRACE_BUFFER_SIZE)
+        count++;
+      else
+        dropped++;
+
+      portEXIT_CRITICAL(&traceMux);
+    }
+
+    void enable(bool on = true)
+    {
+      enabled = on;
+    }
+
+    void clear()
+    {
+      portENTER_CRITICAL(&traceMux);
+      head    = 0;
+      count   = 0;
+      dropped = 0;
+      portEXIT_CRITICAL(&traceMux);
+    }
+
+    uint16_t size()
+    {
+      return count;
+    }
+
+    uint32_t getDropped()
+    {
+      return dropped;
+    }
+
+    // Write the ring, oldest first, as a Chrome Trace Event JSON object.
+    // Recording is paused while dumping so the ring is not overwritten under us.
+    void dump(Print& out)
+    {
+      bool wasEnabled = enabled;
+      enabled = false;
+
+      uint16_t n     = count;
+      uint16_t start = (head + BLYNK_TRACE_BUFFER_SIZE - n) % BLYNK_TRACE_BUFFER_SIZE;
+
+      out.print(F("{\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":"));
+      out.print(dropped);
+      out.print(F("},\"traceEvents\":["));
+
+      for (uint16_t i = 0; i < n; i++)
+      {
+        const BlynkTraceEvent& ev = events[(start + i) % BLYNK_TRACE_BUFFER_SIZE];
+
+        if (i)
+          out.print(',');
+
+        out.print(F("{\"name\":\""));
+        out.print(ev.name);
+        out.print(F("\",\"ph\":\""));
+        out.print(ev.phase);
+        out.print(F("\",\"ts\":"));
+        out.print(ev.ts);
+        out.print(F(",\"pid\":1,\"tid\":"));
+        out.print(ev.core);
+
+        if (ev.phase == BLYNK_TRACE_PH_INSTANT)
+          out.print(F(",\"s\":\"t\""));
+
+        out.print('}');
+      }
+
+      out.println(F("]}"));
+
+      enabled = wasEnabled;
+    }
+
+  private:
+    BlynkTraceEvent events[BLYNK_TRACE_BUFFER_SIZE];
+
+    volatile uint16_t head;
+    volatile uint16_t count;
+    volatile uint32_t dropped;
+    volatile bool     enabled;
+
+    portMUX_TYPE traceMux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+BlynkTrace BlynkTracer;
+
+// Records Begin on construction and End when leaving the enclosing scope
+class BlynkTraceScope
+{
+  public:
+    BlynkTraceScope(const char* name)
+      : mName(name)
+    {
+      BlynkTracer.record(mName, BLYNK_TRACE_PH_BEGIN);
+    }
+
+    ~BlynkTraceScope()
+    {
+      BlynkTracer.record(mName, BLYNK_TRACE_PH_END);
+    }
+
+  private:
+    const char* mName;
+};
+
+#define BLYNK_TRACE_CONCAT_(a, b)     a##b
+#define BLYNK_TRACE_CONCAT(a, b)      BLYNK_TRACE_CONCAT_(a, b)
+
+#define BLYNK_TRACE_BEGIN(name)       BlynkTracer.record(name, BLYNK_TRACE_PH_BEGIN)
+#define BLYNK_TRACE_END(name)         BlynkTracer.record(name, BLYNK_TRACE_PH_END)
+#define BLYNK_TRACE_INSTANT(name)     BlynkTracer.record(name, BLYNK_TRACE_PH_INSTANT)
+#define BLYNK_TRACE_SCOPE(name)       BlynkTraceScope BLYNK_TRACE_CONCAT(_blynkTraceScope, __LINE__)(name)
+#define BLYNK_TRACE_DUMP(out)         BlynkTracer.dump(out)
+
+#else
+
+#define BLYNK_TRACE_BEGIN(name)       do {} while (0)
+#define BLYNK_TRACE_END(name)         do {} while (0)
+#define BLYNK_TRACE_INSTANT(name)     do {} while (0)
+#define BLYNK_TRACE_SCOPE(name)       do {} while (0)
+#define BLYNK_TRACE_DUMP(out)         do {} while (0)
+
+#endif    // BLYNK_USE_TRACE
+
+#endif    // BlynkEsp32_Trace_h
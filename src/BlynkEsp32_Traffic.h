@@ -0,0 +1,80 @@
+/****************************************************************************************************************************
+   BlynkEsp32_Traffic.h
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   Byte counters of the Blynk transports, read by the coexistence controller and the throughput benchmark.
+   BlynkCountingClient is the WiFiClient used by Blynk_WF.
+ *****************************************************************************************************************************/
+
+#ifndef BlynkEsp32_Traffic_h
+#define BlynkEsp32_Traffic_h
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+
+typedef struct
+{
+  uint32_t  bytesIn;
+  uint32_t  bytesOut;
+} BlynkTrafficCounter;
+
+class BlynkCountingClient : public WiFiClient
+{
+  public:
+    BlynkCountingClient()
+    {
+      traffic.bytesIn   = 0;
+      traffic.bytesOut  = 0;
+    }
+
+    using WiFiClient::write;
+    using WiFiClient::read;
+
+    size_t write(const uint8_t *buf, size_t size)
+    {
+      size_t res = WiFiClient::write(buf, size);
+      traffic.bytesOut += res;
+      return res;
+    }
+
+    size_t write(uint8_t data)
+    {
+      return write(&data, 1);
+    }
+
+    int read(uint8_t *buf, size_t size)
+    {
+      int res = WiFiClient::read(buf, size);
+
+      if (res > 0)
+        traffic.bytesIn += res;
+
+      return res;
+    }
+
+    int read()
+    {
+      int res = WiFiClient::read();
+
+      if (res >= 0)
+        traffic.bytesIn++;
+
+      return res;
+    }
+
+    const BlynkTrafficCounter& getTraffic()
+    {
+      return traffic;
+    }
+
+  private:
+    BlynkTrafficCounter traffic;
+};
+
+#endif    // BlynkEsp32_Traffic_h
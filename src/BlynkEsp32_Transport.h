@@ -0,0 +1,302 @@
+/****************************************************************************************************************************
+   BlynkEsp32_Transport.h
+   For ESP32 using WiFi along with BlueTooth / BLE
+
+   BlynkESP32_BT_WF is a library for inclusion of both ESP32 Blynk BT/BLE and WiFi libraries. Then select either one or both at runtime.
+   Forked from Blynk library v0.6.1 https://github.com/blynkkk/blynk-library/releases
+   Built by Khoi Hoang https://github.com/khoih-prog/BlynkGSM_ESPManager
+   Licensed under MIT license
+   Version: 1.0.5
+
+   Runtime start / stop / switch of the WiFi, BT (SPP) and BLE transports, without reboot.
+   Include after the Blynk transport headers used by the sketch. BT and BLE share the Bluetooth controller, so only one
+   of them runs at a time. Each switch is timed, and the free heap before / after is recorded.
+ *****************************************************************************************************************************/
+
+#ifndef BlynkEsp32_Transport_h
+#define BlynkEsp32_Transport_h
+
+#include <Arduino.h>
+#include <Blynk/BlynkProtocolDefs.h>
+#include "esp_bt.h"
+
+#define BLYNK_TRANSPORT_NONE      0x00
+#define BLYNK_TRANSPORT_WIFI      0x01
+#define BLYNK_TRANSPORT_BT        0x02
+#define BLYNK_TRANSPORT_BLE       0x04
+
+#define BLYNK_TRANSPORT_TOKEN_LEN 36
+
+class BlynkTransportManager
+{
+  public:
+    BlynkTransportManager()
+      : active(BLYNK_TRANSPORT_NONE)
+      , btReleased(false)
+      , lastSwitch_us(0)
+      , lastHeapDelta(0)
+    {
+      btToken[0] = 0;
+    }
+
+    // Token for BT or BLE. Copied, so a temporary String is fine.
+    void setBTToken(const char* token)
+    {
+      strncpy(btToken, token, sizeof(btToken) - 1);
+      btToken[sizeof(btToken) - 1] = 0;
+    }
+
+    // Declare transports already started by the sketch, e.g. after Blynk_WF.begin()
+    void setActive(uint8_t transports)
+    {
+      active = transports;
+    }
+
+    uint8_t getActive()
+    {
+      return active;
+    }
+
+    bool isActive(uint8_t transport)
+    {
+      return (active & transport);
+    }
+
+    // Stop transports not in the set, then start the new ones. BT and BLE can't be selected together.
+    bool select(uint8_t transports)
+    {
+      if ( (transports & BLYNK_TRANSPORT_BT) && (transports & BLYNK_TRANSPORT_BLE) )
+      {
+        BLYNK_LOG1(BLYNK_F("Tr:BT+BLENotPermitted"));
+        return false;
+      }
+
+      if ( btReleased && (transports & (BLYNK_TRANSPORT_BT | BLYNK_TRANSPORT_BLE)) )
+      {
+        BLYNK_LOG1(BLYNK_F("Tr:BTReleased"));
+        return false;
+      }
+
+      if (transports == active)
+        return true;
+
+      uint32_t heapBefore = ESP.getFreeHeap();
+      uint32_t start      = micros();
+
+      stopTransports(active & ~transports);
+      bool ok = startTransports(transports & ~active);
+
+      lastSwitch_us = micros() - start;
+      lastHeapDelta = (int32_t) ESP.getFreeHeap() - (int32_t) heapBefore;
+
+      BLYNK_LOG6(BLYNK_F("Tr:Now="), active, BLYNK_F(",us="), lastSwitch_us, BLYNK_F(",heap+="), lastHeapDelta);
+
+      return ok;
+    }
+
+    bool start(uint8_t transports)
+    {
+      return select(active | transports);
+    }
+
+    bool stop(uint8_t transports)
+    {
+      return select(active & ~transports);
+    }
+
+    // Stop BT / BLE and give the controller memory back to the heap, for the rest of this boot.
+    // Arduino btStart() always enables dual mode, so memory of one mode alone can't be released.
+    int32_t releaseBluetooth()
+    {
+      if (btReleased)
+        return 0;
+
+      uint32_t heapBefore = ESP.getFreeHeap();
+
+      stopTransports(active & (BLYNK_TRANSPORT_BT | BLYNK_TRANSPORT_BLE));
+
+      // end() keeps the Bluetooth stack up for the next session : take it down
+#if defined(BlynkSimpleEsp32_BLE_WF_h)
+      Blynk_BLE.release();
+#endif
+
+#if defined(BlynkSimpleEsp32_BT_WF_h)
+      Blynk_BT.release();
+#endif
+
+      // Controller must be deinitialized before its memory is released
+      if (esp_bt_controller_get_status() == ESP_BT_CONTROLLER_STATUS_IDLE)
+      {
+        btReleased = (esp_bt_controller_mem_release(ESP_BT_MODE_BTDM) == ESP_OK);
+      }
+
+      lastHeapDelta = (int32_t) ESP.getFreeHeap() - (int32_t) heapBefore;
+
+      BLYNK_LOG4(BLYNK_F("Tr:BTRelease="), btReleased ? BLYNK_F("OK") : BLYNK_F("NG"), BLYNK_F(",heap+="), lastHeapDelta);
+
+      return lastHeapDelta;
+    }
+
+    // Blynk session up on this transport
+    bool isConnected(uint8_t transport)
+    {
+      if ( !(active & transport) )
+        return false;
+
+#if defined(BlynkSimpleEsp32_BT_WF_h)
+      if (transport == BLYNK_TRANSPORT_BT)
+        return Blynk_BT.connected();
+#endif
+
+#if defined(BlynkSimpleEsp32_BLE_WF_h)
+      if (transport == BLYNK_TRANSPORT_BLE)
+        return Blynk_BLE.connected();
+#endif
+
+#if (defined(BlynkSimpleEsp32_WFM_h) || defined(BlynkSimpleEsp32_WF_h))
+      if (transport == BLYNK_TRANSPORT_WIFI)
+        return Blynk_WF.connected();
+#endif
+
+      return false;
+    }
+
+    // Send an encoded hardware command ("vw", pin, values...) on one transport
+    void sendHardware(uint8_t transport, const void* data, size_t len)
+    {
+#if defined(BlynkSimpleEsp32_BT_WF_h)
+      if (transport == BLYNK_TRANSPORT_BT)
+        Blynk_BT.sendCmd(BLYNK_CMD_HARDWARE, 0, data, len);
+#endif
+
+#if defined(BlynkSimpleEsp32_BLE_WF_h)
+      if (transport == BLYNK_TRANSPORT_BLE)
+        Blynk_BLE.sendCmd(BLYNK_CMD_HARDWARE, 0, data, len);
+#endif
+
+#if (defined(BlynkSimpleEsp32_WFM_h) || defined(BlynkSimpleEsp32_WF_h))
+      if (transport == BLYNK_TRANSPORT_WIFI)
+        Blynk_WF.sendCmd(BLYNK_CMD_HARDWARE, 0, data, len);
+#endif
+    }
+
+    // Call in loop() instead of run() of each Blynk instance
+    void run()
+    {
+#if defined(BlynkSimpleEsp32_BT_WF_h)
+      if (active & BLYNK_TRANSPORT_BT)
+        Blynk_BT.run();
+#endif
+
+#if defined(BlynkSimpleEsp32_BLE_WF_h)
+      if (active & BLYNK_TRANSPORT_BLE)
+        Blynk_BLE.run();
+#endif
+
+#if (defined(BlynkSimpleEsp32_WFM_h) || defined(BlynkSimpleEsp32_WF_h))
+      if (active & BLYNK_TRANSPORT_WIFI)
+        Blynk_WF.run();
+#endif
+    }
+
+    uint32_t getLastSwitchTime()
+    {
+      return lastSwitch_us;
+    }
+
+    // Free heap change caused by the last switch or release, in bytes. Positive when memory was reclaimed.
+    int32_t getLastHeapDelta()
+    {
+      return lastHeapDelta;
+    }
+
+  private:
+    uint8_t   active;
+    bool      btReleased;
+    uint32_t  lastSwitch_us;
+    int32_t   lastHeapDelta;
+    char      btToken[BLYNK_TRANSPORT_TOKEN_LEN];
+
+    void stopTransports(uint8_t transports)
+    {
+#if defined(BlynkSimpleEsp32_BT_WF_h)
+      if (transports & BLYNK_TRANSPORT_BT)
+        Blynk_BT.end();
+#endif
+
+#if defined(BlynkSimpleEsp32_BLE_WF_h)
+      if (transports & BLYNK_TRANSPORT_BLE)
+        Blynk_BLE.end();
+#endif
+
+#if (defined(BlynkSimpleEsp32_WFM_h) || defined(BlynkSimpleEsp32_WF_h))
+      if (transports & BLYNK_TRANSPORT_WIFI)
+      {
+        Blynk_WF.disconnect();
+        WiFi.disconnect(true);
+        WiFi.mode(WIFI_OFF);
+      }
+#endif
+
+      active &= ~transports;
+    }
+
+    bool startTransports(uint8_t transports)
+    {
+      bool ok = true;
+
+#if defined(BlynkSimpleEsp32_BT_WF_h)
+      if (transports & BLYNK_TRANSPORT_BT)
+      {
+        if (btToken[0])
+        {
+          Blynk_BT.begin(btToken);
+          active |= BLYNK_TRANSPORT_BT;
+        }
+        else
+        {
+          ok = false;
+        }
+      }
+#endif
+
+#if defined(BlynkSimpleEsp32_BLE_WF_h)
+      if (transports & BLYNK_TRANSPORT_BLE)
+      {
+        if (btToken[0])
+        {
+          Blynk_BLE.begin(btToken);
+          active |= BLYNK_TRANSPORT_BLE;
+        }
+        else
+        {
+          ok = false;
+        }
+      }
+#endif
+
+#if (defined(BlynkSimpleEsp32_WFM_h) || defined(BlynkSimpleEsp32_WF_h))
+      if (transports & BLYNK_TRANSPORT_WIFI)
+      {
+        WiFi.mode(WIFI_STA);
+
+#if !defined(BlynkSimpleEsp32_WFM_h)
+        // Reconnect with the last credentials. Blynk_WF.run() of BlynkSimpleEsp32_WFM.h does it by itself.
+        WiFi.begin();
+#endif
+
+        active |= BLYNK_TRANSPORT_WIFI;
+      }
+#endif
+
+      if (transports & ~active)
+      {
+        BLYNK_LOG2(BLYNK_F("Tr:NotStarted="), transports & ~active);
+        ok = false;
+      }
+
+      return ok;
+    }
+};
+
+#endif    // BlynkEsp32_Transport_h
@@ -39,7 +39,10 @@
 #endif
 
 #define BLYNK_SEND_ATOMIC
+
+#ifndef BLYNK_SEND_CHUNK
 #define BLYNK_SEND_CHUNK 20
+#endif
 //#define BLYNK_SEND_THROTTLE 20
 
 // KH
@@ -49,11 +52,22 @@
 #include <Blynk/BlynkProtocol.h>
 #include <utility/BlynkFifo.h>
 
+#include "BlynkEsp32_Trace.h"
+#include "BlynkEsp32_Traffic.h"
+#include "BlynkEsp32_Arena.h"
+
 #include <BLEDevice.h>
 #include <BLEServer.h>
 #include <BLEUtils.h>
 #include <BLE2902.h>
 
+// end() waits for the central to go before it stops advertising
+#ifndef BLYNK_BLE_END_TIMEOUT_MS
+#define BLYNK_BLE_END_TIMEOUT_MS    500
+#endif
+
+#define BLYNK_BLE_END_SETTLE_MS     20
+
 #define SERVICE_UUID           "713D0000-503E-4C75-BA94-3148F18D941E"
 #define CHARACTERISTIC_UUID_RX "713D0003-503E-4C75-BA94-3148F18D941E"
 #define CHARACTERISTIC_UUID_TX "713D0002-503E-4C75-BA94-3148F18D941E"
@@ -67,7 +81,20 @@ class BlynkTransportEsp32_BLE :
     BlynkTransportEsp32_BLE()
       : mConn (false)
       , mName ("Blynk")
-    {}
+      , pServer (NULL)
+      , pService (NULL)
+      , pCharacteristicTX (NULL)
+      , pCharacteristicRX (NULL)
+      , mAdvMin (0)
+      , mAdvMax (0)
+      , mStarted (false)
+      , mReleased (false)
+    {
+      vPortCPUInitializeMutex(&mRxMux);
+
+      mTraffic.bytesIn  = 0;
+      mTraffic.bytesOut = 0;
+    }
 
     void setDeviceName(const char* name) {
       mName = name;
@@ -76,29 +103,44 @@ class BlynkTransportEsp32_BLE :
     // IP redirect not available
     void begin(char BLYNK_UNUSED *h, uint16_t BLYNK_UNUSED p) {}
 
+    // The stack and the GATT objects are built by the first call only. Later calls, after end(), restart advertising.
     void begin() {
+      // Already running
+      if (mStarted) {
+        return;
+      }
+
+      // BLEDevice can't register a server again once its stack was deinitialized
+      if (mReleased) {
+        BLYNK_LOG1(BLYNK_F("BLEReleased"));
+        return;
+      }
+
+      mStarted = true;
+
+      if (pServer) {
+        pServer->getAdvertising()->start();
+        return;
+      }
+
       // Create the BLE Device
       BLEDevice::init(mName);
 
-      // Create the BLE Server
+      // Create the BLE Server. BLEDevice owns it.
       pServer = BLEDevice::createServer();
       pServer->setCallbacks(this);
 
       // Create the BLE Service
       pService = pServer->createService(SERVICE_UUID);
 
-      // Create a BLE Characteristic
-      pCharacteristicTX = pService->createCharacteristic(
-                            CHARACTERISTIC_UUID_TX,
-                            BLECharacteristic::PROPERTY_NOTIFY
-                          );
-
-      pCharacteristicTX->addDescriptor(new BLE2902());
+      // Create the BLE Characteristics, in static slots.
+      // The properties are passed by value : create() forwards references, and they are only declared in-class.
+      pCharacteristicTX = mCharTX.create(CHARACTERISTIC_UUID_TX, (uint32_t) BLECharacteristic::PROPERTY_NOTIFY);
+      pCharacteristicTX->addDescriptor(mTxCCCD.create());
+      pService->addCharacteristic(pCharacteristicTX);
 
-      pCharacteristicRX = pService->createCharacteristic(
-                            CHARACTERISTIC_UUID_RX,
-                            BLECharacteristic::PROPERTY_WRITE
-                          );
+      pCharacteristicRX = mCharRX.create(CHARACTERISTIC_UUID_RX, (uint32_t) BLECharacteristic::PROPERTY_WRITE);
+      pService->addCharacteristic(pCharacteristicRX);
 
       pCharacteristicRX->setCallbacks(this);
 
@@ -107,11 +149,94 @@ class BlynkTransportEsp32_BLE :
 
       // Start advertising
       pServer->getAdvertising()->addServiceUUID(pService->getUUID());
+
+      if (mAdvMin)
+      {
+        pServer->getAdvertising()->setMinInterval(mAdvMin);
+        pServer->getAdvertising()->setMaxInterval(mAdvMax);
+      }
+
       pServer->getAdvertising()->start();
     }
 
+    // Longer intervals save power but the phone takes longer to find / reach the board
+    void setAdvertisingInterval(uint16_t min_ms, uint16_t max_ms) {
+      // Units of 0.625 ms
+      mAdvMin = min_ms * 8 / 5;
+      mAdvMax = max_ms * 8 / 5;
+
+      if (pServer) {
+        BLEAdvertising* pAdvertising = pServer->getAdvertising();
+
+        pAdvertising->stop();
+        pAdvertising->setMinInterval(mAdvMin);
+        pAdvertising->setMaxInterval(mAdvMax);
+
+        if (!mConn) {
+          pAdvertising->start();
+        }
+      }
+    }
+
+    // Ask the phone for another connection interval. It may refuse.
+    bool setConnectionInterval(uint16_t min_ms, uint16_t max_ms, uint16_t latency, uint16_t timeout_ms) {
+      if (!mConn) {
+        return false;
+      }
+
+      esp_ble_conn_update_params_t params;
+
+      memcpy(params.bda, mRemoteBda, sizeof(esp_bd_addr_t));
+      params.min_int  = min_ms * 4 / 5;       // Units of 1.25 ms
+      params.max_int  = max_ms * 4 / 5;
+      params.latency  = latency;
+      params.timeout  = timeout_ms / 10;      // Units of 10 ms
+
+      return (esp_ble_gap_update_conn_params(&params) == ESP_OK);
+    }
+
+    // Drop the central and stop advertising. The stack and the GATT objects are kept for the next begin(), so
+    // sessions can be cycled without allocating anything.
+    void end() {
+      if (!mStarted) {
+        return;
+      }
+
+      mStarted = false;
+
+      // mConn is already cleared by Blynk_BLE.end() : ask the server
+      if (pServer->getConnectedCount()) {
+        pServer->disconnect(pServer->getConnId());
+
+        // Some BLE library versions restart advertising after onDisconnect() : stop it after that
+        millis_time_t start = BlynkMillis();
+
+        while (pServer->getConnectedCount() && (BlynkMillis() - start < BLYNK_BLE_END_TIMEOUT_MS)) {
+          delay(1);
+        }
+
+        delay(BLYNK_BLE_END_SETTLE_MS);
+      }
+
+      pServer->getAdvertising()->stop();
+
+      mConn = false;
+      clearRX();
+    }
+
+    // Stop and deinit the Bluetooth stack, BT included, for good : begin() won't start BLE again until reboot.
+    // The server and its service belong to BLEDevice, which keeps pointing at the server : they aren't freed.
+    void release() {
+      end();
+
+      if (pServer && !mReleased) {
+        BLEDevice::deinit(false);
+        mReleased = true;
+      }
+    }
+
     bool connect() {
-      mBuffRX.clear();
+      clearRX();
       return mConn = true;
     }
 
@@ -124,6 +249,8 @@ class BlynkTransportEsp32_BLE :
     }
 
     size_t read(void* buf, size_t len) {
+      BLYNK_TRACE_SCOPE("BLE.read");
+
       millis_time_t start = BlynkMillis();
       while (BlynkMillis() - start < BLYNK_TIMEOUT_MS) {
         if (available() < len) {
@@ -132,18 +259,32 @@ class BlynkTransportEsp32_BLE :
           break;
         }
       }
+      portENTER_CRITICAL(&mRxMux);
       size_t res = mBuffRX.get((uint8_t*)buf, len);
+      portEXIT_CRITICAL(&mRxMux);
+
+      mTraffic.bytesIn += res;
       return res;
     }
 
     size_t write(const void* buf, size_t len) {
+      BLYNK_TRACE_SCOPE("BLE.write");
+
       pCharacteristicTX->setValue((uint8_t*)buf, len);
       pCharacteristicTX->notify();
+      mTraffic.bytesOut += len;
       return len;
     }
 
+    const BlynkTrafficCounter& getTraffic() {
+      return mTraffic;
+    }
+
     size_t available() {
+      portENTER_CRITICAL(&mRxMux);
       size_t rxSize = mBuffRX.size();
+      portEXIT_CRITICAL(&mRxMux);
+
       return rxSize;
     }
 
@@ -152,7 +293,14 @@ class BlynkTransportEsp32_BLE :
     void onConnect(BLEServer* pServer);
     void onDisconnect(BLEServer* pServer);
 
+    // Called along with onConnect(BLEServer*). Keep the central address for setConnectionInterval()
+    void onConnect(BLEServer* pServer, esp_ble_gatts_cb_param_t* param) {
+      memcpy(mRemoteBda, param->connect.remote_bda, sizeof(esp_bd_addr_t));
+    }
+
     void onWrite(BLECharacteristic *pCharacteristic) {
+      BLYNK_TRACE_INSTANT("BLE.onWrite");
+
       std::string rxValue = pCharacteristic->getValue();
 
       if (rxValue.length() > 0) {
@@ -160,7 +308,10 @@ class BlynkTransportEsp32_BLE :
         size_t len = rxValue.length();
 
         BLYNK_DBG_DUMP(">> ", data, len);
+
+        portENTER_CRITICAL(&mRxMux);
         mBuffRX.put(data, len);
+        portEXIT_CRITICAL(&mRxMux);
       }
     }
 
@@ -173,7 +324,27 @@ class BlynkTransportEsp32_BLE :
     BLECharacteristic *pCharacteristicTX;
     BLECharacteristic *pCharacteristicRX;
 
+    BlynkStaticSlot<BLECharacteristic>  mCharTX;
+    BlynkStaticSlot<BLECharacteristic>  mCharRX;
+    BlynkStaticSlot<BLE2902>            mTxCCCD;
+
+    uint16_t mAdvMin;
+    uint16_t mAdvMax;
+    esp_bd_addr_t mRemoteBda;
+
+    bool mStarted;
+    bool mReleased;
+
+    // Filled by the BLE callback task, read by the task running Blynk_BLE.run(), maybe on the other core
     BlynkFifo<uint8_t, BLYNK_MAX_READBYTES * 2> mBuffRX;
+    portMUX_TYPE mRxMux;
+    BlynkTrafficCounter mTraffic;
+
+    void clearRX() {
+      portENTER_CRITICAL(&mRxMux);
+      mBuffRX.clear();
+      portEXIT_CRITICAL(&mRxMux);
+    }
 };
 
 class BlynkEsp32_BLE
@@ -197,6 +368,33 @@ class BlynkEsp32_BLE
       conn.setDeviceName(name);
     }
 
+    // Bytes exchanged with the phone since boot
+    const BlynkTrafficCounter& getTraffic() {
+      return conn.getTraffic();
+    }
+
+    void setAdvertisingInterval(uint16_t min_ms, uint16_t max_ms) {
+      conn.setAdvertisingInterval(min_ms, max_ms);
+    }
+
+    bool setConnectionInterval(uint16_t min_ms, uint16_t max_ms, uint16_t latency, uint16_t timeout_ms) {
+      return conn.setConnectionInterval(min_ms, max_ms, latency, timeout_ms);
+    }
+
+    // Stop BLE, keeping the stack and the GATT objects. Call begin() again to restart.
+    void end()
+    {
+      Base::disconnect();
+      conn.end();
+    }
+
+    // Stop BLE and deinit the Bluetooth stack, for the rest of this boot
+    void release()
+    {
+      Base::disconnect();
+      conn.release();
+    }
+
 };
 
 
@@ -205,10 +403,20 @@ static BlynkTransportEsp32_BLE _blynkTransportBLE;
 // KH
 BlynkEsp32_BLE Blynk_BLE(_blynkTransportBLE);
 
+#ifndef Blynk
 #define Blynk Blynk_BLE
+#endif
 
 inline
 void BlynkTransportEsp32_BLE::onConnect(BLEServer* pServer) {
+  // Advertising restarted by the BLE library after end() : refuse the central
+  if (!mStarted) {
+    BLYNK_LOG1(BLYNK_F("BLEConStopped"));
+    pServer->getAdvertising()->stop();
+    pServer->disconnect(pServer->getConnId());
+    return;
+  }
+
   BLYNK_LOG1(BLYNK_F("BLECon"));
   connect();
   Blynk_BLE.startSession();
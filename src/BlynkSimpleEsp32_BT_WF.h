@@ -39,7 +39,11 @@
 #endif
 
 #define BLYNK_SEND_ATOMIC
+
+// When used with BLE in the same sketch, include <BlynkSimpleEsp32_BLE_WF.h> first to keep the smaller BLE chunk
+#ifndef BLYNK_SEND_CHUNK
 #define BLYNK_SEND_CHUNK 40
+#endif
 
 // KH
 #define BLYNK_TIMEOUT_MS     30000UL
@@ -62,13 +66,30 @@
 #include <Blynk/BlynkProtocol.h>
 #include <utility/BlynkFifo.h>
 
+#include "BlynkEsp32_Trace.h"
+#include "BlynkEsp32_Traffic.h"
+
+// TX power range set in begin(). A BlynkCoexController may change it later.
+#ifndef BLYNK_BT_TX_POWER_MIN
+#define BLYNK_BT_TX_POWER_MIN     ESP_PWR_LVL_N2
+#endif
+
+#ifndef BLYNK_BT_TX_POWER_MAX
+#define BLYNK_BT_TX_POWER_MAX     ESP_PWR_LVL_P7
+#endif
+
 class BlynkTransportEsp32_BT
 {
   public:
     BlynkTransportEsp32_BT()
       : mConn (false)
       , mName ("Blynk")
-    {}
+    {
+      vPortCPUInitializeMutex(&mRxMux);
+
+      mTraffic.bytesIn  = 0;
+      mTraffic.bytesOut = 0;
+    }
 
     void setDeviceName(const char* name) {
       mName = name;
@@ -110,7 +131,7 @@ class BlynkTransportEsp32_BT
         return;
       }
 
-      if (esp_bredr_tx_power_set(ESP_PWR_LVL_N2, ESP_PWR_LVL_P7) != ESP_OK)
+      if (esp_bredr_tx_power_set(BLYNK_BT_TX_POWER_MIN, BLYNK_BT_TX_POWER_MAX) != ESP_OK)
       {
         BLYNK_LOG1(BLYNK_F("TXPwrSetFailed"));
       };
@@ -121,8 +142,41 @@ class BlynkTransportEsp32_BT
       }
     }
 
+    // Tear down SPP only. Bluedroid and the controller keep running, for the next begin() or for BLE, so sessions
+    // can be cycled without the heap growing. begin() can be called again later.
+    void end() {
+      mConn = false;
+
+      if (spp_handle) {
+        esp_spp_disconnect(spp_handle);
+        spp_handle = 0;
+      }
+
+      esp_spp_deinit();
+
+      clearRX();
+      instance = NULL;
+    }
+
+    // end(), then deinit Bluedroid and stop the controller, BLE included
+    void release() {
+      end();
+
+      if (esp_bluedroid_get_status() == ESP_BLUEDROID_STATUS_ENABLED) {
+        esp_bluedroid_disable();
+      }
+
+      if (esp_bluedroid_get_status() == ESP_BLUEDROID_STATUS_INITIALIZED) {
+        esp_bluedroid_deinit();
+      }
+
+      if (btStarted()) {
+        btStop();
+      }
+    }
+
     bool connect() {
-      mBuffRX.clear();
+      clearRX();
       return mConn = true;
     }
 
@@ -135,6 +189,8 @@ class BlynkTransportEsp32_BT
     }
 
     size_t read(void* buf, size_t len) {
+      BLYNK_TRACE_SCOPE("BT.read");
+
       millis_time_t start = BlynkMillis();
       while (BlynkMillis() - start < BLYNK_TIMEOUT_MS) {
         if (available() < len) {
@@ -143,21 +199,40 @@ class BlynkTransportEsp32_BT
           break;
         }
       }
+      portENTER_CRITICAL(&mRxMux);
       size_t res = mBuffRX.get((uint8_t*)buf, len);
+      portEXIT_CRITICAL(&mRxMux);
+
+      mTraffic.bytesIn += res;
       return res;
     }
 
     size_t write(const void* buf, size_t len) {
+      BLYNK_TRACE_SCOPE("BT.write");
+
       if (!spp_handle) {
         return 0;
       }
 
       esp_err_t err = esp_spp_write(spp_handle, len, (uint8_t *)buf);
-      return (err == ESP_OK) ? len : 0;
+
+      if (err != ESP_OK) {
+        return 0;
+      }
+
+      mTraffic.bytesOut += len;
+      return len;
+    }
+
+    const BlynkTrafficCounter& getTraffic() {
+      return mTraffic;
     }
 
     size_t available() {
+      portENTER_CRITICAL(&mRxMux);
       size_t rxSize = mBuffRX.size();
+      portEXIT_CRITICAL(&mRxMux);
+
       return rxSize;
     }
 
@@ -167,7 +242,9 @@ class BlynkTransportEsp32_BT
       if (instance)
       {
         // BLYNK_DBG_DUMP(">> ", data, len);
+        portENTER_CRITICAL(&instance->mRxMux);
         instance->mBuffRX.put(data, len);
+        portEXIT_CRITICAL(&instance->mRxMux);
       }
     }
 
@@ -181,7 +258,16 @@ class BlynkTransportEsp32_BT
     bool mConn;
     const char* mName;
 
+    // Filled by the Bluedroid task, read by the task running Blynk_BT.run(), maybe on the other core
     BlynkFifo<uint8_t, BLYNK_MAX_READBYTES * 2> mBuffRX;
+    portMUX_TYPE mRxMux;
+    BlynkTrafficCounter mTraffic;
+
+    void clearRX() {
+      portENTER_CRITICAL(&mRxMux);
+      mBuffRX.clear();
+      portEXIT_CRITICAL(&mRxMux);
+    }
 
     static void esp_spp_cb(esp_spp_cb_event_t event, esp_spp_cb_param_t *param)
     {
@@ -198,6 +284,8 @@ class BlynkTransportEsp32_BT
           break;
 
         case ESP_SPP_DATA_IND_EVT:// Data received
+          BLYNK_TRACE_INSTANT("BT.dataInd");
+
           if (param->data_ind.len > 0)
           {
             instance->putData((uint8_t*)param->data_ind.data, param->data_ind.len);
@@ -249,6 +337,25 @@ class BlynkEsp32_BT
       conn.setDeviceName(name);
     }
 
+    // Bytes exchanged with the phone since boot
+    const BlynkTrafficCounter& getTraffic() {
+      return conn.getTraffic();
+    }
+
+    // Stop BT, keeping the Bluetooth stack. Call begin() again to restart.
+    void end()
+    {
+      Base::disconnect();
+      conn.end();
+    }
+
+    // Stop BT and the Bluetooth stack. begin() can start it again.
+    void release()
+    {
+      Base::disconnect();
+      conn.release();
+    }
+
 };
 
 BlynkTransportEsp32_BT* BlynkTransportEsp32_BT::instance = NULL;
@@ -258,7 +365,9 @@ uint32_t BlynkTransportEsp32_BT::spp_handle = 0;
 static BlynkTransportEsp32_BT _blynkTransport_BT;
 BlynkEsp32_BT Blynk_BT(_blynkTransport_BT);
 
+#ifndef Blynk
 #define Blynk Blynk_BT
+#endif
 
 void BlynkTransportEsp32_BT::onConnect() {
   BLYNK_LOG1(BLYNK_F("BTCon"));
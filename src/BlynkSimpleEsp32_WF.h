@@ -44,6 +44,8 @@
 #include <Adapters/BlynkArduinoClient.h>
 #include <WiFi.h>
 
+#include "BlynkEsp32_Traffic.h"
+
 class BlynkWifi
   : public BlynkProtocol<BlynkArduinoClient>
 {
@@ -109,14 +111,22 @@ class BlynkWifi
       while (this->connect() != true) {}
     }
 
+    // Bytes exchanged with the Blynk server since boot
+    const BlynkTrafficCounter& getTraffic();
+
 };
 
-static WiFiClient _blynkWifiClient;
+static BlynkCountingClient _blynkWifiClient;
 static BlynkArduinoClient _blynkTransport(_blynkWifiClient);
 
 // KH
 BlynkWifi Blynk_WF(_blynkTransport);
 
+inline
+const BlynkTrafficCounter& BlynkWifi::getTraffic() {
+  return _blynkWifiClient.getTraffic();
+}
+
 #if defined(Blynk)
 #undef Blynk
 #define Blynk Blynk_WF
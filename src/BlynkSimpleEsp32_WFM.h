@@ -43,10 +43,29 @@
 #include <Blynk/BlynkProtocol.h>
 #include <Adapters/BlynkArduinoClient.h>
 
+#include "BlynkEsp32_Trace.h"
+#include "BlynkEsp32_Log.h"
+#include "BlynkEsp32_RunWatchdog.h"
+#include "BlynkEsp32_Backoff.h"
+#include "BlynkEsp32_ServerHealth.h"
+#include "BlynkEsp32_LinkMonitor.h"
+#include "BlynkEsp32_DeepSleep.h"
+#include "BlynkEsp32_Features.h"
+#include "BlynkEsp32_KeyTable.h"
+#include "BlynkEsp32_Arena.h"
+
 #include <WiFi.h>
 #include <WiFiMulti.h>
 
+#include "BlynkEsp32_Traffic.h"
+
+#if BLYNK_WM_CONFIG_PORTAL
 #include <WebServer.h>
+#endif
+
+#if BLYNK_WM_WIFI_SCAN
+#include "BlynkEsp32_ScanCache.h"
+#endif
 
 //default to use EEPROM, otherwise, use SPIFFS
 #if USE_SPIFFS
@@ -73,9 +92,18 @@ typedef struct
 //
 
 ///NEW
+#if BLYNK_WM_DYNAMIC_PARAMETERS
 extern uint16_t NUM_MENU_ITEMS;
 extern MenuItem myMenuItems [];
 
+#define BLYNK_WM_NUM_MENU_ITEMS   NUM_MENU_ITEMS
+#define BLYNK_WM_MENU_ITEMS       myMenuItems
+#else
+// Constant 0 : the loops over menu items are compiled out
+#define BLYNK_WM_NUM_MENU_ITEMS   0
+#define BLYNK_WM_MENU_ITEMS       ((MenuItem*) NULL)
+#endif
+
 #define SSID_MAX_LEN      32
 //From v1.0.5, WPA2 passwords can be up to 63 characters long.
 #define PASS_MAX_LEN      64
@@ -95,68 +123,183 @@ typedef struct
   char blynk_token [BLYNK_TOKEN_MAX_LEN];
 }  Blynk_Credentials;
 
+// Max number of WiFi APs. APs left blank in Config Portal are skipped at runtime.
+#ifndef NUM_WIFI_CREDENTIALS
 #define NUM_WIFI_CREDENTIALS      2
+#else
+#if (NUM_WIFI_CREDENTIALS < 1)
+#warning NUM_WIFI_CREDENTIALS too low. Reseting to 1
+#undef NUM_WIFI_CREDENTIALS
+#define NUM_WIFI_CREDENTIALS      1
+#elif (NUM_WIFI_CREDENTIALS > 8)
+#warning NUM_WIFI_CREDENTIALS too high. Reseting to 8
+#undef NUM_WIFI_CREDENTIALS
+#define NUM_WIFI_CREDENTIALS      8
+#endif
+#endif
+
+// Max number of Blynk servers. Servers left blank in Config Portal are skipped at runtime.
+#ifndef NUM_BLYNK_CREDENTIALS
 #define NUM_BLYNK_CREDENTIALS     2
+#else
+#if (NUM_BLYNK_CREDENTIALS < 1)
+#warning NUM_BLYNK_CREDENTIALS too low. Reseting to 1
+#undef NUM_BLYNK_CREDENTIALS
+#define NUM_BLYNK_CREDENTIALS     1
+#elif (NUM_BLYNK_CREDENTIALS > 8)
+#warning NUM_BLYNK_CREDENTIALS too high. Reseting to 8
+#undef NUM_BLYNK_CREDENTIALS
+#define NUM_BLYNK_CREDENTIALS     8
+#endif
+#endif
+
+#define BOARD_NAME_MAX_LEN        24
 
-// Configurable items excluding fixed Header and checkSum. Currently 12 
-#define NUM_CONFIGURABLE_ITEMS    ( 4 + (2 * NUM_WIFI_CREDENTIALS) + (2 * NUM_BLYNK_CREDENTIALS) )
 typedef struct Configuration
 {
   char header         [16];
   WiFi_Credentials  WiFi_Creds  [NUM_WIFI_CREDENTIALS];
   Blynk_Credentials Blynk_Creds [NUM_BLYNK_CREDENTIALS];
   int  blynk_port;
-  char blynk_bt_tk    [36];
-  char blynk_ble_tk   [36];  
-  char board_name     [24];
+  char blynk_bt_tk    [BLYNK_TOKEN_MAX_LEN];
+  char blynk_ble_tk   [BLYNK_TOKEN_MAX_LEN];
+  char board_name     [BOARD_NAME_MAX_LEN];
   int  checkSum;
+  // Appended from version 2 on, so older data stays readable : it ends at checkSum
+  int  version;
+  // Reconnect backoff window, in seconds
+  int  reconnect_min;
+  int  reconnect_max;
 } Blynk_WM_Configuration;
-// Currently CONFIG_DATA_SIZE  =  ( 120 + (96 * NUM_WIFI_CREDENTIALS) + (68 * NUM_BLYNK_CREDENTIALS) ) = 448
 
-// Currently CONFIG_DATA_SIZE  =   448
+// Layout of Blynk_WM_Configuration. 1 : no version, up to checkSum. 2 : reconnect window.
+#define BLYNK_WM_CONFIG_VERSION     2
+
+// sizeof(Blynk_WM_Configuration), usable by the preprocessor to size the EEPROM.
+// Currently ( 132 + (96 * NUM_WIFI_CREDENTIALS) + (68 * NUM_BLYNK_CREDENTIALS) ) = 460
+#define BLYNK_WM_CONFIG_DATA_SIZE   ( 16 + (NUM_WIFI_CREDENTIALS * (SSID_MAX_LEN + PASS_MAX_LEN)) + \
+                                      (NUM_BLYNK_CREDENTIALS * (BLYNK_SERVER_MAX_LEN + BLYNK_TOKEN_MAX_LEN)) + (5 * 4) + \
+                                      (2 * BLYNK_TOKEN_MAX_LEN) + BOARD_NAME_MAX_LEN )
+
+static_assert(BLYNK_WM_CONFIG_DATA_SIZE == sizeof(Blynk_WM_Configuration),
+              "BLYNK_WM_CONFIG_DATA_SIZE doesn't match Blynk_WM_Configuration");
+
+// Currently CONFIG_DATA_SIZE  =   460
 uint16_t CONFIG_DATA_SIZE = sizeof(Blynk_WM_Configuration);
 
+// Config schema : one row per configurable field of Blynk_WM_Configuration, excluding header and checkSum.
+// Defaults, Config Portal page and request parsing are all generated from it.
+// X(fieldset, key, label, type, member, count, stride, default)
+//   key     : Config Portal id. Entries of credentials arrays add their index : "sv", "sv1", "sv2", ...
+//   count   : number of entries, stride : distance between entries. Single fields have 1, 0.
+//   type    : STR, INT, or SSID : a STR offered the scanned networks in the Config Portal.
+//   default : initial value of INT fields. STR fields start as NO_CONFIG.
+// Arrays of a fieldset are shown entry by entry, then its single fields.
+#define BLYNK_WM_CONFIG_FIELDS(X) \
+  X(0, "id",    "WiFi SSID",          SSID, WiFi_Creds[0].wifi_ssid,      NUM_WIFI_CREDENTIALS,   sizeof(WiFi_Credentials),   0) \
+  X(0, "pw",    "PWD",                STR,  WiFi_Creds[0].wifi_pw,        NUM_WIFI_CREDENTIALS,   sizeof(WiFi_Credentials),   0) \
+  X(1, "sv",    "Blynk Server",       STR,  Blynk_Creds[0].blynk_server,  NUM_BLYNK_CREDENTIALS,  sizeof(Blynk_Credentials),  0) \
+  X(1, "tk",    "WiFi Token",         STR,  Blynk_Creds[0].blynk_token,   NUM_BLYNK_CREDENTIALS,  sizeof(Blynk_Credentials),  0) \
+  X(1, "pt",    "Port",               INT,  blynk_port,                   1,  0,  BLYNK_SERVER_HARDWARE_PORT) \
+  X(1, "rmin",  "Reconnect Min (s)",  INT,  reconnect_min,                1,  0,  RECONNECT_BACKOFF_MIN_MS / 1000) \
+  X(1, "rmax",  "Reconnect Max (s)",  INT,  reconnect_max,                1,  0,  RECONNECT_BACKOFF_MAX_MS / 1000) \
+  X(2, "bttk",  "BT Token",           STR,  blynk_bt_tk,                  1,  0,  0) \
+  X(2, "bltk",  "BLE Token",          STR,  blynk_ble_tk,                 1,  0,  0) \
+  X(3, "nm",    "Board Name",         STR,  board_name,                   1,  0,  0)
+
+#define BLYNK_WM_NUM_FIELDSETS    4
+
+// Max count of a schema field
+#define BLYNK_WM_MAX_FIELD_COUNT  ( (NUM_WIFI_CREDENTIALS > NUM_BLYNK_CREDENTIALS) ? NUM_WIFI_CREDENTIALS : NUM_BLYNK_CREDENTIALS )
+
+#define BLYNK_FIELD_STR           0
+#define BLYNK_FIELD_INT           1
+#define BLYNK_FIELD_SSID          2
+
+typedef struct
+{
+  const char* key;
+  const char* label;
+  uint8_t     fieldset;
+  uint8_t     type;
+  uint16_t    offset;
+  uint8_t     size;
+  uint8_t     count;
+  uint16_t    stride;
+  int         defaultValue;
+  uint32_t    hash;           // blynkKeyHash() of key
+} BlynkConfigField;
+
+#define BLYNK_WM_FIELD_ROW(fieldset, key, label, type, member, count, stride, dflt) \
+  { key, label, fieldset, BLYNK_FIELD_ ## type, offsetof(Blynk_WM_Configuration, member), \
+    sizeof(((Blynk_WM_Configuration*) 0)->member), count, stride, dflt, blynkKeyHash(key, sizeof(key) - 1) },
+
+#define BLYNK_WM_FIELD_COUNT(fieldset, key, label, type, member, count, stride, dflt)   + (count)
+
+// Configurable items excluding fixed Header and checkSum. Currently 14
+#define NUM_CONFIGURABLE_ITEMS    ( 0 BLYNK_WM_CONFIG_FIELDS(BLYNK_WM_FIELD_COUNT) )
+
+#if USE_DEEP_SLEEP_RESUME
+// Kept during deep sleep, lost on power-on or reset
+RTC_DATA_ATTR BlynkRtcSession         blynkRtcSession;
+RTC_DATA_ATTR Blynk_WM_Configuration  blynkRtcConfig;
+RTC_DATA_ATTR BlynkSleepTimings       blynkRtcLastCycle;
+#endif
+
+#if BLYNK_WM_CONFIG_PORTAL
 //From v1.0.5, Permit special chars such as # and %
 
 // -- HTML page fragments
 const char BLYNK_WM_HTML_HEAD[]     /*PROGMEM*/ = "<!DOCTYPE html><html><head><title>Blynk_Esp32_BT_BLE_WF</title><style>div,input{padding:2px;font-size:1em;}input{width:95%;}\
 body{text-align: center;}button{background-color:#16A1E7;color:#fff;line-height:2.4rem;font-size:1.2rem;width:100%;}fieldset{border-radius:0.5rem;margin:0px;}\
-</style></head><div style=\"text-align:left;display:inline-block;min-width:260px;\">\
-<fieldset><div><label>WiFi SSID</label><input value=\"[[id]]\"id=\"id\"><div></div></div>\
-<div><label>PWD</label><input value=\"[[pw]]\"id=\"pw\"><div></div></div>\
-<div><label>WiFi SSID1</label><input value=\"[[id1]]\"id=\"id1\"><div></div></div>\
-<div><label>PWD1</label><input value=\"[[pw1]]\"id=\"pw1\"><div></div></div></fieldset>\
-<fieldset><div><label>Blynk Server</label><input value=\"[[sv]]\"id=\"sv\"><div></div></div>\
-<div><label>WiFi Token</label><input value=\"[[tk]]\"id=\"tk\"><div></div></div>\
-<div><label>Blynk Server1</label><input value=\"[[sv1]]\"id=\"sv1\"><div></div></div>\
-<div><label>WiFi Token1</label><input value=\"[[tk1]]\"id=\"tk1\"><div></div></div>\
-<div><label>Port</label><input value=\"[[pt]]\"id=\"pt\"><div></div></div></fieldset>\
-<fieldset><div><label>BT Token</label><input value=\"[[bttk]]\"id=\"bttk\"><div></div></div>\
-<div><label>BLE Token</label><input value=\"[[bltk]]\"id=\"bltk\"><div></div></div></fieldset>\
-<fieldset><div><label>Board Name</label><input value=\"[[nm]]\"id=\"nm\"><div></div></div></fieldset>";
+</style></head><div style=\"text-align:left;display:inline-block;min-width:260px;\">";
 const char BLYNK_WM_FLDSET_START[]  /*PROGMEM*/ = "<fieldset>";
 const char BLYNK_WM_FLDSET_END[]    /*PROGMEM*/ = "</fieldset>";
-const char BLYNK_WM_HTML_PARAM[]    /*PROGMEM*/ = "<div><label>{b}</label><input value='[[{v}]]'id='{i}'><div></div></div>";
+// One input : LABEL label VALUE value ID id PARAM_END. Label and value are HTML-escaped.
+const char BLYNK_WM_HTML_LABEL[]      /*PROGMEM*/ = "<div><label>";
+const char BLYNK_WM_HTML_VALUE[]      /*PROGMEM*/ = "</label><input value=\"";
+const char BLYNK_WM_HTML_ID[]         /*PROGMEM*/ = "\"id=\"";
+// Instead of HTML_ID for SSID fields : suggests the scanned networks, free text still allowed
+const char BLYNK_WM_HTML_SSID_ID[]    /*PROGMEM*/ = "\"list=\"ssids\"id=\"";
+const char BLYNK_WM_HTML_PARAM_END[]  /*PROGMEM*/ = "\"><div></div></div>";
 const char BLYNK_WM_HTML_BUTTON[]   /*PROGMEM*/ = "<button onclick=\"sv()\">Save</button></div>";
+#if BLYNK_WM_WIFI_SCAN
+// Networks fetched from /scan once the page is shown. 202 : first scan not done yet, ask again.
+const char BLYNK_WM_HTML_SCRIPT[]   /*PROGMEM*/ = "<datalist id=\"ssids\"></datalist><script id=\"jsbin-javascript\">\
+function udVal(key,val){var request=new XMLHttpRequest();var url='/?key='+key+'&value='+encodeURIComponent(val);request.open('GET',url,false);request.send(null);}\
+function sc(){var r=new XMLHttpRequest();r.onload=function(){if(r.status==202){setTimeout(sc,2000);return;}var d=document.getElementById('ssids');\
+JSON.parse(r.responseText).forEach(function(a){var o=document.createElement('option');o.value=a[0];o.textContent=a[1]+'dBm'+(a[2]?'':' open');d.appendChild(o);});};\
+r.open('GET','/scan',true);r.send(null);}sc();\
+function sv(){";
+#else
 const char BLYNK_WM_HTML_SCRIPT[]   /*PROGMEM*/ = "<script id=\"jsbin-javascript\">\
 function udVal(key,val){var request=new XMLHttpRequest();var url='/?key='+key+'&value='+encodeURIComponent(val);request.open('GET',url,false);request.send(null);}\
-function sv(){udVal('id',document.getElementById('id').value);udVal('pw',document.getElementById('pw').value);\
-udVal('id1',document.getElementById('id1').value);udVal('pw1',document.getElementById('pw1').value);\
-udVal('sv',document.getElementById('sv').value);udVal('tk',document.getElementById('tk').value);\
-udVal('sv1',document.getElementById('sv1').value);udVal('tk1',document.getElementById('tk1').value);\
-udVal('bttk',document.getElementById('bttk').value);udVal('bltk',document.getElementById('bltk').value);\
-udVal('pt',document.getElementById('pt').value);udVal('nm',document.getElementById('nm').value);";
-
-const char BLYNK_WM_HTML_SCRIPT_ITEM[]  /*PROGMEM*/ = "udVal('{d}',document.getElementById('{d}').value);";
+function sv(){";
+#endif
+
+// One udVal() per input : SCRIPT_ITEM id SCRIPT_GET id SCRIPT_ITEM_END
+const char BLYNK_WM_HTML_SCRIPT_ITEM[]      /*PROGMEM*/ = "udVal('";
+const char BLYNK_WM_HTML_SCRIPT_GET[]       /*PROGMEM*/ = "',document.getElementById('";
+const char BLYNK_WM_HTML_SCRIPT_ITEM_END[]  /*PROGMEM*/ = "').value);";
 const char BLYNK_WM_HTML_SCRIPT_END[]   /*PROGMEM*/ = "alert('Updated');}</script>";
 const char BLYNK_WM_HTML_END[]          /*PROGMEM*/ = "</html>";
+
+// The page is sent by chunks of this size, never built whole in RAM
+#ifndef BLYNK_WM_HTML_CHUNK_LEN
+#define BLYNK_WM_HTML_CHUNK_LEN     256
+#endif
 ///
+#endif    // BLYNK_WM_CONFIG_PORTAL
 
 #define BLYNK_SERVER_HARDWARE_PORT    8080
 
 #define BLYNK_BOARD_TYPE      "ESP32_WFM"
 #define NO_CONFIG             "blank"
 
+const BlynkConfigField BLYNK_WM_CONFIG_SCHEMA[] = { BLYNK_WM_CONFIG_FIELDS(BLYNK_WM_FIELD_ROW) };
+
+#define BLYNK_WM_NUM_FIELDS       ( sizeof(BLYNK_WM_CONFIG_SCHEMA) / sizeof(BLYNK_WM_CONFIG_SCHEMA[0]) )
+
 class BlynkWifi
   : public BlynkProtocol<BlynkArduinoClient>
 {
@@ -168,13 +311,13 @@ class BlynkWifi
 
     void connectWiFi(const char* ssid, const char* pass)
     {
-      BLYNK_LOG2(BLYNK_F("Con2:"), ssid);
+      BLYNK_WM_LOGI(BLYNK_F("Con2:"), ssid);
       WiFi.mode(WIFI_STA);
 
       // New from Blynk_WM v1.0.5
       if (static_IP != IPAddress(0, 0, 0, 0))
       {
-        BLYNK_LOG1(BLYNK_F("UseStatIP"));
+        BLYNK_WM_LOGI(BLYNK_F("UseStatIP"));
         WiFi.config(static_IP, static_GW, static_SN, static_DNS1, static_DNS2);
       }
       
@@ -195,7 +338,7 @@ class BlynkWifi
         BlynkDelay(500);
       }
 
-      BLYNK_LOG1(BLYNK_F("Conn2WiFi"));
+      BLYNK_WM_LOGI(BLYNK_F("Conn2WiFi"));
       displayWiFiData();
     }
 
@@ -255,34 +398,31 @@ class BlynkWifi
 
       WiFi.mode(WIFI_STA);
 
-      if (iHostname[0] == 0)
-      {
-        String _hostname = "ESP32-" + String((uint32_t)ESP.getEfuseMac(), HEX);
-        _hostname.toUpperCase();
+      initHostname(iHostname);
 
-        getRFC952_hostname(_hostname.c_str());
-
-      }
-      else
-      {
-        // Prepare and store the hostname only not NULL
-        getRFC952_hostname(iHostname);
-      }
+      reconnectPolicy.begin(ESP.getEfuseMac());
 
-      BLYNK_LOG2(BLYNK_F("Hostname="), RFC952_hostname);
+#if BLYNK_WM_CONFIG_PORTAL
+      buildPortalKeys();
+#endif
 
       if (getConfigData())
       {
+        DEEP_SLEEP_MARK(SLEEP_PHASE_CONFIG);
+
         hadConfigData = true;
+
+        updateUsableServers();
+
+        reconnectPolicy.setLimitsSeconds(BlynkESP32_WM_config.reconnect_min, BlynkESP32_WM_config.reconnect_max);
         
-        for (int i = 0; i < NUM_WIFI_CREDENTIALS; i++)
-        {
-          wifiMulti.addAP(BlynkESP32_WM_config.WiFi_Creds[i].wifi_ssid, BlynkESP32_WM_config.WiFi_Creds[i].wifi_pw);
-        }
+        addWiFiMultiAPs();
 
         if (connectMultiWiFi())
         {
-          BLYNK_LOG1(BLYNK_F("b:WOK.TryB"));
+          BLYNK_WM_LOGI(BLYNK_F("b:WOK.TryB"));
+
+          DEEP_SLEEP_MARK(SLEEP_PHASE_WIFI);
 
           int i = 0;
           while ( (i++ < 10) && !connectMultiBlynk() )
@@ -291,30 +431,145 @@ class BlynkWifi
 
           if (connected())
           {
-            BLYNK_LOG1(BLYNK_F("b:WBOK"));
+            DEEP_SLEEP_MARK(SLEEP_PHASE_BLYNK);
+
+            BLYNK_WM_LOGI(BLYNK_F("b:WBOK"));
           }
           else
           {
-            BLYNK_LOG1(BLYNK_F("b:WOK,BNot"));
+            BLYNK_WM_LOGW(BLYNK_F("b:WOK,BNot"));
             // failed to connect to Blynk server, will start configuration mode
             startConfigurationMode();
           }
         }
         else
         {
-          BLYNK_LOG1(BLYNK_F("b:FailW+B"));
+          BLYNK_WM_LOGE(BLYNK_F("b:FailW+B"));
           // failed to connect to Blynk server, will start configuration mode
           startConfigurationMode();
         }
       }
       else
       {
-        BLYNK_LOG1(BLYNK_F("b:Nodat.Stay"));
+#if BLYNK_WM_CONFIG_PORTAL
+        BLYNK_WM_LOGW(BLYNK_F("b:Nodat.Stay"));
+#else
+        // Nothing else can provide it
+        BLYNK_WM_LOGE(BLYNK_F("b:Nodat.NoPortal.CallSetConfig"));
+#endif
         // failed to connect to Blynk server, will start configuration mode
         hadConfigData = false;
         startConfigurationMode();
       }
+
+      // Before the sketch's setup() goes on, or crashes
+      BLYNK_WM_LOG_DRAIN();
+    }
+
+    // Stores the credentials of entry index, as the Config Portal does. The only way to configure a board built
+    // without the Config Portal : call it before begin(), e.g. with credentials from the sketch. Saved only when
+    // they differ from the stored ones, so it can run at every boot.
+    bool setConfig(const char* ssid, const char* pass, const char* server, const char* token, uint8_t index = 0)
+    {
+      if ( (index >= NUM_WIFI_CREDENTIALS) || (index >= NUM_BLYNK_CREDENTIALS) )
+        return false;
+
+      // Loads the stored data, or initializes it with the defaults
+      getConfigData();
+
+      WiFi_Credentials&   wifi    = BlynkESP32_WM_config.WiFi_Creds[index];
+      Blynk_Credentials&  blynk   = BlynkESP32_WM_config.Blynk_Creds[index];
+      bool                changed = false;
+
+      changed |= setConfigString(wifi.wifi_ssid,      sizeof(wifi.wifi_ssid),     ssid);
+      changed |= setConfigString(wifi.wifi_pw,        sizeof(wifi.wifi_pw),       pass);
+      changed |= setConfigString(blynk.blynk_server,  sizeof(blynk.blynk_server), server);
+      changed |= setConfigString(blynk.blynk_token,   sizeof(blynk.blynk_token),  token);
+
+      if (changed)
+      {
+        BLYNK_WM_LOGI(BLYNK_F("SetCfg#"), index);
+        saveConfigData();
+      }
+
+      return true;
+    }
+
+#if USE_DEEP_SLEEP_RESUME
+    // Call in setup() instead of begin(iHostname). After a deep-sleep wake-up, joins the AP and Blynk server stored
+    // by sleep() directly. Otherwise, or if that fails, runs the full begin(). Returns true if the session was resumed.
+    bool resume(const char *iHostname = "")
+    {
+      bool woke = (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_UNDEFINED);
+
+      sleepTimings.reset(true);
+
+      if (woke)
+      {
+        initHostname(iHostname);
+
+        reconnectPolicy.begin(ESP.getEfuseMac());
+
+        if (resumeSession())
+        {
+          BLYNK_WM_LOGI(BLYNK_F("DS:Resumed#"), blynkRtcSession.numResumes, BLYNK_F(",ms="), millis());
+          BLYNK_WM_LOG_DRAIN();
+          return true;
+        }
+      }
+
+      // Cold boot or stale session : full begin() stores a fresh one at the next sleep()
+      blynkRtcSession.magic = 0;
+
+      sleepTimings.reset(false);
+      begin(iHostname);
+
+      return false;
+    }
+
+    // Keep the current session in RTC memory, close the links and deep sleep for sleep_us. Doesn't return.
+    void sleep(uint64_t sleep_us)
+    {
+      DEEP_SLEEP_MARK(SLEEP_PHASE_PUBLISH);
+
+      saveSession(sleep_us);
+
+      blynkRtcLastCycle = sleepTimings;
+
+      // Let the last writes leave before FIN
+      Base::run();
+      delay(DEEP_SLEEP_FLUSH_MS);
+      disconnect();
+
+      WiFi.disconnect(true);
+      WiFi.mode(WIFI_OFF);
+
+      BLYNK_WM_LOGI(BLYNK_F("DS:Sleep,ms="), millis());
+      BLYNK_WM_LOG_DRAIN();
+
+      esp_sleep_enable_timer_wakeup(sleep_us);
+      esp_deep_sleep_start();
+    }
+
+    // Timings of this wake cycle, up to the last finished phase
+    const BlynkSleepTimings& getSleepTimings()
+    {
+      return sleepTimings;
+    }
+
+    // Timings of the previous cycle, valid after a deep-sleep wake-up
+    const BlynkSleepTimings& getLastCycle()
+    {
+      return blynkRtcLastCycle;
+    }
+
+    // True while the Config Portal must stay up : no config data yet, or a user is on the config page.
+    // Otherwise a cycle without a link can go back to sleep and retry later.
+    bool isConfigPortalHeld()
+    {
+      return configuration_mode && (configTimeout == 0);
     }
+#endif
 
 #ifndef TIMEOUT_RECONNECT_WIFI
 #define TIMEOUT_RECONNECT_WIFI   10000L
@@ -354,6 +609,20 @@ class BlynkWifi
     {
       static int retryTimes = 0;
 
+      BLYNK_TRACE_SCOPE("WF.run");
+
+      // Logs of begin() and of the previous run()
+      BLYNK_WM_LOG_DRAIN();
+
+#if BLYNK_WM_WIFI_SCAN
+      // Also after the portal is closed, to free the results of a scan that was still running
+      scanCache.run();
+#endif
+
+#if USE_RUN_WATCHDOG
+      BlynkRunWatchdog::Scope runWatchdogScope(runWatchdog);
+#endif
+
       // Lost connection in running. Give chance to reconfig.
       if ( WiFi.status() != WL_CONNECTED || !connected() )
       {
@@ -363,13 +632,31 @@ class BlynkWifi
         {
           retryTimes = 0;
 
+#if BLYNK_WM_CONFIG_PORTAL
           if (server)
+          {
+            BLYNK_TRACE_SCOPE("WF.handleClient");
+            RUN_WATCHDOG_MARK("handleClient");
             server->handleClient();
+          }
+#endif
 
           return;
         }
         else
         {
+#if !BLYNK_WM_CONFIG_PORTAL
+          // No credentials to try, until setConfig() and begin()
+          if (!hadConfigData)
+            return;
+#endif
+
+          // Spread reconnects of a fleet in time. Nothing to run in Base while not connected.
+          reconnectPolicy.lost();
+
+          if (!reconnectPolicy.due())
+            return;
+
 #if RESET_IF_CONFIG_TIMEOUT
           // If we're here but still in configuration_mode, permit running TIMES_BEFORE_RESET times before reset hardware
           // to permit user another chance to config.
@@ -377,10 +664,11 @@ class BlynkWifi
           {
             if (++retryTimes <= CONFIG_TIMEOUT_RETRYTIMES_BEFORE_RESET)
             {
-              BLYNK_LOG2(BLYNK_F("r:Wlost&TOut.ConW+B.Retry#"), retryTimes);
+              BLYNK_WM_LOGW(BLYNK_F("r:Wlost&TOut.ConW+B.Retry#"), retryTimes);
             }
             else
             {
+              BLYNK_WM_LOG_DRAIN();
               ESP.restart();
             }
           }
@@ -389,50 +677,86 @@ class BlynkWifi
           // Not in config mode, try reconnecting before force to config mode
           if ( WiFi.status() != WL_CONNECTED )
           {
-            BLYNK_LOG1(BLYNK_F("r:Wlost.ReconW+B"));
+            BLYNK_WM_LOGW(BLYNK_F("r:Wlost.ReconW+B"));
+
+            RUN_WATCHDOG_MARK("connectMultiWiFi");
             
             if (connectMultiWiFi())
             {
               // turn the LED_BUILTIN OFF to tell us we exit configuration mode.
               digitalWrite(LED_BUILTIN, LED_OFF);
 
-              BLYNK_LOG1(BLYNK_F("r:WOK.TryB"));
+              BLYNK_WM_LOGI(BLYNK_F("r:WOK.TryB"));
+
+              RUN_WATCHDOG_MARK("connectMultiBlynk");
 
-               if (connectMultiBlynk())
+              if (connectMultiBlynk())
               {
-                BLYNK_LOG1(BLYNK_F("r:W+BOK"));
+                BLYNK_WM_LOGI(BLYNK_F("r:W+BOK"));
               }
             }
           }
           else
           {
-            BLYNK_LOG1(BLYNK_F("r:Blost.TryB"));
+            BLYNK_WM_LOGW(BLYNK_F("r:Blost.TryB"));
+
+            RUN_WATCHDOG_MARK("connectMultiBlynk");
 
             if (connectMultiBlynk())
             {
               // turn the LED_BUILTIN OFF to tell us we exit configuration mode.
               digitalWrite(LED_BUILTIN, LED_OFF);
 
-              BLYNK_LOG1(BLYNK_F("r:BOK"));
+              BLYNK_WM_LOGI(BLYNK_F("r:BOK"));
             }
           }
 
-          //BLYNK_LOG1(BLYNK_F("run: Lost connection => configMode"));
+          if ( (WiFi.status() == WL_CONNECTED) && connected() )
+          {
+            reconnectPolicy.succeeded();
+          }
+          else
+          {
+            reconnectPolicy.failed();
+            BLYNK_WM_LOGD(BLYNK_F("r:Backoff#"), reconnectPolicy.getAttempt(), BLYNK_F(",ms="), reconnectPolicy.getWaitTime());
+          }
+
+          //BLYNK_WM_LOGI(BLYNK_F("run: Lost connection => configMode"));
           //startConfigurationMode();
         }
       }
       else if (configuration_mode)
       {
         configuration_mode = false;
-        BLYNK_LOG1(BLYNK_F("r:gotW+Bback"));
+        BLYNK_WM_LOGI(BLYNK_F("r:gotW+Bback"));
+
+        stopConfigurationMode();
+
         // Turn the LED_BUILTIN OFF when out of configuration mode. ESP32 LED_BUILDIN is correct polarity, LOW to turn OFF
         digitalWrite(LED_BUILTIN, LED_OFF);
       }
+      else if (serverSelector.shouldReprobe())
+      {
+        RUN_WATCHDOG_MARK("reprobePreferredServer");
+        reprobePreferredServer();
+      }
+
+#if USE_WIFI_ROAMING
+      // Must be checked before Base::run() consumes the reply
+      checkRttProbe();
+#endif
 
       //if (connected())
       {
+        BLYNK_TRACE_SCOPE("WF.protocol");
+        RUN_WATCHDOG_MARK("protocol");
         Base::run();
       }
+
+#if USE_WIFI_ROAMING
+      RUN_WATCHDOG_MARK("linkMonitor");
+      runLinkMonitor();
+#endif
     }
 
     void setHostname(void)
@@ -450,10 +774,10 @@ class BlynkWifi
       portal_apIP = portalIP;
     }
 
-    void setConfigPortal(String ssid = "", String pass = "")
+    void setConfigPortal(const char* ssid = "", const char* pass = "")
     {
-      portal_ssid = ssid;
-      portal_pass = pass;
+      strncpy(portal_ssid, ssid, sizeof(portal_ssid) - 1);
+      strncpy(portal_pass, pass, sizeof(portal_pass) - 1);
     }
 
 #define MIN_WIFI_CHANNEL      1
@@ -493,72 +817,73 @@ class BlynkWifi
         static_DNS2   = dns_address_2;
     }
 
-    String getWiFiSSID(uint8_t index)
+    // Getters point into the config data, valid until the next change of it
+    const char* getWiFiSSID(uint8_t index)
     { 
       if (index >= NUM_WIFI_CREDENTIALS)
-        return String("");
+        return "";
         
       if (!hadConfigData)
         getConfigData();
 
-      return (String(BlynkESP32_WM_config.WiFi_Creds[index].wifi_ssid));
+      return (BlynkESP32_WM_config.WiFi_Creds[index].wifi_ssid);
     }
 
-    String getWiFiPW(uint8_t index)
+    const char* getWiFiPW(uint8_t index)
     {
       if (index >= NUM_WIFI_CREDENTIALS)
-        return String("");
+        return "";
         
       if (!hadConfigData)
         getConfigData();
 
-      return (String(BlynkESP32_WM_config.WiFi_Creds[index].wifi_pw));
+      return (BlynkESP32_WM_config.WiFi_Creds[index].wifi_pw);
     }
 
-    String getServerName(uint8_t index)
+    const char* getServerName(uint8_t index)
     {
       if (index >= NUM_BLYNK_CREDENTIALS)
-        return String("");
+        return "";
 
       if (!hadConfigData)
         getConfigData();
 
-      return (String(BlynkESP32_WM_config.Blynk_Creds[index].blynk_server));
+      return (BlynkESP32_WM_config.Blynk_Creds[index].blynk_server);
     }
 
-    String getToken(uint8_t index)
+    const char* getToken(uint8_t index)
     {
       if (index >= NUM_BLYNK_CREDENTIALS)
-        return String("");
+        return "";
 
       if (!hadConfigData)
         getConfigData();
 
-      return (String(BlynkESP32_WM_config.Blynk_Creds[index].blynk_token));
+      return (BlynkESP32_WM_config.Blynk_Creds[index].blynk_token);
     }
 
-    String getBlynkBTToken(void)
+    const char* getBlynkBTToken(void)
     {
       if (!hadConfigData)
         getConfigData();
 
-      return (String(BlynkESP32_WM_config.blynk_bt_tk));
+      return (BlynkESP32_WM_config.blynk_bt_tk);
     }
 
-    String getBlynkBLEToken(void)
+    const char* getBlynkBLEToken(void)
     {
       if (!hadConfigData)
         getConfigData();
 
-      return (String(BlynkESP32_WM_config.blynk_ble_tk));
+      return (BlynkESP32_WM_config.blynk_ble_tk);
     }
 
-    String getBoardName()
+    const char* getBoardName()
     {
       if (!hadConfigData)
         getConfigData();
 
-      return (String(BlynkESP32_WM_config.board_name));
+      return (BlynkESP32_WM_config.board_name);
     }
 
     int getHWPort()
@@ -588,11 +913,136 @@ class BlynkWifi
       saveConfigData();
     }
 
+    // Number of Blynk servers entered in Config Portal, up to NUM_BLYNK_CREDENTIALS
+    uint8_t getNumBlynkCredentials()
+    {
+      return serverSelector.getNumUsable();
+    }
+
+    // Index in Blynk_Creds of the server currently connected, or BLYNK_SERVER_NONE
+    int8_t getCurrentServer()
+    {
+      return serverSelector.getCurrent();
+    }
+
+    // Static RAM of the optional parts built in, and flash of the Config Portal page text, in bytes. Code size is only
+    // in the build output : compare it with and without a flag of BlynkEsp32_Features.h.
+    void printFeatureCost(Print& out)
+    {
+      out.print(F("Feat:BlynkWifi="));
+      out.print(sizeof(BlynkWifi));
+      out.print(F(",Cfg="));
+      out.print(sizeof(BlynkESP32_WM_config));
+#if BLYNK_WM_CONFIG_PORTAL
+      out.print(F(",Portal="));
+      out.print(sizeof(portalServer) + sizeof(portalKeys) + sizeof(htmlChunk));
+      out.print(F(",HTML="));
+      out.print(sizeof(BLYNK_WM_HTML_HEAD) + sizeof(BLYNK_WM_HTML_SCRIPT) + sizeof(BLYNK_WM_HTML_BUTTON) +
+                sizeof(BLYNK_WM_HTML_SCRIPT_END) + sizeof(BLYNK_WM_HTML_END));
+#endif
+#if BLYNK_WM_WIFI_SCAN
+      out.print(F(",Scan="));
+      out.print(sizeof(scanCache));
+#endif
+#if (BLYNK_WM_LOG_LEVEL > BLYNK_LOG_LEVEL_NONE)
+      out.print(F(",Log="));
+      out.print(sizeof(BlynkLogger));
+#endif
+#if USE_RUN_WATCHDOG
+      out.print(F(",Watchdog="));
+      out.print(sizeof(runWatchdog));
+#endif
+#if USE_WIFI_ROAMING
+      out.print(F(",Roaming="));
+      out.print(sizeof(linkMonitor));
+#endif
+#if USE_DEEP_SLEEP_RESUME
+      out.print(F(",RTC="));
+      out.print(sizeof(blynkRtcSession) + sizeof(blynkRtcConfig) + sizeof(blynkRtcLastCycle));
+#endif
+      out.println();
+    }
+
+    void printServerHealth(Print& out)
+    {
+      serverSelector.print(out);
+    }
+
+    // Bytes exchanged with the Blynk server since boot
+    const BlynkTrafficCounter& getTraffic();
+
+#if USE_WIFI_ROAMING
+    // Smoothed RSSI of the current AP, LINK_RSSI_UNKNOWN if not sampled yet
+    int16_t getLinkRSSI()
+    {
+      return linkMonitor.getRSSI();
+    }
+
+    // Smoothed Blynk round-trip time in ms, 0 if not measured yet
+    uint32_t getLinkRTT()
+    {
+      return linkMonitor.getRTT();
+    }
+
+    uint16_t getNumHandovers()
+    {
+      return linkMonitor.getNumHandovers();
+    }
+#endif
+
+#if USE_RUN_WATCHDOG
+    // Fire callback whenever one run() call takes longer than budget_ms
+    void setRunWatchdog(uint32_t budget_ms, BlynkRunWatchdogCallback callback = NULL)
+    {
+      runWatchdog.setBudget(budget_ms);
+      runWatchdog.setCallback(callback);
+    }
+
+    BlynkRunWatchdog& getRunWatchdog()
+    {
+      return runWatchdog;
+    }
+#endif
+
   private:
-    WebServer *server;
+#if BLYNK_WM_CONFIG_PORTAL
+    // In portalServer while the Config Portal runs, else NULL
+    WebServer *server = NULL;
+    BlynkStaticSlot<WebServer> portalServer;
+
+    BlynkKeyTable portalKeys;
+
+#if BLYNK_WM_WIFI_SCAN
+    BlynkScanCache scanCache;
+#endif
+
+    char          htmlChunk[BLYNK_WM_HTML_CHUNK_LEN];
+    uint16_t      htmlChunkLen = 0;
+    // Menu items beyond are not in portalKeys
+    int           numHashedMenuItems = 0;
+#endif
+
+#if USE_RUN_WATCHDOG
+    BlynkRunWatchdog runWatchdog;
+#endif
+
+    BlynkReconnectPolicy reconnectPolicy;
+
+#if USE_WIFI_ROAMING
+    BlynkLinkMonitor linkMonitor;
+    uint32_t rttProbe_ms = 0;
+#endif
+
+#if USE_DEEP_SLEEP_RESUME
+    BlynkSleepTimings sleepTimings;
+    bool leaseRenewed = false;
+#endif
+
+    BlynkServerSelector<NUM_BLYNK_CREDENTIALS> serverSelector;
     bool configuration_mode = false;
     
     WiFiMulti wifiMulti;
+    bool wifiMultiAPsAdded = false;
 
     unsigned long configTimeout;
     bool hadConfigData = false;
@@ -607,8 +1057,8 @@ class BlynkWifi
     // For Config Portal, from Blynk_WM v1.0.5
     IPAddress portal_apIP = IPAddress(192, 168, 4, 1);
 
-    String portal_ssid = "";
-    String portal_pass = "";
+    char portal_ssid[SSID_MAX_LEN] = "";
+    char portal_pass[PASS_MAX_LEN] = "";
 
     // For static IP, from Blynk_WM v1.0.5
     IPAddress static_IP   = IPAddress(0, 0, 0, 0);
@@ -643,127 +1093,556 @@ class BlynkWifi
       return RFC952_hostname;
     }
 
-    void displayConfigData(void)
-    {
-      BLYNK_LOG4(BLYNK_F("Hdr="),        BlynkESP32_WM_config.header,
-                 BLYNK_F(",BrdName="),   BlynkESP32_WM_config.board_name);
-      BLYNK_LOG4(BLYNK_F("SSID="),       BlynkESP32_WM_config.WiFi_Creds[0].wifi_ssid,
-                 BLYNK_F(",PW="),        BlynkESP32_WM_config.WiFi_Creds[0].wifi_pw);
-      BLYNK_LOG4(BLYNK_F("SSID1="),      BlynkESP32_WM_config.WiFi_Creds[1].wifi_ssid,
-                 BLYNK_F(",PW1="),       BlynkESP32_WM_config.WiFi_Creds[1].wifi_pw);
-      BLYNK_LOG4(BLYNK_F("Server="),     BlynkESP32_WM_config.Blynk_Creds[0].blynk_server,
-                 BLYNK_F(",Token="),     BlynkESP32_WM_config.Blynk_Creds[0].blynk_token);
-      BLYNK_LOG4(BLYNK_F("Server1="),    BlynkESP32_WM_config.Blynk_Creds[1].blynk_server,
-                 BLYNK_F(",Token1="),    BlynkESP32_WM_config.Blynk_Creds[1].blynk_token);
-      BLYNK_LOG4(BLYNK_F("BT-Token="),   BlynkESP32_WM_config.blynk_bt_tk, 
-                 BLYNK_F(",BLE-Token="), BlynkESP32_WM_config.blynk_ble_tk);                 
-      BLYNK_LOG2(BLYNK_F("Port="),       BlynkESP32_WM_config.blynk_port);     
-    }
-       
-    void displayWiFiData(void)
+    void initHostname(const char* iHostname)
     {
-      BLYNK_LOG6(BLYNK_F("IP="), WiFi.localIP().toString(), BLYNK_F(",GW="), WiFi.gatewayIP().toString(),
-                   BLYNK_F(",SN="), WiFi.subnetMask().toString());
-      BLYNK_LOG4(BLYNK_F("DNS1="), WiFi.dnsIP(0).toString(), BLYNK_F(",DNS2="), WiFi.dnsIP(1).toString());
-    }
+      if (iHostname[0] == 0)
+      {
+        char _hostname[16];
 
-    int calcChecksum()
-    {
-      int checkSum = 0;
-      for (uint16_t index = 0; index < (sizeof(BlynkESP32_WM_config) - sizeof(BlynkESP32_WM_config.checkSum)); index++)
+        snprintf(_hostname, sizeof(_hostname), "ESP32-%X", (unsigned int) ESP.getEfuseMac());
+
+        getRFC952_hostname(_hostname);
+
+      }
+      else
       {
-        checkSum += * ( ( (byte*) &BlynkESP32_WM_config ) + index);
+        // Prepare and store the hostname only not NULL
+        getRFC952_hostname(iHostname);
       }
 
-      return checkSum;
+      BLYNK_WM_LOGI(BLYNK_F("Hostname="), RFC952_hostname);
     }
 
-#if USE_SPIFFS
+    // Bounded copy into the config data. True if it changed.
+    bool setConfigString(char* data, size_t size, const char* value)
+    {
+      if (!value || !strncmp(data, value, size - 1))
+        return false;
 
-#define  CONFIG_FILENAME              BLYNK_F("/wfm_config.dat")
-#define  CONFIG_FILENAME_BACKUP       BLYNK_F("/wfm_config.bak")
+      strncpy(data, value, size - 1);
+      data[size - 1] = 0;
 
-#define  CREDENTIALS_FILENAME         BLYNK_F("/wm_cred.dat")
-#define  CREDENTIALS_FILENAME_BACKUP  BLYNK_F("/wm_cred.bak")
+      return true;
+    }
 
-    bool loadCredentials(void)
+    // Address of entry index of a schema field in BlynkESP32_WM_config
+    char* getFieldData(const BlynkConfigField& field, uint8_t index)
     {
-      int checkSum = 0;
-      int readCheckSum;
-      totalDataSize = sizeof(BlynkESP32_WM_config) + sizeof(readCheckSum);
-      
-      File file = SPIFFS.open(CREDENTIALS_FILENAME, "r");
-      BLYNK_LOG1(BLYNK_F("LoadCredFile "));
+      return ( (char*) &BlynkESP32_WM_config ) + field.offset + (index * field.stride);
+    }
 
-      if (!file)
-      {
-        BLYNK_LOG1(BLYNK_F("failed"));
+    void setDefaultConfigData(void)
+    {
+      BlynkESP32_WM_config.version = BLYNK_WM_CONFIG_VERSION;
 
-        // Trying open redundant config file
-        file = SPIFFS.open(CREDENTIALS_FILENAME_BACKUP, "r");
-        BLYNK_LOG1(BLYNK_F("LoadBkUpCredFile "));
+      for (uint8_t f = 0; f < BLYNK_WM_NUM_FIELDS; f++)
+      {
+        const BlynkConfigField& field = BLYNK_WM_CONFIG_SCHEMA[f];
 
-        if (!file)
+        for (uint8_t i = 0; i < field.count; i++)
         {
-          BLYNK_LOG1(BLYNK_F("failed"));
-          return false;
+          if (field.type == BLYNK_FIELD_INT)
+            * (int*) getFieldData(field, i) = field.defaultValue;
+          else
+            strcpy(getFieldData(field, i), NO_CONFIG);
         }
       }
-     
-      for (int i = 0; i < NUM_MENU_ITEMS; i++)
-      {       
-        char* _pointer = myMenuItems[i].pdata;
-        totalDataSize += myMenuItems[i].maxlen;
-        
-        // Actual size of pdata is [maxlen + 1]
-        memset(myMenuItems[i].pdata, 0, myMenuItems[i].maxlen + 1);
-        
-        file.readBytes(_pointer, myMenuItems[i].maxlen);
-               
-        for (uint16_t j = 0; j < myMenuItems[i].maxlen; j++,_pointer++)
-        {         
-          checkSum += *_pointer;  
-        }       
+    }
+
+    void displayConfigData(void)
+    {
+      BLYNK_WM_LOGD(BLYNK_F("Hdr="),        BlynkESP32_WM_config.header,
+                 BLYNK_F(",BrdName="),   BlynkESP32_WM_config.board_name);
+
+      for (int i = 0; i < NUM_WIFI_CREDENTIALS; i++)
+      {
+        BLYNK_WM_LOGD(BLYNK_F("SSID"),      i, BLYNK_F("="), BlynkESP32_WM_config.WiFi_Creds[i].wifi_ssid,
+                   BLYNK_F(",PW="),      BlynkESP32_WM_config.WiFi_Creds[i].wifi_pw);
       }
 
-      file.readBytes((char *) &readCheckSum, sizeof(readCheckSum));
-      
-      BLYNK_LOG1(BLYNK_F("OK"));
-      file.close();
-      
-      BLYNK_LOG4(F("CrCCSum=0x"), String(checkSum, HEX), F(",CrRCSum=0x"), String(readCheckSum, HEX));
-      
-      if ( checkSum != readCheckSum)
+      for (int i = 0; i < NUM_BLYNK_CREDENTIALS; i++)
       {
-        return false;
+        BLYNK_WM_LOGD(BLYNK_F("Server"),    i, BLYNK_F("="), BlynkESP32_WM_config.Blynk_Creds[i].blynk_server,
+                   BLYNK_F(",Token="),   BlynkESP32_WM_config.Blynk_Creds[i].blynk_token);
       }
-      
-      return true;    
-    }
 
-    void saveCredentials(void)
-    {
-      int checkSum = 0;
-    
+      BLYNK_WM_LOGD(BLYNK_F("BT-Token="),   BlynkESP32_WM_config.blynk_bt_tk, 
+                 BLYNK_F(",BLE-Token="), BlynkESP32_WM_config.blynk_ble_tk);                 
+      BLYNK_WM_LOGD(BLYNK_F("Port="),       BlynkESP32_WM_config.blynk_port);     
+      BLYNK_WM_LOGD(BLYNK_F("ReconMin="),   BlynkESP32_WM_config.reconnect_min,
+                 BLYNK_F(",ReconMax="),  BlynkESP32_WM_config.reconnect_max);
+    }
+       
+    void displayWiFiData(void)
+    {
+      BLYNK_WM_LOGI(BLYNK_F("IP="), WiFi.localIP(), BLYNK_F(",GW="), WiFi.gatewayIP(),
+                   BLYNK_F(",SN="), WiFi.subnetMask());
+      BLYNK_WM_LOGI(BLYNK_F("DNS1="), WiFi.dnsIP(0), BLYNK_F(",DNS2="), WiFi.dnsIP(1));
+    }
+
+    // SSID entered, SSID and PW not blank. Empty PW is permitted for open APs.
+    bool isWiFiCredValid(uint8_t index)
+    {
+      WiFi_Credentials& cred = BlynkESP32_WM_config.WiFi_Creds[index];
+
+      return ( (cred.wifi_ssid[0] != 0) && strncmp(cred.wifi_ssid, NO_CONFIG, strlen(NO_CONFIG)) &&
+               strncmp(cred.wifi_pw, NO_CONFIG, strlen(NO_CONFIG)) );
+    }
+
+    // Once only : WiFiMulti keeps each AP added, and resume() falls back to begin() after adding them
+    void addWiFiMultiAPs()
+    {
+      if (wifiMultiAPsAdded)
+        return;
+
+      for (int i = 0; i < NUM_WIFI_CREDENTIALS; i++)
+      {
+        if (isWiFiCredValid(i))
+          wifiMulti.addAP(BlynkESP32_WM_config.WiFi_Creds[i].wifi_ssid, BlynkESP32_WM_config.WiFi_Creds[i].wifi_pw);
+      }
+
+      wifiMultiAPsAdded = true;
+    }
+
+    // Server and Token entered, not blank
+    bool isBlynkCredValid(uint8_t index)
+    {
+      Blynk_Credentials& cred = BlynkESP32_WM_config.Blynk_Creds[index];
+
+      return ( (cred.blynk_server[0] != 0) && (cred.blynk_token[0] != 0) &&
+               strncmp(cred.blynk_server, NO_CONFIG, strlen(NO_CONFIG)) && strncmp(cred.blynk_token, NO_CONFIG, strlen(NO_CONFIG)) );
+    }
+
+#if USE_WIFI_ROAMING
+    // Approximation : first bytes received after our ping. Ping is only sent when the link is quiet,
+    // so these bytes are normally its reply.
+    void checkRttProbe()
+    {
+      if (!rttProbe_ms)
+        return;
+
+      if (!connected())
+      {
+        rttProbe_ms = 0;
+      }
+      else if (conn.available() > 0)
+      {
+        linkMonitor.addRTT(millis() - rttProbe_ms);
+        rttProbe_ms = 0;
+      }
+      else if (millis() - rttProbe_ms > BLYNK_TIMEOUT_MS)
+      {
+        rttProbe_ms = 0;
+      }
+    }
+
+    void runLinkMonitor()
+    {
+      if ( (WiFi.status() != WL_CONNECTED) || !connected() )
+      {
+        if (linkMonitor.isScanning())
+        {
+          WiFi.scanDelete();
+        }
+
+        linkMonitor.reset();
+        rttProbe_ms = 0;
+
+        return;
+      }
+
+      if (linkMonitor.isSampleDue())
+      {
+        linkMonitor.sampleRSSI(WiFi.RSSI());
+      }
+
+      bool quiet = (rttProbe_ms == 0) && (conn.available() == 0);
+
+      if (quiet && linkMonitor.isRttProbeDue())
+      {
+        sendCmd(BLYNK_CMD_PING);
+        rttProbe_ms = millis();
+        linkMonitor.rttProbeSent();
+        return;
+      }
+
+      if (linkMonitor.isScanDue())
+      {
+        BLYNK_WM_LOGW(BLYNK_F("roam:WeakRSSI="), linkMonitor.getRSSI());
+
+        // Async, results polled in next calls
+        if (WiFi.scanNetworks(true) == WIFI_SCAN_RUNNING)
+          linkMonitor.scanStarted();
+      }
+      else if (linkMonitor.isScanning())
+      {
+        checkRoamScan();
+      }
+      else if (quiet && linkMonitor.isHandoverPending())
+      {
+        handover();
+      }
+    }
+
+    void checkRoamScan()
+    {
+      int n = WiFi.scanComplete();
+
+      if (n == WIFI_SCAN_RUNNING)
+        return;
+
+      uint8_t* currentBSSID = WiFi.BSSID();
+
+      for (int i = 0; i < n; i++)
+      {
+        // Read in place : WiFi.SSID(i) would build a String per AP
+        const wifi_ap_record_t* ap = (const wifi_ap_record_t*) WiFi.getScanInfoByIndex(i);
+
+        if (!ap)
+          continue;
+
+        for (uint8_t j = 0; j < NUM_WIFI_CREDENTIALS; j++)
+        {
+          if ( isWiFiCredValid(j) &&
+               !strncmp((const char*) ap->ssid, BlynkESP32_WM_config.WiFi_Creds[j].wifi_ssid, SSID_MAX_LEN) )
+          {
+            linkMonitor.considerAP(j, ap->rssi, ap->bssid, ap->primary, currentBSSID);
+          }
+        }
+      }
+
+      WiFi.scanDelete();
+
+      if (linkMonitor.scanDone())
+      {
+        const BlynkRoamTarget& target = linkMonitor.getTarget();
+
+        BLYNK_WM_LOGI(BLYNK_F("roam:Cand="), BlynkESP32_WM_config.WiFi_Creds[target.credIndex].wifi_ssid,
+                   BLYNK_F(",RSSI="), target.rssi, BLYNK_F(",Ch="), target.channel);
+      }
+    }
+
+    // Move to the planned AP, then reconnect Blynk. On failure, run() falls back to wifiMulti with backoff.
+    void handover()
+    {
+      BlynkRoamTarget target = linkMonitor.getTarget();
+      WiFi_Credentials& cred = BlynkESP32_WM_config.WiFi_Creds[target.credIndex];
+
+      BLYNK_WM_LOGI(BLYNK_F("roam:Handover.SSID="), cred.wifi_ssid, BLYNK_F(",RSSI="), target.rssi);
+
+      linkMonitor.handoverDone();
+
+      disconnect();
+      WiFi.disconnect();
+      WiFi.begin(cred.wifi_ssid, cred.wifi_pw, target.channel, target.bssid);
+
+      BLYNK_WM_LOG_DRAIN();
+
+      uint32_t start = millis();
+
+      while ( (WiFi.status() != WL_CONNECTED) && (millis() - start < ROAM_CONNECT_TIMEOUT_MS) )
+      {
+        delay(50);
+      }
+
+      if (WiFi.status() == WL_CONNECTED)
+      {
+        BLYNK_WM_LOGI(BLYNK_F("roam:WOK,ms="), millis() - start);
+        connectMultiBlynk();
+      }
+      else
+      {
+        BLYNK_WM_LOGE(BLYNK_F("roam:WFailed"));
+      }
+
+      linkMonitor.reset();
+    }
+#endif
+
+#if USE_DEEP_SLEEP_RESUME
+    // Same steps as begin(), with everything learnt on the last cycle : no config read, no scan, no DHCP,
+    // no server selection
+    bool resumeSession()
+    {
+      BlynkRtcSession& session = blynkRtcSession;
+
+      if ( (session.magic != DEEP_SLEEP_MAGIC) || (session.numResumes >= DEEP_SLEEP_MAX_RESUMES) )
+        return false;
+
+      memcpy(&BlynkESP32_WM_config, &blynkRtcConfig, sizeof(BlynkESP32_WM_config));
+
+      if ( (BlynkESP32_WM_config.checkSum != calcChecksum()) || (session.wifiIndex >= NUM_WIFI_CREDENTIALS) ||
+           (session.server < 0) || (session.server >= NUM_BLYNK_CREDENTIALS) )
+      {
+        BLYNK_WM_LOGW(BLYNK_F("DS:BadSession"));
+        return false;
+      }
+
+      hadConfigData = true;
+
+      updateUsableServers();
+
+      reconnectPolicy.setLimitsSeconds(BlynkESP32_WM_config.reconnect_min, BlynkESP32_WM_config.reconnect_max);
+
+      // Still needed by run() if the link is lost later in this cycle
+      addWiFiMultiAPs();
+
+      DEEP_SLEEP_MARK(SLEEP_PHASE_CONFIG);
+
+      WiFi_Credentials& cred = BlynkESP32_WM_config.WiFi_Creds[session.wifiIndex];
+
+      WiFi.mode(WIFI_STA);
+
+      // Reuse last DHCP lease, while it is surely still ours. Otherwise DHCP gets a fresh one, the rest is reused.
+      leaseRenewed = (session.leaseAge_s >= DEEP_SLEEP_DHCP_LEASE_S / 2);
+
+      if (leaseRenewed)
+        BLYNK_WM_LOGI(BLYNK_F("DS:RenewLease,s="), session.leaseAge_s);
+      else
+        WiFi.config(IPAddress(session.ip), IPAddress(session.gateway), IPAddress(session.subnet), IPAddress(session.dns));
+
+      if (RFC952_hostname[0] != 0)
+        WiFi.setHostname(RFC952_hostname);
+
+      WiFi.begin(cred.wifi_ssid, cred.wifi_pw, session.channel, session.bssid);
+
+      BLYNK_WM_LOG_DRAIN();
+
+      uint32_t start = millis();
+
+      while ( (WiFi.status() != WL_CONNECTED) && (millis() - start < DEEP_SLEEP_WIFI_TIMEOUT_MS) )
+      {
+        delay(10);
+      }
+
+      if (WiFi.status() != WL_CONNECTED)
+      {
+        BLYNK_WM_LOGE(BLYNK_F("DS:WiFiFail"));
+        WiFi.disconnect();
+        return false;
+      }
+
+      DEEP_SLEEP_MARK(SLEEP_PHASE_WIFI);
+
+      Blynk_Credentials& server = BlynkESP32_WM_config.Blynk_Creds[session.server];
+
+      config(server.blynk_token, server.blynk_server, BLYNK_SERVER_HARDWARE_PORT);
+
+      BLYNK_WM_LOG_DRAIN();
+
+      start = millis();
+
+      if (!connect(DEEP_SLEEP_BLYNK_TIMEOUT_MS))
+      {
+        BLYNK_WM_LOGE(BLYNK_F("DS:BlynkFail"));
+        serverSelector.failure(session.server);
+        WiFi.disconnect();
+        return false;
+      }
+
+      serverSelector.success(session.server, millis() - start);
+
+      DEEP_SLEEP_MARK(SLEEP_PHASE_BLYNK);
+
+      session.numResumes++;
+
+      return true;
+    }
+
+    // Only a session that is up right now is stored. sleep_us ages the lease.
+    void saveSession(uint64_t sleep_us)
+    {
+      BlynkRtcSession& session = blynkRtcSession;
+
+      session.magic = 0;
+
+      int8_t server = serverSelector.getCurrent();
+
+      if ( !connected() || (WiFi.status() != WL_CONNECTED) || (server == BLYNK_SERVER_NONE) )
+        return;
+
+      wifi_ap_record_t apInfo;
+
+      if (esp_wifi_sta_get_ap_info(&apInfo) != ESP_OK)
+        return;
+
+      uint8_t i;
+
+      for (i = 0; i < NUM_WIFI_CREDENTIALS; i++)
+      {
+        if ( isWiFiCredValid(i) && !strcmp((const char*) apInfo.ssid, BlynkESP32_WM_config.WiFi_Creds[i].wifi_ssid) )
+          break;
+      }
+
+      if (i == NUM_WIFI_CREDENTIALS)
+        return;
+
+      session.wifiIndex = i;
+      session.server    = server;
+      session.channel   = WiFi.channel();
+      memcpy(session.bssid, WiFi.BSSID(), sizeof(session.bssid));
+
+      session.ip        = (uint32_t) WiFi.localIP();
+      session.gateway   = (uint32_t) WiFi.gatewayIP();
+      session.subnet    = (uint32_t) WiFi.subnetMask();
+      session.dns       = (uint32_t) WiFi.dnsIP(0);
+
+      if (!sleepTimings.isResumed())
+        session.numResumes = 0;
+
+      // Got by DHCP in this cycle : counted from boot, a bit older than it is
+      if (!sleepTimings.isResumed() || leaseRenewed)
+        session.leaseAge_s = 0;
+
+      session.leaseAge_s += (millis() / 1000) + (uint32_t) (sleep_us / 1000000ULL) + 1;
+
+      memcpy(&blynkRtcConfig, &BlynkESP32_WM_config, sizeof(blynkRtcConfig));
+
+      session.magic = DEEP_SLEEP_MAGIC;
+    }
+#endif
+
+    void updateUsableServers()
+    {
+      for (uint8_t i = 0; i < NUM_BLYNK_CREDENTIALS; i++)
+      {
+        serverSelector.setUsable(i, isBlynkCredValid(i));
+      }
+
+      BLYNK_WM_LOGI(BLYNK_F("NumBlynkServers="), serverSelector.getNumUsable());
+    }
+
+    // All bytes but checkSum. With version1Only, only those before it : the whole data of version 1.
+    int calcChecksum(bool version1Only = false)
+    {
+      int checkSum = 0;
+      uint16_t checkSumOffset = offsetof(Blynk_WM_Configuration, checkSum);
+
+      for (uint16_t index = 0; index < sizeof(BlynkESP32_WM_config); index++)
+      {
+        if (index == checkSumOffset)
+        {
+          if (version1Only)
+            break;
+
+          index += sizeof(BlynkESP32_WM_config.checkSum) - 1;
+          continue;
+        }
+
+        checkSum += * ( ( (byte*) &BlynkESP32_WM_config ) + index);
+      }
+
+      return checkSum;
+    }
+
+    // Data of version 1 keeps its credentials and gets the defaults of the fields added since.
+    // True if migrated : it must then be saved in the current layout.
+    bool migrateConfigData()
+    {
+      if ( (BlynkESP32_WM_config.version == BLYNK_WM_CONFIG_VERSION) && (calcChecksum() == BlynkESP32_WM_config.checkSum) )
+        return false;
+
+      if ( (strncmp(BlynkESP32_WM_config.header, BLYNK_BOARD_TYPE, strlen(BLYNK_BOARD_TYPE)) != 0) ||
+           (calcChecksum(true) != BlynkESP32_WM_config.checkSum) )
+        return false;
+
+      BlynkESP32_WM_config.version        = BLYNK_WM_CONFIG_VERSION;
+      BlynkESP32_WM_config.reconnect_min  = RECONNECT_BACKOFF_MIN_MS / 1000;
+      BlynkESP32_WM_config.reconnect_max  = RECONNECT_BACKOFF_MAX_MS / 1000;
+      BlynkESP32_WM_config.checkSum       = calcChecksum();
+
+      BLYNK_WM_LOGW(BLYNK_F("Cfg:Migrated,v="), BLYNK_WM_CONFIG_VERSION);
+
+      return true;
+    }
+
+#if USE_SPIFFS
+
+#define  CONFIG_FILENAME              BLYNK_F("/wfm_config.dat")
+#define  CONFIG_FILENAME_BACKUP       BLYNK_F("/wfm_config.bak")
+
+#define  CREDENTIALS_FILENAME         BLYNK_F("/wm_cred.dat")
+#define  CREDENTIALS_FILENAME_BACKUP  BLYNK_F("/wm_cred.bak")
+
+#if BLYNK_WM_DYNAMIC_PARAMETERS
+    bool loadCredentials(void)
+    {
+      int checkSum = 0;
+      int readCheckSum;
+      totalDataSize = sizeof(BlynkESP32_WM_config) + sizeof(readCheckSum);
+      
+      File file = SPIFFS.open(CREDENTIALS_FILENAME, "r");
+      BLYNK_WM_LOGI(BLYNK_F("LoadCredFile "));
+
+      if (!file)
+      {
+        BLYNK_WM_LOGE(BLYNK_F("failed"));
+
+        // Trying open redundant config file
+        file = SPIFFS.open(CREDENTIALS_FILENAME_BACKUP, "r");
+        BLYNK_WM_LOGI(BLYNK_F("LoadBkUpCredFile "));
+
+        if (!file)
+        {
+          BLYNK_WM_LOGE(BLYNK_F("failed"));
+          return false;
+        }
+      }
+     
+      for (int i = 0; i < BLYNK_WM_NUM_MENU_ITEMS; i++)
+      {       
+        char* _pointer = BLYNK_WM_MENU_ITEMS[i].pdata;
+        totalDataSize += BLYNK_WM_MENU_ITEMS[i].maxlen;
+        
+        // Actual size of pdata is [maxlen + 1]
+        memset(BLYNK_WM_MENU_ITEMS[i].pdata, 0, BLYNK_WM_MENU_ITEMS[i].maxlen + 1);
+        
+        file.readBytes(_pointer, BLYNK_WM_MENU_ITEMS[i].maxlen);
+               
+        for (uint16_t j = 0; j < BLYNK_WM_MENU_ITEMS[i].maxlen; j++,_pointer++)
+        {         
+          checkSum += *_pointer;  
+        }       
+      }
+
+      file.readBytes((char *) &readCheckSum, sizeof(readCheckSum));
+      
+      BLYNK_WM_LOGI(BLYNK_F("OK"));
+      file.close();
+      
+      BLYNK_WM_LOGD(F("CrCCSum=0x"), blynkLogHex(checkSum), F(",CrRCSum=0x"), blynkLogHex(readCheckSum));
+      
+      if ( checkSum != readCheckSum)
+      {
+        return false;
+      }
+      
+      return true;    
+    }
+
+    void saveCredentials(void)
+    {
+      int checkSum = 0;
+    
       File file = SPIFFS.open(CREDENTIALS_FILENAME, "w");
-      BLYNK_LOG1(BLYNK_F("SaveCredFile "));
+      BLYNK_WM_LOGI(BLYNK_F("SaveCredFile "));
 
-      for (int i = 0; i < NUM_MENU_ITEMS; i++)
+      for (int i = 0; i < BLYNK_WM_NUM_MENU_ITEMS; i++)
       {       
-        char* _pointer = myMenuItems[i].pdata;
+        char* _pointer = BLYNK_WM_MENU_ITEMS[i].pdata;
         
-        //BLYNK_LOG4(F("pdata="), myMenuItems[i].pdata, F(",len="), myMenuItems[i].maxlen);
+        //BLYNK_WM_LOGD(F("pdata="), BLYNK_WM_MENU_ITEMS[i].pdata, F(",len="), BLYNK_WM_MENU_ITEMS[i].maxlen);
         
         if (file)
         {
-          file.write((uint8_t*) _pointer, myMenuItems[i].maxlen);         
+          file.write((uint8_t*) _pointer, BLYNK_WM_MENU_ITEMS[i].maxlen);         
         }
         else
         {
-          BLYNK_LOG1(BLYNK_F("failed"));
+          BLYNK_WM_LOGE(BLYNK_F("failed"));
         }        
                      
-        for (uint16_t j = 0; j < myMenuItems[i].maxlen; j++,_pointer++)
+        for (uint16_t j = 0; j < BLYNK_WM_MENU_ITEMS[i].maxlen; j++,_pointer++)
         {         
           checkSum += *_pointer;     
          }
@@ -773,35 +1652,35 @@ class BlynkWifi
       {
         file.write((uint8_t*) &checkSum, sizeof(checkSum));     
         file.close();
-        BLYNK_LOG1(BLYNK_F("OK"));    
+        BLYNK_WM_LOGI(BLYNK_F("OK"));    
       }
       else
       {
-        BLYNK_LOG1(BLYNK_F("failed"));
+        BLYNK_WM_LOGE(BLYNK_F("failed"));
       }   
            
-      BLYNK_LOG2(F("CrCCSum=0x"), String(checkSum, HEX));
+      BLYNK_WM_LOGD(F("CrCCSum=0x"), blynkLogHex(checkSum));
       
       // Trying open redundant Auth file
       file = SPIFFS.open(CREDENTIALS_FILENAME_BACKUP, "w");
-      BLYNK_LOG1(BLYNK_F("SaveBkUpCredFile "));
+      BLYNK_WM_LOGI(BLYNK_F("SaveBkUpCredFile "));
 
-      for (int i = 0; i < NUM_MENU_ITEMS; i++)
+      for (int i = 0; i < BLYNK_WM_NUM_MENU_ITEMS; i++)
       {       
-        char* _pointer = myMenuItems[i].pdata;
+        char* _pointer = BLYNK_WM_MENU_ITEMS[i].pdata;
         
-        BLYNK_LOG4(F("pdata="), myMenuItems[i].pdata, F(",len="), myMenuItems[i].maxlen);
+        BLYNK_WM_LOGD(F("pdata="), BLYNK_WM_MENU_ITEMS[i].pdata, F(",len="), BLYNK_WM_MENU_ITEMS[i].maxlen);
         
         if (file)
         {
-          file.write((uint8_t*) _pointer, myMenuItems[i].maxlen);         
+          file.write((uint8_t*) _pointer, BLYNK_WM_MENU_ITEMS[i].maxlen);         
         }
         else
         {
-          BLYNK_LOG1(BLYNK_F("failed"));
+          BLYNK_WM_LOGE(BLYNK_F("failed"));
         }        
                      
-        for (uint16_t j = 0; j < myMenuItems[i].maxlen; j++,_pointer++)
+        for (uint16_t j = 0; j < BLYNK_WM_MENU_ITEMS[i].maxlen; j++,_pointer++)
         {         
           checkSum += *_pointer;     
          }
@@ -811,37 +1690,38 @@ class BlynkWifi
       {
         file.write((uint8_t*) &checkSum, sizeof(checkSum));     
         file.close();
-        BLYNK_LOG1(BLYNK_F("OK"));    
+        BLYNK_WM_LOGI(BLYNK_F("OK"));    
       }
       else
       {
-        BLYNK_LOG1(BLYNK_F("failed"));
+        BLYNK_WM_LOGE(BLYNK_F("failed"));
       }   
     }
+#endif
     
     void loadConfigData(void)
     {
       File file = SPIFFS.open(CONFIG_FILENAME, "r");
-      BLYNK_LOG1(BLYNK_F("LoadCfgFile "));
+      BLYNK_WM_LOGI(BLYNK_F("LoadCfgFile "));
 
       if (!file)
       {
-        BLYNK_LOG1(BLYNK_F("failed"));
+        BLYNK_WM_LOGE(BLYNK_F("failed"));
 
         // Trying open redundant config file
         file = SPIFFS.open(CONFIG_FILENAME_BACKUP, "r");
-        BLYNK_LOG1(BLYNK_F("Load BkUpCfgFile "));
+        BLYNK_WM_LOGI(BLYNK_F("Load BkUpCfgFile "));
 
         if (!file)
         {
-          BLYNK_LOG1(BLYNK_F("failed"));
+          BLYNK_WM_LOGE(BLYNK_F("failed"));
           return;
         }
       }
 
       file.readBytes((char *) &BlynkESP32_WM_config, sizeof(BlynkESP32_WM_config));
 
-      BLYNK_LOG1(BLYNK_F("OK"));
+      BLYNK_WM_LOGI(BLYNK_F("OK"));
       file.close();
     }
 
@@ -852,35 +1732,37 @@ class BlynkWifi
       int calChecksum = calcChecksum();
       BlynkESP32_WM_config.checkSum = calChecksum;
       
-      BLYNK_LOG2(BLYNK_F("SaveCfgFile,CSum=0x"), String(calChecksum, HEX));
+      BLYNK_WM_LOGD(BLYNK_F("SaveCfgFile,CSum=0x"), blynkLogHex(calChecksum));
 
       if (file)
       {
         file.write((uint8_t*) &BlynkESP32_WM_config, sizeof(BlynkESP32_WM_config));
         file.close();
-        BLYNK_LOG1(BLYNK_F("OK"));
+        BLYNK_WM_LOGI(BLYNK_F("OK"));
       }
       else
       {
-        BLYNK_LOG1(BLYNK_F("failed"));
+        BLYNK_WM_LOGE(BLYNK_F("failed"));
       }
 
       // Trying open redundant Auth file
       file = SPIFFS.open(CONFIG_FILENAME_BACKUP, "w");
-      BLYNK_LOG1(BLYNK_F("SaveBkUpCfgFile "));
+      BLYNK_WM_LOGI(BLYNK_F("SaveBkUpCfgFile "));
 
       if (file)
       {
         file.write((uint8_t *) &BlynkESP32_WM_config, sizeof(BlynkESP32_WM_config));
         file.close();
-        BLYNK_LOG1(BLYNK_F("OK"));
+        BLYNK_WM_LOGI(BLYNK_F("OK"));
       }
       else
       {
-        BLYNK_LOG1(BLYNK_F("failed"));
+        BLYNK_WM_LOGE(BLYNK_F("failed"));
       }
       
+#if BLYNK_WM_DYNAMIC_PARAMETERS
       saveCredentials();
+#endif
     }
 
     // Return false if init new EEPROM or SPIFFS. No more need trying to connect. Go directly to config mode
@@ -892,7 +1774,7 @@ class BlynkWifi
       
       if (!SPIFFS.begin())
       {
-        BLYNK_LOG1(BLYNK_F("SPIFFS failed! Use EEPROM."));
+        BLYNK_WM_LOGE(BLYNK_F("SPIFFS failed! Use EEPROM."));
         return false;
       }
 
@@ -902,45 +1784,42 @@ class BlynkWifi
         loadConfigData();
       }
 
+      // The dynamic parameters are in their own file, where they were
+      bool migrated = migrateConfigData();
+
       int calChecksum = calcChecksum();
 
-      BLYNK_LOG4(BLYNK_F("CCSum=0x"), String(calChecksum, HEX),
-                 BLYNK_F(",RCSum=0x"), String(BlynkESP32_WM_config.checkSum, HEX));
+      BLYNK_WM_LOGD(BLYNK_F("CCSum=0x"), blynkLogHex(calChecksum),
+                 BLYNK_F(",RCSum=0x"), blynkLogHex(BlynkESP32_WM_config.checkSum));
 
       //displayConfigData();
+#if BLYNK_WM_DYNAMIC_PARAMETERS
       credDataValid = loadCredentials();
+#else
+      credDataValid = true;
+#endif
 
       if ( (strncmp(BlynkESP32_WM_config.header, BLYNK_BOARD_TYPE, strlen(BLYNK_BOARD_TYPE)) != 0) ||
            (calChecksum != BlynkESP32_WM_config.checkSum) || !credDataValid )
       {
         memset(&BlynkESP32_WM_config, 0, sizeof(BlynkESP32_WM_config));
         
-        for (int i = 0; i < NUM_MENU_ITEMS; i++)
+        for (int i = 0; i < BLYNK_WM_NUM_MENU_ITEMS; i++)
         {
           // Actual size of pdata is [maxlen + 1]
-          memset(myMenuItems[i].pdata, 0, myMenuItems[i].maxlen + 1);
+          memset(BLYNK_WM_MENU_ITEMS[i].pdata, 0, BLYNK_WM_MENU_ITEMS[i].maxlen + 1);
         }
 
-        BLYNK_LOG4(BLYNK_F("InitCfgFile,sz="), sizeof(BlynkESP32_WM_config), BLYNK_F(", TotalDataSz="), totalDataSize);
+        BLYNK_WM_LOGI(BLYNK_F("InitCfgFile,sz="), sizeof(BlynkESP32_WM_config), BLYNK_F(", TotalDataSz="), totalDataSize);
         
         // doesn't have any configuration
         strcpy(BlynkESP32_WM_config.header,           BLYNK_BOARD_TYPE);
-        strcpy(BlynkESP32_WM_config.WiFi_Creds[0].wifi_ssid,      NO_CONFIG);
-        strcpy(BlynkESP32_WM_config.WiFi_Creds[0].wifi_pw,        NO_CONFIG);
-        strcpy(BlynkESP32_WM_config.WiFi_Creds[1].wifi_ssid,      NO_CONFIG);
-        strcpy(BlynkESP32_WM_config.WiFi_Creds[1].wifi_pw,        NO_CONFIG);
-        strcpy(BlynkESP32_WM_config.Blynk_Creds[0].blynk_server,  NO_CONFIG);
-        strcpy(BlynkESP32_WM_config.Blynk_Creds[0].blynk_token,   NO_CONFIG);
-        strcpy(BlynkESP32_WM_config.Blynk_Creds[1].blynk_server,  NO_CONFIG);
-        strcpy(BlynkESP32_WM_config.Blynk_Creds[1].blynk_token,   NO_CONFIG);
-        BlynkESP32_WM_config.blynk_port = BLYNK_SERVER_HARDWARE_PORT;
-        strcpy(BlynkESP32_WM_config.blynk_bt_tk,      NO_CONFIG);
-        strcpy(BlynkESP32_WM_config.blynk_ble_tk,     NO_CONFIG);
-        strcpy(BlynkESP32_WM_config.board_name,       NO_CONFIG);
+
+        setDefaultConfigData();
         
-        for (int i = 0; i < NUM_MENU_ITEMS; i++)
+        for (int i = 0; i < BLYNK_WM_NUM_MENU_ITEMS; i++)
         {
-          strncpy(myMenuItems[i].pdata, NO_CONFIG, myMenuItems[i].maxlen);
+          strncpy(BLYNK_WM_MENU_ITEMS[i].pdata, NO_CONFIG, BLYNK_WM_MENU_ITEMS[i].maxlen);
         }
         
         // Don't need
@@ -950,16 +1829,18 @@ class BlynkWifi
 
         return false;
       }
-      else if ( !strncmp(BlynkESP32_WM_config.WiFi_Creds[0].wifi_ssid,       NO_CONFIG, strlen(NO_CONFIG) )  ||
-                !strncmp(BlynkESP32_WM_config.WiFi_Creds[0].wifi_pw,         NO_CONFIG, strlen(NO_CONFIG) )  ||
-                !strncmp(BlynkESP32_WM_config.WiFi_Creds[1].wifi_ssid,       NO_CONFIG, strlen(NO_CONFIG) )  ||
-                !strncmp(BlynkESP32_WM_config.WiFi_Creds[1].wifi_pw,         NO_CONFIG, strlen(NO_CONFIG) )  ||
-                !strncmp(BlynkESP32_WM_config.Blynk_Creds[0].blynk_server,   NO_CONFIG, strlen(NO_CONFIG) )  ||
-                !strncmp(BlynkESP32_WM_config.Blynk_Creds[0].blynk_token,    NO_CONFIG, strlen(NO_CONFIG) )  ||
-                !strncmp(BlynkESP32_WM_config.Blynk_Creds[1].blynk_server,   NO_CONFIG, strlen(NO_CONFIG) )  ||
-                !strncmp(BlynkESP32_WM_config.Blynk_Creds[1].blynk_token,    NO_CONFIG, strlen(NO_CONFIG) )  ||
-                !strncmp(BlynkESP32_WM_config.blynk_bt_tk,                   NO_CONFIG, strlen(NO_CONFIG) )  ||
-                !strncmp(BlynkESP32_WM_config.blynk_ble_tk,                  NO_CONFIG, strlen(NO_CONFIG) ) )
+
+      if (migrated)
+        saveConfigData();
+
+      // BT / BLE tokens are only checked with the Config Portal : without it, they can't be entered
+      if ( !isWiFiCredValid(0)  ||
+                !isBlynkCredValid(0)
+#if BLYNK_WM_CONFIG_PORTAL
+                || !strncmp(BlynkESP32_WM_config.blynk_bt_tk,                NO_CONFIG, strlen(NO_CONFIG) )
+                || !strncmp(BlynkESP32_WM_config.blynk_ble_tk,               NO_CONFIG, strlen(NO_CONFIG) )
+#endif
+              )
       {
         // If SSID, PW, Server,Token ="nothing", stay in config mode forever until having config Data.
         return false;
@@ -975,46 +1856,48 @@ class BlynkWifi
 
 #else
 
+#ifndef EEPROM_START
+#define EEPROM_START     0
+#endif
+
+// 512, or what the config data needs with more credentials. The dynamic parameters, sized at runtime, are checked
+// by getConfigData().
 #ifndef EEPROM_SIZE
+#if (EEPROM_START + BLYNK_WM_CONFIG_DATA_SIZE + 4 <= 512)
 #define EEPROM_SIZE     512
 #else
-#if (EEPROM_SIZE > 2048)
+#define EEPROM_SIZE     ( EEPROM_START + BLYNK_WM_CONFIG_DATA_SIZE + 4 )
+#endif
+#elif (EEPROM_SIZE > 2048)
 #warning EEPROM_SIZE must be <= 2048. Reset to 2048
 #undef EEPROM_SIZE
 #define EEPROM_SIZE     2048
 #endif
-#if (EEPROM_SIZE < CONFIG_DATA_SIZE)
-#warning EEPROM_SIZE must be > CONFIG_DATA_SIZE. Reset to 512
-#undef EEPROM_SIZE
-#define EEPROM_SIZE     512
-#endif
-#endif
 
-#ifndef EEPROM_START
-#define EEPROM_START     0
-#else
-#if (EEPROM_START + CONFIG_DATA_SIZE > EEPROM_SIZE)
-#error EPROM_START + CONFIG_DATA_SIZE > EEPROM_SIZE. Please adjust.
-#endif
+// EEPROM.put() silently skips what lies past EEPROM_SIZE : the config would never be saved
+#if (EEPROM_START + BLYNK_WM_CONFIG_DATA_SIZE > EEPROM_SIZE)
+#error EEPROM_START + config data > EEPROM_SIZE. Raise EEPROM_SIZE or lower NUM_WIFI_CREDENTIALS / NUM_BLYNK_CREDENTIALS.
 #endif
 
-    bool EEPROM_getCredentials(void)
+#if BLYNK_WM_DYNAMIC_PARAMETERS
+    // configSize : size of the config data before them, smaller in older layouts
+    bool EEPROM_getCredentials(uint16_t configSize)
     {
       int readCheckSum;
       int checkSum = 0;
-      uint16_t offset = EEPROM_START + sizeof(BlynkESP32_WM_config);
+      uint16_t offset = EEPROM_START + configSize;
            
       totalDataSize = sizeof(BlynkESP32_WM_config) + sizeof(readCheckSum);
       
-      for (int i = 0; i < NUM_MENU_ITEMS; i++)
+      for (int i = 0; i < BLYNK_WM_NUM_MENU_ITEMS; i++)
       {       
-        char* _pointer = myMenuItems[i].pdata;
-        totalDataSize += myMenuItems[i].maxlen;
+        char* _pointer = BLYNK_WM_MENU_ITEMS[i].pdata;
+        totalDataSize += BLYNK_WM_MENU_ITEMS[i].maxlen;
         
         // Actual size of pdata is [maxlen + 1]
-        memset(myMenuItems[i].pdata, 0, myMenuItems[i].maxlen + 1);
+        memset(BLYNK_WM_MENU_ITEMS[i].pdata, 0, BLYNK_WM_MENU_ITEMS[i].maxlen + 1);
                
-        for (uint16_t j = 0; j < myMenuItems[i].maxlen; j++,_pointer++,offset++)
+        for (uint16_t j = 0; j < BLYNK_WM_MENU_ITEMS[i].maxlen; j++,_pointer++,offset++)
         {
           *_pointer = EEPROM.read(offset);
           
@@ -1024,7 +1907,7 @@ class BlynkWifi
       
       EEPROM.get(offset, readCheckSum);
       
-      BLYNK_LOG4(F("CrCCSum=0x"), String(checkSum, HEX), F(",CrRCSum=0x"), String(readCheckSum, HEX));
+      BLYNK_WM_LOGD(F("CrCCSum=0x"), blynkLogHex(checkSum), F(",CrRCSum=0x"), blynkLogHex(readCheckSum));
       
       if ( checkSum != readCheckSum)
       {
@@ -1039,13 +1922,13 @@ class BlynkWifi
       int checkSum = 0;
       uint16_t offset = EEPROM_START + sizeof(BlynkESP32_WM_config);
                 
-      for (int i = 0; i < NUM_MENU_ITEMS; i++)
+      for (int i = 0; i < BLYNK_WM_NUM_MENU_ITEMS; i++)
       {       
-        char* _pointer = myMenuItems[i].pdata;
+        char* _pointer = BLYNK_WM_MENU_ITEMS[i].pdata;
         
-        BLYNK_LOG4(F("pdata="), myMenuItems[i].pdata, F(",len="), myMenuItems[i].maxlen);
+        BLYNK_WM_LOGD(F("pdata="), BLYNK_WM_MENU_ITEMS[i].pdata, F(",len="), BLYNK_WM_MENU_ITEMS[i].maxlen);
                             
-        for (uint16_t j = 0; j < myMenuItems[i].maxlen; j++,_pointer++,offset++)
+        for (uint16_t j = 0; j < BLYNK_WM_MENU_ITEMS[i].maxlen; j++,_pointer++,offset++)
         {
           EEPROM.write(offset, *_pointer);
           
@@ -1056,8 +1939,9 @@ class BlynkWifi
       EEPROM.put(offset, checkSum);
       //EEPROM.commit();
       
-      BLYNK_LOG2(F("CrCCSum=0x"), String(checkSum, HEX));
+      BLYNK_WM_LOGD(F("CrCCSum=0x"), blynkLogHex(checkSum));
     }
+#endif
     
     // Return false if init new EEPROM or SPIFFS. No more need trying to connect. Go directly to config mode
     bool getConfigData()
@@ -1069,64 +1953,68 @@ class BlynkWifi
       EEPROM.begin(EEPROM_SIZE);
       EEPROM.get(EEPROM_START, BlynkESP32_WM_config);
 
+      // Version 1 data ends at checkSum, its dynamic parameters follow
+      bool migrated = migrateConfigData();
+
       int calChecksum = calcChecksum();
 
-      BLYNK_LOG4(BLYNK_F("CCSum=0x"), String(calChecksum, HEX),
-                 BLYNK_F(",RCSum=0x"), String(BlynkESP32_WM_config.checkSum, HEX));
+      BLYNK_WM_LOGD(BLYNK_F("CCSum=0x"), blynkLogHex(calChecksum),
+                 BLYNK_F(",RCSum=0x"), blynkLogHex(BlynkESP32_WM_config.checkSum));
                  
-      credDataValid = EEPROM_getCredentials();             
+#if BLYNK_WM_DYNAMIC_PARAMETERS
+      credDataValid = EEPROM_getCredentials(migrated ? offsetof(Blynk_WM_Configuration, version) : sizeof(BlynkESP32_WM_config));
+
+      // Known only now. What doesn't fit would be silently dropped by every save.
+      if (EEPROM_START + totalDataSize > EEPROM_SIZE)
+      {
+        BLYNK_WM_LOGE(BLYNK_F("EEPROM_SIZE too small,need="), EEPROM_START + totalDataSize);
+      }
+#else
+      credDataValid = true;
+#endif
 
       if ( (strncmp(BlynkESP32_WM_config.header, BLYNK_BOARD_TYPE, strlen(BLYNK_BOARD_TYPE)) != 0) ||
            (calChecksum != BlynkESP32_WM_config.checkSum) || !credDataValid )
       {
         memset(&BlynkESP32_WM_config, 0, sizeof(BlynkESP32_WM_config));
         
-        for (int i = 0; i < NUM_MENU_ITEMS; i++)
+        for (int i = 0; i < BLYNK_WM_NUM_MENU_ITEMS; i++)
         {
           // Actual size of pdata is [maxlen + 1]
-          memset(myMenuItems[i].pdata, 0, myMenuItems[i].maxlen + 1);
+          memset(BLYNK_WM_MENU_ITEMS[i].pdata, 0, BLYNK_WM_MENU_ITEMS[i].maxlen + 1);
         }
         
         // Including Credentials CSum
-        BLYNK_LOG4(F("InitEEPROM,sz="), EEPROM_SIZE, F(",Datasz="), totalDataSize);
+        BLYNK_WM_LOGI(F("InitEEPROM,sz="), EEPROM_SIZE, F(",Datasz="), totalDataSize);
 
         // doesn't have any configuration
         strcpy(BlynkESP32_WM_config.header,           BLYNK_BOARD_TYPE);
-        strcpy(BlynkESP32_WM_config.WiFi_Creds[0].wifi_ssid,      NO_CONFIG);
-        strcpy(BlynkESP32_WM_config.WiFi_Creds[0].wifi_pw,        NO_CONFIG);
-        strcpy(BlynkESP32_WM_config.WiFi_Creds[1].wifi_ssid,      NO_CONFIG);
-        strcpy(BlynkESP32_WM_config.WiFi_Creds[1].wifi_pw,        NO_CONFIG);
-        strcpy(BlynkESP32_WM_config.Blynk_Creds[0].blynk_server,  NO_CONFIG);
-        strcpy(BlynkESP32_WM_config.Blynk_Creds[0].blynk_token,   NO_CONFIG);
-        strcpy(BlynkESP32_WM_config.Blynk_Creds[1].blynk_server,  NO_CONFIG);
-        strcpy(BlynkESP32_WM_config.Blynk_Creds[1].blynk_token,   NO_CONFIG);
-        BlynkESP32_WM_config.blynk_port = BLYNK_SERVER_HARDWARE_PORT;
-        strcpy(BlynkESP32_WM_config.blynk_bt_tk,      NO_CONFIG);
-        strcpy(BlynkESP32_WM_config.blynk_ble_tk,     NO_CONFIG);
-        strcpy(BlynkESP32_WM_config.board_name,       NO_CONFIG);
+
+        setDefaultConfigData();
         
-        for (int i = 0; i < NUM_MENU_ITEMS; i++)
+        for (int i = 0; i < BLYNK_WM_NUM_MENU_ITEMS; i++)
         {
-          strncpy(myMenuItems[i].pdata, NO_CONFIG, myMenuItems[i].maxlen);
+          strncpy(BLYNK_WM_MENU_ITEMS[i].pdata, NO_CONFIG, BLYNK_WM_MENU_ITEMS[i].maxlen);
         }
         
         // Don't need
         BlynkESP32_WM_config.checkSum = 0;
 
         EEPROM.put(EEPROM_START, BlynkESP32_WM_config);
+#if BLYNK_WM_DYNAMIC_PARAMETERS
         EEPROM_putCredentials();
+#endif
         EEPROM.commit();
 
         return false;
       }
-      else if ( !strncmp(BlynkESP32_WM_config.WiFi_Creds[0].wifi_ssid,       NO_CONFIG, strlen(NO_CONFIG) )  ||
-                !strncmp(BlynkESP32_WM_config.WiFi_Creds[0].wifi_pw,         NO_CONFIG, strlen(NO_CONFIG) )  ||
-                !strncmp(BlynkESP32_WM_config.WiFi_Creds[1].wifi_ssid,       NO_CONFIG, strlen(NO_CONFIG) )  ||
-                !strncmp(BlynkESP32_WM_config.WiFi_Creds[1].wifi_pw,         NO_CONFIG, strlen(NO_CONFIG) )  ||
-                !strncmp(BlynkESP32_WM_config.Blynk_Creds[0].blynk_server,   NO_CONFIG, strlen(NO_CONFIG) )  ||
-                !strncmp(BlynkESP32_WM_config.Blynk_Creds[0].blynk_token,    NO_CONFIG, strlen(NO_CONFIG) )  ||
-                !strncmp(BlynkESP32_WM_config.Blynk_Creds[1].blynk_server,   NO_CONFIG, strlen(NO_CONFIG) )  ||
-                !strncmp(BlynkESP32_WM_config.Blynk_Creds[1].blynk_token,    NO_CONFIG, strlen(NO_CONFIG) ) )
+
+      // Rewritten in the current layout, the dynamic parameters after it
+      if (migrated)
+        saveConfigData();
+
+      if ( !isWiFiCredValid(0)  ||
+           !isBlynkCredValid(0) )
       {
         // If SSID, PW, Server,Token ="nothing", stay in config mode forever until having config Data.
         return false;
@@ -1138,41 +2026,99 @@ class BlynkWifi
       return true;
     }
 
-    void saveConfigData()
-    {
-      int calChecksum = calcChecksum();
-      BlynkESP32_WM_config.checkSum = calChecksum;
-      BLYNK_LOG4(BLYNK_F("SaveEEPROM,sz="), EEPROM_SIZE /*EEPROM.length()*/,
-                 BLYNK_F(",CSum=0x"), String(calChecksum, HEX));
+    void saveConfigData()
+    {
+      int calChecksum = calcChecksum();
+      BlynkESP32_WM_config.checkSum = calChecksum;
+      BLYNK_WM_LOGI(BLYNK_F("SaveEEPROM,sz="), EEPROM_SIZE /*EEPROM.length()*/,
+                 BLYNK_F(",CSum=0x"), blynkLogHex(calChecksum));
+
+      EEPROM.put(EEPROM_START, BlynkESP32_WM_config);
+#if BLYNK_WM_DYNAMIC_PARAMETERS
+      EEPROM_putCredentials();
+#endif
+      EEPROM.commit();
+    }
+
+#endif
+
+    bool connectMultiBlynk(void)
+    {
+      BLYNK_TRACE_SCOPE("WF.connectMultiBlynk");
+
+      uint8_t order[NUM_BLYNK_CREDENTIALS];
+      uint8_t numServers = serverSelector.getOrder(order);
+
+      serverSelector.disconnected();
+     
+      for (uint8_t k = 0; k < numServers; k++)
+      {
+        if (connectBlynkServer(order[k]))
+          return true;
+      }
+
+      BLYNK_WM_LOGW(BLYNK_F("Blynk not connected"));
+
+      return false;
+
+    }
+
+    bool connectBlynkServer(uint8_t index)
+    {
+      uint32_t timeout = serverSelector.getTimeout(index);
+
+      config(BlynkESP32_WM_config.Blynk_Creds[index].blynk_token,
+             BlynkESP32_WM_config.Blynk_Creds[index].blynk_server, BLYNK_SERVER_HARDWARE_PORT);
+
+      BLYNK_WM_LOG_DRAIN();
+
+      uint32_t startConnect = millis();
+
+      if (connect(timeout))
+      {
+        uint32_t connectTime = millis() - startConnect;
+
+        serverSelector.success(index, connectTime);
+
+        BLYNK_WM_LOGI(BLYNK_F("Conn2BlynkServer="), BlynkESP32_WM_config.Blynk_Creds[index].blynk_server,
+                   BLYNK_F(",Token="), BlynkESP32_WM_config.Blynk_Creds[index].blynk_token, BLYNK_F(",ms="), connectTime);
+        return true;
+      }
+
+      serverSelector.failure(index);
 
-      EEPROM.put(EEPROM_START, BlynkESP32_WM_config);
-      EEPROM_putCredentials();
-      EEPROM.commit();
-    }
+      BLYNK_WM_LOGE(BLYNK_F("BlynkServerFail="), BlynkESP32_WM_config.Blynk_Creds[index].blynk_server, BLYNK_F(",timeout="), timeout);
 
-#endif
+      return false;
+    }
 
-    bool connectMultiBlynk(void)
+    // Connected to a backup server. Check with a plain TCP connect, without dropping the current session,
+    // if the preferred server answers again. Only then switch back to it.
+    void reprobePreferredServer()
     {
-#define BLYNK_CONNECT_TIMEOUT_MS      5000L
-     
-      for (int i = 0; i < NUM_BLYNK_CREDENTIALS; i++)
-      {        
-        config(BlynkESP32_WM_config.Blynk_Creds[i].blynk_token,
-               BlynkESP32_WM_config.Blynk_Creds[i].blynk_server, BLYNK_SERVER_HARDWARE_PORT);
+      int8_t preferred = serverSelector.getPreferred();
 
-        if (connect(BLYNK_CONNECT_TIMEOUT_MS) )
-        {
-          BLYNK_LOG4(BLYNK_F("Conn2BlynkServer="), BlynkESP32_WM_config.Blynk_Creds[i].blynk_server,
-                     BLYNK_F(",Token="), BlynkESP32_WM_config.Blynk_Creds[i].blynk_token);
-          return true;
-        }
+      if (preferred == BLYNK_SERVER_NONE)
+        return;
+
+      WiFiClient probe;
+
+      if (!probe.connect(BlynkESP32_WM_config.Blynk_Creds[preferred].blynk_server, BLYNK_SERVER_HARDWARE_PORT, BLYNK_CONNECT_MIN_TIMEOUT_MS))
+      {
+        BLYNK_WM_LOGW(BLYNK_F("r:PreferredSrvStillDown"));
+        return;
       }
 
-      BLYNK_LOG1(BLYNK_F("Blynk not connected"));
+      probe.stop();
 
-      return false;
+      BLYNK_WM_LOGI(BLYNK_F("r:PreferredSrvBack.Switch"));
 
+      disconnect();
+
+      if (!connectBlynkServer(preferred))
+      {
+        connectMultiBlynk();
+      }
     }
 
     uint8_t connectMultiWiFi(void)
@@ -1181,13 +2127,17 @@ class BlynkWifi
 #define WIFI_MULTI_CONNECT_WAITING_MS      2000L
 
       uint8_t status;
-      BLYNK_LOG1(BLYNK_F("Connecting MultiWifi..."));
+      BLYNK_WM_LOGI(BLYNK_F("Connecting MultiWifi..."));
+
+      BLYNK_TRACE_SCOPE("WF.connectMultiWiFi");
 
       WiFi.mode(WIFI_STA);
       
       //New v1.0.11
       setHostname();
            
+      BLYNK_WM_LOG_DRAIN();
+
       int i = 0;
       status = wifiMulti.run();
       delay(WIFI_MULTI_CONNECT_WAITING_MS);
@@ -1204,90 +2154,376 @@ class BlynkWifi
 
       if ( status == WL_CONNECTED )
       {
-        BLYNK_LOG2(BLYNK_F("WiFi connected after time: "), i);
-        BLYNK_LOG4(BLYNK_F("SSID:"), WiFi.SSID(), BLYNK_F(",RSSI="), WiFi.RSSI());
-        BLYNK_LOG4(BLYNK_F("Channel:"), WiFi.channel(), BLYNK_F(",IP="), WiFi.localIP() );
+        BLYNK_WM_LOGI(BLYNK_F("WiFi connected after time: "), i);
+        wifi_ap_record_t apInfo;
+
+        if (esp_wifi_sta_get_ap_info(&apInfo) == ESP_OK)
+          BLYNK_WM_LOGI(BLYNK_F("SSID:"), (const char*) apInfo.ssid, BLYNK_F(",RSSI="), apInfo.rssi);
+        BLYNK_WM_LOGI(BLYNK_F("Channel:"), WiFi.channel(), BLYNK_F(",IP="), WiFi.localIP() );
       }
       else
-        BLYNK_LOG1(BLYNK_F("WiFi not connected"));
+        BLYNK_WM_LOGW(BLYNK_F("WiFi not connected"));
 
       return status;
     }
-    
-    // NEW
-    void createHTML(String &root_html_template)
+#if BLYNK_WM_CONFIG_PORTAL
+    // Portal keys of credentials arrays are "sv", "sv1", "sv2", ...
+    const char* credSuffix(uint8_t index, char* suffix)
     {
-      String pitem;
-      
-      root_html_template = String(BLYNK_WM_HTML_HEAD)  + BLYNK_WM_FLDSET_START;
-      
-      for (int i = 0; i < NUM_MENU_ITEMS; i++)
+      suffix[0] = index ? '0' + index : 0;
+      suffix[1] = 0;
+
+      return suffix;
+    }
+
+    // Fills portalKeys with the schema fields and the menu items
+    void buildPortalKeys()
+    {
+      portalKeys.clear();
+      numHashedMenuItems = 0;
+
+      for (uint8_t f = 0; f < BLYNK_WM_NUM_FIELDS; f++)
+        portalKeys.add(BLYNK_WM_CONFIG_SCHEMA[f].hash, f);
+
+      for (int i = 0; i < BLYNK_WM_NUM_MENU_ITEMS; i++)
       {
-        pitem = String(BLYNK_WM_HTML_PARAM);
+        if ( (BLYNK_WM_NUM_FIELDS + i >= BLYNK_KEY_NONE) ||
+             !portalKeys.add(blynkKeyHash(BLYNK_WM_MENU_ITEMS[i].id, strlen(BLYNK_WM_MENU_ITEMS[i].id)), BLYNK_WM_NUM_FIELDS + i) )
+        {
+          // Remaining menu items are searched one by one
+          break;
+        }
 
-        pitem.replace("{b}", myMenuItems[i].displayName);
-        pitem.replace("{v}", myMenuItems[i].id);
-        pitem.replace("{i}", myMenuItems[i].id);
-        
-        root_html_template += pitem;
+        numHashedMenuItems = i + 1;
       }
-      
-      root_html_template += String(BLYNK_WM_FLDSET_END) + BLYNK_WM_HTML_BUTTON + BLYNK_WM_HTML_SCRIPT;     
-      
-      for (int i = 0; i < NUM_MENU_ITEMS; i++)
+
+      BLYNK_WM_LOGD(BLYNK_F("KeyTbl="), portalKeys.getNumKeys(), BLYNK_F(",NotHashed="), BLYNK_WM_NUM_MENU_ITEMS - numHashedMenuItems);
+    }
+
+    const char* getPortalKey(int entry)
+    {
+      return (entry < (int) BLYNK_WM_NUM_FIELDS) ? BLYNK_WM_CONFIG_SCHEMA[entry].key : BLYNK_WM_MENU_ITEMS[entry - BLYNK_WM_NUM_FIELDS].id;
+    }
+
+    // Entry of the first len chars of key, or -1
+    int findPortalKey(const char* key, uint8_t len)
+    {
+      uint32_t  hash  = blynkKeyHash(key, len);
+      uint16_t  probe = 0;
+      uint8_t   entry;
+
+      while ( (entry = portalKeys.find(hash, probe)) != BLYNK_KEY_NONE )
       {
-        pitem = String(BLYNK_WM_HTML_SCRIPT_ITEM);
-        
-        pitem.replace("{d}", myMenuItems[i].id);
-        
-        root_html_template += pitem;
+        const char* entryKey = getPortalKey(entry);
+
+        if ( !strncmp(entryKey, key, len) && (entryKey[len] == 0) )
+          return entry;
       }
-      
-      root_html_template += String(BLYNK_WM_HTML_SCRIPT_END) + BLYNK_WM_HTML_END;
-      
-      return;     
+
+      for (int i = numHashedMenuItems; i < BLYNK_WM_NUM_MENU_ITEMS; i++)
+      {
+        if ( !strncmp(BLYNK_WM_MENU_ITEMS[i].id, key, len) && (BLYNK_WM_MENU_ITEMS[i].id[len] == 0) )
+          return BLYNK_WM_NUM_FIELDS + i;
+      }
+
+      return -1;
     }
-    ////
-    
+
+    // Entry set by a portal key : a schema field if < BLYNK_WM_NUM_FIELDS, with the index of its entry for keys
+    // such as "sv", "sv1", ..., else a menu item. -1 if none.
+    int getPortalEntry(const char* key, uint8_t& index)
+    {
+      uint8_t len = strnlen(key, BLYNK_KEY_NONE);
+      int     entry;
+
+      index = 0;
+
+      if ( (entry = findPortalKey(key, len)) >= 0 )
+        return entry;
+
+      if (len < 2)
+        return -1;
+
+      char last = key[len - 1];
+
+      if ( (last < '1') || (last > '9') )
+        return -1;
+
+      // Entry of a credentials array
+      entry = findPortalKey(key, len - 1);
+
+      if ( (entry < 0) || (entry >= (int) BLYNK_WM_NUM_FIELDS) || !BLYNK_WM_CONFIG_SCHEMA[entry].stride ||
+           (last - '0' >= BLYNK_WM_CONFIG_SCHEMA[entry].count) )
+        return -1;
+
+      index = last - '0';
+
+      return entry;
+    }
+
+    // Bounds-checked copy of a portal value into a schema field
+    void setField(const BlynkConfigField& field, uint8_t index, const char* value)
+    {
+      char* data = getFieldData(field, index);
+
+      if (field.type == BLYNK_FIELD_INT)
+      {
+        * (int*) data = atoi(value);
+      }
+      else
+      {
+        strncpy(data, value, field.size - 1);
+        data[field.size - 1] = 0;
+      }
+    }
+
+    // Bounds-checked copy of a portal value into a menu item
+    void setMenuItem(MenuItem& item, const char* value)
+    {
+      // Actual size of pdata is [maxlen + 1]
+      strncpy(item.pdata, value, item.maxlen);
+      item.pdata[item.maxlen] = 0;
+    }
+
+    // Adds text to the page, sent by chunks of BLYNK_WM_HTML_CHUNK_LEN
+    void sendHTML(const char* text)
+    {
+      while (*text)
+      {
+        if (htmlChunkLen == sizeof(htmlChunk))
+          flushHTML();
+
+        htmlChunk[htmlChunkLen++] = *text++;
+      }
+    }
+
+    // Text of the config data or of the sketch, written into the page : & < " and ' must not end the attribute or tag
+    void sendHTMLEscaped(const char* text)
+    {
+      char one[2] = { 0, 0 };
+
+      for ( ; *text; text++)
+      {
+        switch (*text)
+        {
+          case '&':
+            sendHTML("&amp;");
+            break;
+
+          case '<':
+            sendHTML("&lt;");
+            break;
+
+          case '"':
+            sendHTML("&quot;");
+            break;
+
+          case '\'':
+            sendHTML("&#39;");
+            break;
+
+          default:
+            one[0] = *text;
+            sendHTML(one);
+            break;
+        }
+      }
+    }
+
+    void flushHTML()
+    {
+      if (htmlChunkLen)
+      {
+        server->sendContent_P(htmlChunk, htmlChunkLen);
+        htmlChunkLen = 0;
+      }
+    }
+
+    // Chunked response : beginHTML(), sendHTML()..., endHTML()
+    void beginHTML(int code, const char* contentType)
+    {
+      server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+      server->send(code, contentType, "");
+
+      htmlChunkLen = 0;
+    }
+
+    void endHTML()
+    {
+      flushHTML();
+
+      // Empty last chunk
+      server->sendContent_P(htmlChunk, 0);
+    }
+
+    // One input of the page, with its current value
+    void sendHTMLInput(const char* label, const char* id, const char* suffix, const char* value, bool ssidList = false)
+    {
+      sendHTML(BLYNK_WM_HTML_LABEL);
+      sendHTMLEscaped(label);
+      sendHTML(suffix);
+      sendHTML(BLYNK_WM_HTML_VALUE);
+      sendHTMLEscaped(value);
+#if BLYNK_WM_WIFI_SCAN
+      sendHTML(ssidList ? BLYNK_WM_HTML_SSID_ID : BLYNK_WM_HTML_ID);
+#else
+      (void) ssidList;
+      sendHTML(BLYNK_WM_HTML_ID);
+#endif
+      sendHTML(id);
+      sendHTML(suffix);
+      sendHTML(BLYNK_WM_HTML_PARAM_END);
+    }
+
+    // Its udVal() in the script
+    void sendHTMLScriptItem(const char* id, const char* suffix)
+    {
+      sendHTML(BLYNK_WM_HTML_SCRIPT_ITEM);
+      sendHTML(id);
+      sendHTML(suffix);
+      sendHTML(BLYNK_WM_HTML_SCRIPT_GET);
+      sendHTML(id);
+      sendHTML(suffix);
+      sendHTML(BLYNK_WM_HTML_SCRIPT_ITEM_END);
+    }
+
+    void sendHTMLField(const BlynkConfigField& field, uint8_t index, bool script)
+    {
+      char        suffix[2];
+      char        number[12];
+      const char* data = getFieldData(field, index);
+
+      credSuffix(index, suffix);
+
+      if (script)
+      {
+        sendHTMLScriptItem(field.key, suffix);
+        return;
+      }
+
+      if (field.type == BLYNK_FIELD_INT)
+      {
+        snprintf(number, sizeof(number), "%d", * (int*) data);
+        data = number;
+      }
+
+      sendHTMLInput(field.label, field.key, suffix, data, field.type == BLYNK_FIELD_SSID);
+    }
+
+    // Inputs generated from the schema and the menu items, or their udVal() when script
+    void sendHTMLFields(bool script)
+    {
+      for (uint8_t fieldset = 0; fieldset < BLYNK_WM_NUM_FIELDSETS; fieldset++)
+      {
+        if (!script)
+          sendHTML(BLYNK_WM_FLDSET_START);
+
+        // Credentials arrays, entry by entry
+        for (uint8_t i = 0; i < BLYNK_WM_MAX_FIELD_COUNT; i++)
+        {
+          for (uint8_t f = 0; f < BLYNK_WM_NUM_FIELDS; f++)
+          {
+            const BlynkConfigField& field = BLYNK_WM_CONFIG_SCHEMA[f];
+
+            if ( (field.fieldset == fieldset) && field.stride && (i < field.count) )
+              sendHTMLField(field, i, script);
+          }
+        }
+
+        for (uint8_t f = 0; f < BLYNK_WM_NUM_FIELDS; f++)
+        {
+          const BlynkConfigField& field = BLYNK_WM_CONFIG_SCHEMA[f];
+
+          if ( (field.fieldset == fieldset) && !field.stride )
+            sendHTMLField(field, 0, script);
+        }
+
+        if (!script)
+          sendHTML(BLYNK_WM_FLDSET_END);
+      }
+
+      if (!script)
+        sendHTML(BLYNK_WM_FLDSET_START);
+
+      for (int i = 0; i < BLYNK_WM_NUM_MENU_ITEMS; i++)
+      {
+        if (script)
+          sendHTMLScriptItem(BLYNK_WM_MENU_ITEMS[i].id, "");
+        else
+          sendHTMLInput(BLYNK_WM_MENU_ITEMS[i].displayName, BLYNK_WM_MENU_ITEMS[i].id, "", BLYNK_WM_MENU_ITEMS[i].pdata);
+      }
+
+      if (!script)
+        sendHTML(BLYNK_WM_FLDSET_END);
+    }
+
+    // Page with the current values, streamed with chunked transfer encoding instead of built in a String
+    void sendConfigPage()
+    {
+      beginHTML(200, "text/html");
+
+      sendHTML(BLYNK_WM_HTML_HEAD);
+      sendHTMLFields(false);
+      sendHTML(BLYNK_WM_HTML_BUTTON);
+      sendHTML(BLYNK_WM_HTML_SCRIPT);
+      sendHTMLFields(true);
+      sendHTML(BLYNK_WM_HTML_SCRIPT_END);
+      sendHTML(BLYNK_WM_HTML_END);
+
+      endHTML();
+    }
+
+#if BLYNK_WM_WIFI_SCAN
+    // Networks of the cache as [["ssid",rssi,secure],...], strongest first. Answers from the cache at once, never
+    // waits for a scan : 202 with [] until the first one is done.
+    void handleScan()
+    {
+      BLYNK_TRACE_SCOPE("WF.handleScan");
+
+      char entry[BLYNK_SCAN_JSON_ENTRY_LEN];
+
+      scanCache.run();
+
+      if (scanCache.isStale())
+        scanCache.start();
+
+      beginHTML( (scanCache.isScanning() && !scanCache.size()) ? 202 : 200, "application/json");
+
+      sendHTML("[");
+
+      for (uint8_t i = 0; i < scanCache.size(); i++)
+      {
+        if (i)
+          sendHTML(",");
+
+        scanCache.formatEntry(i, entry);
+        sendHTML(entry);
+      }
+
+      sendHTML("]");
+
+      endHTML();
+    }
+#endif
+
     void handleRequest()
     {
+      BLYNK_TRACE_SCOPE("WF.handleRequest");
+
       if (server)
       {
-        String key = server->arg("key");
-        String value = server->arg("value");
+        // Args are Strings in WebServer, only read through c_str()
+        const String& key   = server->arg("key");
+        const String& value = server->arg("value");
 
         static int number_items_Updated = 0;
 
-        if (key == "" && value == "")
+        if ( !key.length() && !value.length() )
         {
-          String result;
-          createHTML(result);
-
-          BLYNK_LOG1(BLYNK_F("h:repl"));
-
           // Reset configTimeout to stay here until finished.
           configTimeout = 0;
-          
-          result.replace("[[id]]",     BlynkESP32_WM_config.WiFi_Creds[0].wifi_ssid);
-          result.replace("[[pw]]",     BlynkESP32_WM_config.WiFi_Creds[0].wifi_pw);
-          result.replace("[[id1]]",    BlynkESP32_WM_config.WiFi_Creds[1].wifi_ssid);
-          result.replace("[[pw1]]",    BlynkESP32_WM_config.WiFi_Creds[1].wifi_pw);
-          result.replace("[[sv]]",     BlynkESP32_WM_config.Blynk_Creds[0].blynk_server);
-          result.replace("[[tk]]",     BlynkESP32_WM_config.Blynk_Creds[0].blynk_token);
-          result.replace("[[sv1]]",    BlynkESP32_WM_config.Blynk_Creds[1].blynk_server);
-          result.replace("[[tk1]]",    BlynkESP32_WM_config.Blynk_Creds[1].blynk_token);
-          result.replace("[[pt]]",     String(BlynkESP32_WM_config.blynk_port));
-          result.replace("[[bttk]]",   BlynkESP32_WM_config.blynk_bt_tk);
-          result.replace("[[bltk]]",   BlynkESP32_WM_config.blynk_ble_tk);
-          result.replace("[[nm]]",     BlynkESP32_WM_config.board_name);
-
-          for (int i = 0; i < NUM_MENU_ITEMS; i++)
-          {
-            String toChange = String("[[") + myMenuItems[i].id + "]]";
-            result.replace(toChange, myMenuItems[i].pdata);
-          }
 
-          server->send(200, "text/html", result);
+          sendConfigPage();
 
           return;
         }
@@ -1298,131 +2534,39 @@ class BlynkWifi
           strcpy(BlynkESP32_WM_config.header, BLYNK_BOARD_TYPE);
         }
 
-        if (key == "id")
-        {
-          number_items_Updated++;
-          if (strlen(value.c_str()) < sizeof(BlynkESP32_WM_config.WiFi_Creds[0].wifi_ssid) - 1)
-            strcpy(BlynkESP32_WM_config.WiFi_Creds[0].wifi_ssid, value.c_str());
-          else
-            strncpy(BlynkESP32_WM_config.WiFi_Creds[0].wifi_ssid, value.c_str(), sizeof(BlynkESP32_WM_config.WiFi_Creds[0].wifi_ssid) - 1);
-        }
-        else if (key == "pw")
-        {
-          number_items_Updated++;
-          if (strlen(value.c_str()) < sizeof(BlynkESP32_WM_config.WiFi_Creds[0].wifi_pw) - 1)
-            strcpy(BlynkESP32_WM_config.WiFi_Creds[0].wifi_pw, value.c_str());
-          else
-            strncpy(BlynkESP32_WM_config.WiFi_Creds[0].wifi_pw, value.c_str(), sizeof(BlynkESP32_WM_config.WiFi_Creds[0].wifi_pw) - 1);
-        }
-        else if (key == "id1")
-        {
-          number_items_Updated++;
-          if (strlen(value.c_str()) < sizeof(BlynkESP32_WM_config.WiFi_Creds[1].wifi_ssid) - 1)
-            strcpy(BlynkESP32_WM_config.WiFi_Creds[1].wifi_ssid, value.c_str());
-          else
-            strncpy(BlynkESP32_WM_config.WiFi_Creds[1].wifi_ssid, value.c_str(), sizeof(BlynkESP32_WM_config.WiFi_Creds[1].wifi_ssid) - 1);
-        }
-        else if (key == "pw1")
-        {
-          number_items_Updated++;
-          if (strlen(value.c_str()) < sizeof(BlynkESP32_WM_config.WiFi_Creds[1].wifi_pw) - 1)
-            strcpy(BlynkESP32_WM_config.WiFi_Creds[1].wifi_pw, value.c_str());
-          else
-            strncpy(BlynkESP32_WM_config.WiFi_Creds[1].wifi_pw, value.c_str(), sizeof(BlynkESP32_WM_config.WiFi_Creds[1].wifi_pw) - 1);
-        }
-        else if (key == "sv")
-        {
-          number_items_Updated++;
-          if (strlen(value.c_str()) < sizeof(BlynkESP32_WM_config.Blynk_Creds[0].blynk_server) - 1)
-            strcpy(BlynkESP32_WM_config.Blynk_Creds[0].blynk_server, value.c_str());
-          else
-            strncpy(BlynkESP32_WM_config.Blynk_Creds[0].blynk_server, value.c_str(), sizeof(BlynkESP32_WM_config.Blynk_Creds[0].blynk_server) - 1);
-        }
-        else if (key == "tk")
-        {
-          number_items_Updated++;
-          if (strlen(value.c_str()) < sizeof(BlynkESP32_WM_config.Blynk_Creds[0].blynk_token) - 1)
-            strcpy(BlynkESP32_WM_config.Blynk_Creds[0].blynk_token, value.c_str());
-          else
-            strncpy(BlynkESP32_WM_config.Blynk_Creds[0].blynk_token, value.c_str(), sizeof(BlynkESP32_WM_config.Blynk_Creds[0].blynk_token) - 1);
-        }
-        else if (key == "sv1")
-        {
-          number_items_Updated++;
-          if (strlen(value.c_str()) < sizeof(BlynkESP32_WM_config.Blynk_Creds[1].blynk_server) - 1)
-            strcpy(BlynkESP32_WM_config.Blynk_Creds[1].blynk_server, value.c_str());
-          else
-            strncpy(BlynkESP32_WM_config.Blynk_Creds[1].blynk_server, value.c_str(), sizeof(BlynkESP32_WM_config.Blynk_Creds[1].blynk_server) - 1);
-        }
-        else if (key == "tk1")
-        {
-          number_items_Updated++;
-          if (strlen(value.c_str()) < sizeof(BlynkESP32_WM_config.Blynk_Creds[1].blynk_token) - 1)
-            strcpy(BlynkESP32_WM_config.Blynk_Creds[1].blynk_token, value.c_str());
-          else
-            strncpy(BlynkESP32_WM_config.Blynk_Creds[1].blynk_token, value.c_str(), sizeof(BlynkESP32_WM_config.Blynk_Creds[1].blynk_token) - 1);
-        }
-        else if (key == "pt")
-        {
-          number_items_Updated++;
-          BlynkESP32_WM_config.blynk_port = value.toInt();
-        }
-        else if (key == "bttk")
-        {
-          number_items_Updated++;
-          if (strlen(value.c_str()) < sizeof(BlynkESP32_WM_config.blynk_bt_tk) - 1)
-            strcpy(BlynkESP32_WM_config.blynk_bt_tk, value.c_str());
-          else
-            strncpy(BlynkESP32_WM_config.blynk_bt_tk, value.c_str(), sizeof(BlynkESP32_WM_config.blynk_bt_tk) - 1);
-        }
-        else if (key == "bltk")
+        uint8_t index;
+        int     entry = getPortalEntry(key.c_str(), index);
+
+        if (entry >= (int) BLYNK_WM_NUM_FIELDS)
         {
           number_items_Updated++;
-          if (strlen(value.c_str()) < sizeof(BlynkESP32_WM_config.blynk_ble_tk) - 1)
-            strcpy(BlynkESP32_WM_config.blynk_ble_tk, value.c_str());
-          else
-            strncpy(BlynkESP32_WM_config.blynk_ble_tk, value.c_str(), sizeof(BlynkESP32_WM_config.blynk_ble_tk) - 1);
+          setMenuItem(BLYNK_WM_MENU_ITEMS[entry - BLYNK_WM_NUM_FIELDS], value.c_str());
         }
-        else if (key == "nm")
+        else if (entry >= 0)
         {
           number_items_Updated++;
-          if (strlen(value.c_str()) < sizeof(BlynkESP32_WM_config.board_name) - 1)
-            strcpy(BlynkESP32_WM_config.board_name, value.c_str());
-          else
-            strncpy(BlynkESP32_WM_config.board_name, value.c_str(), sizeof(BlynkESP32_WM_config.board_name) - 1);
+          setField(BLYNK_WM_CONFIG_SCHEMA[entry], index, value.c_str());
         }
 
-        for (int i = 0; i < NUM_MENU_ITEMS; i++)
-        {
-          if (key == myMenuItems[i].id)
-          {
-            //BLYNK_LOG4(F("h:"), myMenuItems[i].id, F("="), value.c_str() );
-            number_items_Updated++;
-
-            // Actual size of pdata is [maxlen + 1]
-            memset(myMenuItems[i].pdata, 0, myMenuItems[i].maxlen + 1);
-
-            if ((int) strlen(value.c_str()) < myMenuItems[i].maxlen)
-              strcpy(myMenuItems[i].pdata, value.c_str());
-            else
-              strncpy(myMenuItems[i].pdata, value.c_str(), myMenuItems[i].maxlen);
-          }
-        }
-        
         server->send(200, "text/html", "OK");
 
         // NEW
-        if (number_items_Updated == NUM_CONFIGURABLE_ITEMS + NUM_MENU_ITEMS)
+        if (number_items_Updated == NUM_CONFIGURABLE_ITEMS + BLYNK_WM_NUM_MENU_ITEMS)
         {
 #if USE_SPIFFS
-          BLYNK_LOG2(BLYNK_F("h:UpdSPIFFS "), CONFIG_FILENAME);
+          BLYNK_WM_LOGI(BLYNK_F("h:UpdSPIFFS "), CONFIG_FILENAME);
 #else
-          BLYNK_LOG1(BLYNK_F("h:UpdEEPROM"));
+          BLYNK_WM_LOGI(BLYNK_F("h:UpdEEPROM"));
 #endif
 
+          RUN_WATCHDOG_MARK("handleRequest.save");
           saveConfigData();
 
-          BLYNK_LOG1(BLYNK_F("h:Rst"));
+          BLYNK_WM_LOGI(BLYNK_F("h:Rst"));
+
+          RUN_WATCHDOG_MARK("handleRequest.restart");
+
+          BLYNK_WM_LOG_DRAIN();
 
           // Delay then reset the ESP8266 after save data
           delay(1000);
@@ -1430,22 +2574,21 @@ class BlynkWifi
         }
       }    // if (server)
     }
+#endif    // BLYNK_WM_CONFIG_PORTAL
 
     void startConfigurationMode()
     {
 #define CONFIG_TIMEOUT			60000L
 
+#if BLYNK_WM_CONFIG_PORTAL
+
       // turn the LED_BUILTIN ON to tell us we are in configuration mode.
       digitalWrite(LED_BUILTIN, LED_ON);
 
-      if ( (portal_ssid == "") || portal_pass == "" )
+      if ( !portal_ssid[0] || !portal_pass[0] )
       {
-        String chipID = String(ESP_getChipId(), HEX);
-        chipID.toUpperCase();
-
-        portal_ssid = "ESP_" + chipID;
-
-        portal_pass = "MyESP_" + chipID;
+        snprintf(portal_ssid, sizeof(portal_ssid), "ESP_%X",   (unsigned int) ESP_getChipId());
+        snprintf(portal_pass, sizeof(portal_pass), "MyESP_%X", (unsigned int) ESP_getChipId());
       }
 
       WiFi.mode(WIFI_AP);
@@ -1460,24 +2603,33 @@ class BlynkWifi
       else
         channel = WiFiAPChannel;
 
-      WiFi.softAP(portal_ssid.c_str(), portal_pass.c_str(), channel);
+      WiFi.softAP(portal_ssid, portal_pass, channel);
       
-      BLYNK_LOG4(BLYNK_F("stConf:SSID="), portal_ssid, BLYNK_F(",PW="), portal_pass);
-      BLYNK_LOG4(BLYNK_F("IP="), portal_apIP.toString(), ",ch=", channel);
+      BLYNK_WM_LOGI(BLYNK_F("stConf:SSID="), portal_ssid, BLYNK_F(",PW="), portal_pass);
+      BLYNK_WM_LOGI(BLYNK_F("IP="), portal_apIP, ",ch=", channel);
       
       delay(100); // ref: https://github.com/espressif/arduino-esp32/issues/985#issuecomment-359157428
       WiFi.softAPConfig(portal_apIP, portal_apIP, IPAddress(255, 255, 255, 0));
 
+      // In static storage, handlers registered once per WebServer
       if (!server)
-        server = new WebServer;
-
-      //See https://stackoverflow.com/questions/39803135/c-unresolved-overloaded-function-type?rq=1
-      if (server)
       {
+        server = portalServer.create();
+
+        //See https://stackoverflow.com/questions/39803135/c-unresolved-overloaded-function-type?rq=1
         server->on("/", [this]() { handleRequest(); });
+#if BLYNK_WM_WIFI_SCAN
+        server->on("/scan", [this]() { handleScan(); });
+#endif
         server->begin();
       }
 
+#if BLYNK_WM_WIFI_SCAN
+      // Runs while the AP comes up. The driver enables STA for it, the AP stays on its channel.
+      if (!scanCache.start())
+        BLYNK_WM_LOGW(BLYNK_F("stConf:ScanFail"));
+#endif
+
       // If there is no saved config Data, stay in config mode forever until having config Data.
       if (hadConfigData)
         configTimeout = millis() + CONFIG_TIMEOUT;
@@ -1485,15 +2637,47 @@ class BlynkWifi
         configTimeout = 0;
 
       configuration_mode = true;
+#else
+      // No Config Portal : run() keeps retrying the stored credentials
+      BLYNK_WM_LOGW(BLYNK_F("stConf:NoPortal"));
+
+      configuration_mode = false;
+#endif
+    }
+
+    // Back in STA mode : destroy the WebServer, which frees its handlers and client, and close the soft AP
+    void stopConfigurationMode()
+    {
+#if BLYNK_WM_CONFIG_PORTAL
+#if BLYNK_WM_WIFI_SCAN
+      scanCache.end();
+#endif
+
+      if (server)
+      {
+        server->stop();
+        portalServer.destroy();
+        server = NULL;
+      }
+
+      WiFi.softAPdisconnect(true);
+
+      BLYNK_WM_LOGD(BLYNK_F("stConf:End,heap="), ESP.getFreeHeap());
+#endif
     }
 };
 
-static WiFiClient _blynkWifiClient;
+static BlynkCountingClient _blynkWifiClient;
 static BlynkArduinoClient _blynkTransport(_blynkWifiClient);
 
 // KH
 BlynkWifi Blynk_WF(_blynkTransport);
 
+inline
+const BlynkTrafficCounter& BlynkWifi::getTraffic() {
+  return _blynkWifiClient.getTraffic();
+}
+
 #if defined(Blynk)
 #undef Blynk
 #define Blynk Blynk_WF